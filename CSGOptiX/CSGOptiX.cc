@@ -77,6 +77,7 @@ HMM: looking like getting qudarap/qsim.h to work with OptiX < 7 is more effort t
 #include "QSim.hh"
 #include "qsim.h"
 #include "QEvt.hh"
+#include "QWavefront.hh"
 
 // CSGOptiX
 #include "Frame.h"
@@ -663,6 +664,7 @@ void CSGOptiX::initSimulate()
     params->tmin = SEventConfig::PropagateEpsilon() ;  // eg 0.1 0.05 to avoid self-intersection off boundaries
     params->tmax = 1000000.f ;
     params->max_time = SEventConfig::MaxTime() ;
+    params->wf = sim && sim->wf ? sim->wf->d_wf : nullptr ;
 
 
 }
@@ -1133,7 +1135,7 @@ double CSGOptiX::launch()
     {
         case SRG_RENDER:    { width = params->width         ; height = params->height ; depth = params->depth ; } ; break ;
         case SRG_SIMTRACE:  { width = qev->getNumSimtrace() ; height = 1              ; depth = 1             ; } ; break ;
-        case SRG_SIMULATE:  { width = qev->getNumPhoton()   ; height = 1              ; depth = 1             ; } ; break ;
+        case SRG_SIMULATE:  { width = params->wf ? sim->wf->num_active() : qev->getNumPhoton() ; height = 1 ; depth = 1 ; } ; break ;
     }
 
     bool expect = width > 0 ;
@@ -1230,7 +1232,54 @@ double CSGOptiX::simtrace_launch()
 double CSGOptiX::simulate_launch()
 {
     assert(raygenmode == SRG_SIMULATE) ;
-    return launch()  ;
+    return sim->wf ? simulate_launch_wavefront() : launch()  ;
+}
+
+/**
+CSGOptiX::simulate_launch_wavefront
+-------------------------------------
+
+With OPTICKS_PROPAGATE_WAVEFRONT the megakernel is replaced by the
+stage sequence described in qwavefront.h. Each trace stage is an
+optixLaunch with width of the active queue, in which the raygen only
+traces into qwavefront::prd. The generate, propagate and finalize stages
+are CUDA kernels launched by QWavefront.
+
+The per bounce launch times are collected into a single
+kernel_times entry for the event, as with the megakernel.
+
+**/
+
+double CSGOptiX::simulate_launch_wavefront()
+{
+    QWavefront* wf = sim->wf ;
+    assert( wf && params->wf == wf->d_wf );
+
+    size_t num_kt = kernel_times.size() ;
+    size_t num_kt_ = kernel_times_.size() ;
+    auto _t0 = std::chrono::high_resolution_clock::now();
+    int64_t t0 = sstamp::Now();
+
+    unsigned num_slot = qev->getNumPhoton() ;
+    unsigned num_active = wf->generate( num_slot, sim->get_photon_slot_offset(), params->max_time );
+    while( num_active > 0 )
+    {
+        launch();
+        num_active = wf->propagate( params->max_time );
+    }
+    wf->finalize();
+
+    auto _t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> _dt = _t1 - _t0 ;
+    kernel_dt = _dt.count() ;
+
+    kernel_times.resize(num_kt);
+    kernel_times.push_back(kernel_dt);
+    kernel_times_.resize(num_kt_);
+    kernel_times_.push_back(sstamp::Now() - t0);
+
+    LOG(LEVEL) << wf->desc() ;
+    return kernel_dt ;
 }
 
 const CSGFoundry* CSGOptiX::getFoundry() const
@@ -186,6 +186,7 @@ private:
  private:
     double simtrace_launch();
     double simulate_launch();
+    double simulate_launch_wavefront();
 
  public:
     const CSGFoundry* getFoundry() const ;
@@ -70,6 +70,7 @@ __intersection__is
 
 #include "qrng.h"
 #include "qsim.h"
+#include "qwavefront.h"
 
 #include "csg_intersect_leaf.h"
 #include "csg_intersect_node.h"
@@ -402,12 +403,47 @@ in cases where these things happen within close to surfaces.
 
 **/
 
+/**
+wavefront_trace
+-----------------
+
+Trace stage of wavefront simulation (OPTICKS_PROPAGATE_WAVEFRONT) for queue
+entry launch_idx.x, intersecting the persisted photon state into the
+per slot prd. The other stages are QWavefront.cu kernels, see qwavefront.h
+
+**/
+
+static __forceinline__ __device__ void wavefront_trace( const uint3& launch_idx )
+{
+    qwavefront* wf = params.wf ;
+    if (launch_idx.x >= wf->num_active) return;
+
+    unsigned idx = wf->active[launch_idx.x] ;
+    const sphoton& p = wf->ctx[idx].p ;
+    quad2* prd = wf->prd + idx ;
+
+    float tmin = ( p.orient_boundary_flag & params.PropagateEpsilon0Mask ) ? params.tmin0 : params.tmin ;
+    switch(params.PropagateRefine)
+    {
+        case 0u: trace<false>( params.handle, p.pos, p.mom, tmin, params.tmax, prd, params.vizmask, params.PropagateRefineDistance );  break ;
+        case 1u: trace<true>(  params.handle, p.pos, p.mom, tmin, params.tmax, prd, params.vizmask, params.PropagateRefineDistance );  break ;
+    }
+}
+
 static __forceinline__ __device__ void simulate( const uint3& launch_idx, const uint3& dim, quad2* prd )
 {
+    if( params.wf )
+    {
+        wavefront_trace( launch_idx );
+        return ;
+    }
+
     sevent* evt = params.evt ;
     if (launch_idx.x >= evt->num_seed) return;   // was evt->num_photon
 
-    unsigned idx = launch_idx.x ;
+    unsigned idx = evt->order ? evt->order[launch_idx.x] : launch_idx.x ;
+    // optional gentype coherent launch order (QEvt__ORDER) maps threads to photon slots, see sseedorder.h
+
     unsigned genstep_idx = evt->seed[idx] ;
     const quad6& gs = evt->genstep[genstep_idx] ;
     // genstep needs the raw index, from zero for each genstep slice sub-launch
@@ -484,6 +520,7 @@ static __forceinline__ __device__ void simulate( const uint3& launch_idx, const
     ctx.end();  // write seq, tag, flat
 #endif
 
+    if( evt->weight_threshold > 0.f ) ctx.p.set_weight( expf(-ctx.tau) ); // weighted propagation, see qsim::propagate_to_boundary_weighted
 
     if( evt->photon )
     {
@@ -495,6 +532,7 @@ static __forceinline__ __device__ void simulate( const uint3& launch_idx, const
         sphotonlite l ;
         l.init( ctx.p.identity, ctx.p.time, ctx.p.flagmask );
         l.set_lpos(prd->lposcost(), prd->lposfphi() );
+        if( evt->weight_threshold > 0.f ) l.set_weight( ctx.p.weight() );
         evt->photonlite[idx] = l ;  // *idx* (not *photon_idx*) as needs to go from zero for photons from a slice of genstep array
     }
 
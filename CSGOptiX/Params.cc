@@ -158,7 +158,8 @@ Params::Params(int raygenmode_, unsigned width, unsigned height, unsigned depth)
     evt(nullptr),
     event_index(0),
     photon_slot_offset(0ull),
-    max_time(1.e27f)
+    max_time(1.e27f),
+    wf(nullptr)
 {
     setRaygenMode(raygenmode_);
     setSize(width, height, depth);
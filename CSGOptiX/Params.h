@@ -23,6 +23,7 @@ struct qat4 ;
 struct quad4 ;
 struct quad6 ;
 struct qsim ;
+struct qwavefront ;
 struct sevent ;
 
 
@@ -86,6 +87,7 @@ struct Params
     int  event_index ;
     unsigned long long  photon_slot_offset ;   // for multi-launch to match single-launch
     float max_time ;           // ns
+    qwavefront*  wf ;          // non-null with OPTICKS_PROPAGATE_WAVEFRONT, raygen only traces the active queue
 
 
     // debug dumping : set from PIDXYZ envvar by CSGOptiX::initPIDXYZ default -1:-1:-1
@@ -0,0 +1,55 @@
+/**
+CSGOptiXServer
+================
+
+Native local genstep-to-hits server, an alternative to the python FastAPI
+service for clients on the same node or cluster. Gensteps from concurrent
+clients are coalesced into single launches by SGenstepServer.h::
+
+    SGenstepServer__ADDR=unix:/tmp/opticks_gs.sock CSGOptiXServer
+    SGenstepServer__ADDR=tcp:0.0.0.0:5555 SGenstepServer__WINDOW_US=5000 CSGOptiXServer
+
+Clients use SGenstepClient from SGenstepServer.h.
+Runs until SIGINT or SIGTERM, or for CSGOptiXServer__SECONDS when that is
+greater than zero, then stops the server which completes queued requests
+and rejects later ones::
+
+    CSGOptiXServer__SECONDS=10 CSGOptiXServer
+
+**/
+
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+
+#include "OPTICKS_LOG.hh"
+#include "SGenstepServer.h"
+#include "CSGOptiXService.h"
+
+static std::atomic<bool> STOP(false) ;
+static void OnSignal(int){ STOP = true ; }
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+
+    CSGOptiXService cxs ;
+
+    SGenstepServer<CSGOptiXService> svr(&cxs) ;
+    if(!svr.start()) return 1 ;
+    std::cout << svr.desc() ;
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    int seconds = ssys::getenvint("CSGOptiXServer__SECONDS", 0) ;
+    auto t0 = std::chrono::steady_clock::now() ;
+    auto expired = [&]{ return seconds > 0 && std::chrono::steady_clock::now() - t0 >= std::chrono::seconds(seconds) ; } ;
+
+    while(!STOP && !expired()) std::this_thread::sleep_for(std::chrono::milliseconds(100)) ;
+
+    svr.stop();
+    std::cout << svr.desc() ;
+    return 0 ;
+}
@@ -7,10 +7,12 @@
 
 #include "GDXMLRead.hh"
 #include "GDXMLWrite.hh"
+#include "GDXMLStream.hh"
 #include "GDXML.hh"
 
 #include "SStr.hh"
 #include "SLOG.hh"
+#include "ssys.h"
 
 const plog::Severity GDXML::LEVEL = SLOG::EnvLevel("GDXML", "DEBUG" ); 
 
@@ -30,9 +32,27 @@ Instead of doing that its better to have a raw intermediate .gdml
 so the user who is not paying attention can be unaware of the fixup. 
 But file organization is left to the user.  
 
+The fixes are done by the single pass SAX GDXMLStream, with memory
+bounded by the largest element rather than the document.
+The former DOM based fixup is used with GDXML__Fix_DOM=1
+
 **/
 
 void GDXML::Fix(const char* dstpath, const char* srcpath)  // static
+{
+    bool dom = ssys::getenvbool(_Fix_DOM) ; 
+    LOG(LEVEL) << _Fix_DOM << " " << dom ; 
+    if(dom) 
+    {
+        Fix_DOM(dstpath, srcpath); 
+    }
+    else
+    {
+        GDXMLStream::Fix(dstpath, srcpath); 
+    }
+}
+
+void GDXML::Fix_DOM(const char* dstpath, const char* srcpath)  // static
 {
     xercesc::XMLPlatformUtils::Initialize();  // HMM: might clash with Geant4 ? 
 
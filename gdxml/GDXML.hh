@@ -22,7 +22,9 @@ struct GDXMLWrite ;
 struct GDXML_API GDXML
 {
     static const plog::Severity LEVEL ; 
+    static constexpr const char* _Fix_DOM = "GDXML__Fix_DOM" ; 
     static void Fix(const char* dstpath, const char* srcpath); 
+    static void Fix_DOM(const char* dstpath, const char* srcpath); 
 
     GDXML(const char* srcpath) ; 
     void replaceAllConstantWithMatrix(); 
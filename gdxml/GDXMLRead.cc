@@ -298,7 +298,7 @@ Note this should only be used for values that need trimming
 due to truncation.
 **/
 
-std::string GDXMLRead::KludgeFix( const char* values )
+std::string GDXMLRead::KludgeFix( const char* values ) // static
 {
     std::stringstream ss; 
     ss.str(values)  ;
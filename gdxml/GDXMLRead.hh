@@ -34,6 +34,8 @@ struct Matrix
 
 
 
+double atod_( const char* a );   // tolerant istringstream conversion, shared with GDXMLStream
+
 struct GDXML_API GDXMLRead
 {
     static const plog::Severity LEVEL ; 
@@ -66,7 +68,7 @@ struct GDXML_API GDXMLRead
 
 
     void KludgeTruncatedMatrix(xercesc::DOMElement* matrixElement );
-    std::string KludgeFix( const char* values );
+    static std::string KludgeFix( const char* values );
 
 
 };
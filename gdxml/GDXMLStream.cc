@@ -0,0 +1,423 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <csignal>
+#include <cassert>
+
+#include <xercesc/util/PlatformUtils.hpp>
+#include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/TransService.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+
+#include "SStr.hh"
+#include "sdigest.h"
+#include "SLOG.hh"
+
+#include "GDXMLRead.hh"
+#include "GDXMLWrite.hh"
+#include "GDXMLStream.hh"
+
+const plog::Severity GDXMLStream::LEVEL = SLOG::EnvLevel("GDXMLStream", "DEBUG") ;
+
+/**
+GDXMLStream::Fix
+------------------
+
+Streaming equivalent of GDXML::Fix, writing *dstpath* and
+the _gdxml_report.txt alongside it.
+
+**/
+
+void GDXMLStream::Fix(const char* dstpath, const char* srcpath) // static
+{
+    xercesc::XMLPlatformUtils::Initialize();
+
+    bool same = strcmp(dstpath, srcpath) == 0 ;
+    bool expect = same == false ;
+    assert(expect);
+    if(!expect) std::raise(SIGINT);
+
+    bool kludge_truncated_matrix = true ;
+    GDXMLStream gs(dstpath, kludge_truncated_matrix) ;
+    bool ok = gs.parse(srcpath) ;
+
+    const char* txtpath = SStr::ReplaceEnd(dstpath, ".gdml", "_gdxml_report.txt" );
+    std::string rep = gs.desc();
+    LOG(LEVEL) << " ok " << ok << " rep " << std::endl << rep ;
+    LOG_IF(error, !ok) << " failed to stream " << srcpath << " into " << dstpath ;
+    SStr::Save(txtpath, rep.c_str() );
+}
+
+GDXMLStream::GDXMLStream(const char* dstpath_, bool kludge_truncated_matrix_)
+    :
+    dstpath(strdup(dstpath_)),
+    kludge_truncated_matrix(kludge_truncated_matrix_),
+    out(dstpath_, std::ios::out | std::ios::binary),
+    depth(0),
+    skip_depth(0),
+    in_define(false),
+    in_dtd(false),
+    open_start(false),
+    num_matrix(0),
+    num_duplicated_matrixElement(0),
+    num_pruned_matrixElement(0),
+    num_truncated_matrixElement(0),
+    num_constants(0),
+    num_error(0)
+{
+}
+
+GDXMLStream::~GDXMLStream()
+{
+}
+
+bool GDXMLStream::parse(const char* srcpath)
+{
+    LOG(LEVEL) << "streaming " << srcpath << " into " << dstpath ;
+    if(!out.is_open())
+    {
+        LOG(fatal) << "failed to open " << dstpath ;
+        return false ;
+    }
+
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\" ?>\n" ;
+
+    xercesc::SAX2XMLReader* parser = xercesc::XMLReaderFactory::createXMLReader();
+    parser->setFeature(xercesc::XMLUni::fgSAX2CoreValidation, false);
+    parser->setFeature(xercesc::XMLUni::fgSAX2CoreNameSpaces, true);
+    parser->setFeature(xercesc::XMLUni::fgSAX2CoreNameSpacePrefixes, true);   // report xmlns attributes
+    parser->setContentHandler(this);
+    parser->setLexicalHandler(this);
+    parser->setErrorHandler(this);
+
+    try
+    {
+        parser->parse(srcpath);
+    }
+    catch (const xercesc::XMLException& e)
+    {
+        LOG(error) << "XMLException " << Transcode(e.getMessage()) ;
+        num_error += 1 ;
+    }
+    catch (const xercesc::SAXParseException& e)
+    {
+        LOG(error) << "SAXParseException " << Transcode(e.getMessage()) << " line " << e.getLineNumber() ;
+        num_error += 1 ;
+    }
+    delete parser ;
+
+    out << "\n" ;
+    out.close();
+    return num_error == 0 && depth == 0 ;
+}
+
+std::string GDXMLStream::desc() const
+{
+    std::stringstream ss ;
+    ss << "GDXMLStream::desc" << std::endl
+       << " dstpath " << dstpath << std::endl
+       << " num_matrix " << num_matrix << std::endl
+       << " num_duplicated_matrixElement " << num_duplicated_matrixElement << std::endl
+       << " num_pruned_matrixElement " << num_pruned_matrixElement << std::endl
+       << " num_truncated_matrixElement " << num_truncated_matrixElement << std::endl
+       << " num_constants " << num_constants << std::endl
+       << " num_error " << num_error << std::endl
+       << " issues " << ( num_truncated_matrixElement > 0 || num_constants > 0 ? "YES" : "NO" ) << std::endl
+       ;
+    std::string s = ss.str();
+    return s ;
+}
+
+std::string GDXMLStream::Transcode(const XMLCh* const chars, XMLSize_t length) // static
+{
+    if( chars == nullptr || length == 0 ) return "" ;
+    xercesc::TranscodeToStr utf8(chars, length, "UTF-8");
+    return std::string( (const char*)utf8.str(), utf8.length() );
+}
+
+std::string GDXMLStream::Transcode(const XMLCh* const chars) // static
+{
+    return Transcode(chars, chars ? xercesc::XMLString::stringLen(chars) : 0 );
+}
+
+/**
+GDXMLStream::Escape
+---------------------
+
+Markup characters as escaped by the xercesc DOM serializer,
+attribute values also escape the double quote.
+
+**/
+
+void GDXMLStream::Escape(std::string& dst, const std::string& src, bool attr) // static
+{
+    for(char c : src)
+    {
+        switch(c)
+        {
+            case '&': dst += "&amp;" ; break ;
+            case '<': dst += "&lt;"  ; break ;
+            case '>': dst += "&gt;"  ; break ;
+            case '"': dst += ( attr ? "&quot;" : "\"" ) ; break ;
+            default:  dst += c       ; break ;
+        }
+    }
+}
+
+void GDXMLStream::close_start()
+{
+    if(!open_start) return ;
+    out << ">" ;
+    open_start = false ;
+}
+
+void GDXMLStream::flush_ws()
+{
+    if(pending_ws.empty()) return ;
+    close_start();
+    out << pending_ws ;
+    pending_ws.clear();
+}
+
+/**
+GDXMLStream::matrix_start
+---------------------------
+
+Returns false for matrix names already seen, which are dropped.
+Sets *kludged_values* when the values are truncated.
+
+**/
+
+bool GDXMLStream::matrix_start(const xercesc::Attributes& attrs, std::string& kludged_values)
+{
+    std::string name ;
+    std::string values ;
+    for(XMLSize_t i=0 ; i < attrs.getLength() ; i++)
+    {
+        std::string k = Transcode(attrs.getQName(i)) ;
+        if( k == "name" )   name = Transcode(attrs.getValue(i)) ;
+        if( k == "values" ) values = Transcode(attrs.getValue(i)) ;
+    }
+    num_matrix += 1 ;
+
+    std::string dig = sdigest::Buf(values.c_str(), int(values.size())) ;
+    auto it = matrix_digest.find(name) ;
+    if( it != matrix_digest.end() )
+    {
+        bool expect = it->second == dig ;
+        LOG_IF(fatal, !expect) << " duplicated matrix name " << name << " with different values " ;
+        assert(expect) ;
+        if(!expect) std::raise(SIGINT);
+
+        LOG(LEVEL) << "pruning duplicated matrix " << name ;
+        num_duplicated_matrixElement += 1 ;
+        num_pruned_matrixElement += 1 ;
+        return false ;
+    }
+    matrix_digest[name] = dig ;
+
+    size_t num_value = 0 ;
+    std::stringstream ss(values) ;
+    std::string s ;
+    while (std::getline(ss, s, ' ')) num_value += 1 ;
+
+    bool truncated_values = values.length() >= 9999 || num_value % 2 != 0 ;
+    if(truncated_values)
+    {
+        num_truncated_matrixElement += 1 ;
+        if(kludge_truncated_matrix) kludged_values = GDXMLRead::KludgeFix(values.c_str()) ;
+        LOG(LEVEL) << " truncated matrix " << name << " values.length " << values.length() << " num_value " << num_value ;
+    }
+    return true ;
+}
+
+void GDXMLStream::startElement(const XMLCh* const, const XMLCh* const, const XMLCh* const qname, const xercesc::Attributes& attrs)
+{
+    depth += 1 ;
+    if(skip_depth > 0)
+    {
+        skip_depth += 1 ;
+        return ;
+    }
+
+    std::string tag = Transcode(qname) ;
+    std::string kludged_values ;
+    bool define_child = in_define && depth == 3 ;   // gdml/define/child
+
+    if( define_child ) child_indent = pending_ws ;
+
+    if( define_child && tag == "constant" )
+    {
+        std::string name ;
+        double value = 0. ;
+        for(XMLSize_t i=0 ; i < attrs.getLength() ; i++)
+        {
+            std::string k = Transcode(attrs.getQName(i)) ;
+            if( k == "name" )  name = Transcode(attrs.getValue(i)) ;
+            if( k == "value" ) value = atod_(Transcode(attrs.getValue(i)).c_str()) ;
+        }
+        constants.push_back( {name, value} );
+        num_constants += 1 ;
+        pending_ws.clear();
+        skip_depth = 1 ;
+        return ;
+    }
+
+    if( define_child && tag == "matrix" && !matrix_start(attrs, kludged_values) )
+    {
+        pending_ws.clear();
+        skip_depth = 1 ;
+        return ;
+    }
+
+    if( depth == 2 && tag == "define" ) in_define = true ;
+
+    flush_ws();
+    close_start();
+
+    buf.clear();
+    buf += "<" ;
+    buf += tag ;
+    for(XMLSize_t i=0 ; i < attrs.getLength() ; i++)
+    {
+        std::string k = Transcode(attrs.getQName(i)) ;
+        bool kludge = !kludged_values.empty() && k == "values" ;
+        buf += " " ;
+        buf += k ;
+        buf += "=\"" ;
+        Escape(buf, kludge ? kludged_values : Transcode(attrs.getValue(i)), true );
+        buf += "\"" ;
+    }
+    out << buf ;
+    open_start = true ;
+}
+
+void GDXMLStream::endElement(const XMLCh* const, const XMLCh* const, const XMLCh* const qname)
+{
+    depth -= 1 ;
+    if(skip_depth > 0)
+    {
+        skip_depth -= 1 ;
+        return ;
+    }
+
+    std::string tag = Transcode(qname) ;
+    if( in_define && depth == 1 && tag == "define" )
+    {
+        write_constant_matrices();
+        in_define = false ;
+    }
+
+    if( open_start && pending_ws.empty() )
+    {
+        out << "/>" ;
+        open_start = false ;
+        return ;
+    }
+    flush_ws();
+    close_start();
+    out << "</" << tag << ">" ;
+}
+
+/**
+GDXMLStream::write_constant_matrices
+--------------------------------------
+
+Appended at the end of the define in the same form as
+GDXMLWrite::ConstantToMatrixElement
+
+**/
+
+void GDXMLStream::write_constant_matrices()
+{
+    double nm_lo = 80. ;
+    double nm_hi = 800. ;
+    for(const auto& c : constants)
+    {
+        close_start();
+        out << child_indent ;
+
+        std::string values = GDXMLWrite::ConstantToMatrixValues(c.second, nm_lo, nm_hi );
+        buf.clear();
+        buf += "<matrix name=\"" ;
+        Escape(buf, c.first, true );
+        buf += "\" coldim=\"2\" values=\"" ;
+        Escape(buf, values, true );
+        buf += "\"/>" ;
+        out << buf ;
+    }
+    constants.clear();
+}
+
+void GDXMLStream::characters(const XMLCh* const chars, const XMLSize_t length)
+{
+    if(skip_depth > 0 || depth == 0) return ;
+    std::string s = Transcode(chars, length) ;
+    bool ws = s.find_first_not_of(" \t\r\n") == std::string::npos ;
+    if(ws)
+    {
+        pending_ws += s ;
+        return ;
+    }
+    flush_ws();
+    close_start();
+    buf.clear();
+    Escape(buf, s, false );
+    out << buf ;
+}
+
+void GDXMLStream::ignorableWhitespace(const XMLCh* const chars, const XMLSize_t length)
+{
+    if(skip_depth > 0 || depth == 0) return ;
+    pending_ws += Transcode(chars, length) ;
+}
+
+void GDXMLStream::processingInstruction(const XMLCh* const target, const XMLCh* const data)
+{
+    if(skip_depth > 0) return ;
+    flush_ws();
+    close_start();
+    out << "<?" << Transcode(target) << " " << Transcode(data) << "?>" ;
+    if(depth == 0) out << "\n" ;
+}
+
+void GDXMLStream::comment(const XMLCh* const chars, const XMLSize_t length)
+{
+    if(skip_depth > 0 || in_dtd) return ;
+    flush_ws();
+    close_start();
+    out << "<!--" << Transcode(chars, length) << "-->" ;
+    if(depth == 0) out << "\n" ;
+}
+
+void GDXMLStream::startDTD(const XMLCh* const, const XMLCh* const, const XMLCh* const)
+{
+    in_dtd = true ;
+}
+
+void GDXMLStream::endDTD()
+{
+    in_dtd = false ;
+}
+
+void GDXMLStream::warning(const xercesc::SAXParseException& exc)
+{
+    LOG(LEVEL) << "warning " << Transcode(exc.getMessage()) << " line " << exc.getLineNumber() ;
+}
+
+void GDXMLStream::error(const xercesc::SAXParseException& exc)
+{
+    LOG(error) << Transcode(exc.getMessage()) << " line " << exc.getLineNumber() ;
+    num_error += 1 ;
+}
+
+void GDXMLStream::fatalError(const xercesc::SAXParseException& exc)
+{
+    LOG(fatal) << Transcode(exc.getMessage()) << " line " << exc.getLineNumber() ;
+    num_error += 1 ;
+    throw exc ;
+}
+
@@ -0,0 +1,94 @@
+#pragma once
+/**
+GDXMLStream.hh : single pass SAX2 GDML fix-up with bounded memory
+===================================================================
+
+Does the same fixes as the DOM based GDXML (GDXMLRead/GDXMLWrite)
+without holding the document in memory, the fixed GDML is written
+while the source is parsed:
+
+1. <constant> in <define> are dropped and replaced by two point
+   <matrix> appended at the end of the <define>, as
+   GDXML::replaceAllConstantWithMatrix
+2. repeated <matrix> names are dropped after the first, as
+   GDXMLRead::checkDuplicatedMatrix/pruneDuplicatedMatrix. Instead of
+   pairwise comparison of all matrices only the name and the sdigest.h
+   (MD5 by default) hexdigest of the values of each matrix is kept,
+   a repeated name with different values is fatal as with the DOM path
+3. truncated <matrix> values are trimmed with GDXMLRead::KludgeFix
+
+All other content (elements, attributes in document order, text,
+whitespace, comments and processing instructions) is copied through
+so the source formatting is kept, other than whitespace around
+dropped elements. As the DOM path pretty prints, the two outputs are
+equivalent after normalizing formatting, see tests/GDXMLStreamTest.cc
+
+**/
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/Attributes.hpp>
+
+#include "plog/Severity.h"
+#include "GDXML_API_EXPORT.hh"
+
+struct GDXML_API GDXMLStream : public xercesc::DefaultHandler
+{
+    static const plog::Severity LEVEL ;
+    static void Fix(const char* dstpath, const char* srcpath);
+
+    GDXMLStream(const char* dstpath, bool kludge_truncated_matrix);
+    virtual ~GDXMLStream();
+
+    bool parse(const char* srcpath);
+    std::string desc() const ;
+
+    static std::string Transcode(const XMLCh* const chars, XMLSize_t length);
+    static std::string Transcode(const XMLCh* const chars);
+    static void        Escape(std::string& dst, const std::string& src, bool attr);
+
+    void startElement(const XMLCh* const uri, const XMLCh* const localname, const XMLCh* const qname, const xercesc::Attributes& attrs) override ;
+    void endElement(const XMLCh* const uri, const XMLCh* const localname, const XMLCh* const qname) override ;
+    void characters(const XMLCh* const chars, const XMLSize_t length) override ;
+    void ignorableWhitespace(const XMLCh* const chars, const XMLSize_t length) override ;
+    void processingInstruction(const XMLCh* const target, const XMLCh* const data) override ;
+    void comment(const XMLCh* const chars, const XMLSize_t length) override ;
+    void startDTD(const XMLCh* const name, const XMLCh* const publicId, const XMLCh* const systemId) override ;
+    void endDTD() override ;
+    void warning(const xercesc::SAXParseException& exc) override ;
+    void error(const xercesc::SAXParseException& exc) override ;
+    void fatalError(const xercesc::SAXParseException& exc) override ;
+
+    void close_start();
+    void flush_ws();
+    void write_constant_matrices();
+    bool matrix_start(const xercesc::Attributes& attrs, std::string& kludged_values);
+
+    const char*   dstpath ;
+    bool          kludge_truncated_matrix ;
+    std::ofstream out ;
+
+    int           depth ;
+    int           skip_depth ;      // >0 within a dropped element
+    bool          in_define ;
+    bool          in_dtd ;
+    bool          open_start ;      // start tag written without its closing '>'
+    std::string   pending_ws ;      // whitespace held until the next written content
+    std::string   child_indent ;    // whitespace before the last <define> child
+    std::string   buf ;
+
+    std::vector<std::pair<std::string,double>>   constants ;
+    std::unordered_map<std::string, std::string> matrix_digest ;  // name to hexdigest of values
+
+    unsigned      num_matrix ;
+    unsigned      num_duplicated_matrixElement ;
+    unsigned      num_pruned_matrixElement ;
+    unsigned      num_truncated_matrixElement ;
+    unsigned      num_constants ;
+    unsigned      num_error ;
+};
+
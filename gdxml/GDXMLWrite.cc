@@ -40,7 +40,7 @@ xercesc::DOMAttr* GDXMLWrite::NewAttribute(const char* name, const char* value)
     Out[4]: 1.55e-05
 **/
 
-std::string GDXMLWrite::ConstantToMatrixValues(double value, double nm_lo, double nm_hi ) 
+std::string GDXMLWrite::ConstantToMatrixValues(double value, double nm_lo, double nm_hi ) // static
 {
     double mev_lo = 1240./nm_hi/1e6 ; 
     double mev_hi = 1240./nm_lo/1e6 ; 
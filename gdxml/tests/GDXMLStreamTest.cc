@@ -0,0 +1,265 @@
+/**
+GDXMLStreamTest.cc
+=====================
+
+Compares the fixed GDML from the streaming GDXMLStream with that of
+the DOM based GDXML::Fix_DOM::
+
+    GDXMLStreamTest /path/to/name.gdml
+
+Without argument a small GDML with the issues fixed by both
+(constants, duplicated and truncated matrices) is written and used.
+One constant has an expression value which std::stod would throw on.
+
+The DOM path pretty prints whereas the stream keeps the source formatting,
+so both outputs are normalized by reading them back, removing whitespace
+only text nodes and writing with GDXMLWrite. The normalized files must
+then be byte identical. In addition the raw bytes of the name and values
+of each <matrix> of the two fixed outputs are compared, as duplicated
+matrices are pruned by matching values.
+
+The tests/CMakeLists.txt also runs this with the real geometries
+of tests/geom.
+
+**/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+
+#include "OPTICKS_LOG.hh"
+#include "spath.h"
+#include "GDXML.hh"
+#include "GDXMLRead.hh"
+#include "GDXMLWrite.hh"
+#include "GDXMLStream.hh"
+
+struct GDXMLStreamTest
+{
+    static constexpr const char* FOLD = "$TMP/GDXMLStreamTest" ;
+    static const char* SRC ;
+
+    static const char* Path(const char* name);
+    static std::string ReadFile(const char* path);
+    static void StripWhitespace(xercesc::DOMNode* node);
+    static void Normalize(const char* dst, const char* src);
+    static int  Compare(const char* a, const char* b);
+    static int  CompareMatrix(const char* a, const char* b);
+
+    static int main(int argc, char** argv);
+};
+
+const char* GDXMLStreamTest::SRC = R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>
+<gdml xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:noNamespaceSchemaLocation="http://service-spi.web.cern.ch/service-spi/app/releases/GDML/schema/gdml.xsd">
+  <!-- GDXMLStreamTest source -->
+  <define>
+    <constant name="SCINTILLATIONYIELD0x1" value="11522"/>
+    <matrix coldim="2" name="RINDEX0x2" values="1.55e-06 1.45 1.55e-05 1.48"/>
+    <constant name="RESOLUTIONSCALE0x3" value="1"/>
+    <constant name="HALFPI0x8" value="pi/2"/>
+    <matrix coldim="2" name="ABSLENGTH0x4" values="1.55e-06 1000 1.55e-05 2000 3.1e-05"/>
+    <matrix coldim="2" name="RINDEX0x2" values="1.55e-06 1.45 1.55e-05 1.48"/>
+    <matrix coldim="2" name="RINDEX0x2" values="1.55e-06 1.45 1.55e-05 1.48"/>
+  </define>
+  <materials>
+    <material name="LS0x5" state="solid">
+      <property name="RINDEX" ref="RINDEX0x2"/>
+      <property name="ABSLENGTH" ref="ABSLENGTH0x4"/>
+      <property name="SCINTILLATIONYIELD" ref="SCINTILLATIONYIELD0x1"/>
+      <D unit="g/cm3" value="0.86"/>
+      <fraction n="1" ref="G4_C"/>
+    </material>
+  </materials>
+  <solids>
+    <box lunit="mm" name="World0x6" x="2000" y="2000" z="2000"/>
+  </solids>
+  <structure>
+    <volume name="World0x7">
+      <materialref ref="LS0x5"/>
+      <solidref ref="World0x6"/>
+      <auxiliary auxtype="label" auxvalue="a &amp; b &lt; c"/>
+    </volume>
+  </structure>
+  <setup name="Default" version="1.0">
+    <world ref="World0x7"/>
+  </setup>
+</gdml>
+)" ;
+
+const char* GDXMLStreamTest::Path(const char* name) // static
+{
+    return spath::Resolve(FOLD, name) ;
+}
+
+std::string GDXMLStreamTest::ReadFile(const char* path) // static
+{
+    std::ifstream fp(path, std::ios::in | std::ios::binary);
+    std::stringstream ss ;
+    ss << fp.rdbuf() ;
+    return ss.str();
+}
+
+void GDXMLStreamTest::StripWhitespace(xercesc::DOMNode* node) // static
+{
+    xercesc::DOMNode* child = node->getFirstChild() ;
+    while( child )
+    {
+        xercesc::DOMNode* next = child->getNextSibling() ;
+        if( child->getNodeType() == xercesc::DOMNode::TEXT_NODE )
+        {
+            std::string s = GDXMLStream::Transcode(child->getNodeValue()) ;
+            bool ws = s.find_first_not_of(" \t\r\n") == std::string::npos ;
+            if(ws) node->removeChild(child)->release() ;
+        }
+        else
+        {
+            StripWhitespace(child) ;
+        }
+        child = next ;
+    }
+}
+
+void GDXMLStreamTest::Normalize(const char* dst, const char* src) // static
+{
+    bool kludge_truncated_matrix = false ;
+    GDXMLRead reader(src, kludge_truncated_matrix) ;
+    xercesc::DOMDocument* doc = const_cast<xercesc::DOMDocument*>(reader.doc) ;
+    StripWhitespace(doc) ;
+    GDXMLWrite writer(doc) ;
+    writer.write(dst) ;
+}
+
+/**
+GDXMLStreamTest::Compare
+--------------------------
+
+Returns 0 when identical, otherwise reports the first differing line.
+
+**/
+
+int GDXMLStreamTest::Compare(const char* a, const char* b) // static
+{
+    std::string sa = ReadFile(a) ;
+    std::string sb = ReadFile(b) ;
+    bool same = !sa.empty() && sa == sb ;
+
+    LOG(info)
+        << " a " << a << " " << sa.size()
+        << " b " << b << " " << sb.size()
+        << " " << ( same ? "IDENTICAL" : "DIFFERENT" )
+        ;
+
+    if(same) return 0 ;
+
+    std::stringstream ia(sa) ;
+    std::stringstream ib(sb) ;
+    std::string la, lb ;
+    int line = 0 ;
+    while( true )
+    {
+        bool ga = bool(std::getline(ia, la)) ;
+        bool gb = bool(std::getline(ib, lb)) ;
+        line += 1 ;
+        if(!ga && !gb) break ;
+        if( la != lb || ga != gb )
+        {
+            LOG(error) << " first difference at line " << line << std::endl << " a: " << la << std::endl << " b: " << lb ;
+            break ;
+        }
+    }
+    return 1 ;
+}
+
+/**
+GDXMLStreamTest::CompareMatrix
+--------------------------------
+
+Returns 0 when the <matrix> of both fixed GDML have byte identical names
+and values in the same order with no repeated names.
+
+**/
+
+int GDXMLStreamTest::CompareMatrix(const char* a, const char* b) // static
+{
+    bool kludge_truncated_matrix = false ;
+    GDXMLRead ra(a, kludge_truncated_matrix) ;
+    GDXMLRead rb(b, kludge_truncated_matrix) ;
+
+    bool same = ra.matrix.size() == rb.matrix.size() ;
+    int num_diff = same ? 0 : 1 ;
+    for(size_t i=0 ; same && i < ra.matrix.size() ; i++)
+    {
+        const Matrix& ma = ra.matrix[i] ;
+        const Matrix& mb = rb.matrix[i] ;
+        bool same_i = ma.name.size() == mb.name.size()
+                   && ma.values.size() == mb.values.size()
+                   && memcmp(ma.name.data(), mb.name.data(), ma.name.size()) == 0
+                   && memcmp(ma.values.data(), mb.values.data(), ma.values.size()) == 0
+                   ;
+        if(!same_i)
+        {
+            LOG(error) << " matrix " << i << " differs " << std::endl << " a: " << ma.desc() << std::endl << " b: " << mb.desc() ;
+            num_diff += 1 ;
+        }
+    }
+
+    int num_dupe = ra.checkDuplicatedMatrix() + rb.checkDuplicatedMatrix() ;
+
+    LOG(info)
+        << " num_matrix " << ra.matrix.size() << " " << rb.matrix.size()
+        << " num_diff " << num_diff
+        << " num_dupe " << num_dupe
+        << " " << ( num_diff == 0 && num_dupe == 0 ? "IDENTICAL" : "DIFFERENT" )
+        ;
+    return num_diff == 0 && num_dupe == 0 ? 0 : 1 ;
+}
+
+int GDXMLStreamTest::main(int argc, char** argv) // static
+{
+    const char* srcpath = argc > 1 ? argv[1] : Path("src.gdml") ;
+    if( argc == 1 )
+    {
+        spath::MakeDirsForFile(srcpath);
+        std::ofstream fp(srcpath, std::ios::out);
+        fp << SRC ;
+    }
+
+    const char* dom_path    = Path("dom.gdml") ;
+    const char* stream_path = Path("stream.gdml") ;
+    const char* dom_norm    = Path("dom_norm.gdml") ;
+    const char* stream_norm = Path("stream_norm.gdml") ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    spath::MakeDirsForFile(dom_path);
+    GDXML::Fix_DOM(dom_path, srcpath) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    GDXMLStream::Fix(stream_path, srcpath) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    auto ms = [](auto a, auto b){ return std::chrono::duration<double, std::milli>(b - a).count() ; } ;
+    LOG(info)
+        << " srcpath " << srcpath
+        << " ms dom " << ms(t0,t1)
+        << " stream " << ms(t1,t2)
+        ;
+
+    Normalize(dom_norm, dom_path) ;
+    Normalize(stream_norm, stream_path) ;
+
+    int rc = Compare(dom_norm, stream_norm) ;
+    rc += CompareMatrix(dom_path, stream_path) ;
+
+    std::string rep_dom    = ReadFile(spath::Resolve(FOLD, "dom_gdxml_report.txt")) ;
+    std::string rep_stream = ReadFile(spath::Resolve(FOLD, "stream_gdxml_report.txt")) ;
+    LOG(info) << std::endl << rep_dom << std::endl << rep_stream ;
+
+    return rc ;
+}
+
+int main(int argc, char** argv)
+{
+    OPTICKS_LOG(argc, argv);
+    return GDXMLStreamTest::main(argc, argv) ;
+}
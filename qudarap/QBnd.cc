@@ -5,6 +5,8 @@
 #include <csignal>
 
 #include "SBnd.h"
+#include "ssys.h"
+#include "shalf.h"
 #include "NP.hh"
 #include "NPFold.h"
 
@@ -35,20 +37,27 @@ const plog::Severity QBnd::LEVEL = SLOG::EnvLevel("QBnd", "DEBUG");
 const QBnd* QBnd::INSTANCE = nullptr ; 
 const QBnd* QBnd::Get(){ return INSTANCE ; }
 
+const bool QBnd::COMPACT = ssys::getenvbool("QBnd__COMPACT") ; 
+const bool QBnd::HALF    = ssys::getenvbool("QBnd__HALF") ; 
+
 /**
 QBnd::MakeInstance
 ---------------------
 
-static method used from QBnd::QBnd using the bnd array spec names
+static method used from QBnd::init using the bnd array spec names,
+one of tex or htex is expected. The compact line index and half
+scales are set by QBnd::init.
 
 **/
 
-qbnd* QBnd::MakeInstance(const QTex<float4>* tex, const std::vector<std::string>& names )
+qbnd* QBnd::MakeInstance(const QTex<float4>* tex, const QTex<ushort4>* htex, const std::vector<std::string>& names )
 {
     qbnd* qb = new qbnd ; 
 
-    qb->boundary_tex = tex->texObj ; 
-    qb->boundary_meta = tex->d_meta ; 
+    qb->boundary_tex = htex ? htex->texObj : tex->texObj ; 
+    qb->boundary_meta = htex ? htex->d_meta : tex->d_meta ; 
+    qb->boundary_line = nullptr ; 
+    qb->boundary_scale = nullptr ; 
     qb->boundary_tex_MaterialLine_Water = SBnd::GetMaterialLine("Water", names) ; 
     qb->boundary_tex_MaterialLine_LS    = SBnd::GetMaterialLine("LS", names) ; 
 
@@ -81,23 +90,88 @@ QBnd::QBnd(const NP* buf)
     dsrc(buf->ebyte == 8 ? buf : nullptr),
     src(NP::MakeNarrowIfWide(buf)),
     sbn(new SBnd(src)),
-    tex(MakeBoundaryTex(src)),
-    qb(MakeInstance(tex, buf->names)),
+    line(nullptr),
+    csrc(nullptr),
+    hsrc(nullptr),
+    hscale(nullptr),
+    hdec(nullptr),
+    tex(nullptr),
+    htex(nullptr),
+    qb(nullptr),
     d_qb(nullptr)
 {
     init(); 
 } 
 
+/**
+QBnd::init
+------------
+
+1. with QBnd__COMPACT replace the texture source with its unique lines
+2. with QBnd__HALF encode the texture source into scaled half
+3. create the texture and qbnd instance, uploading line index and scales
+
+**/
+
 void QBnd::init()
 {
     INSTANCE = this ; 
+
+    const NP* tsrc = src ; 
+    if( COMPACT )
+    {
+        csrc = SBnd::MakeCompact(src, line) ; 
+        tsrc = csrc ; 
+    }
+
+    if( HALF )
+    {
+        hsrc = SBnd::MakeHalf(tsrc, hscale) ; 
+        hdec = shalf::Decode(hsrc) ;  
+        htex = MakeBoundaryTexHalf(hsrc, hdec) ; 
+    }
+    else
+    {
+        tex = MakeBoundaryTex(tsrc) ; 
+    }
+
+    qb = MakeInstance(tex, htex, src->names) ; 
+
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
+    qb->boundary_line = line ? line->values<int>() : nullptr ; 
+    qb->boundary_scale = hscale ? (float4*)hscale->values<float>() : nullptr ; 
     d_qb = qb ;  
 #else
+    if(line) qb->boundary_line = QU::UploadArray<int>(line->cvalues<int>(), line->num_values(), "QBnd::init/boundary_line" ) ; 
+    if(hscale) qb->boundary_scale = (float4*)QU::UploadArray<float>(hscale->cvalues<float>(), hscale->num_values(), "QBnd::init/boundary_scale" ) ; 
     d_qb = QU::UploadArray<qbnd>(qb,1,"QBnd::QBnd/d_qb") ; 
+    LOG(LEVEL) << desc() ; 
 #endif
 }
 
+const NP* QBnd::getTexSrc() const { return csrc ? csrc : src ; }
+unsigned QBnd::getTexWidth() const {  return htex ? htex->width : tex->width ; }
+unsigned QBnd::getTexHeight() const { return htex ? htex->height : tex->height ; }
+
+/**
+QBnd::getLineHeight
+---------------------
+
+Number of 2*line+k rows addressed by qbnd::boundary_lookup(ix,iy),
+the same as the texture height unless compacted. 
+
+**/
+
+unsigned QBnd::getLineHeight() const 
+{
+    return src->shape[0]*src->shape[1]*src->shape[2] ; 
+}
+
+size_t QBnd::getTexBytes() const 
+{
+    return htex ? htex->width*htex->height*sizeof(ushort4) : tex->width*tex->height*sizeof(float4) ; 
+}
+
 
 /**
 QBnd::MakeBoundaryTex
@@ -159,7 +233,54 @@ QTex<float4>* QBnd::MakeBoundaryTex(const NP* buf )   // static
     bool normalizedCoords = true ; 
 
     QTex<float4>* btex = new QTex<float4>(nx, ny, values, filterMode, normalizedCoords, buf ) ; 
+    SetDomainX(btex, buf); 
+    return btex ; 
+}
+
+/**
+QBnd::MakeBoundaryTexHalf
+---------------------------
+
+hbuf is the uint16 half encoding from SBnd::MakeHalf with the shape of
+the float buf, hdec is its float decode which is only used by MOCK_TEXTURE 
+to return what the texture unit would. 
+
+**/
+
+QTex<ushort4>* QBnd::MakeBoundaryTexHalf(const NP* hbuf, const NP* hdec )   // static 
+{
+    assert( hbuf->ebyte == 2 && hbuf->shape.size() == 5 && hbuf->shape[4] == 4 );  
+
+    unsigned nx = hbuf->shape[3] ; 
+    unsigned ny = hbuf->shape[0]*hbuf->shape[1]*hbuf->shape[2] ;   
+
+    const uint16_t* values = hbuf->cvalues<uint16_t>(); 
+
+    char filterMode = 'L' ; 
+    bool normalizedCoords = true ; 
+
+#if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
+    const NP* a = hdec ; 
+#else
+    const NP* a = hbuf ; 
+#endif
+
+    QTex<ushort4>* btex = new QTex<ushort4>(nx, ny, values, filterMode, normalizedCoords, a ) ; 
+    SetDomainX(btex, hbuf); 
+    return btex ; 
+}
+
+/**
+QBnd::SetDomainX
+------------------
+
+Sets the wavelength domain from buf metadata into the texture meta and uploads it 
 
+**/
+
+template<typename T>
+void QBnd::SetDomainX(QTex<T>* btex, const NP* buf )   // static 
+{
     bool buf_has_meta = buf->has_meta() ;
 
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
@@ -190,8 +311,6 @@ QTex<float4>* QBnd::MakeBoundaryTex(const NP* buf )   // static
 
     btex->setMetaDomainX(&domainX); 
     btex->uploadMeta(); 
-
-    return btex ; 
 }
 
 std::string QBnd::desc() const
@@ -201,7 +320,13 @@ std::string QBnd::desc() const
        << " src " << ( src ? src->desc() : "-" )
        << " tex " << ( tex ? tex->desc() : "-" )
        << " tex " << tex 
+       << " htex " << ( htex ? htex->desc() : "-" )
+       << " COMPACT " << ( COMPACT ? "Y" : "N" )
+       << " HALF " << ( HALF ? "Y" : "N" )
+       << " tex_bytes " << getTexBytes()
+       << " full_bytes " << src->shape[0]*src->shape[1]*src->shape[2]*src->shape[3]*sizeof(float4)
        ; 
+    if(csrc) ss << " " << SBnd::DescCompact(src, csrc) ; 
     std::string str = ss.str(); 
     return str ; 
 }
@@ -243,10 +368,20 @@ void QBnd::ConfigureLaunch( dim3& numBlocks, dim3& threadsPerBlock, int width, i
     numBlocks.z = 1 ; 
 }
 
+/**
+QBnd::lookup
+--------------
+
+Looks up every texel and returns them in the src layout, 
+applying the half row scales and expanding compacted rows
+back to all lines so the result is comparable with src. 
+
+**/
+
 NP* QBnd::lookup() const 
 {
-    unsigned width = tex->width ; 
-    unsigned height = tex->height ; 
+    unsigned width = getTexWidth() ; 
+    unsigned height = getTexHeight() ; 
     unsigned num_lookup = width*height ; 
 
     NP* out = NP::Make<float>(height, width, 4 ); 
@@ -254,6 +389,32 @@ NP* QBnd::lookup() const
     quad* out_ = (quad*)out->values<float>(); 
     lookup( out_ , num_lookup, width, height ); 
 
+    if( hscale )
+    {
+        const float* sc = hscale->cvalues<float>() ; 
+        float* oo = out->values<float>() ; 
+        for(unsigned iy=0 ; iy < height ; iy++)
+        for(unsigned ix=0 ; ix < width ; ix++)
+        for(unsigned m=0 ; m < 4 ; m++) oo[(iy*width+ix)*4+m] *= sc[iy*4+m] ; 
+    }
+
+    if( line )
+    {
+        unsigned line_height = getLineHeight() ; 
+        NP* full = NP::Make<float>(line_height, width, 4 ); 
+        const int* lr = line->cvalues<int>() ; 
+        const float* oo = out->cvalues<float>() ; 
+        float* ff = full->values<float>() ; 
+        size_t row_values = width*4 ; 
+        for(unsigned iy=0 ; iy < line_height ; iy++)
+        {
+            unsigned ry = _BOUNDARY_NUM_FLOAT4*lr[iy/_BOUNDARY_NUM_FLOAT4] + iy % _BOUNDARY_NUM_FLOAT4 ; 
+            memcpy( ff + iy*row_values, oo + ry*row_values, row_values*sizeof(float) ); 
+        }
+        delete out ; 
+        out = full ; 
+    }
+
     out->reshape(src->shape); 
 
     return out ; 
@@ -264,6 +425,9 @@ NPFold* QBnd::serialize() const
     NPFold* f = new NPFold ; 
     f->add("src", src ); 
     f->add("dst", lookup() ); 
+    if(line) f->add("line", line ); 
+    if(csrc) f->add("csrc", csrc ); 
+    if(hscale) f->add("hscale", hscale ); 
     return f ; 
 }
 
@@ -305,11 +469,13 @@ extern "C" void QBnd_lookup_0(
 
 void QBnd::lookup( quad* lookup, int num_lookup, int width, int height ) const 
 {
-    if( tex->d_meta == nullptr )
+    if( tex && tex->d_meta == nullptr )
     {
         tex->uploadMeta();    // TODO: not a good place to do this, needs to be more standard
     }
-    assert( tex->d_meta != nullptr && "must QTex::uploadMeta() before lookups" );
+    cudaTextureObject_t texObj = htex ? htex->texObj : tex->texObj ; 
+    quad4* d_meta = htex ? htex->d_meta : tex->d_meta ; 
+    assert( d_meta != nullptr && "must QTex::uploadMeta() before lookups" );
 
 
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
@@ -317,7 +483,7 @@ void QBnd::lookup( quad* lookup, int num_lookup, int width, int height ) const
     std::cout << "QBnd::lookup MISSING MOCK IMPL " << std::endl ; 
     quad* d_lookup  = lookup ; 
 
-    QBnd_lookup_0_MOCK(tex->texObj, tex->d_meta, d_lookup, num_lookup, width, height );  
+    QBnd_lookup_0_MOCK(texObj, d_meta, d_lookup, num_lookup, width, height );  
 
 #else
 
@@ -333,7 +499,7 @@ void QBnd::lookup( quad* lookup, int num_lookup, int width, int height ) const
     quad* d_lookup  ;  
     QUDA_CHECK( cudaMalloc(reinterpret_cast<void**>( &d_lookup ), size )); 
 
-    QBnd_lookup_0(numBlocks, threadsPerBlock, tex->texObj, tex->d_meta, d_lookup, num_lookup, width, height );  
+    QBnd_lookup_0(numBlocks, threadsPerBlock, texObj, d_meta, d_lookup, num_lookup, width, height );  
 
     QUDA_CHECK( cudaMemcpy(reinterpret_cast<void*>(lookup), d_lookup, size, cudaMemcpyDeviceToHost )); 
     QUDA_CHECK( cudaFree(d_lookup) ); 
@@ -14,6 +14,21 @@ in order to facilitate reuse from eg U4Recorder.
 * anything data preparation related that is not using CUDA should be down in sysrap
 
 
+Compact and half textures
+---------------------------
+
+QBnd__COMPACT
+    texture holds only the unique lines of the bnd array, with a line to row
+    index uploaded alongside, see SBnd::MakeCompact and qbnd.h
+
+QBnd__HALF
+    texture is IEEE half float4 with per row power of two scales,
+    see SBnd::MakeHalf, halving texture memory at relative precision 2^-11
+
+Both keep the linear filtering over the uniform wavelength domain,
+so lookups go through the same qbnd::boundary_lookup.
+
+
 TODO: consider combine QBnd and QOptical into QOpticalBnd or incorporating 
       QOptical within QBnd as bnd and optical are so closely related 
       and require coordinated changes when adding dynamic boundaries
@@ -33,6 +48,7 @@ TODO: consider combine QBnd and QOptical into QOpticalBnd or incorporating
 
 union quad ; 
 struct float4 ; 
+struct ushort4 ; 
 struct dim3 ; 
 struct qbnd ; 
 
@@ -50,13 +66,23 @@ struct QUDARAP_API QBnd
     static const QBnd*          INSTANCE ; 
     static const QBnd*          Get(); 
 
-    static qbnd* MakeInstance(const QTex<float4>* tex, const std::vector<std::string>& names ); 
+    static const bool COMPACT ; 
+    static const bool HALF ; 
+
+    static qbnd* MakeInstance(const QTex<float4>* tex, const QTex<ushort4>* htex, const std::vector<std::string>& names ); 
 
     const NP*      dsrc ;  
     const NP*      src ;  
     SBnd*          sbn ; 
 
-    QTex<float4>*  tex ; 
+    NP*            line ;    // texture row of each line, QBnd__COMPACT 
+    NP*            csrc ;    // unique lines of src, QBnd__COMPACT  
+    NP*            hsrc ;    // half encoded texture source, QBnd__HALF
+    NP*            hscale ;  // scale of each texture row, QBnd__HALF 
+    NP*            hdec ;    // float decode of hsrc, the values the texture fetches return before scaling
+
+    QTex<float4>*  tex ;     // nullptr with QBnd__HALF
+    QTex<ushort4>* htex ;    // nullptr without QBnd__HALF
 
     qbnd*          qb ;    // formerly bnd 
     qbnd*          d_qb ;  // formerly d_bnd
@@ -66,7 +92,15 @@ struct QUDARAP_API QBnd
 
     std::string desc() const ; 
 
+    const NP* getTexSrc() const ; 
+    unsigned  getTexWidth() const ; 
+    unsigned  getTexHeight() const ; 
+    unsigned  getLineHeight() const ; 
+    size_t    getTexBytes() const ; 
+
+    template<typename T> static void SetDomainX(QTex<T>* btex, const NP* buf ); 
     static QTex<float4>* MakeBoundaryTex(const NP* buf ) ;
+    static QTex<ushort4>* MakeBoundaryTexHalf(const NP* hbuf, const NP* hdec ) ;
     static void ConfigureLaunch( dim3& numBlocks, dim3& threadsPerBlock, int width, int height );
     static std::string DescLaunch( const dim3& numBlocks, const dim3& threadsPerBlock, int width, int height ); 
 
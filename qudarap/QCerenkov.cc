@@ -1,13 +1,16 @@
 #include <sstream>
+#include <cstring>
 #include <algorithm>
 #include <cuda_runtime.h>
 
 #include "SLOG.hh"
+#include "ssys.h"
 #include "spath.h"
 #include "scuda.h"
 #include "squad.h"
 #include "sphoton.h"
 #include "scerenkov.h"
+#include "scerenkov_icdf.h"
 
 #include "qrng.h"
 #include "qcerenkov.h"
@@ -33,6 +36,7 @@ const QCerenkov* QCerenkov::Get(){ return INSTANCE ;  }
 
 
 const char* QCerenkov::DEFAULT_FOLD = "$TMP/QCerenkovIntegralTest/test_makeICDF_SplitBin" ; 
+const char* QCerenkov::MODE = ssys::getenvvar(_QCerenkov__MODE, "bndtex") ; 
 
 NP* QCerenkov::Load(const char* fold, const char* name)  // static
 {
@@ -56,6 +60,49 @@ QTex<float4>* QCerenkov::MakeTex(const NP* icdf, char filterMode, bool normalize
     return tex ; 
 }
 
+/**
+QCerenkov::Mode
+-----------------
+
+QCerenkov__MODE envvar selects the wavelength sampling of qcerenkov::generate
+
+bndtex
+    rejection sampling of RINDEX from the boundary texture (default)
+icdf
+    lookup from 2D (BetaInverse, u) ICDF tables built from the boundary
+    RINDEX by scerenkov_icdf, fixed per-photon cost
+
+**/
+
+unsigned QCerenkov::Mode() // static
+{
+    return strcmp(MODE, "icdf") == 0 ? qcerenkov::ICDF : qcerenkov::BNDTEX ; 
+}
+
+/**
+QCerenkov::MakeICDFTable
+--------------------------
+
+Only built when the icdf mode is configured. The table resolution can be
+changed with envvars QCerenkov__ICDF_NB (BetaInverse rows per material)
+and QCerenkov__ICDF_NU (u columns), the defaults keep the energy
+distribution within chi2 of the rejection sampling down to close to threshold.
+
+**/
+
+scerenkov_icdf* QCerenkov::MakeICDFTable() // static
+{
+    if( Mode() != qcerenkov::ICDF ) return nullptr ; 
+    const QBnd* bnd = QBnd::Get(); 
+    assert( bnd );  
+    int nb = ssys::getenvint("QCerenkov__ICDF_NB", scerenkov_icdf::NB ); 
+    int nu = ssys::getenvint("QCerenkov__ICDF_NU", scerenkov_icdf::NU ); 
+    scerenkov_icdf* table = scerenkov_icdf::Create( bnd->src, nb, nu ); 
+    LOG_IF(fatal, table == nullptr) << " failed to create icdf table from bnd " << ( bnd->src ? bnd->src->sstr() : "-" ) ; 
+    LOG_IF(LEVEL, table) << table->desc() ; 
+    return table ; 
+}
+
 /**
 QCerenkov::MakeInstance
 ------------------------
@@ -63,9 +110,11 @@ QCerenkov::MakeInstance
 QProp was assuming a saved GGeo and IDPath and access to "$IDPath/GScintillatorLib/LS_ori/RINDEX.npy"
 see GGeo::convertSim_Prop
 
+Without the icdf table the mode falls back to BNDTEX. 
+
 **/
 
-qcerenkov* QCerenkov::MakeInstance() // static 
+qcerenkov* QCerenkov::MakeInstance(const scerenkov_icdf* icdf_table, const QTex<float4>* icdf_tex ) // static 
 {
     const QBase* base = QBase::Get(); 
     assert( base );  
@@ -80,6 +129,17 @@ qcerenkov* QCerenkov::MakeInstance() // static
     ck->base = base->d_base ;  
     ck->bnd = bnd->d_qb ;  
     ck->prop = prop ? prop->d_prop : nullptr ; 
+
+    bool with_icdf = icdf_table && icdf_tex ; 
+    ck->mode = with_icdf ? qcerenkov::ICDF : qcerenkov::BNDTEX ; 
+    ck->icdf_tex = with_icdf ? icdf_tex->texObj : 0 ; 
+    ck->icdf_dom = with_icdf ? (float4*)QU::UploadArray<float>( icdf_table->dom->cvalues<float>(), icdf_table->dom->num_values(), "QCerenkov::MakeInstance/icdf_dom" ) : nullptr ; 
+    ck->icdf_slot = with_icdf ? QU::UploadArray<int>( icdf_table->slot->cvalues<int>(), icdf_table->slot->num_values(), "QCerenkov::MakeInstance/icdf_slot" ) : nullptr ; 
+    ck->icdf_num_line = with_icdf ? icdf_table->slot->num_values() : 0 ; 
+    ck->icdf_num_slot = with_icdf ? icdf_table->num_slot() : 0 ; 
+    ck->icdf_nb = with_icdf ? icdf_table->nb : 0 ; 
+    ck->icdf_nu = with_icdf ? icdf_table->nu : 0 ; 
+
     return ck ; 
 }
 
@@ -104,7 +164,9 @@ QCerenkov::QCerenkov(const char* fold_ )
     normalizedCoords(true), 
     tex(nullptr),
     look(nullptr),
-    cerenkov(MakeInstance()),
+    icdf_table(MakeICDFTable()),
+    icdf_tex(icdf_table && icdf_table->num_slot() > 0 ? QTexMaker::Make2d_f4(icdf_table->icdf, 'L', true) : nullptr),
+    cerenkov(MakeInstance(icdf_table, icdf_tex)),
     d_cerenkov(QU::UploadArray<qcerenkov>(cerenkov, 1, "QCerenkov::QCerenkov/d_cerenkov.1"))
 {
     init(); 
@@ -119,7 +181,9 @@ QCerenkov::QCerenkov()
     normalizedCoords(true),
     tex(nullptr),
     look(nullptr),
-    cerenkov(MakeInstance()),
+    icdf_table(MakeICDFTable()),
+    icdf_tex(icdf_table && icdf_table->num_slot() > 0 ? QTexMaker::Make2d_f4(icdf_table->icdf, 'L', true) : nullptr),
+    cerenkov(MakeInstance(icdf_table, icdf_tex)),
     d_cerenkov(QU::UploadArray<qcerenkov>(cerenkov, 1,"QCerenkov::QCerenkov/d_cerenkov.0"))
 {
     init(); 
@@ -188,6 +252,8 @@ std::string QCerenkov::desc() const
        << " icdf_ " << ( icdf_ ? icdf_->sstr() : "-" )
        << " icdf " << ( icdf ? icdf->sstr() : "-" )
        << " tex " << tex 
+       << " MODE " << MODE 
+       << " icdf_table " << ( icdf_table ? icdf_table->desc() : "-" )
        ; 
 
     std::string s = ss.str(); 
@@ -29,6 +29,7 @@ ana/rindex.py
 
 struct float4 ; 
 struct qcerenkov ; 
+struct scerenkov_icdf ; 
 
 struct NP ; 
 template <typename T> struct QTex ; 
@@ -44,7 +45,12 @@ struct QUDARAP_API QCerenkov
     static NP*                  Load(const char* fold, const char* name) ; 
     static QTex<float4>*        MakeTex(const NP* icdf, char filterMode, bool normalizedCoords) ; 
 
-    static qcerenkov* MakeInstance(); 
+    static constexpr const char* _QCerenkov__MODE = "QCerenkov__MODE" ; 
+    static const char*          MODE ;    // "bndtex" OR "icdf" 
+    static unsigned             Mode(); 
+    static scerenkov_icdf*      MakeICDFTable(); 
+
+    static qcerenkov* MakeInstance(const scerenkov_icdf* icdf_table, const QTex<float4>* icdf_tex ); 
 
     const char*             fold ; 
     const NP*               icdf_ ; 
@@ -53,6 +59,8 @@ struct QUDARAP_API QCerenkov
     bool                    normalizedCoords ; 
     QTex<float4>*           tex ; 
     QTexLookup<float4>*     look ; 
+    scerenkov_icdf*         icdf_table ; 
+    QTex<float4>*           icdf_tex ; 
     qcerenkov*              cerenkov ; 
     qcerenkov*              d_cerenkov ; 
 
@@ -44,8 +44,11 @@ extern "C" void QCurandState_curand_init_chunk(SLaunchSequence* lseq, scurandref
 
 struct QCurandState
 {
+    static constexpr const char* QCurandState__HOST = "QCurandState__HOST" ; 
     static QCurandState* Create(const char* _dir=nullptr); 
 
+    bool HOST ; 
+
     SCurandState cs = {} ;
     QCurandState(const char* _dir); 
 
@@ -66,6 +69,7 @@ inline QCurandState* QCurandState::Create(const char* _dir)
 
 inline QCurandState::QCurandState(const char* _dir)
     :
+    HOST(ssys::getenvbool(QCurandState__HOST)),
     cs(_dir)
 {
     init(); 
@@ -79,7 +83,9 @@ QCurandState::init
 Completeness means all the chunk files exist. 
 
 Outcome of instanciation is a complete set of
-chunk files. 
+chunk files. With QCurandState__HOST the missing chunks
+are generated on the CPU with SCurandState::generate,
+giving identical files without using the GPU. 
 
 **/
 
@@ -96,6 +102,13 @@ inline void QCurandState::init()
 
     if(complete) return ; 
 
+    if(HOST)
+    {
+        int num_gen = cs.generate(); 
+        assert( num_gen > -1 ); 
+        return ; 
+    }
+
     for(int i=0 ; i < num_chunk ; i++)
     {
         SCurandChunk& c = cs.chunk[i]; 
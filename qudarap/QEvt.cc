@@ -21,6 +21,7 @@
 #endif
 
 #include "sevent.h"
+#include "sseedorder.h"
 #include "salloc.h"
 #include "sstamp.h"
 #include "ssys.h"
@@ -56,12 +57,14 @@ QEvt* QEvt::INSTANCE = nullptr ;
 QEvt* QEvt::Get(){ return INSTANCE ; }
 
 const bool QEvt::SEvt_NPFold_VERBOSE  = ssys::getenvbool("QEvt__SEvt_NPFold_VERBOSE") ;
+const int QEvt::ORDER = sseedorder::Mode(ssys::getenvvar(QEvt__ORDER, sseedorder::NONE_)) ;
 
 std::string QEvt::Desc() // static
 {
     std::stringstream ss ;
     ss << "QEvt::Desc" << std::endl
        << " QEvt__SEvt_NPFold_VERBOSE     : " << ( SEvt_NPFold_VERBOSE     ? "YES" : "NO " ) << std::endl
+       << " QEvt__ORDER                   : " << sseedorder::Name(ORDER) << std::endl
        ;
 
     std::string str = ss.str();
@@ -309,6 +312,9 @@ If the number of gensteps is zero there are no photons and no launch.
    * populates seed buffer using num photons per genstep from genstep buffer,
      which is the way each photon thread refers back to its genstep
 
+   * with QEvt__ORDER (GENTYPE or GENTYPE_MATLINE) QEvt::fill_order_buffer
+     then populates the order buffer with a gentype coherent launch order
+
 5. setNumSimtrace/setInputPhoton/setNumPhoton which may allocate records
 
 
@@ -397,6 +403,8 @@ int QEvt::setGenstepUpload(const quad6* qq0, int gs_start, int gs_stop )
         LOG(LEVEL) << "[ count_genstep_photons_and_fill_seed_buffer " ;
         count_genstep_photons_and_fill_seed_buffer();   // combi-function doing what both the above do
         LOG(LEVEL) << "] count_genstep_photons_and_fill_seed_buffer " ;
+
+        if(evt->order) fill_order_buffer();
     }
     else
     {
@@ -466,6 +474,10 @@ void QEvt::device_alloc_genstep_and_seed()
     evt->seed    = QU::device_alloc<int>(   evt->max_slot   , "QEvt::setGenstep/device_alloc_genstep_and_seed:int/max_slot" )  ;
                                      //     ^^^^^^^^^^^^^^^ was max_photon but max_slot now makes more sense
 
+    if(ORDER != sseedorder::NONE)
+    {
+        evt->order = QU::device_alloc<int>( evt->max_slot, "QEvt::setGenstep/device_alloc_genstep_and_seed:int/max_slot order" ) ;
+    }
 }
 
 
@@ -625,6 +637,24 @@ void QEvt::count_genstep_photons_and_fill_seed_buffer()
     QEvt_count_genstep_photons_and_fill_seed_buffer( evt );
 }
 
+/**
+QEvt::fill_order_buffer
+-------------------------
+
+Populates the order buffer with the photon slots stable sorted by the
+gentype (and optionally matline) of their gensteps, see sseedorder.h.
+The simulate kernel maps launch index to photon slot via the order buffer,
+so warps are gentype coherent while RNG and output slots are unchanged.
+
+**/
+
+extern "C" void QEvt_fill_order_buffer(sevent* evt, int mode );
+void QEvt::fill_order_buffer()
+{
+    LOG_IF(info, LIFECYCLE) << " ORDER " << sseedorder::Name(ORDER) ;
+    QEvt_fill_order_buffer( evt, ORDER );
+}
+
 
 
 
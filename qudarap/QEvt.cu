@@ -5,10 +5,14 @@
 #include "srec.h"
 #include "sphoton.h"
 #include "sevent.h"
+#include "sseedorder.h"
 
 #include "iexpand.h"
 #include "strided_range.h"
 #include <thrust/device_vector.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
 
 /**
 _QEvt_checkEvt
@@ -238,4 +242,41 @@ extern "C" void QEvt_count_genstep_photons_and_fill_seed_buffer(sevent* evt )
 
 
 
+/**
+QEvt_fill_order_buffer
+-------------------------
+
+Invoked from QEvt::fill_order_buffer after the seed buffer is filled.
+Populates evt->order with the photon slots 0..num_seed-1 stable sorted by
+the sseedorder::Key of their gensteps. As for the above functions the
+sevent* argument is the CPU side instance holding GPU side pointers.
+
+**/
 
+struct seedorder_key_functor
+{
+    const quad6* genstep ;
+    int mode ;
+    __host__ __device__ unsigned long long operator()(int genstep_id) const { return sseedorder::Key( genstep[genstep_id], mode ) ; }
+};
+
+extern "C" void QEvt_fill_order_buffer(sevent* evt, int mode )
+{
+    assert( evt->order && evt->seed );
+
+    thrust::device_ptr<int> t_seed  = thrust::device_pointer_cast(evt->seed) ;
+    thrust::device_ptr<int> t_order = thrust::device_pointer_cast(evt->order) ;
+
+    thrust::sequence( t_order, t_order + evt->num_seed );
+    if( mode == sseedorder::NONE ) return ;
+
+    thrust::device_vector<unsigned long long> key(evt->num_seed) ;
+    seedorder_key_functor fn = { evt->genstep, mode } ;
+    thrust::transform( t_seed, t_seed + evt->num_seed, key.begin(), fn );
+
+    thrust::stable_sort_by_key( key.begin(), key.end(), t_order );
+
+#ifdef DEBUG_QEVENT
+    printf("//QEvt_fill_order_buffer evt.num_seed %d mode %d \n", evt->num_seed, mode );
+#endif
+}
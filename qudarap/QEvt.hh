@@ -81,6 +81,8 @@ struct QUDARAP_API QEvt : public SCompProvider
     static QEvt* INSTANCE ;
     static QEvt* Get();
     static const bool SEvt_NPFold_VERBOSE ;
+    static constexpr const char* QEvt__ORDER = "QEvt__ORDER" ;
+    static const int ORDER ;
     static std::string Desc();
 
 
@@ -138,6 +140,7 @@ private:
     unsigned count_genstep_photons();
     void     fill_seed_buffer();
     void     count_genstep_photons_and_fill_seed_buffer();
+    void     fill_order_buffer();
 
 public:
     // who uses these ? TODO: switch to comp based
@@ -102,6 +102,7 @@ inline void QPMT<T>::init()
     init_thickness();
     init_lcqs();
     init_s_qescale();
+    init_art_table();
 
 #if defined(MOCK_CURAND) || defined(MOCK_CUDA)
     d_pmt = pmt ;
@@ -180,6 +181,60 @@ inline void QPMT<T>::init_s_qescale()
     pmt->s_qescale = d_s_qescale ;
 }
 
+/**
+QPMT::init_art_table
+----------------------
+
+When SPMT provided the tabulated TMM arrays (SPMT__ART_TABLE) they are
+uploaded and qpmt::get_lpmtid_ATQC interpolates them instead of doing
+the multi-layer stack calculation for every photon, other than in the
+cells near the critical angle flagged by the optional fbk_table.
+
+**/
+
+template<typename T>
+inline void QPMT<T>::init_art_table()
+{
+    bool with_table = art_table && esc_table ;
+    LOG(LEVEL)
+       << " art_table " << ( art_table ? art_table->sstr() : "-" )
+       << " esc_table " << ( esc_table ? esc_table->sstr() : "-" )
+       << " fbk_table " << ( fbk_table ? fbk_table->sstr() : "-" )
+       << " max_err " << ( art_table ? art_table->get_meta<double>("max_err", -1.) : -1. )
+       << " fbk_fraction " << ( art_table ? art_table->get_meta<double>("fbk_fraction", -1.) : -1. )
+       ;
+    if(!with_table) return ;
+
+    int nwl = art_table->get_meta<int>("nwl", 0) ;
+    int nct = art_table->get_meta<int>("nct", 0) ;
+    double wl0 = art_table->get_meta<double>("wl0", 0.) ;
+    double wl1 = art_table->get_meta<double>("wl1", 0.) ;
+
+    bool expect = art_table->has_shape(s_pmt::NUM_CAT, 2, nwl, nct, 4) && esc_table->has_shape(s_pmt::NUM_CAT, nwl) && nwl > 1 && nct > 1 && wl1 > wl0 ;
+    expect &= fbk_table == nullptr || ( fbk_table->uifc == 'u' && fbk_table->ebyte == 1 && fbk_table->has_shape(s_pmt::NUM_CAT, 2, nwl-1, nct-1) ) ;
+    LOG_IF(fatal, !expect) << " unexpected art_table/esc_table shape or metadata " ;
+    assert( expect );
+    if(!expect) std::raise(SIGINT);
+
+#if defined(MOCK_CURAND) || defined(MOCK_CUDA)
+    T* d_art_table = const_cast<T*>(art_table->cvalues<T>()) ;
+    T* d_esc_table = const_cast<T*>(esc_table->cvalues<T>()) ;
+    unsigned char* d_fbk_table = fbk_table ? const_cast<unsigned char*>(fbk_table->cvalues<unsigned char>()) : nullptr ;
+#else
+    T* d_art_table = QU::UploadArray<T>(art_table->cvalues<T>(), art_table->num_values(), "QPMT::init_art_table/d_art_table") ;
+    T* d_esc_table = QU::UploadArray<T>(esc_table->cvalues<T>(), esc_table->num_values(), "QPMT::init_art_table/d_esc_table") ;
+    unsigned char* d_fbk_table = fbk_table ? QU::UploadArray<unsigned char>(fbk_table->cvalues<unsigned char>(), fbk_table->num_values(), "QPMT::init_art_table/d_fbk_table") : nullptr ;
+#endif
+
+    pmt->art_table = d_art_table ;
+    pmt->esc_table = d_esc_table ;
+    pmt->fbk_table = d_fbk_table ;
+    pmt->art_nwl = nwl ;
+    pmt->art_nct = nct ;
+    pmt->art_wl0 = wl0 ;
+    pmt->art_inv_dwl = double(nwl-1)/(wl1 - wl0) ;
+}
+
 
 
 
@@ -75,6 +75,13 @@ struct QUDARAP_API QPMT
 
     const NP* s_qescale ;
 
+    const NP* src_art_table ; // optional (NUM_PMTCAT, 2, NWL, NCT, 4:[A_s,A_p,R_s,R_p]) see stmm_table.h
+    const NP* src_esc_table ; // optional (NUM_PMTCAT, NWL)
+    const NP* src_fbk_table ; // optional (NUM_PMTCAT, 2, NWL-1, NCT-1) uint8 cells using the stack calculation
+    const NP* art_table ;
+    const NP* esc_table ;
+    const NP* fbk_table ;
+
 
     qpmt<T>* pmt ;
     qpmt<T>* d_pmt ;
@@ -88,6 +95,7 @@ struct QUDARAP_API QPMT
     void init_thickness();
     void init_lcqs();
     void init_s_qescale();
+    void init_art_table();
 
     // .h
     NPFold* serialize() const ;  // formerly get_fold
@@ -133,6 +141,7 @@ QPMT::QPMT
 5. creates cetheta_prop from cetheta
 5. narrows src_thickness into thickness
 6. narrows src_lcqs into lcqs
+7. narrows optional art_table, esc_table from SPMT::make_art_table
 
 NB the jpmt argument is the NPFold provided by SPMT::CreateFromJPMTAndSerialize
 not the raw fold from _PMTSimParamData. So all the data preparation done
@@ -167,6 +176,12 @@ inline QPMT<T>::QPMT(const NPFold* jpmt )
     s_qeshape(   NP::MakeWithType<T>(src_s_qeshape)), // adopt template type, potentially narrowing
     s_qeshape_prop(new QProp<T>(s_qeshape)),
     s_qescale(src_s_qescale ? NP::MakeWithType<T>(src_s_qescale) : nullptr),
+    src_art_table(jpmt->get("art_table")),
+    src_esc_table(jpmt->get("esc_table")),
+    src_fbk_table(jpmt->get("fbk_table")),
+    art_table(src_art_table ? NP::MakeWithType<T>(src_art_table) : nullptr),
+    esc_table(src_esc_table ? NP::MakeWithType<T>(src_esc_table) : nullptr),
+    fbk_table(src_fbk_table ? src_fbk_table->copy() : nullptr),
     pmt(new qpmt<T>()),                    // host-side qpmt.h instance
     d_pmt(nullptr)                         // device-side pointer set at upload in init
 {
@@ -202,6 +217,10 @@ inline NPFold* QPMT<T>::serialize() const  // formerly get_fold
     fold->add("s_qeshape_prop_a", s_qeshape_prop->a );
     fold->add("s_qescale", s_qescale );
 
+    if(art_table) fold->add("art_table", art_table );
+    if(esc_table) fold->add("esc_table", esc_table );
+    if(fbk_table) fold->add("fbk_table", fbk_table );
+
     return fold ;
 }
 
@@ -221,12 +240,16 @@ inline std::string QPMT<T>::desc() const
        << std::setw(w) << "lcqs " << lcqs->sstr() << std::endl
        << std::setw(w) << "s_qeshape " << s_qeshape->sstr() << std::endl
        << std::setw(w) << "s_qescale " << s_qescale->sstr() << std::endl
+       << std::setw(w) << "art_table " << ( art_table ? art_table->sstr() : "-" ) << std::endl
+       << std::setw(w) << "esc_table " << ( esc_table ? esc_table->sstr() : "-" ) << std::endl
+       << std::setw(w) << "fbk_table " << ( fbk_table ? fbk_table->sstr() : "-" ) << std::endl
        << std::setw(w) << " pmt.rindex_prop " << pmt->rindex_prop  << std::endl
        << std::setw(w) << " pmt.qeshape_prop " << pmt->qeshape_prop  << std::endl
        << std::setw(w) << " pmt.cetheta_prop " << pmt->cetheta_prop  << std::endl
        << std::setw(w) << " pmt.cecosth_prop " << pmt->cecosth_prop  << std::endl
        << std::setw(w) << " pmt.thickness " << pmt->thickness  << std::endl
        << std::setw(w) << " pmt.lcqs " << pmt->lcqs  << std::endl
+       << std::setw(w) << " pmt.art_table " << pmt->art_table  << std::endl
        << std::setw(w) << " d_pmt " << d_pmt   << std::endl
        ;
     std::string s = ss.str();
@@ -1,4 +1,6 @@
+#include <cmath>
 #include "NP.hh"
+#include "ssys.h"
 
 #if defined(MOCK_CURAND)
 #include "plog/Severity.h"
@@ -28,6 +30,210 @@ const QProp<T>* QProp<T>::INSTANCE = nullptr ;
 template<typename T>
 const QProp<T>* QProp<T>::Get(){ return INSTANCE ; }
 
+template<typename T>
+const double QProp<T>::RESAMPLE_TOL = ssys::getenvdouble("QProp__RESAMPLE_TOL", 0. ) ;
+
+template<typename T>
+const char QProp<T>::RESAMPLE_MODE = ssys::getenvvar("QProp__RESAMPLE_MODE", "A" )[0] ;
+
+template<typename T>
+const unsigned QProp<T>::RESAMPLE_MAX_N = ssys::getenvunsigned("QProp__RESAMPLE_MAX_N", 4096 ) ;
+
+
+/**
+QProp::Eval
+-------------
+
+Host equivalent of qprop::interpolate_search for one property
+with *ni* (domain, value) pairs.
+
+**/
+
+template<typename T>
+T QProp<T>::Eval(const T* vv, int ni, T x ) // static
+{
+    int lo = 0 ;
+    int hi = ni-1 ;
+    if( x <= vv[2*lo+0] ) return vv[2*lo+1] ;
+    if( x >= vv[2*hi+0] ) return vv[2*hi+1] ;
+    while (lo < hi-1)
+    {
+        int mi = (lo+hi)/2;
+        if (x < vv[2*mi+0]) hi = mi ;
+        else lo = mi;
+    }
+    T dy = vv[2*hi+1] - vv[2*lo+1] ;
+    T dx = vv[2*hi+0] - vv[2*lo+0] ;
+    return vv[2*lo+1] + dy*(x-vv[2*lo+0])/dx ;
+}
+
+/**
+QProp::ResampleError
+----------------------
+
+Samples the property at *n* uniform or log-uniform points across its domain
+into *yy* and returns the maximum absolute deviation of the interpolated
+samples from the original property, evaluated at the original knots and
+the midpoints of original and resampled bins. For uniform resampling
+that is the exact maximum as both are piecewise linear in x.
+
+**/
+
+template<typename T>
+double QProp<T>::ResampleError(const T* vv, int ni, int mode, int n, std::vector<T>& yy, T& x0, T& inv_dx ) // static
+{
+    bool lg = mode == qprop<T>::LOG_UNIFORM ;
+    double xa = vv[0] ;
+    double xb = vv[2*(ni-1)] ;
+    double ua = lg ? std::log(xa) : xa ;
+    double ub = lg ? std::log(xb) : xb ;
+    double du = (ub - ua)/double(n-1) ;
+
+    yy.resize(n) ;
+    for(int j=0 ; j < n ; j++)
+    {
+        double X = ua + du*double(j) ;
+        yy[j] = Eval( vv, ni, T(lg ? std::exp(X) : X) ) ;
+    }
+    x0 = ua ;
+    inv_dx = 1./du ;
+
+    auto g = [&](double x) -> double
+    {
+        double f = ( (lg ? std::log(x) : x) - ua )/du ;
+        if( f <= 0. ) return yy[0] ;
+        if( f >= double(n-1) ) return yy[n-1] ;
+        int i = int(f) ;
+        double t = f - double(i) ;
+        return yy[i] + t*(double(yy[i+1]) - double(yy[i])) ;
+    };
+
+    double err = 0. ;
+    for(int k=0 ; k < ni ; k++)
+    {
+        err = std::max( err, std::abs( g(vv[2*k]) - double(vv[2*k+1]) ) );
+        if( k == ni - 1 ) continue ;
+        double xm = 0.5*( double(vv[2*k]) + double(vv[2*k+2]) ) ;
+        err = std::max( err, std::abs( g(xm) - double(Eval(vv, ni, T(xm))) ) );
+    }
+    for(int j=0 ; j < n-1 ; j++)
+    {
+        double X = ua + du*(double(j) + 0.5) ;
+        double xm = lg ? std::exp(X) : X ;
+        err = std::max( err, std::abs( g(xm) - double(Eval(vv, ni, T(xm))) ) );
+    }
+    return err ;
+}
+
+/**
+QProp::Resample
+-----------------
+
+For each property of the combined array *a* finds the fewest samples
+n <= max_n, by doubling then bisection, for which the resampled
+interpolation deviates by no more than tol*max(|value|).
+mode 'U' uniform, 'L' log-uniform (positive domains only) or 'A' whichever
+needs fewer samples. Properties with fewer than two values or that
+do not reach the tolerance get mode NONE and keep using the binary search.
+
+Returns array of shape (ni, UHEAD + max_samples) in the layout described in
+qprop.h and sets *uerr* to an array of shape (ni, 4) with
+(n, mode, max_abs_err, max_rel_err) for each property, -1 errors for NONE.
+
+**/
+
+template<typename T>
+NP* QProp<T>::Resample(const NP* a, double tol, char mode, unsigned max_n, NP** uerr ) // static
+{
+    int ni = a->shape[0] ;
+    int width = a->shape[1]*a->shape[2] ;
+    const T* pp = a->cvalues<T>() ;
+
+    NP* err = NP::Make<double>( ni, 4 ) ;
+    double* ee = err->values<double>() ;
+
+    std::vector<std::vector<T>> rows(ni) ;
+    std::vector<int>  rmode(ni, qprop<T>::NONE) ;
+    std::vector<T>    rx0(ni, 0), rinv(ni, 0) ;
+    int max_used = 1 ;
+
+    std::vector<int> modes ;
+    if( mode == 'U' || mode == 'A' ) modes.push_back( qprop<T>::UNIFORM );
+    if( mode == 'L' || mode == 'A' ) modes.push_back( qprop<T>::LOG_UNIFORM );
+
+    for(int i=0 ; i < ni ; i++)
+    {
+        const T* vv = pp + width*i ;
+        int nk = sview::int_from<T>( vv[width-1] ) ;
+        ee[i*4+0] = 0. ; ee[i*4+1] = qprop<T>::NONE ; ee[i*4+2] = -1. ; ee[i*4+3] = -1. ;
+        if( nk < 2 ) continue ;
+
+        double ymax = 0. ;
+        for(int k=0 ; k < nk ; k++) ymax = std::max( ymax, std::abs(double(vv[2*k+1])) );
+        double atol = tol*( ymax > 0. ? ymax : 1. ) ;
+
+        std::vector<T> yy ;
+        T x0, inv_dx ;
+        int best_n = 0 ;
+
+        for(int m : modes)
+        {
+            if( m == qprop<T>::LOG_UNIFORM && !(vv[0] > T(0)) ) continue ;
+
+            int lo = 1 ;
+            int n = 2 ;
+            bool ok = true ;
+            while( ResampleError(vv, nk, m, n, yy, x0, inv_dx) > atol )
+            {
+                lo = n ;
+                if( n >= int(max_n) ) { ok = false ; break ; }
+                n = std::min( 2*n, int(max_n) ) ;
+            }
+            if(!ok) continue ;
+
+            int hi = n ;
+            while( hi - lo > 1 )
+            {
+                int mid = (lo + hi)/2 ;
+                if( ResampleError(vv, nk, m, mid, yy, x0, inv_dx) <= atol ) hi = mid ;
+                else lo = mid ;
+            }
+            if( best_n == 0 || hi < best_n )
+            {
+                best_n = hi ;
+                rmode[i] = m ;
+            }
+        }
+        if( best_n == 0 ) continue ;
+
+        double e = ResampleError(vv, nk, rmode[i], best_n, rows[i], rx0[i], rinv[i] ) ;
+        ee[i*4+0] = best_n ;
+        ee[i*4+1] = rmode[i] ;
+        ee[i*4+2] = e ;
+        ee[i*4+3] = ymax > 0. ? e/ymax : e ;
+        max_used = std::max( max_used, best_n );
+    }
+
+    int uwidth = qprop<T>::UHEAD + max_used ;
+    NP* u = NP::Make<T>( ni, uwidth ) ;
+    T* uu = u->values<T>() ;
+    for(int i=0 ; i < ni ; i++)
+    {
+        T* uv = uu + uwidth*i ;
+        int n = rows[i].size() ;
+        uv[0] = rx0[i] ;
+        uv[1] = rinv[i] ;
+        uv[2] = sview::int_as<T>( n ) ;
+        uv[3] = sview::int_as<T>( rmode[i] ) ;
+        for(int j=0 ; j < n ; j++) uv[qprop<T>::UHEAD+j] = rows[i][j] ;
+    }
+    u->set_meta<double>("tol", tol );
+    u->set_meta<std::string>("mode", std::string(1, mode) );
+
+    if(uerr) *uerr = err ;
+    return u ;
+}
+
 template<typename T>
 qprop<T>* QProp<T>::getDevicePtr() const
 {
@@ -84,7 +290,7 @@ Instanciation:
 **/
 
 template<typename T>
-QProp<T>::QProp(const NP* a_)
+QProp<T>::QProp(const NP* a_, double resample_tol_)
     :
     a(a_ ? a_->copy() : nullptr),
     pp(a ? a->cvalues<T>() : nullptr),
@@ -92,6 +298,9 @@ QProp<T>::QProp(const NP* a_)
     ni(a ? a->shape[0] : 0 ),
     nj(a ? a->shape[1] : 0 ),
     nk(a ? a->shape[2] : 0 ),
+    resample_tol(resample_tol_),
+    u(nullptr),
+    uerr(nullptr),
     prop(new qprop<T>),
     d_prop(nullptr)
 {
@@ -118,6 +327,8 @@ void QProp<T>::init()
 #endif
     assert( type_consistent );
 
+    if( resample_tol > 0. ) u = Resample(a, resample_tol, RESAMPLE_MODE, RESAMPLE_MAX_N, &uerr );
+
     //dump();
     upload();
 }
@@ -144,12 +355,21 @@ void QProp<T>::upload()
     prop->height = ni ;
     prop->width  = nj*nk ;
 
+    prop->uwidth = u ? u->shape[1] : 0 ;
+
 #if defined(MOCK_CURAND)
     prop->pp = const_cast<T*>(pp) ;
+    prop->uu = u ? u->values<T>() : nullptr ;
     d_prop = prop ;
 #else
     prop->pp = QU::device_alloc<T>(nv,"QProp::upload/pp") ;
     QU::copy_host_to_device<T>( prop->pp, pp, nv );
+    if( u )
+    {
+        unsigned nu = u->num_values() ;
+        prop->uu = QU::device_alloc<T>(nu,"QProp::upload/uu") ;
+        QU::copy_host_to_device<T>( prop->uu, u->cvalues<T>(), nu );
+    }
     d_prop = QU::UploadArray<qprop<T>>(prop, 1, "QProp::upload/d_prop");
 #endif
 
@@ -161,6 +381,7 @@ void QProp<T>::cleanup()
 #if defined(MOCK_CURAND)
 #else
     QUDA_CHECK(cudaFree(prop->pp));
+    if(prop->uu) QUDA_CHECK(cudaFree(prop->uu));
     QUDA_CHECK(cudaFree(d_prop));
 #endif
 }
@@ -180,10 +401,47 @@ std::string QProp<T>::desc() const
        << " ni " << ni
        << " nj " << nj
        << " nk " << nk
+       << " resample_tol " << resample_tol
+       << " u " << ( u ? u->sstr() : "-" )
        ;
     return ss.str();
 }
 
+/**
+QProp::desc_resample
+----------------------
+
+Per property number of samples, mode and achieved interpolation errors.
+
+**/
+
+template<typename T>
+std::string QProp<T>::desc_resample() const
+{
+    std::stringstream ss ;
+    ss << "QProp::desc_resample"
+       << " resample_tol " << resample_tol
+       << " mode " << RESAMPLE_MODE
+       << " max_n " << RESAMPLE_MAX_N
+       << " u " << ( u ? u->sstr() : "-" )
+       << std::endl
+       ;
+    const double* ee = uerr ? uerr->cvalues<double>() : nullptr ;
+    for(unsigned i=0 ; i < ni && ee ; i++)
+    {
+        int mode = ee[i*4+1] ;
+        ss << " iprop " << std::setw(4) << i
+           << " n " << std::setw(5) << int(ee[i*4+0])
+           << " mode " << ( mode == qprop<T>::UNIFORM ? "uniform    " : ( mode == qprop<T>::LOG_UNIFORM ? "log-uniform" : "none       " ) )
+           << " max_abs_err " << std::scientific << std::setprecision(3) << ee[i*4+2]
+           << " max_rel_err " << std::scientific << std::setprecision(3) << ee[i*4+3]
+           << std::endl
+           ;
+    }
+    std::string str = ss.str();
+    return str ;
+}
+
 
 
 template<typename T>
@@ -21,6 +21,21 @@ The QProp approach is very close to what Geant4 does, the texture approach
 is likely faster but takes more effort to setup and probably requires fine
 textures to reproduce the Geant4 results. 
 
+Uniform resampling
+--------------------
+
+qprop::interpolate does a binary search of the property domain for 
+every lookup. When a resample tolerance is given (ctor argument 
+or QProp__RESAMPLE_TOL envvar) QProp::Resample also creates rows 
+of each property resampled onto uniform or log-uniform domains
+(QProp__RESAMPLE_MODE U/L/A, A:auto picks whichever needs fewer samples) 
+with the fewest samples, up to QProp__RESAMPLE_MAX_N, that keep the 
+interpolation error within tolerance*max(|value|) of the original 
+piecewise linear property. qprop then uses O(1) indexed interpolation. 
+
+The achieved error of every property is reported in the *uerr* array
+and by desc_resample. 
+
 **/
 
 #include <vector>
@@ -41,6 +56,14 @@ struct QUDARAP_API QProp
     static const QProp<T>*  INSTANCE ; 
     static const QProp<T>*  Get(); 
 
+    static const double   RESAMPLE_TOL ; 
+    static const char     RESAMPLE_MODE ; 
+    static const unsigned RESAMPLE_MAX_N ; 
+
+    static NP* Resample(const NP* a, double tol, char mode, unsigned max_n, NP** uerr ); 
+    static T   Eval(const T* vv, int ni, T x ); 
+    static double ResampleError(const T* vv, int ni, int mode, int n, std::vector<T>& yy, T& x0, T& inv_dx ); 
+
     const NP* a  ;  
     const T* pp ; 
     unsigned nv ; 
@@ -49,10 +72,14 @@ struct QUDARAP_API QProp
     unsigned nj ; 
     unsigned nk ; 
 
+    double    resample_tol ; 
+    NP*       u ;      // resampled rows (ni, uwidth) or nullptr 
+    NP*       uerr ;   // per property (n, mode, max_abs_err, max_rel_err) 
+
     qprop<T>* prop ; 
     qprop<T>* d_prop ; 
 
-    QProp(const NP* a); 
+    QProp(const NP* a, double resample_tol=RESAMPLE_TOL ); 
 
     virtual ~QProp(); 
     void init(); 
@@ -61,6 +88,7 @@ struct QUDARAP_API QProp
 
     void dump() const ; 
     std::string desc() const ;
+    std::string desc_resample() const ;
     qprop<T>* getDevicePtr() const ;
     void lookup( T* lookup, const T* domain,  unsigned num_prop, unsigned domain_width ) const ; 
     void lookup_scan(T x0, T x1, unsigned nx, const char* fold, const char* reldir=nullptr ) const ; 
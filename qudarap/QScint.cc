@@ -10,6 +10,7 @@
 #include "squad.h"
 #include "sphoton.h"
 #include "sscint.h"
+#include "sscint_icdf.h"
 
 
 #include "NP.hh"
@@ -41,23 +42,75 @@ QScint::QScint(const NP* icdf, unsigned hd_factor )
     dsrc(icdf->ebyte == 8 ? icdf : nullptr),
     src( icdf->ebyte == 4 ? icdf : NP::MakeNarrow(dsrc) ), 
     tex(MakeScintTex(src, hd_factor)),
-    scint(MakeInstance(tex)),
+    adaptive(MakeAdaptive(dsrc ? dsrc : src)),
+    atex(MakeAdaptiveTex(adaptive)),
+    d_aseg(adaptive ? QU::UploadArray<unsigned>(adaptive->seg.data(), adaptive->seg.size(), "QScint::QScint/d_aseg") : nullptr),
+    scint(MakeInstance(tex, atex, d_aseg, adaptive)),
     d_scint(QU::UploadArray<qscint>(scint, 1, "QScint::QScint/d_scint"))
 {
     INSTANCE = this ; 
 }
 
 
-qscint* QScint::MakeInstance(const QTex<float>* tex) // static 
+qscint* QScint::MakeInstance(const QTex<float>* tex, const QTex<float>* atex, unsigned* d_aseg, const sscint_icdf* adaptive) // static 
 {
     qscint* scint = new qscint ; 
     scint->scint_tex = tex->texObj ; 
     scint->scint_meta = tex->d_meta ;
     bool qscint_disable_hd = ssys::getenvbool("QSCINT_DISABLE_HD"); 
     scint->hd_factor = qscint_disable_hd ? 0u : tex->getHDFactor() ;
+
+    scint->icdf_tex = atex ? atex->texObj : 0 ; 
+    scint->icdf_seg = d_aseg ; 
+    scint->icdf_nseg = adaptive ? adaptive->nseg : 0u ; 
+    scint->icdf_inv_width = atex ? 1.f/float(atex->width) : 0.f ; 
     return scint ; 
 }
 
+/**
+QScint::MakeAdaptive
+----------------------
+
+With QSCINT_ADAPTIVE_TOL > 0 (nm) builds the adaptive packed ICDF
+from the source, which is then used by qscint::wavelength in place of
+the hd_factor texture, see sscint_icdf.h. Optional QSCINT_ADAPTIVE_NSEG
+and QSCINT_ADAPTIVE_MAX_LEVEL override the segmentation, the defaults
+allow any tolerance to be met.
+
+**/
+
+const sscint_icdf* QScint::MakeAdaptive(const NP* icdf) // static 
+{
+    double tol = ssys::getenvdouble(QSCINT_ADAPTIVE_TOL, 0.) ; 
+    if( tol <= 0. ) return nullptr ; 
+
+    int nseg = ssys::getenvint("QSCINT_ADAPTIVE_NSEG", 0 );            // 0: aligned default 
+    int max_level = ssys::getenvint("QSCINT_ADAPTIVE_MAX_LEVEL", 0 ); 
+    const sscint_icdf* adaptive = new sscint_icdf(icdf, tol, nseg, max_level) ; 
+    LOG(LEVEL) << adaptive->desc() ; 
+    LOG_IF(error, adaptive->max_error() > tol ) << " max_level reached before tolerance " << adaptive->desc() ; 
+    return adaptive ; 
+}
+
+/**
+QScint::MakeAdaptiveTex
+-------------------------
+
+Single row of packed knots, point sampled as qscint::wavelength_adaptive
+does the interpolation.
+
+**/
+
+QTex<float>* QScint::MakeAdaptiveTex(const sscint_icdf* adaptive) // static 
+{
+    if( adaptive == nullptr ) return nullptr ; 
+    NP* a = adaptive->make_tex(); 
+    unsigned nx = a->shape[1] ; 
+    QTex<float>* tx = new QTex<float>(nx, 1, a->cvalues<float>(), 'P', true, a ) ; 
+    tx->uploadMeta(); 
+    return tx ; 
+}
+
 
 std::string QScint::desc() const
 {
@@ -67,6 +120,7 @@ std::string QScint::desc() const
        << " src " << ( src ? src->desc() : "-" )
        << " tex " << ( tex ? tex->desc() : "-" )
        << " tex " << tex 
+       << " adaptive " << ( adaptive ? adaptive->desc() : "-" )
        ; 
 
     std::string s = ss.str(); 
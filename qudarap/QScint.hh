@@ -8,6 +8,7 @@ struct dim3 ;
 struct NP ; 
 template <typename T> struct QTex ; 
 struct qscint ; 
+struct sscint_icdf ; 
 
 struct QUDARAP_API QScint
 {
@@ -15,13 +16,19 @@ struct QUDARAP_API QScint
     static const QScint*        INSTANCE ; 
     static const QScint*        Get(); 
 
+    static constexpr const char* QSCINT_ADAPTIVE_TOL = "QSCINT_ADAPTIVE_TOL" ; 
     static QTex<float>* MakeScintTex(const NP* src, unsigned hd_factor);
-    static qscint* MakeInstance(const QTex<float>* tex); 
+    static const sscint_icdf* MakeAdaptive(const NP* icdf); 
+    static QTex<float>* MakeAdaptiveTex(const sscint_icdf* adaptive);
+    static qscint* MakeInstance(const QTex<float>* tex, const QTex<float>* atex, unsigned* d_aseg, const sscint_icdf* adaptive); 
 
 
     const NP*      dsrc ; 
     const NP*      src ; 
     QTex<float>*    tex ; 
+    const sscint_icdf* adaptive ;   // nullptr unless QSCINT_ADAPTIVE_TOL > 0
+    QTex<float>*    atex ; 
+    unsigned*       d_aseg ; 
     qscint*       scint ; 
     qscint*       d_scint ; 
 
@@ -7,6 +7,7 @@
 #include "sstamp.h"
 #include "spath.h"
 #include "SProf.hh"
+#include "stimeline.h"
 
 #include "SComp.h"
 #include "SEvt.hh"
@@ -45,6 +46,7 @@
 #include "QSimLaunch.hh"
 #include "QDebug.hh"
 #include "QPMT.hh"
+#include "QWavefront.hh"
 
 #include "QSim.hh"
 
@@ -277,6 +279,7 @@ QSim::QSim()
     d_sim(nullptr),
     dbg(debug_ ? debug_->dbg : nullptr),
     d_dbg(debug_ ? debug_->d_dbg : nullptr),
+    wf(nullptr),
     cx(nullptr)
 {
     LOG(LEVEL) << desc() ;
@@ -344,6 +347,7 @@ void QSim::init()
     if(MISSING_PMT)  std::raise(SIGINT);
 
     d_sim = QU::UploadArray<qsim>(sim, 1, "QSim::init.sim" );
+    wf = SEventConfig::PropagateWavefront() ? new QWavefront(d_sim) : nullptr ;
 
     INSTANCE = this ;
     LOG(LEVEL) << desc() ;
@@ -579,6 +583,7 @@ double QSim::simulate(int eventID, bool reset_)
     int64_t t_TAIL  = SProf::Add("QSim__simulate_TAIL");
 
     SProf::Write(); // per-event write, so have something in case of crash
+    stimeline::Write(); // binary timeline of the SProf::Add stamps and SEvt stages, when stimeline__WRITE
 
     LOG_IF(info, SEvt::MINTIME) << "\n"
         << SEvt::SEvt__MINTIME
@@ -959,6 +964,7 @@ std::string QSim::descComponents() const
        << " (qsim)d_sim             " << ( d_sim     ? "YES" : "NO " )  << std::endl
        << " (qdebug)dbg             " << ( dbg       ? "YES" : "NO " )  << std::endl
        << " (qdebug)d_dbg           " << ( d_dbg     ? "YES" : "NO " )  << std::endl
+       << " (QWavefront)wf          " << ( wf        ? "YES" : "NO " )  << std::endl
        ;
     std::string s = ss.str();
     return s ;
@@ -1827,11 +1833,19 @@ void QSim::multifilm_lookup_all( quad2 * sample , quad2 * result ,  unsigned wid
 
 unsigned QSim::getBoundaryTexWidth() const
 {
-    return bnd->tex->width ;
+    return bnd->getTexWidth() ;
 }
+/**
+QSim::getBoundaryTexHeight
+----------------------------
+
+Number of 2*line+k rows addressed by boundary_lookup_all, which
+stays the full height when the texture is compacted with QBnd__COMPACT.
+
+**/
 unsigned QSim::getBoundaryTexHeight() const
 {
-    return bnd->tex->height ;
+    return bnd->getLineHeight() ;
 }
 const NP* QSim::getBoundaryTexSrc() const
 {
@@ -44,6 +44,7 @@ struct QMultiFilm;
 struct QOptical ;
 struct QEvt ;
 struct QDebug ;
+struct QWavefront ;
 
 struct qdebug ;
 struct sstate ;
@@ -89,6 +90,8 @@ struct QUDARAP_API QSim
     qdebug*           dbg ;
     qdebug*           d_dbg ;
 
+    QWavefront*       wf ;    // only with OPTICKS_PROPAGATE_WAVEFRONT
+
     SSimulator*        cx ;
 
 
@@ -19,6 +19,22 @@
 #include "QTex.hh"
 
 
+#if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
+#else
+template<typename T>
+cudaChannelFormatDesc QTex<T>::ChannelDesc() // static
+{
+    return cudaCreateChannelDesc<T>() ; 
+}
+
+template<>
+cudaChannelFormatDesc QTex<ushort4>::ChannelDesc() // static
+{
+    return cudaCreateChannelDescHalf4() ;   // ushort4 holds half bits 
+}
+#endif
+
+
 template<typename T>
 QTex<T>::QTex(size_t width_, size_t height_ , const void* src_, char filterMode_, bool normalizedCoords_, const NP* a_  )
     :   
@@ -32,7 +48,7 @@ QTex<T>::QTex(size_t width_, size_t height_ , const void* src_, char filterMode_
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
 #else
     cuArray(nullptr),
-    channelDesc(cudaCreateChannelDesc<T>()),
+    channelDesc(ChannelDesc()),
 #endif
     texObj(0),
     meta(new quad4),
@@ -308,6 +324,7 @@ template struct QUDARAP_API QTex<uchar4>;
 // quell warning: type attributes ignored after type is already defined [-Wattributes]
 template struct QUDARAP_API QTex<float>;
 template struct QUDARAP_API QTex<float4>;
+template struct QUDARAP_API QTex<ushort4>;
 #pragma GCC diagnostic pop
 
 
@@ -3,6 +3,11 @@
 QTex.hh
 ========
 
+QTex<ushort4> is used for IEEE half float4 textures, the ushort4 being
+storage for the half bits with the channel description from
+cudaCreateChannelDescHalf4 so fetches return float4.
+For MOCK_TEXTURE the NP array *a* must then be the float decode.
+
 
 **/
 #include <string>
@@ -64,6 +69,7 @@ struct QUDARAP_API QTex
 
 #if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
 #else
+    static cudaChannelFormatDesc ChannelDesc(); 
     void createArray(); 
     void uploadToArray(); 
     void createTextureObject(); 
@@ -27,6 +27,7 @@
 #include "curand_kernel.h"
 #include "qrng.h"
 #include "qsim.h"
+#include "qwavefront.h"
 
 #include "qbase.h"
 #include "qprop.h"
@@ -152,6 +153,7 @@ template float*         QU::UploadArray<float>(const float* array, unsigned num_
 template double*        QU::UploadArray<double>(const double* array, unsigned num_items, const char* label) ;
 template unsigned*      QU::UploadArray<unsigned>(const unsigned* array, unsigned num_items, const char* label) ;
 template int*           QU::UploadArray<int>(const int* array, unsigned num_items, const char* label) ;
+template unsigned char* QU::UploadArray<unsigned char>(const unsigned char* array, unsigned num_items, const char* label) ;
 template quad4*         QU::UploadArray<quad4>(const quad4* array, unsigned num_items, const char* label) ;
 template sphoton*       QU::UploadArray<sphoton>(const sphoton* array, unsigned num_items, const char* label) ;
 template sphotonlite*   QU::UploadArray<sphotonlite>(const sphotonlite* array, unsigned num_items, const char* label) ;
@@ -173,6 +175,7 @@ template qdebug*        QU::UploadArray<qdebug>(const qdebug* array, unsigned nu
 template qscint*        QU::UploadArray<qscint>(const qscint* array, unsigned num_items, const char* label) ;
 template qcerenkov*     QU::UploadArray<qcerenkov>(const qcerenkov* array, unsigned num_items, const char* label) ;
 template qbase*         QU::UploadArray<qbase>(const qbase* array, unsigned num_items, const char* label) ;
+template qwavefront*    QU::UploadArray<qwavefront>(const qwavefront* array, unsigned num_items, const char* label) ;
 
 
 
@@ -343,6 +346,10 @@ template QUDARAP_API qdebug*    QU::device_alloc<qdebug>(unsigned num_items, con
 template QUDARAP_API sstate*    QU::device_alloc<sstate>(unsigned num_items, const char* label) ;
 template QUDARAP_API XORWOW*    QU::device_alloc<XORWOW>(unsigned num_items, const char* label) ;
 template QUDARAP_API Philox*    QU::device_alloc<Philox>(unsigned num_items, const char* label) ;
+#if defined(RNG_PHILITEOX)
+template QUDARAP_API PhiLiteOx* QU::device_alloc<PhiLiteOx>(unsigned num_items, const char* label) ;
+#endif
+template QUDARAP_API sctx*      QU::device_alloc<sctx>(unsigned num_items, const char* label) ;
 
 #ifndef PRODUCTION
 template QUDARAP_API srec*      QU::device_alloc<srec>(unsigned num_items, const char* label) ;
@@ -448,6 +455,11 @@ template QUDARAP_API void   QU::device_free<sphotonlite>(sphotonlite*) ;
 template QUDARAP_API void   QU::device_free<uchar4>(uchar4*) ;
 template QUDARAP_API void   QU::device_free<XORWOW>(XORWOW*) ;
 template QUDARAP_API void   QU::device_free<Philox>(Philox*) ;
+#if defined(RNG_PHILITEOX)
+template QUDARAP_API void   QU::device_free<PhiLiteOx>(PhiLiteOx*) ;
+#endif
+template QUDARAP_API void   QU::device_free<int>(int*) ;
+template QUDARAP_API void   QU::device_free<sctx>(sctx*) ;
 
 
 template<typename T>
@@ -588,6 +600,7 @@ template void QU::copy_host_to_device<quad6>(    quad6* d,    const quad6* h, un
 template void QU::copy_host_to_device<quad2>(    quad2* d,    const quad2* h, unsigned num_items);
 template void QU::copy_host_to_device<XORWOW>(   XORWOW* d,   const XORWOW* h,   unsigned num_items);
 template void QU::copy_host_to_device<Philox>(   Philox* d,   const Philox* h,   unsigned num_items);
+template void QU::copy_host_to_device<qwavefront>( qwavefront* d, const qwavefront* h, unsigned num_items);
 
 /**
 QU::NumItems
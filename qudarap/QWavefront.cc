@@ -0,0 +1,202 @@
+#include <sstream>
+#include <iomanip>
+
+#include "SLOG.hh"
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "sphotonlite.h"
+#include "srec.h"
+#include "sevent.h"
+#include "sstate.h"
+
+#include "QUDA_CHECK.h"
+#include "QU.hh"
+#include "QWavefront.hh"
+
+#include "qrng.h"
+#include "qsim.h"
+#include "qwavefront.h"
+
+const plog::Severity QWavefront::LEVEL = SLOG::EnvLevel("QWavefront", "DEBUG");
+
+extern "C" void QWavefront_generate(dim3 numBlocks, dim3 threadsPerBlock, qsim* sim, qwavefront* wf, unsigned num_slot, unsigned long long photon_slot_offset, float max_time ) ;
+extern "C" void QWavefront_propagate(dim3 numBlocks, dim3 threadsPerBlock, qsim* sim, qwavefront* wf, unsigned num_active, float max_time ) ;
+extern "C" void QWavefront_finalize(dim3 numBlocks, dim3 threadsPerBlock, qwavefront* wf, unsigned num_slot ) ;
+extern "C" unsigned QWavefront_compact( int* active, int* alive, int* active_next, unsigned num_active ) ;
+
+
+QWavefront::QWavefront(qsim* d_sim_)
+    :
+    d_sim(d_sim_),
+    wf(new qwavefront),
+    d_wf(nullptr),
+    capacity(0)
+{
+    init();
+}
+
+/**
+QWavefront::init
+------------------
+
+Uploads the instance with null buffers, the device pointer is
+placed into Params by CSGOptiX::initSimulate so it must not change,
+later allocations and queue swaps are copied into the same d_wf.
+
+**/
+
+void QWavefront::init()
+{
+    *wf = {} ;
+    d_wf = QU::UploadArray<qwavefront>(wf, 1, "QWavefront::init/d_wf" );
+}
+
+/**
+QWavefront::alloc
+-------------------
+
+Grows the per slot buffers when num_slot exceeds capacity.
+
+**/
+
+void QWavefront::alloc( unsigned num_slot )
+{
+    if( num_slot <= capacity ) return ;
+    free_buffers();
+
+    LOG(LEVEL) << " num_slot " << num_slot << " capacity " << capacity ;
+
+    wf->ctx         = QU::device_alloc<sctx>(num_slot,  "QWavefront::alloc/ctx" );
+    wf->rng         = QU::device_alloc<RNG>(num_slot,   "QWavefront::alloc/rng" );
+    wf->prd         = QU::device_alloc<quad2>(num_slot, "QWavefront::alloc/prd" );
+    wf->active      = QU::device_alloc<int>(num_slot,   "QWavefront::alloc/active" );
+    wf->active_next = QU::device_alloc<int>(num_slot,   "QWavefront::alloc/active_next" );
+    wf->alive       = QU::device_alloc<int>(num_slot,   "QWavefront::alloc/alive" );
+    capacity = num_slot ;
+}
+
+void QWavefront::free_buffers()
+{
+    if( capacity == 0 ) return ;
+    QU::device_free<sctx>(wf->ctx);
+    QU::device_free<RNG>(wf->rng);
+    QU::device_free<quad2>(wf->prd);
+    QU::device_free<int>(wf->active);
+    QU::device_free<int>(wf->active_next);
+    QU::device_free<int>(wf->alive);
+    capacity = 0 ;
+}
+
+void QWavefront::upload()
+{
+    QU::copy_host_to_device<qwavefront>( d_wf, wf, 1 );
+}
+
+/**
+QWavefront::generate
+----------------------
+
+Stage 0 for all slots then compaction, returning the initial
+queue length for the first trace launch.
+
+**/
+
+unsigned QWavefront::generate( unsigned num_slot, unsigned long long photon_slot_offset, float max_time )
+{
+    alloc(num_slot);
+    wf->num_slot = num_slot ;
+    wf->num_active = num_slot ;
+    wf->bounce = 0 ;
+    num_active_bounce.clear();
+    upload();
+
+    dim3 numBlocks ;
+    dim3 threadsPerBlock ;
+    QU::ConfigureLaunch1D( numBlocks, threadsPerBlock, num_slot, 512u );
+    QWavefront_generate( numBlocks, threadsPerBlock, d_sim, d_wf, num_slot, photon_slot_offset, max_time );
+
+    return compact();
+}
+
+/**
+QWavefront::propagate
+-----------------------
+
+Stage 2 for the queue following the trace launch, then compaction
+and bounce increment. Returns the queue length for the next trace launch.
+
+**/
+
+unsigned QWavefront::propagate( float max_time )
+{
+    unsigned num_active = wf->num_active ;
+    if( num_active == 0 ) return 0 ;
+    num_active_bounce.push_back(num_active);
+
+    dim3 numBlocks ;
+    dim3 threadsPerBlock ;
+    QU::ConfigureLaunch1D( numBlocks, threadsPerBlock, num_active, 512u );
+    QWavefront_propagate( numBlocks, threadsPerBlock, d_sim, d_wf, num_active, max_time );
+
+    wf->bounce += 1 ;
+    return compact();
+}
+
+void QWavefront::finalize()
+{
+    dim3 numBlocks ;
+    dim3 threadsPerBlock ;
+    QU::ConfigureLaunch1D( numBlocks, threadsPerBlock, wf->num_slot, 512u );
+    QWavefront_finalize( numBlocks, threadsPerBlock, d_wf, wf->num_slot );
+    QUDA_CHECK( cudaDeviceSynchronize() );
+
+    LOG(LEVEL) << desc() ;
+}
+
+/**
+QWavefront::compact
+---------------------
+
+Swaps the queues on host and uploads the instance, so the
+device side sees the compacted queue as *active*.
+
+**/
+
+unsigned QWavefront::compact()
+{
+    unsigned n = QWavefront_compact( wf->active, wf->alive, wf->active_next, wf->num_active );
+    std::swap( wf->active, wf->active_next );
+    wf->num_active = n ;
+    upload();
+    return n ;
+}
+
+unsigned QWavefront::num_active() const
+{
+    return wf->num_active ;
+}
+
+int QWavefront::bounce() const
+{
+    return wf->bounce ;
+}
+
+std::string QWavefront::desc() const
+{
+    std::stringstream ss ;
+    ss << "QWavefront::desc"
+       << " capacity " << capacity
+       << " num_slot " << wf->num_slot
+       << " num_active " << wf->num_active
+       << " bounce " << wf->bounce
+       << " sizeof(sctx) " << sizeof(sctx)
+       << " sizeof(RNG) " << sizeof(RNG)
+       << std::endl
+       << " num_active_bounce [" ;
+    for(unsigned i=0 ; i < num_active_bounce.size() ; i++) ss << " " << num_active_bounce[i] ;
+    ss << " ]" ;
+    std::string str = ss.str();
+    return str ;
+}
+
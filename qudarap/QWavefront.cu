@@ -0,0 +1,86 @@
+/**
+QWavefront.cu : stage kernels of wavefront simulation
+=======================================================
+
+The launch functions are invoked from QWavefront.cc, the stage
+methods are in qwavefront.h shared with the host scheduler.
+
+**/
+
+#include "stdio.h"
+#include "qrng.h"
+
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "sphotonlite.h"
+#include "srec.h"
+#include "sevent.h"
+#include "sstate.h"
+
+#include "qbnd.h"
+#include "qsim.h"
+#include "qbase.h"
+#include "qwavefront.h"
+
+#include <thrust/device_ptr.h>
+#include <thrust/copy.h>
+#include <thrust/functional.h>
+
+
+__global__ void _QWavefront_generate( qsim* sim, qwavefront* wf, unsigned num_slot, unsigned long long photon_slot_offset, float max_time )
+{
+    unsigned k = blockIdx.x*blockDim.x + threadIdx.x;
+    if( k >= num_slot ) return ;
+    wf->generate( sim, k, photon_slot_offset, max_time );
+}
+
+__global__ void _QWavefront_propagate( qsim* sim, qwavefront* wf, unsigned num_active, float max_time )
+{
+    unsigned k = blockIdx.x*blockDim.x + threadIdx.x;
+    if( k >= num_active ) return ;
+    wf->propagate( sim, k, max_time );
+}
+
+__global__ void _QWavefront_finalize( qwavefront* wf, unsigned num_slot )
+{
+    unsigned idx = blockIdx.x*blockDim.x + threadIdx.x;
+    if( idx >= num_slot ) return ;
+    wf->finalize( idx );
+}
+
+
+extern "C" void QWavefront_generate(dim3 numBlocks, dim3 threadsPerBlock, qsim* sim, qwavefront* wf, unsigned num_slot, unsigned long long photon_slot_offset, float max_time )
+{
+    _QWavefront_generate<<<numBlocks,threadsPerBlock>>>( sim, wf, num_slot, photon_slot_offset, max_time );
+}
+
+extern "C" void QWavefront_propagate(dim3 numBlocks, dim3 threadsPerBlock, qsim* sim, qwavefront* wf, unsigned num_active, float max_time )
+{
+    _QWavefront_propagate<<<numBlocks,threadsPerBlock>>>( sim, wf, num_active, max_time );
+}
+
+extern "C" void QWavefront_finalize(dim3 numBlocks, dim3 threadsPerBlock, qwavefront* wf, unsigned num_slot )
+{
+    _QWavefront_finalize<<<numBlocks,threadsPerBlock>>>( wf, num_slot );
+}
+
+/**
+QWavefront_compact
+--------------------
+
+Stable copy of the queue entries with alive set into active_next,
+device equivalent of qwavefront::compact. Returns the new queue length.
+
+**/
+
+extern "C" unsigned QWavefront_compact( int* active, int* alive, int* active_next, unsigned num_active )
+{
+    thrust::device_ptr<int> t_active      = thrust::device_pointer_cast(active) ;
+    thrust::device_ptr<int> t_alive       = thrust::device_pointer_cast(alive) ;
+    thrust::device_ptr<int> t_active_next = thrust::device_pointer_cast(active_next) ;
+
+    thrust::device_ptr<int> t_end = thrust::copy_if( t_active, t_active + num_active, t_alive, t_active_next, thrust::identity<int>() );
+    return unsigned( t_end - t_active_next ) ;
+}
+
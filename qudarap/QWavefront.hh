@@ -0,0 +1,53 @@
+#pragma once
+/**
+QWavefront
+============
+
+Manages the device buffers of wavefront simulation (OPTICKS_PROPAGATE_WAVEFRONT)
+and launches the generate, propagate and finalize stage kernels of QWavefront.cu
+together with the queue compaction. The trace stage is launched by
+CSGOptiX::simulate_launch_wavefront between the generate/propagate
+calls, see qwavefront.h for the sequence.
+
+The buffers are allocated at first use and grown when an event
+(or genstep slice) has more photon slots than the current capacity.
+
+**/
+
+#include <string>
+#include <vector>
+#include "QUDARAP_API_EXPORT.hh"
+#include "plog/Severity.h"
+
+struct qsim ;
+struct qwavefront ;
+
+struct QUDARAP_API QWavefront
+{
+    static const plog::Severity LEVEL ;
+
+    qsim*        d_sim ;
+    qwavefront*  wf ;       // host instance holding device pointers
+    qwavefront*  d_wf ;
+    unsigned     capacity ;
+
+    std::vector<unsigned> num_active_bounce ;   // queue length at each bounce of the last generate
+
+    QWavefront(qsim* d_sim);
+    void init();
+
+    void alloc( unsigned num_slot );
+    void free_buffers();
+    void upload();
+
+    unsigned generate( unsigned num_slot, unsigned long long photon_slot_offset, float max_time );
+    unsigned propagate( float max_time );
+    void     finalize();
+
+    unsigned num_active() const ;
+    int      bounce() const ;
+    unsigned compact();
+
+    std::string desc() const ;
+};
+
@@ -5,6 +5,19 @@ qbnd.h
 
 bnd and optical are closely related so they must be kept together
 
+Compact and half boundary textures
+-------------------------------------
+
+With QBnd__COMPACT the texture holds only the unique lines of the bnd
+array and boundary_line gives the texture row of every line, see
+SBnd::MakeCompact. The optical buffer stays indexed by the full line.
+
+With QBnd__HALF the texture is IEEE half float4, promoted to float by
+the texture unit, and boundary_scale holds per texture row power of two
+scales that are multiplied back after the fetch, see SBnd::MakeHalf.
+
+Both pointers are nullptr for the standard full float texture.
+
 **/
 
 enum { _BOUNDARY_NUM_MATSUR = 4,  _BOUNDARY_NUM_FLOAT4 = 2 };
@@ -34,6 +47,8 @@ struct qbnd
     unsigned            boundary_tex_MaterialLine_Water ;
     unsigned            boundary_tex_MaterialLine_LS ;
     quad*               optical ;
+    int*                boundary_line ;   // nullptr OR texture row of each line (QBnd__COMPACT)
+    float4*             boundary_scale ;  // nullptr OR scale of each texture row (QBnd__HALF)
 
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_TEXTURE) || defined(MOCK_CUDA)
     QBND_METHOD float4  boundary_lookup( unsigned ix, unsigned iy );
@@ -55,15 +70,19 @@ struct qbnd
 qbnd::boundary_lookup ix iy : Low level integer addressing lookup
 --------------------------------------------------------------------
 
+iy addresses the full 2*line+k rows, also when the texture is compacted.
+
 **/
 
 inline QBND_METHOD float4 qbnd::boundary_lookup( unsigned ix, unsigned iy )
 {
     const unsigned& nx = boundary_meta->q0.u.x  ;
     const unsigned& ny = boundary_meta->q0.u.y  ;
+    if( boundary_line ) iy = _BOUNDARY_NUM_FLOAT4*boundary_line[iy/_BOUNDARY_NUM_FLOAT4] + iy % _BOUNDARY_NUM_FLOAT4 ;
     float x = (float(ix)+0.5f)/float(nx) ;
     float y = (float(iy)+0.5f)/float(ny) ;
     float4 props = tex2D<float4>( boundary_tex, x, y );
+    if( boundary_scale ) props *= boundary_scale[iy] ;
     return props ;
 }
 
@@ -112,11 +131,13 @@ inline QBND_METHOD float4 qbnd::boundary_lookup( float nm, unsigned line, unsign
     float fx = (nm - nm0)/nms ;
     float x = (fx+0.5f)/float(nx) ;   // ?? +0.5f ??
 
-    unsigned iy = _BOUNDARY_NUM_FLOAT4*line + k ;    // 2*line+k (0/1)
+    unsigned row = boundary_line ? boundary_line[line] : line ;
+    unsigned iy = _BOUNDARY_NUM_FLOAT4*row + k ;    // 2*row+k (0/1)
     float y = (float(iy)+0.5f)/float(ny) ;
 
 
     float4 props = tex2D<float4>( boundary_tex, x, y );
+    if( boundary_scale ) props *= boundary_scale[iy] ;
 
     // printf("//qbnd.boundary_lookup nm %10.4f nm0 %10.4f nms %10.4f  x %10.4f nx %d ny %d y %10.4f props.x %10.4f %10.4f %10.4f %10.4f  \n",
     //     nm, nm0, nms, x, nx, ny, y, props.x, props.y, props.z, props.w );
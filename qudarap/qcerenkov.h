@@ -17,6 +17,10 @@ qcerenkov.h
 
 #include "qrng.h"
 
+#if defined(MOCK_TEXTURE) || defined(MOCK_CUDA)
+#include "stexture.h"
+#endif
+
 
 struct scerenkov ;
 struct qbase ;
@@ -36,16 +40,29 @@ as want a cerenkov member of qsim
 
 struct qcerenkov
 {
+    enum { BNDTEX, ICDF } ;
+
     qbase* base ;
     qbnd*  bnd ;
     qprop<float>*  prop ;
 
+    unsigned            mode ;           // BNDTEX: rejection sampling, ICDF: scerenkov_icdf table lookup
+    cudaTextureObject_t icdf_tex ;
+    float4*             icdf_dom ;       // per slot (bi0, bi1, e0, e1)
+    int*                icdf_slot ;      // per boundary texture line, -1 for no table
+    unsigned            icdf_num_line ;
+    unsigned            icdf_num_slot ;
+    unsigned            icdf_nb ;
+    unsigned            icdf_nu ;
+
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined(MOCK_CURAND) || defined(MOCK_CUDA)
     QCERENKOV_METHOD void generate( sphoton& p,  RNG& rng, const quad6& gs, unsigned long long idx, int genstep_id ) const ;
 
     template<typename T>
     QCERENKOV_METHOD void wavelength_sampled_enprop( float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, unsigned long long idx, int genstep_id ) const ;
     QCERENKOV_METHOD void wavelength_sampled_bndtex( float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, unsigned long long idx, int genstep_id ) const ;
+    QCERENKOV_METHOD void wavelength_sampled_icdf(   float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, unsigned long long idx, int genstep_id ) const ;
+    QCERENKOV_METHOD float icdf_energy( float u, float y ) const ;
 
     QCERENKOV_METHOD void fraction_sampled(float& fraction, float& delta, RNG& rng, const scerenkov& gs, unsigned long long idx, int gsid ) const ;
 #endif
@@ -66,7 +83,14 @@ inline QCERENKOV_METHOD void qcerenkov::generate( sphoton& p, RNG& rng, const qu
 
     //wavelength = 500.f ; cosTheta = 0.70710678f ; sin2Theta = 0.5f ;
 
-    wavelength_sampled_bndtex(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+    if( mode == ICDF )
+    {
+        wavelength_sampled_icdf(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+    }
+    else
+    {
+        wavelength_sampled_bndtex(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+    }
     //wavelength_sampled_enprop<float>(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
     //wavelength_sampled_enprop<double>(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
 
@@ -327,6 +351,94 @@ inline QCERENKOV_METHOD void qcerenkov::wavelength_sampled_bndtex(float& wavelen
 }
 
 
+/**
+qcerenkov::wavelength_sampled_icdf
+-------------------------------------
+
+Samples the same energy distribution as the rejection loop of
+wavelength_sampled_bndtex with a fixed cost of one random and four
+texture lookups, see scerenkov_icdf.h for the table layout.
+
+1. texture row from the material slot of gs.matline and gs.BetaInverse,
+   with linear filtering interpolating the ICDF between BetaInverse rows
+2. CDF (w payload) at the genstep energy range [hc/Wmax, hc/Wmin]
+   restricts u to that range
+3. energy from the ICDF with the hd_factor 10 zooms for the tails
+4. RINDEX at the sampled wavelength gives cosTheta, which is clamped
+   to 1 for samples very close to threshold
+
+Materials without a table fall back to the rejection sampling.
+
+**/
+
+inline QCERENKOV_METHOD void qcerenkov::wavelength_sampled_icdf(float& wavelength, float& cosTheta, float& sin2Theta, RNG& rng, const scerenkov& gs, unsigned long long idx, int gsid ) const
+{
+    int s = gs.matline < icdf_num_line ? icdf_slot[gs.matline] : -1 ;
+    if( s < 0 )
+    {
+        wavelength_sampled_bndtex(wavelength, cosTheta, sin2Theta, rng, gs, idx, gsid) ;
+        return ;
+    }
+
+    const float4& d = icdf_dom[s] ;
+    float nu = float(icdf_nu) ;
+    float fb = fminf( fmaxf( (gs.BetaInverse - d.x)/(d.y - d.x), 0.f ), 1.f )*float(icdf_nb - 1u) ;
+    float y = (float(unsigned(s)*icdf_nb) + fb + 0.5f)/float(icdf_nb*icdf_num_slot) ;
+
+    float xs = (nu - 1.f)/(d.w - d.z) ;
+    float e_lo = fminf( fmaxf( smath::hc_eVnm/gs.Wmax, d.z ), d.w ) ;
+    float e_hi = fminf( fmaxf( smath::hc_eVnm/gs.Wmin, d.z ), d.w ) ;
+    float c_lo = tex2D<float4>( icdf_tex, ((e_lo - d.z)*xs + 0.5f)/nu, y ).w ;
+    float c_hi = tex2D<float4>( icdf_tex, ((e_hi - d.z)*xs + 0.5f)/nu, y ).w ;
+
+    float u0 = curand_uniform(&rng) ;
+    float energy = icdf_energy( c_lo + u0*(c_hi - c_lo), y ) ;
+
+    wavelength = smath::hc_eVnm/energy ;
+
+    float4 props = bnd->boundary_lookup(wavelength, gs.matline, 0u);
+    float sampledRI = props.x ;
+
+    cosTheta = fminf( 1.f, gs.BetaInverse / sampledRI ) ;
+    sin2Theta = fmaxf( 0.f, (1.f - cosTheta)*(1.f + cosTheta));
+
+#if !defined(PRODUCTION) && defined(DEBUG_PIDX)
+    if( idx == base->pidx )
+    printf("//qcerenkov::wavelength_sampled_icdf idx %6lld slot %d fb %7.3f c_lo %7.4f c_hi %7.4f u0 %7.4f energy %7.4f sampledRI %7.4f \n",
+              idx, s, fb, c_lo, c_hi, u0, energy, sampledRI );
+#endif
+}
+
+/**
+qcerenkov::icdf_energy
+------------------------
+
+ICDF lookup with hd_factor 10 zooms, as qscint::wavelength_hd10 does
+for the 1D scintillation ICDF. Column j of the table is at u = j/(nu-1)
+so the texel centre offset puts u=0 and u=1 onto the first and last texels.
+
+**/
+
+inline QCERENKOV_METHOD float qcerenkov::icdf_energy( float u, float y ) const
+{
+    float nu = float(icdf_nu) ;
+    float energy ;
+    if( u < 0.1f )
+    {
+        energy = tex2D<float4>( icdf_tex, (u*10.f*(nu - 1.f) + 0.5f)/nu, y ).y ;
+    }
+    else if( u > 0.9f )
+    {
+        energy = tex2D<float4>( icdf_tex, ((u - 0.9f)*10.f*(nu - 1.f) + 0.5f)/nu, y ).z ;
+    }
+    else
+    {
+        energy = tex2D<float4>( icdf_tex, (u*(nu - 1.f) + 0.5f)/nu, y ).x ;
+    }
+    return energy ;
+}
+
+
 /**
 qcerenkov::wavelength_sampled_enprop
 --------------------------------------
@@ -3,6 +3,18 @@
 qpmt.h
 =======
 
+Tabulated TMM mode
+--------------------
+
+When QPMT is given the optional SPMT art_table/esc_table arrays (see stmm_table.h)
+the *art_table* pointer is set and qpmt::get_lpmtid_ATQC interpolates
+A,R,T from the per pmtcat table of S and P components over
+(wavelength, cos_theta) instead of doing the complex multi-layer stack
+calculation for every photon. The tabulated methods do not need Custom4.
+
+The optional *fbk_table* flags the cells around the critical angle where
+the interpolation is not accurate enough, for those the table methods
+return false and get_lpmtid_ATQC falls back to the stack calculation.
 
 **/
 
@@ -58,6 +70,14 @@ struct qpmt
     qprop<F>* s_qeshape_prop ;
     F*        s_qescale ;
 
+    F*        art_table ;   // optional (NUM_CAT, 2, art_nwl, art_nct, 4:[A_s,A_p,R_s,R_p]), nullptr for full TMM calc
+    F*        esc_table ;   // (NUM_CAT, art_nwl) qeshape/A_normal
+    unsigned char* fbk_table ;   // optional (NUM_CAT, 2, art_nwl-1, art_nct-1) cells flagged 1 use the stack calculation
+    int       art_nwl ;
+    int       art_nct ;
+    F         art_wl0 ;
+    F         art_inv_dwl ;
+
 
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_CURAND ) || defined(MOCK_CUDA)
     // loosely follow SPMT.h
@@ -89,6 +109,11 @@ struct qpmt
 
     QPMT_METHOD void get_lpmtid_stackspec_ce(       F* spec15, int lpmtid, F energy_eV, F lposcost ) const ;
 
+    QPMT_METHOD bool get_lpmtcat_ASRS_table( F* asrs, int lpmtcat, F wavelength_nm, F minus_cos_theta ) const ;
+    QPMT_METHOD bool get_lpmtcat_ART_table(  F* art3, int lpmtcat, F wavelength_nm, F minus_cos_theta, F dot_pol_cross_mom_nrm ) const ;
+    QPMT_METHOD F    get_lpmtcat_esc_table(  int lpmtcat, F wavelength_nm ) const ;
+    QPMT_METHOD bool get_lpmtid_ATQC_table(  F* ATQC, int lpmtid, F wavelength_nm, F minus_cos_theta, F dot_pol_cross_mom_nrm, F lposcost ) const ;
+
 
 #ifdef WITH_CUSTOM4
     QPMT_METHOD void get_lpmtid_SPEC(   F* spec16 , int lpmtid, F wavelength_nm ) const ;
@@ -364,6 +389,121 @@ inline QPMT_METHOD void qpmt<F>::get_lpmtid_stackspec_ce( F* spec, int lpmtid, F
 
 
 
+/**
+qpmt::get_lpmtcat_ASRS_table
+------------------------------
+
+Bilinear interpolation of [A_s,A_p,R_s,R_p] in (wavelength, |minus_cos_theta|)
+from the table half selected by the sign of minus_cos_theta, clamping
+outside the tabulated wavelength range. Host reference stmm_table::lookup_asrs.
+Returns false without setting asrs when the cell is flagged in fbk_table,
+host reference stmm_table::fallback.
+
+**/
+
+template<typename F>
+inline QPMT_METHOD bool qpmt<F>::get_lpmtcat_ASRS_table( F* asrs, int lpmtcat, F wavelength_nm, F minus_cos_theta ) const
+{
+    const int half = minus_cos_theta < zero ? 0 : 1 ;
+    const F ct = minus_cos_theta < zero ? -minus_cos_theta : minus_cos_theta ;
+
+    F fw = (wavelength_nm - art_wl0)*art_inv_dwl ;
+    F fc = ct*F(art_nct-1) ;
+    fw = fw < zero ? zero : ( fw > F(art_nwl-1) ? F(art_nwl-1) : fw ) ;
+    fc = fc > F(art_nct-1) ? F(art_nct-1) : fc ;
+
+    int iw = int(fw) ;
+    int ic = int(fc) ;
+    iw = iw > art_nwl - 2 ? art_nwl - 2 : iw ;
+    ic = ic > art_nct - 2 ? art_nct - 2 : ic ;
+    if( fbk_table && fbk_table[((lpmtcat*2 + half)*(art_nwl-1) + iw)*(art_nct-1) + ic] ) return false ;
+
+    const F tw = fw - F(iw) ;
+    const F tc = fc - F(ic) ;
+
+    const F* aa = art_table + ((lpmtcat*2 + half)*art_nwl + iw)*art_nct*4 ;
+    const F* a0 = aa + ic*4 ;
+    const F* a1 = aa + (art_nct + ic)*4 ;
+
+    for(int c=0 ; c < 4 ; c++)
+    {
+        F v0 = a0[c] + tc*(a0[4+c] - a0[c]) ;
+        F v1 = a1[c] + tc*(a1[4+c] - a1[c]) ;
+        asrs[c] = v0 + tw*(v1 - v0) ;
+    }
+    return true ;
+}
+
+/**
+qpmt::get_lpmtcat_ART_table
+-----------------------------
+
+Mixes the S and P components with the S power fraction of the photon::
+
+    E_s2 = (dot_pol_cross_mom_nrm/sin_theta)^2
+
+Returns false for fallback cells, see get_lpmtcat_ASRS_table.
+
+**/
+
+template<typename F>
+inline QPMT_METHOD bool qpmt<F>::get_lpmtcat_ART_table( F* art3, int lpmtcat, F wavelength_nm, F minus_cos_theta, F dot_pol_cross_mom_nrm ) const
+{
+    F asrs[4] ;
+    if(!get_lpmtcat_ASRS_table( asrs, lpmtcat, wavelength_nm, minus_cos_theta )) return false ;
+
+    const F st2 = one - minus_cos_theta*minus_cos_theta ;
+    F E_s2 = st2 > zero ? dot_pol_cross_mom_nrm*dot_pol_cross_mom_nrm/st2 : zero ;
+    E_s2 = E_s2 > one ? one : E_s2 ;
+
+    art3[0] = E_s2*asrs[0] + (one - E_s2)*asrs[1] ;   // A
+    art3[1] = E_s2*asrs[2] + (one - E_s2)*asrs[3] ;   // R
+    art3[2] = one - art3[0] - art3[1] ;               // T
+    return true ;
+}
+
+template<typename F>
+inline QPMT_METHOD F qpmt<F>::get_lpmtcat_esc_table( int lpmtcat, F wavelength_nm ) const
+{
+    F fw = (wavelength_nm - art_wl0)*art_inv_dwl ;
+    fw = fw < zero ? zero : ( fw > F(art_nwl-1) ? F(art_nwl-1) : fw ) ;
+    int iw = int(fw) ;
+    iw = iw > art_nwl - 2 ? art_nwl - 2 : iw ;
+    const F tw = fw - F(iw) ;
+    const F* ee = esc_table + lpmtcat*art_nwl + iw ;
+    return ee[0] + tw*(ee[1] - ee[0]) ;
+}
+
+/**
+qpmt::get_lpmtid_ATQC_table
+-----------------------------
+
+Tabulated equivalent of qpmt::get_lpmtid_ATQC, theEfficiency is
+the per-PMT qescale times the tabulated qeshape/A_normal escape factor.
+Returns false leaving ATQC unset for fallback cells.
+
+**/
+
+template<typename F>
+inline QPMT_METHOD bool qpmt<F>::get_lpmtid_ATQC_table( F* ATQC, int lpmtid, F wavelength_nm, F minus_cos_theta, F dot_pol_cross_mom_nrm, F lposcost ) const
+{
+    int lpmtidx = s_pmt::lpmtidx_from_pmtid(lpmtid);
+    const int& lpmtcat = i_lcqs[lpmtidx*2+0] ;
+    const F& qe_scale = lcqs[lpmtidx*2+1] ;
+
+    F art3[3] ;
+    if(!get_lpmtcat_ART_table( art3, lpmtcat, wavelength_nm, minus_cos_theta, dot_pol_cross_mom_nrm )) return false ;
+
+    const F theta_radians = acosf(lposcost);
+    ATQC[3] = cetheta_prop->interpolate( lpmtcat, theta_radians );
+    ATQC[2] = minus_cos_theta < zero ? qe_scale*get_lpmtcat_esc_table( lpmtcat, wavelength_nm ) : zero ;
+
+    ATQC[0] = art3[0] ;               // aka theAbsorption
+    ATQC[1] = art3[2]/(one-art3[0]) ; // aka theTransmittance
+    return true ;
+}
+
+
 
 
 #ifdef WITH_CUSTOM4
@@ -597,6 +737,10 @@ ATQC[3] C
    obtained by interpolation over theta domain (OR maybe in future costheta domain)
 
 
+When the optional art_table is present the tabulated
+qpmt::get_lpmtid_ATQC_table is used instead of the stack calculation,
+except for the cells flagged in fbk_table.
+
 TODO: compare between the alternates::
 
     get_lpmtid_stackspec_ce_acosf   // interpolates ce in theta of local position in PMT frame
@@ -618,6 +762,8 @@ inline QPMT_METHOD void qpmt<F>::get_lpmtid_ATQC(
 #endif
     ) const
 {
+    if( art_table && get_lpmtid_ATQC_table( ATQC, lpmtid, wavelength_nm, minus_cos_theta, dot_pol_cross_mom_nrm, lposcost )) return ;
+
     const F energy_eV = hc_eVnm/wavelength_nm ;
 
     F spec[16] ;
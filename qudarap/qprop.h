@@ -7,6 +7,22 @@ HMM: this relies on the prop arrays having last column integer
 annotation as done by NP::combine but there is no naming 
 or anything that stresses that 
 
+Optional uniform fast path
+-----------------------------
+
+When QProp resamples the properties (see QProp::Resample) *uu* holds 
+for each property a row of *uwidth* values with a four value header::
+
+    uv[0] : x0        domain start, log(x) for log-uniform 
+    uv[1] : inv_dx    1/step in x or log(x) 
+    uv[2] : n         number of samples (int_as) 
+    uv[3] : mode      0:none 1:uniform 2:log-uniform (int_as) 
+    uv[4...4+n-1]     values  
+
+allowing O(1) indexed interpolation instead of the binary search. 
+Properties that could not be resampled within tolerance have mode 0 
+and use the binary search. 
+
 **/
 
 
@@ -23,18 +39,28 @@ or anything that stresses that
 template<typename T>
 struct qprop
 {
+    enum { NONE, UNIFORM, LOG_UNIFORM } ; 
+    static constexpr const unsigned UHEAD = 4 ; 
+
     T* pp ; 
     unsigned width ; 
     unsigned height ; 
 
+    T* uu ;            // optional resampled rows, nullptr when not resampled 
+    unsigned uwidth ; 
+
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_CURAND )
     QPROP_METHOD T  interpolate( unsigned iprop, T x );  
+    QPROP_METHOD T  interpolate_search( unsigned iprop, T x );  
+    QPROP_METHOD T  interpolate_uniform( unsigned iprop, T x );  
 #else
     qprop()
         :
         pp(nullptr),
         width(0),
-        height(0)
+        height(0),
+        uu(nullptr),
+        uwidth(0)
     {
     }
 #endif
@@ -48,6 +74,20 @@ struct qprop
 qprop<T>::interpolate
 -----------------------
 
+Uses the uniform fast path when the properties have been resampled.
+
+**/
+
+template <typename T>
+inline QPROP_METHOD T qprop<T>::interpolate( unsigned iprop, T x )
+{
+    return uu ? interpolate_uniform( iprop, x ) : interpolate_search( iprop, x ) ; 
+}
+
+/**
+qprop<T>::interpolate_search
+------------------------------
+
 1. access property data for index iprop
 2. interpret the last column to obtain the number of payload values
 3. binary search to find the bin relevant to domain argument x  
@@ -56,7 +96,7 @@ qprop<T>::interpolate
 **/
 
 template <typename T>
-inline QPROP_METHOD T qprop<T>::interpolate( unsigned iprop, T x )
+inline QPROP_METHOD T qprop<T>::interpolate_search( unsigned iprop, T x )
 {
     const T* vv = pp + width*iprop ; 
 
@@ -83,6 +123,40 @@ inline QPROP_METHOD T qprop<T>::interpolate( unsigned iprop, T x )
     return y ;  
 }
 
+/**
+qprop<T>::interpolate_uniform
+-------------------------------
+
+O(1) linear interpolation of the resampled row, clamping outside the 
+domain as interpolate_search does. 
+
+**/
+
+template <typename T>
+inline QPROP_METHOD T qprop<T>::interpolate_uniform( unsigned iprop, T x )
+{
+    const T* uv = uu + uwidth*iprop ; 
+    int mode = sview::int_from<T>( uv[3] ) ; 
+    if( mode == NONE ) return interpolate_search( iprop, x ) ; 
+
+    int n = sview::int_from<T>( uv[2] ) ; 
+    const T* yy = uv + UHEAD ; 
+
+    if( mode == LOG_UNIFORM ) 
+    {
+        if( x <= T(0) ) return yy[0] ; 
+        x = log(x) ; 
+    }
+
+    T f = (x - uv[0])*uv[1] ; 
+    if( f <= T(0) ) return yy[0] ; 
+    if( f >= T(n-1) ) return yy[n-1] ; 
+
+    int i = int(f) ; 
+    T t = f - T(i) ; 
+    return yy[i] + t*(yy[i+1] - yy[i]) ; 
+}
+
 
 #endif
 
@@ -148,16 +148,60 @@ struct qrng<Philox>
 };
 
 
+/**
+qrng<sphilox>
+---------------
+
+Host and device counterpart of qrng<Philox> using the portable sphilox.h
+implementation. The init is the same stateless per (event, photon) one, 
+and gives the same sequence as qrng<Philox> on GPU for the same seed, 
+offset and skipahead_event_offset, so MOCK_CURAND tests can reproduce 
+GPU randoms without precooked sequences::
+
+    qrng<sphilox> qr(seed, offset, skipahead_event_offset) ; 
+    sphilox rng ; 
+    qr.init(rng, event_idx, photon_idx ); 
+    float u = curand_uniform(&rng); 
+
+**/
+
+template<>
+struct qrng<sphilox>
+{
+    ULL  seed ;
+    ULL  offset ;
+    ULL  skipahead_event_offset ;
+
+    QRNG_METHOD void init(sphilox& rng, unsigned long long event_idx, unsigned long long photon_idx ) const
+    {
+        rng.init( seed, photon_idx, offset );
+        rng.skipahead( skipahead_event_offset*event_idx );
+    }
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    qrng(ULL seed_, ULL offset_, ULL skipahead_event_offset_ )
+        :
+        seed(seed_),
+        offset(offset_),
+        skipahead_event_offset(skipahead_event_offset_)
+    {
+    }
+    void set_uploaded_states( void* ){}
+#endif
+};
+
+
 #ifdef RNG_PHILITEOX
 template<>
-struct qrng<PhiloxLite>
+struct qrng<PhiLiteOx>
 {
     ULL  seed ;
     ULL  offset ;
     ULL  skipahead_event_offset ;
 
 #if defined(__CUDACC__) || defined(__CUDABE__)
-    QRNG_METHOD void init(PhiloxLite& rng, unsigned long long event_idx, unsigned long long photon_idx )
+    QRNG_METHOD void init(PhiLiteOx& rng, unsigned long long event_idx, unsigned long long photon_idx )
     {
         ULL subsequence_ = photon_idx ;
         curand_init( seed, subsequence_, offset, &rng ) ;
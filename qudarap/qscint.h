@@ -3,6 +3,10 @@
 qscint.h
 ==================
 
+Wavelength sampling uses the fixed resolution hd0/hd10/hd20 ICDF texture
+unless QScint has prepared the adaptive packed table (QSCINT_ADAPTIVE_TOL),
+which is used when icdf_seg is non-null, see sscint_icdf.h
+
 **/
 
 #if defined(__CUDACC__) || defined(__CUDABE__)
@@ -26,6 +30,11 @@ struct qscint
     quad4*              scint_meta ; // HUH: not used ?
     unsigned            hd_factor ;
 
+    cudaTextureObject_t icdf_tex ;       // adaptive packed ICDF knots, point sampled
+    unsigned*           icdf_seg ;       // nullptr OR (offset, num_interval) of each segment
+    unsigned            icdf_nseg ;
+    float               icdf_inv_width ;
+
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined(MOCK_CURAND) || defined(MOCK_CUDA)
     QSCINT_METHOD void    generate( sphoton& p, RNG& rng, const quad6& gs, unsigned long long photon_id, int genstep_id ) const ;
     QSCINT_METHOD void    reemit(   sphoton& p, RNG& rng, float scintillationTime) const ;
@@ -36,6 +45,7 @@ struct qscint
     QSCINT_METHOD float   wavelength_hd0( const float& u0) const ;
     QSCINT_METHOD float   wavelength_hd10(const float& u0) const ;
     QSCINT_METHOD float   wavelength_hd20(const float& u0) const ;
+    QSCINT_METHOD float   wavelength_adaptive(const float& u0) const ;
 
 #endif
 
@@ -148,6 +158,8 @@ inline QSCINT_METHOD void qscint::mom_pol_wavelength(sphoton& p, RNG& rng) const
 
 inline QSCINT_METHOD float qscint::wavelength(const float& u0) const
 {
+    if( icdf_seg ) return wavelength_adaptive(u0) ;
+
     float wl ;
     switch(hd_factor)
     {
@@ -227,6 +239,40 @@ inline QSCINT_METHOD float qscint::wavelength_hd20(const float& u0) const
     return wl ;
 }
 
+/**
+qscint::wavelength_adaptive
+-----------------------------
+
+Lookup of the packed table of sscint_icdf, with segment *s* of u
+having num_interval equal intervals starting at texel offset.
+Two point sampled fetches with the interpolation done here keep
+the error within the sscint_icdf tolerance.
+
+The weight w is obtained from u0 with a single rounding using fmaf,
+with the integer interval position exact in float. Rounding u0*nseg
+first, with nseg not a power of two, loses ~2^-24 of x which is 0.4%
+of an interval at 1024 intervals per segment, enough to move the
+wavelength by ~0.02 nm in the near vertical tails.
+
+**/
+
+inline QSCINT_METHOD float qscint::wavelength_adaptive(const float& u0) const
+{
+    float x = u0*float(icdf_nseg) ;
+    unsigned s = min( unsigned(x), icdf_nseg - 1u ) ;
+    unsigned offset = icdf_seg[2*s+0] ;
+    unsigned n = icdf_seg[2*s+1] ;
+
+    float N = float(icdf_nseg*n) ;
+    float t = fmaxf( fmaf(u0, N, -float(s*n)), 0.f ) ;
+    unsigned i = min( unsigned(t), n - 1u ) ;
+    float w = fmaf(u0, N, -float(s*n + i)) ;
+
+    float v0 = tex2D<float>(icdf_tex, (float(offset+i)+0.5f)*icdf_inv_width, 0.5f );
+    float v1 = tex2D<float>(icdf_tex, (float(offset+i)+1.5f)*icdf_inv_width, 0.5f );
+    return v0 + w*(v1 - v0) ;
+}
+
 
 #endif
 
@@ -103,6 +103,7 @@ struct qsim
     QSIM_METHOD static void random_direction_marsaglia(float3* dir, RNG& rng, sctx& ctx );
     QSIM_METHOD void rayleigh_scatter(RNG& rng, sctx& ctx );
     QSIM_METHOD int     propagate_to_boundary( unsigned& flag, RNG& rng, sctx& ctx );
+    QSIM_METHOD int     propagate_to_boundary_weighted( unsigned& flag, RNG& rng, sctx& ctx );
 #endif
 
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_CURAND ) || defined(MOCK_CUDA)
@@ -717,6 +718,8 @@ TODO:
 
 inline QSIM_METHOD int qsim::propagate_to_boundary(unsigned& flag, RNG& rng, sctx& ctx)
 {
+    if( ctx.evt && ctx.evt->weight_threshold > 0.f ) return propagate_to_boundary_weighted(flag, rng, ctx) ;
+
     sphoton& p = ctx.p ;
     const sstate& s = ctx.s ;
 
@@ -861,6 +864,102 @@ inline QSIM_METHOD int qsim::propagate_to_boundary(unsigned& flag, RNG& rng, sct
 
     return BOUNDARY ;
 }
+
+/**
+qsim::propagate_to_boundary_weighted
+--------------------------------------
+
+Experimental alternative to propagate_to_boundary used when
+OPTICKS_PROPAGATE_WEIGHT_THRESHOLD (sevent::weight_threshold) is greater than zero,
+off by default.
+
+Bulk absorption splits into reemission with probability reemission_prob
+and absorption without reemission. Only reemission is sampled, with
+interaction length absorption_length/reemission_prob, the rest is
+applied as attenuation of the photon weight by accumulating the
+optical depth over every step::
+
+    ctx.tau += step*(1 - reemission_prob)/absorption_length     weight = expf(-ctx.tau)
+
+So photons are no longer lost to bulk absorption in long paths through
+weakly absorbing media, instead arriving at sensors with reduced weight.
+The expectation of the weight of hits matches the analogue hit probability.
+
+When the weight falls below the threshold Russian roulette is played,
+with survival probability equal to the weight and survivors continuing
+with weight 1 (tau zero), keeping the weight unbiased. Rouletted photons
+end with flag BULK_ABSORB.
+
+The weight is written into the photon at the end of the simulate
+kernel with sphoton::set_weight.
+
+NB this is not a general efficiency gain: in QSim_weight_MockTest the
+weighted estimate is unbiased and has smaller variance per photon, but
+as absorbed photons keep being propagated until rouletted the time per
+photon roughly doubles and the figure of merit 1/(variance*time) is
+lower than analogue (ratio 0.3-0.8 over radius 3000-6000, threshold
+0.05-0.3). Only use it where the analogue hit probability is very small.
+
+**/
+
+inline QSIM_METHOD int qsim::propagate_to_boundary_weighted(unsigned& flag, RNG& rng, sctx& ctx)
+{
+    sphoton& p = ctx.p ;
+    const sstate& s = ctx.s ;
+
+    const float& absorption_length = s.material1.y ;
+    const float& scattering_length = s.material1.z ;
+    const float& reemission_prob = s.material1.w ;
+    const float& group_velocity = s.m1group2.x ;
+    const float& distance_to_boundary = ctx.prd->q0.f.w ;
+
+    float u_scattering = curand_uniform(&rng) ;
+    float u_reemission = curand_uniform(&rng) ;
+
+    float scattering_distance = -scattering_length*logf(u_scattering);
+    float reemission_distance = reemission_prob > 0.f ? -absorption_length*logf(u_reemission)/reemission_prob : 1e30f ;
+
+    float step = fminf( distance_to_boundary, fminf( scattering_distance, reemission_distance )) ;
+
+    p.time += step/group_velocity ;
+    p.pos  += step*(p.mom) ;
+    ctx.tau += step*(1.f - reemission_prob)/absorption_length ;
+
+    float weight = expf(-ctx.tau) ;
+    if( weight < ctx.evt->weight_threshold )
+    {
+        float u_roulette = curand_uniform(&rng) ;
+        if( u_roulette >= weight )
+        {
+            flag = BULK_ABSORB ;
+            return BREAK ;
+        }
+        ctx.tau = 0.f ;
+    }
+
+    if( step == reemission_distance )
+    {
+        float u_re_wavelength = curand_uniform(&rng);
+        float u_re_mom_ph = curand_uniform(&rng);
+        float u_re_mom_ct = curand_uniform(&rng);
+        float u_re_pol_ph = curand_uniform(&rng);
+        float u_re_pol_ct = curand_uniform(&rng);
+
+        p.wavelength = scint->wavelength(u_re_wavelength);
+        p.mom = uniform_sphere(u_re_mom_ph, u_re_mom_ct);
+        p.pol = normalize(cross(uniform_sphere(u_re_pol_ph, u_re_pol_ct), p.mom));
+
+        flag = BULK_REEMIT ;
+        return CONTINUE ;
+    }
+    else if( step == scattering_distance )
+    {
+        rayleigh_scatter(rng, ctx);
+        flag = BULK_SCATTER ;
+        return CONTINUE ;
+    }
+    return BOUNDARY ;
+}
 #endif
 #if defined(__CUDACC__) || defined(__CUDABE__) || defined( MOCK_CURAND ) || defined(MOCK_CUDA)
 /**
@@ -2160,6 +2259,7 @@ inline QSIM_METHOD void qsim::fake_propagate( sphoton& p, const quad2* mock_prd,
 #ifndef PRODUCTION
     ctx.end();
 #endif
+    if( evt->weight_threshold > 0.f ) ctx.p.set_weight( expf(-ctx.tau) );
     evt->photon[idx] = ctx.p ;
 }
 
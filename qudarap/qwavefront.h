@@ -0,0 +1,250 @@
+#pragma once
+/**
+qwavefront.h : stages of wavefront simulation, shared by device kernels and host
+=================================================================================
+
+Alternative to the CSGOptiX7.cu:simulate megakernel, enabled with
+OPTICKS_PROPAGATE_WAVEFRONT. The megakernel runs generate, then the
+trace/propagate bounce loop up to max_bounce within each thread, so a few
+long lived photons (many reflections) keep whole warps resident after most
+of their lanes have finished.
+
+Wavefront simulation instead persists the photon state in global memory
+between separately launched stages, keeping a queue of the active slots::
+
+    generate    per slot : RNG init, qsim::generate_photon, queue all slots
+    compact     drop slots with time beyond max_time (or max_bounce 0)
+
+    while num_active > 0
+        trace       per queue entry : OptiX trace filling prd[slot]  (CSGOptiX7.cu)
+        propagate   per queue entry : qsim::propagate, set alive[k]
+        compact     stable copy of the alive queue entries, bounce += 1
+
+    finalize    per slot : write photon, photonlite
+
+All photons of a queue are at the same bounce, so bounce is a single
+value. The per slot RNG and state follow the same sequence as the
+megakernel so the outputs are identical, only the thread assignment
+changes. The queue is seeded in sevent::order when present (see sseedorder.h).
+
+The stage methods below are used by QWavefront.cu kernels, the trace stage
+raygen in CSGOptiX7.cu and the host scheduler qwavefront::simulate that is
+used with MOCK_CURAND/MOCK_CUDA to test without GPU::
+
+    ~/o/qudarap/tests/QWavefront_MockTest.sh
+
+The state is a full sctx per slot, which without PRODUCTION includes the
+heavy debug members, so VRAM use per slot is much larger than for
+the megakernel.
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+   #define QWAVEFRONT_METHOD __device__
+#else
+   #define QWAVEFRONT_METHOD
+#endif
+
+#include "sphotonlite.h"
+// qsim.h has no include guard, so it must be included before this header
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+#include <vector>
+#include <utility>
+#endif
+
+struct qwavefront
+{
+    sctx*     ctx ;          // [num_slot] photon state persisted between stages, indexed by slot
+    RNG*      rng ;          // [num_slot]
+    quad2*    prd ;          // [num_slot] trace result
+    int*      active ;       // [num_slot] queue of slots still propagating
+    int*      active_next ;  // [num_slot] compaction target, swapped with active
+    int*      alive ;        // [num_slot] per queue entry, 1 when the photon continues to the next bounce
+    unsigned  num_slot ;
+    unsigned  num_active ;
+    int       bounce ;
+
+#if defined(__CUDACC__) || defined(__CUDABE__) || defined(MOCK_CURAND) || defined(MOCK_CUDA)
+    QWAVEFRONT_METHOD void generate(  qsim* sim, unsigned k, unsigned long long photon_slot_offset, float max_time );
+    QWAVEFRONT_METHOD void propagate( qsim* sim, unsigned k, float max_time );
+    QWAVEFRONT_METHOD void finalize(  unsigned idx );
+#endif
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    unsigned compact();
+#if defined(MOCK_CURAND) || defined(MOCK_CUDA)
+    template<typename T>
+    int simulate( qsim* sim, T& trace_fn, unsigned num_slot, unsigned long long photon_slot_offset, float max_time, std::vector<unsigned>* num_active_bounce=nullptr );
+#endif
+#endif
+};
+
+
+#if defined(__CUDACC__) || defined(__CUDABE__) || defined(MOCK_CURAND) || defined(MOCK_CUDA)
+
+/**
+qwavefront::generate
+----------------------
+
+Stage 0 for queue entry k, as the head of CSGOptiX7.cu:simulate.
+
+**/
+
+inline QWAVEFRONT_METHOD void qwavefront::generate( qsim* sim, unsigned k, unsigned long long photon_slot_offset, float max_time )
+{
+    sevent* evt = sim->evt ;
+    unsigned idx = evt->order ? evt->order[k] : k ;
+    unsigned genstep_idx = evt->seed[idx] ;
+    const quad6& gs = evt->genstep[genstep_idx] ;
+    unsigned long long photon_idx = photon_slot_offset + idx ;
+
+    RNG& r = rng[idx] ;
+    sim->rng->init( r, evt->index, photon_idx );
+
+    sctx& c = ctx[idx] ;
+    c = {} ;
+    c.evt = evt ;
+    c.prd = prd + idx ;
+    c.idx = idx ;
+    c.pidx = photon_idx ;
+#if !defined(PRODUCTION) && defined(DEBUG_PIDX)
+    c.pidx_debug = sim->base->pidx == photon_idx ;
+#endif
+
+    prd[idx].zero();
+    sim->generate_photon(c.p, r, gs, photon_idx, genstep_idx );
+#ifndef PRODUCTION
+    c.point(0);
+#endif
+
+    active[k] = idx ;
+    alive[k] = evt->max_bounce > 0 && c.p.time < max_time ;
+}
+
+/**
+qwavefront::propagate
+-----------------------
+
+Stage 2 for queue entry k, following the trace of stage 1 into prd[slot].
+As the body of the megakernel bounce loop.
+
+**/
+
+inline QWAVEFRONT_METHOD void qwavefront::propagate( qsim* sim, unsigned k, float max_time )
+{
+    unsigned idx = active[k] ;
+    sctx& c = ctx[idx] ;
+    quad2& pr = prd[idx] ;
+
+    if( pr.boundary() == 0xffffu )
+    {
+        alive[k] = 0 ;
+        return ;
+    }
+
+    float3* normal = pr.normal();
+    *normal = normalize(*normal);
+
+#ifndef PRODUCTION
+    c.trace(bounce);
+#endif
+    int command = sim->propagate(bounce, rng[idx], c);
+#ifndef PRODUCTION
+    c.point(bounce+1);
+#endif
+    alive[k] = command != BREAK && bounce + 1 < c.evt->max_bounce && c.p.time < max_time ;
+}
+
+/**
+qwavefront::finalize
+----------------------
+
+Stage 3 for every slot, as the tail of CSGOptiX7.cu:simulate.
+
+**/
+
+inline QWAVEFRONT_METHOD void qwavefront::finalize( unsigned idx )
+{
+    sctx& c = ctx[idx] ;
+    sevent* evt = c.evt ;
+#ifndef PRODUCTION
+    c.end();
+#endif
+    if( evt->weight_threshold > 0.f ) c.p.set_weight( expf(-c.tau) );
+
+    if( evt->photon ) evt->photon[idx] = c.p ;
+    if( evt->photonlite )
+    {
+        sphotonlite l ;
+        l.init( c.p.identity, c.p.time, c.p.flagmask );
+        l.set_lpos(prd[idx].lposcost(), prd[idx].lposfphi() );
+        if( evt->weight_threshold > 0.f ) l.set_weight( c.p.weight() );
+        evt->photonlite[idx] = l ;
+    }
+}
+
+#endif
+
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+
+/**
+qwavefront::compact
+---------------------
+
+Host equivalent of QWavefront_compact : stable selection of the alive
+queue entries, keeping the slot order.
+
+**/
+
+inline unsigned qwavefront::compact()
+{
+    unsigned n = 0 ;
+    for(unsigned k=0 ; k < num_active ; k++) if( alive[k] ) active_next[n++] = active[k] ;
+    std::swap( active, active_next );
+    num_active = n ;
+    return n ;
+}
+
+#if defined(MOCK_CURAND) || defined(MOCK_CUDA)
+/**
+qwavefront::simulate
+----------------------
+
+Host scheduler running the stages in the same sequence as
+CSGOptiX::simulate_launch_wavefront. The trace_fn is called as
+trace_fn(prd, ctx) for each queue entry and must fill prd from
+the ctx.p position and direction. Returns the number of bounces.
+
+**/
+
+template<typename T>
+inline int qwavefront::simulate( qsim* sim, T& trace_fn, unsigned num_slot_, unsigned long long photon_slot_offset, float max_time, std::vector<unsigned>* num_active_bounce )
+{
+    num_slot = num_slot_ ;
+    num_active = num_slot ;
+    bounce = 0 ;
+
+    for(unsigned k=0 ; k < num_slot ; k++) generate( sim, k, photon_slot_offset, max_time );
+    compact();
+
+    while( num_active > 0 )
+    {
+        if(num_active_bounce) num_active_bounce->push_back(num_active);
+        for(unsigned k=0 ; k < num_active ; k++) trace_fn( prd + active[k], ctx[active[k]] );
+        for(unsigned k=0 ; k < num_active ; k++) propagate( sim, k, max_time );
+        compact();
+        bounce += 1 ;
+    }
+
+    for(unsigned idx=0 ; idx < num_slot ; idx++) finalize( idx );
+    return bounce ;
+}
+#endif
+
+#endif
+
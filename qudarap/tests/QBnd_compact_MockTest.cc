@@ -0,0 +1,385 @@
+/**
+QBnd_compact_MockTest.cc : CPU check of compacted and half precision boundary textures
+=========================================================================================
+
+Uses MOCK_CUDA/MOCK_TEXTURE to run qbnd.h lookups on CPU against three
+textures made from a synthetic bnd array in which boundaries share a
+few materials and surfaces, as in real geometries:
+
+full
+    standard float texture of all lines
+compact
+    unique lines from SBnd::MakeCompact with the boundary_line index
+half
+    compact lines encoded by SBnd::MakeHalf with boundary_scale
+
+Compact lookups must match the full ones for every line, property group
+and wavelength, and through qbnd::fill_state. Half lookups must match
+within the half precision. Absorption lengths up to 1e9 mm check the
+row scaling that keeps them within the half range.
+
+Standalone compile and run with::
+
+   ~/o/qudarap/tests/QBnd_compact_MockTest.sh
+
+**/
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sstate.h"
+#include "stimer.h"
+#include "shalf.h"
+#include "SBnd.h"
+
+#include "stexture.h"
+MockTextureManager* MockTextureManager::INSTANCE = nullptr ;
+
+#include "qbnd.h"
+
+
+struct QBnd_compact_MockTest
+{
+    static constexpr const int NI = 48 ;     // boundaries
+    static constexpr const int NWL = 101 ;
+    static constexpr const float WL0 = 300.f ;
+    static constexpr const float WLS = 5.f ;
+    static constexpr const int NUM_MAT = 5 ;
+    static constexpr const int NUM_SUR = 3 ;
+
+    static void Material(float* vv, int m, float wl);
+    static void Surface( float* vv, int s, float wl);
+    static NP*  MakeBnd();
+
+    int         num ;
+    NP*         bnd ;
+    NP*         line ;
+    NP*         cbnd ;
+    NP*         scale ;
+    NP*         hbnd ;
+    NP*         hdec ;
+    std::vector<quad> optical ;
+
+    quad4       meta_full ;
+    quad4       meta_compact ;
+    qbnd        full ;
+    qbnd        compact ;
+    qbnd        half ;
+
+    QBnd_compact_MockTest();
+    void init_qbnd( qbnd& b, quad4& meta, const NP* a, int num_row, int* bline, NP* bscale );
+
+    int check_shalf() const ;
+    int check_compact() const ;
+    int check_ixiy();
+    int check_lookup();
+    int check_fill_state();
+
+    int main();
+};
+
+
+/**
+QBnd_compact_MockTest::Material
+---------------------------------
+
+group 0 : refractive_index, absorption_length, scattering_length, reemission_prob
+group 1 : group_velocity
+
+Absorption lengths span 1e3 to 1e9 mm across the materials.
+
+**/
+
+void QBnd_compact_MockTest::Material(float* vv, int m, float wl)
+{
+    float u = (wl - WL0)/(WLS*(NWL-1)) ;
+    vv[0] = 1.30f + 0.05f*m + 0.02f*std::exp(-3.f*u) ;
+    vv[1] = std::pow(10.f, 3.f + 1.5f*m)*(0.5f + u) ;
+    vv[2] = 1e5f*(1.f + m)*(0.2f + u*u) ;
+    vv[3] = m == 2 ? 0.5f*(1.f - u) : 0.f ;
+    vv[4] = 299.792458f/vv[0] ;
+    vv[5] = 0.f ;
+    vv[6] = 0.f ;
+    vv[7] = 0.f ;
+}
+
+void QBnd_compact_MockTest::Surface(float* vv, int s, float wl)
+{
+    float u = (wl - WL0)/(WLS*(NWL-1)) ;
+    float detect = s == 0 ? 0.3f*std::sin(3.f*u)*std::sin(3.f*u) : 0.f ;
+    float absorb = 0.1f + 0.05f*s ;
+    vv[0] = detect ;
+    vv[1] = absorb ;
+    vv[2] = (1.f - detect - absorb)*(s == 2 ? 0.f : 1.f) ;
+    vv[3] = (1.f - detect - absorb)*(s == 2 ? 1.f : 0.f) ;
+    for(int p=4 ; p < 8 ; p++) vv[p] = 0.f ;
+}
+
+/**
+QBnd_compact_MockTest::MakeBnd
+--------------------------------
+
+Boundary i has omat i%NUM_MAT, imat (3i+1)%NUM_MAT and osur on every
+fourth boundary, giving NUM_MAT + NUM_SUR + 1 unique lines (the +1
+being the zeros of the missing surfaces).
+
+**/
+
+NP* QBnd_compact_MockTest::MakeBnd()
+{
+    NP* a = NP::Make<float>( NI, 4, 2, NWL, 4 );
+    float* aa = a->values<float>();
+    float vv[8] ;
+    for(int i=0 ; i < NI ; i++)
+    for(int j=0 ; j < 4 ; j++)
+    for(int l=0 ; l < NWL ; l++)
+    {
+        float wl = WL0 + WLS*l ;
+        int osur = i % 4 == 0 ? (i/4) % NUM_SUR : -1 ;
+        switch(j)
+        {
+            case OMAT: Material(vv, i % NUM_MAT, wl)       ; break ;
+            case OSUR: if(osur > -1) Surface(vv, osur, wl) ; else for(int p=0 ; p < 8 ; p++) vv[p] = 0.f ; break ;
+            case ISUR: for(int p=0 ; p < 8 ; p++) vv[p] = 0.f ; break ;
+            case IMAT: Material(vv, (3*i+1) % NUM_MAT, wl) ; break ;
+        }
+        for(int k=0 ; k < 2 ; k++)
+        for(int m=0 ; m < 4 ; m++) aa[((((i*4+j)*2+k)*NWL)+l)*4+m] = vv[k*4+m] ;
+    }
+    a->set_meta<float>("domain_low",  WL0 );
+    a->set_meta<float>("domain_high", WL0 + WLS*(NWL-1) );
+    a->set_meta<float>("domain_step", WLS );
+    a->set_meta<float>("domain_range", WLS*(NWL-1) );
+    return a ;
+}
+
+QBnd_compact_MockTest::QBnd_compact_MockTest()
+    :
+    num(ssys::getenvint("NUM", 1000000)),
+    bnd(MakeBnd()),
+    line(nullptr),
+    cbnd(SBnd::MakeCompact(bnd, line)),
+    scale(nullptr),
+    hbnd(SBnd::MakeHalf(cbnd, scale)),
+    hdec(shalf::Decode(hbnd)),
+    optical(NI*4)
+{
+    for(int l=0 ; l < NI*4 ; l++) optical[l].u = make_uint4( l+1, l % 4, 0u, 0u );
+
+    int num_unique = cbnd->shape[0] ;
+    init_qbnd( full,    meta_full,    bnd,  NI*4*2,       nullptr,             nullptr );
+    init_qbnd( compact, meta_compact, cbnd, num_unique*2, line->values<int>(), nullptr );
+    init_qbnd( half,    meta_compact, hdec, num_unique*2, line->values<int>(), scale   );
+}
+
+void QBnd_compact_MockTest::init_qbnd( qbnd& b, quad4& meta, const NP* a, int num_row, int* bline, NP* bscale )
+{
+    meta = {} ;
+    meta.q0.u.x = NWL ;
+    meta.q0.u.y = num_row ;
+    meta.q1.f.x = WL0 ;
+    meta.q1.f.z = WLS ;
+
+    b = {} ;
+    b.boundary_tex = MockTextureManager::Add(a, 'L') ;
+    b.boundary_meta = &meta ;
+    b.optical = optical.data() ;
+    b.boundary_line = bline ;
+    b.boundary_scale = bscale ? (float4*)bscale->values<float>() : nullptr ;
+}
+
+int QBnd_compact_MockTest::check_shalf() const
+{
+    bool ok = true ;
+    ok &= shalf::FromFloat(1.f) == 0x3c00 ;
+    ok &= shalf::FromFloat(-2.f) == 0xc000 ;
+    ok &= shalf::FromFloat(65504.f) == 0x7bff ;
+    ok &= shalf::FromFloat(65520.f) == 0x7c00 ;           // rounds to inf
+    ok &= shalf::FromFloat(std::ldexp(1.f,-24)) == 0x0001 ;  // smallest subnormal
+    ok &= shalf::FromFloat(std::ldexp(1.f,-26)) == 0x0000 ;
+    ok &= shalf::FromFloat(1.f + std::ldexp(1.f,-11)) == 0x3c00 ;   // tie to even
+    ok &= shalf::FromFloat(1.f + 3.f*std::ldexp(1.f,-11)) == 0x3c02 ; // tie to even
+
+    int num_bad = 0 ;
+    for(int h=0 ; h < 0x7c00 ; h++) if( shalf::FromFloat(shalf::ToFloat(h)) != h ) num_bad += 1 ;
+
+    std::mt19937 gen(1) ;
+    std::uniform_real_distribution<float> lg(-14.f, 15.9f) ;
+    float max_rel = 0.f ;
+    for(int i=0 ; i < 100000 ; i++)
+    {
+        float f = std::exp2(lg(gen)) ;
+        max_rel = std::max( max_rel, std::abs(shalf::ToFloat(shalf::FromFloat(f)) - f)/f ) ;
+    }
+    ok &= num_bad == 0 && max_rel <= std::ldexp(1.f,-11) ;
+
+    std::cout << "check_shalf num_bad " << num_bad << " max_rel " << std::scientific << max_rel << std::fixed << ( ok ? " PASS" : " FAIL" ) << "\n" ;
+    return ok ? 0 : 1 ;
+}
+
+int QBnd_compact_MockTest::check_compact() const
+{
+    int num_unique = cbnd->shape[0] ;
+    bool ok = num_unique == NUM_MAT + NUM_SUR + 1 ;
+
+    const int* lr = line->cvalues<int>() ;
+    NP::INT line_values = 2*NWL*4 ;
+    for(int l=0 ; l < NI*4 ; l++)
+        ok &= memcmp( bnd->cvalues<float>() + l*line_values, cbnd->cvalues<float>() + lr[l]*line_values, line_values*sizeof(float) ) == 0 ;
+
+    const float* sc = scale->cvalues<float>() ;
+    float max_scale = 0.f ;
+    for(int i=0 ; i < scale->num_values() ; i++) max_scale = std::max( max_scale, sc[i] ) ;
+
+    std::cout
+        << SBnd::DescCompact(bnd, cbnd)
+        << " full_bytes " << bnd->arr_bytes()
+        << " compact_bytes " << cbnd->arr_bytes()
+        << " half_bytes " << hbnd->arr_bytes()
+        << " max_scale " << max_scale
+        << ( ok ? " PASS" : " FAIL" ) << "\n" ;
+    return ok ? 0 : 1 ;
+}
+
+/**
+QBnd_compact_MockTest::check_ixiy
+-----------------------------------
+
+Integer addressing of all texels via the full 2*line+k rows,
+as used by QSim::boundary_lookup_all.
+
+**/
+
+int QBnd_compact_MockTest::check_ixiy()
+{
+    int num_diff = 0 ;
+    for(unsigned iy=0 ; iy < NI*4*2 ; iy++)
+    for(unsigned ix=0 ; ix < NWL ; ix++)
+    {
+        float4 a = full.boundary_lookup( ix, iy );
+        float4 b = compact.boundary_lookup( ix, iy );
+        if( memcmp(&a, &b, sizeof(float4)) != 0 ) num_diff += 1 ;
+    }
+    bool ok = num_diff == 0 ;
+    std::cout << "check_ixiy num_diff " << num_diff << ( ok ? " PASS" : " FAIL" ) << "\n" ;
+    return ok ? 0 : 1 ;
+}
+
+/**
+QBnd_compact_MockTest::check_lookup
+-------------------------------------
+
+Random line, group and wavelength lookups. The mock bilinear filter can
+blend neighbouring rows by float rounding of the y coordinate, which with
+different neighbours in the compact texture gives differences at the level
+of float epsilon, so compact is compared with a tiny tolerance.
+
+**/
+
+int QBnd_compact_MockTest::check_lookup()
+{
+    std::mt19937 gen(42) ;
+    std::uniform_int_distribution<int> dline(0, NI*4-1) ;
+    std::uniform_int_distribution<int> dk(0, 1) ;
+    std::uniform_real_distribution<float> dwl(WL0, WL0 + WLS*(NWL-1)) ;
+
+    std::vector<unsigned> ll(num), kk(num) ;
+    std::vector<float> ww(num) ;
+    for(int i=0 ; i < num ; i++) { ll[i] = dline(gen) ; kk[i] = dk(gen) ; ww[i] = dwl(gen) ; }
+
+    std::vector<float4> vf(num), vc(num), vh(num) ;
+
+    stimer* tf = stimer::create() ;
+    for(int i=0 ; i < num ; i++) vf[i] = full.boundary_lookup( ww[i], ll[i], kk[i] ) ;
+    tf->done();
+
+    stimer* tc = stimer::create() ;
+    for(int i=0 ; i < num ; i++) vc[i] = compact.boundary_lookup( ww[i], ll[i], kk[i] ) ;
+    tc->done();
+
+    stimer* th = stimer::create() ;
+    for(int i=0 ; i < num ; i++) vh[i] = half.boundary_lookup( ww[i], ll[i], kk[i] ) ;
+    th->done();
+
+    int num_identical = 0 ;
+    float max_compact = 0.f ;
+    float max_half = 0.f ;
+    for(int i=0 ; i < num ; i++)
+    {
+        if( memcmp(&vf[i], &vc[i], sizeof(float4)) == 0 ) num_identical += 1 ;
+        const float* f = &vf[i].x ;
+        const float* c = &vc[i].x ;
+        const float* h = &vh[i].x ;
+        for(int m=0 ; m < 4 ; m++)
+        {
+            float den = std::max( std::abs(f[m]), 1e-3f ) ;
+            max_compact = std::max( max_compact, std::abs(c[m] - f[m])/den ) ;
+            max_half    = std::max( max_half,    std::abs(h[m] - f[m])/den ) ;
+        }
+    }
+
+    bool ok = max_compact < 1e-6f && max_half < 1e-3f ;
+    std::cout
+        << "check_lookup num " << num
+        << " identical " << num_identical
+        << " max_rel compact " << std::scientific << std::setprecision(3) << max_compact
+        << " half " << max_half
+        << std::fixed << std::setprecision(1)
+        << " full " << 1e9*tf->duration()/num << " ns"
+        << " compact " << 1e9*tc->duration()/num << " ns"
+        << " half " << 1e9*th->duration()/num << " ns"
+        << ( ok ? " PASS" : " FAIL" ) << "\n" ;
+
+    delete tf ;
+    delete tc ;
+    delete th ;
+    return ok ? 0 : 1 ;
+}
+
+int QBnd_compact_MockTest::check_fill_state()
+{
+    int num_diff = 0 ;
+    for(unsigned b=0 ; b < NI ; b++)
+    for(int c=0 ; c < 2 ; c++)
+    for(float wl=WL0 ; wl < WL0 + WLS*(NWL-1) ; wl += 7.3f)
+    {
+        float cosTheta = c == 0 ? -0.5f : 0.5f ;
+        sstate sf = {} ;
+        sstate sc = {} ;
+        full.fill_state( sf, b, wl, cosTheta, 0ull, 1ull );
+        compact.fill_state( sc, b, wl, cosTheta, 0ull, 1ull );
+
+        bool same = sf.optical.x == sc.optical.x && sf.index.x == sc.index.x && sf.index.y == sc.index.y ;
+        const float* f = &sf.material1.x ;
+        const float* s = &sc.material1.x ;
+        for(int m=0 ; m < 16 ; m++) same &= std::abs(f[m] - s[m]) <= 1e-6f*std::max(std::abs(f[m]), 1e-3f) ;
+        if(!same) num_diff += 1 ;
+    }
+    bool ok = num_diff == 0 ;
+    std::cout << "check_fill_state num_diff " << num_diff << ( ok ? " PASS" : " FAIL" ) << "\n" ;
+    return ok ? 0 : 1 ;
+}
+
+int QBnd_compact_MockTest::main()
+{
+    int rc = 0 ;
+    rc += check_shalf();
+    rc += check_compact();
+    rc += check_ixiy();
+    rc += check_lookup();
+    rc += check_fill_state();
+    std::cout << "QBnd_compact_MockTest rc " << rc << "\n" ;
+    return rc ;
+}
+
+int main()
+{
+    QBnd_compact_MockTest t ;
+    return t.main() == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,56 @@
+#!/bin/bash
+usage(){ cat << EOU
+QBnd_compact_MockTest.sh
+========================
+
+CPU check of compacted and half precision boundary texture lookups
+using MOCK_CUDA MOCK_TEXTURE::
+
+   ~/o/qudarap/tests/QBnd_compact_MockTest.sh
+
+   NUM=100000 ~/o/qudarap/tests/QBnd_compact_MockTest.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=QBnd_compact_MockTest
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE FOLD bin name OPTICKS_PREFIX CUDA_PREFIX"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc \
+       -O2 \
+       -std=c++17 -lstdc++ -lm -pthread \
+       -DMOCK_CUDA \
+       -DMOCK_TEXTURE \
+       -I.. \
+       -I../../sysrap \
+       -I$CUDA_PREFIX/include \
+       -I$OPTICKS_PREFIX/externals/glm/glm \
+       -o $bin
+
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
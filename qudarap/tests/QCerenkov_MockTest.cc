@@ -0,0 +1,318 @@
+/**
+QCerenkov_MockTest.cc : CPU comparison of qcerenkov ICDF and rejection wavelength sampling
+=============================================================================================
+
+Uses MOCK_CURAND/MOCK_CUDA/MOCK_TEXTURE to run the qcerenkov.h device code on CPU
+with a synthetic two boundary bnd array:
+
+* boundary 0 : OMAT with RINDEX peaked at 250nm, IMAT with RINDEX falling with wavelength
+* boundary 1 : OMAT same as boundary 0 IMAT (checks slot dedup), IMAT vacuum (no table)
+
+For each case the energy histograms of qcerenkov::wavelength_sampled_icdf and
+qcerenkov::wavelength_sampled_bndtex are compared with a two sample chi2.
+
+Both mock textures use linear filtering, as on GPU, without which the
+ICDF energies would be quantized to the table columns. The near threshold
+cases compare with an uncapped host rejection reference as the count<100
+cap of the bndtex loop truncates there.
+
+Standalone compile and run with::
+
+   ~/o/qudarap/tests/QCerenkov_MockTest.sh
+
+**/
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "sstate.h"
+#include "scerenkov.h"
+#include "stimer.h"
+
+#include "srngcpu.h"
+using RNG = srngcpu ;
+
+#include "stexture.h"
+MockTextureManager* MockTextureManager::INSTANCE = nullptr ;
+
+#include "scerenkov_icdf.h"
+
+#include "qbase.h"
+#include "qbnd.h"
+#include "qcerenkov.h"
+
+
+struct QCerenkov_MockTest
+{
+    static constexpr const int NWL = 761 ;
+    static constexpr const int NBIN = 100 ;
+
+    static double RINDEX(int line, double wl);
+    static NP* MakeBnd();
+
+    int        num ;
+    int        nb ;
+    int        nu ;
+    RNG        rng ;
+    NP*        bnd ;
+    scerenkov_icdf* table ;
+    qbase      base ;
+    quad4      boundary_meta ;
+    qbnd       bn ;
+    qcerenkov  ck ;
+
+    QCerenkov_MockTest();
+
+    double bi_row(int slot, int ib) const ;
+    void   make_gs(scerenkov& gs, unsigned matline, float BetaInverse, float Wmin, float Wmax ) const ;
+    double reference_energy(int slot, const scerenkov& gs, int& count);
+    double chi2( const std::vector<int>& a, const std::vector<int>& b, int& ndf ) const ;
+    int    compare(const char* label, unsigned matline, float BetaInverse, float Wmin, float Wmax, bool uncapped_reference );
+    int    check_slots() const ;
+
+    int main();
+};
+
+
+/**
+QCerenkov_MockTest::RINDEX
+----------------------------
+
+line 0 : peaked at 250nm, max 1.38
+line 3 : falling with wavelength, max 1.532 at 60nm
+
+**/
+
+double QCerenkov_MockTest::RINDEX(int line, double wl)
+{
+    double ri = 1. ;
+    switch(line)
+    {
+        case 0: ri = 1.33 + 0.05*exp( -(wl-250.)*(wl-250.)/(80.*80.) ) ; break ;
+        case 3: ri = 1.50 - 0.00004*(wl - 820.)                       ; break ;
+        case 4: ri = 1.50 - 0.00004*(wl - 820.)                       ; break ;
+    }
+    return ri ;
+}
+
+NP* QCerenkov_MockTest::MakeBnd()
+{
+    NP* a = NP::Make<float>( 2, 4, 2, NWL, 4 );
+    float* aa = a->values<float>();
+    for(int line=0 ; line < 8 ; line++)
+    for(int i=0 ; i < NWL ; i++)
+    {
+        double wl = 60. + double(i) ;
+        aa[(line*2*NWL + i)*4 + 0] = RINDEX(line, wl) ;
+    }
+    a->set_meta<float>("domain_low",  60.f );
+    a->set_meta<float>("domain_high", 820.f );
+    a->set_meta<float>("domain_step", 1.f );
+    a->set_meta<float>("domain_range", 760.f );
+    return a ;
+}
+
+QCerenkov_MockTest::QCerenkov_MockTest()
+    :
+    num(ssys::getenvint("NUM", 1000000)),
+    nb(ssys::getenvint("NB", scerenkov_icdf::NB)),
+    nu(ssys::getenvint("NU", scerenkov_icdf::NU)),
+    rng(),
+    bnd(MakeBnd()),
+    table(nullptr)
+{
+    stimer* t = stimer::create() ;
+    table = scerenkov_icdf::Create(bnd, nb, nu) ;
+    t->done();
+    std::cout << table->desc() << " build " << t->desc() << "\n" ;
+
+    base.pidx = -1 ;
+
+    boundary_meta = {} ;
+    boundary_meta.q0.u.x = NWL ;
+    boundary_meta.q0.u.y = 2*4*2 ;
+    boundary_meta.q1.f.x = 60.f ;
+    boundary_meta.q1.f.z = 1.f ;
+
+    bn = {} ;
+    bn.boundary_tex = MockTextureManager::Add(bnd, 'L') ;
+    bn.boundary_meta = &boundary_meta ;
+
+    ck = {} ;
+    ck.base = &base ;
+    ck.bnd = &bn ;
+    ck.prop = nullptr ;
+    ck.mode = qcerenkov::ICDF ;
+    ck.icdf_tex = MockTextureManager::Add(table->icdf, 'L') ;
+    ck.icdf_dom = (float4*)table->dom->values<float>() ;
+    ck.icdf_slot = table->slot->values<int>() ;
+    ck.icdf_num_line = table->slot->num_values() ;
+    ck.icdf_num_slot = table->num_slot() ;
+    ck.icdf_nb = table->nb ;
+    ck.icdf_nu = table->nu ;
+}
+
+double QCerenkov_MockTest::bi_row(int slot, int ib) const
+{
+    const float4* dd = (const float4*)table->dom->cvalues<float>() ;
+    return dd[slot].x + double(ib)*(dd[slot].y - dd[slot].x)/double(nb-1) ;
+}
+
+void QCerenkov_MockTest::make_gs(scerenkov& gs, unsigned matline, float BetaInverse, float Wmin, float Wmax ) const
+{
+    gs = {} ;
+    gs.matline = matline ;
+    gs.BetaInverse = BetaInverse ;
+    gs.Wmin = Wmin ;
+    gs.Wmax = Wmax ;
+
+    double nMax = 0. ;
+    for(int i=0 ; i < NWL ; i++)
+    {
+        double wl = 60. + double(i) ;
+        if( wl >= Wmin && wl <= Wmax ) nMax = std::max( nMax, RINDEX(matline, wl) );
+    }
+    gs.maxCos = BetaInverse/nMax ;
+    gs.maxSin2 = (1.f - gs.maxCos)*(1.f + gs.maxCos) ;
+}
+
+/**
+QCerenkov_MockTest::reference_energy
+---------------------------------------
+
+Uncapped double precision rejection sampling of the table RINDEX.
+
+**/
+
+double QCerenkov_MockTest::reference_energy(int slot, const scerenkov& gs, int& count)
+{
+    double e0 = smath::hc_eVnm/gs.Wmax ;
+    double e1 = smath::hc_eVnm/gs.Wmin ;
+    double e, s2 ;
+    count = 0 ;
+    do
+    {
+        e = e0 + curand_uniform_double(&rng)*(e1 - e0) ;
+        double ct = gs.BetaInverse/table->rindex_at(slot, e) ;
+        s2 = (1. - ct)*(1. + ct) ;
+        count += 1 ;
+    }
+    while( curand_uniform_double(&rng)*gs.maxSin2 > s2 );
+    return e ;
+}
+
+double QCerenkov_MockTest::chi2( const std::vector<int>& a, const std::vector<int>& b, int& ndf ) const
+{
+    double c2 = 0. ;
+    ndf = 0 ;
+    for(int i=0 ; i < NBIN ; i++)
+    {
+        double ab = a[i] + b[i] ;
+        if( ab < 20. ) continue ;
+        c2 += (a[i] - b[i])*(a[i] - b[i])/ab ;
+        ndf += 1 ;
+    }
+    return c2 ;
+}
+
+int QCerenkov_MockTest::compare(const char* label, unsigned matline, float BetaInverse, float Wmin, float Wmax, bool uncapped_reference )
+{
+    scerenkov gs ;
+    make_gs( gs, matline, BetaInverse, Wmin, Wmax );
+    int slot = table->slot->cvalues<int>()[matline] ;
+
+    double e0 = smath::hc_eVnm/Wmax ;
+    double e1 = smath::hc_eVnm/Wmin ;
+    std::vector<int> h_icdf(NBIN,0), h_ref(NBIN,0) ;
+    auto fill = [&](std::vector<int>& h, double e){ int i = int( (e - e0)/(e1 - e0)*NBIN ) ; if( i >= 0 && i < NBIN ) h[i] += 1 ; };
+
+    float wavelength, cosTheta, sin2Theta ;
+    int num_bad = 0 ;
+
+    stimer* t_icdf = stimer::create() ;
+    for(int i=0 ; i < num ; i++)
+    {
+        ck.wavelength_sampled_icdf( wavelength, cosTheta, sin2Theta, rng, gs, i, 0 );
+        fill( h_icdf, smath::hc_eVnm/wavelength );
+        if( !(sin2Theta >= 0.f && cosTheta <= 1.f) ) num_bad += 1 ;
+    }
+    t_icdf->done();
+
+    int max_count = 0 ;
+    int64_t tot_count = 0 ;
+    stimer* t_ref = stimer::create() ;
+    for(int i=0 ; i < num ; i++)
+    {
+        if( uncapped_reference )
+        {
+            int count = 0 ;
+            fill( h_ref, reference_energy( slot, gs, count ) );
+            max_count = std::max( max_count, count );
+            tot_count += count ;
+        }
+        else
+        {
+            ck.wavelength_sampled_bndtex( wavelength, cosTheta, sin2Theta, rng, gs, i, 0 );
+            fill( h_ref, smath::hc_eVnm/wavelength );
+        }
+    }
+    t_ref->done();
+
+    int ndf = 0 ;
+    double c2 = chi2( h_icdf, h_ref, ndf ) ;
+    double c2n = ndf > 0 ? c2/ndf : 0. ;
+    bool pass = ndf > 0 && c2n < 1.5 && num_bad == 0 ;
+
+    std::cout
+        << std::setw(24) << label
+        << " matline " << matline
+        << " slot " << slot
+        << " BetaInverse " << std::fixed << std::setprecision(5) << BetaInverse
+        << " chi2/ndf " << std::setprecision(2) << c2 << "/" << ndf << " = " << std::setprecision(3) << c2n
+        << " icdf " << std::setprecision(1) << 1e9*t_icdf->duration()/num << " ns/ph"
+        << ( uncapped_reference ? " reference " : " bndtex " ) << 1e9*t_ref->duration()/num << " ns/ph"
+        ;
+    if( uncapped_reference ) std::cout << " mean_loop " << std::setprecision(1) << double(tot_count)/num << " max_loop " << max_count ;
+    std::cout << ( pass ? " PASS" : " FAIL" ) << "\n" ;
+
+    delete t_icdf ;
+    delete t_ref ;
+    return pass ? 0 : 1 ;
+}
+
+int QCerenkov_MockTest::check_slots() const
+{
+    const int* ss = table->slot->cvalues<int>() ;
+    bool ok = table->num_slot() == 2 && ss[0] == 0 && ss[3] == 1 && ss[4] == 1 && ss[7] == -1 && ss[1] == -1 ;
+    std::cout << "check_slots " << ( ok ? "PASS" : "FAIL" ) << "\n" ;
+    return ok ? 0 : 1 ;
+}
+
+int QCerenkov_MockTest::main()
+{
+    int rc = check_slots() ;
+
+    rc += compare( "peaked_fast",       0, 1.0f,   80.f, 800.f, false );
+    rc += compare( "peaked_mid",        0, 1.2f,   80.f, 800.f, false );
+    rc += compare( "falling_fast",      3, 1.0f,   80.f, 800.f, false );
+    rc += compare( "falling_subrange",  3, 1.3f,  200.f, 600.f, false );
+    rc += compare( "peaked_subrange",   0, 1.25f, 150.f, 400.f, false );
+
+    rc += compare( "peaked_near_threshold",  0, bi_row(0, nb-4), 80.f, 800.f, true );
+    rc += compare( "falling_near_threshold", 3, bi_row(1, nb-3), 80.f, 800.f, true );
+
+    std::cout << "QCerenkov_MockTest rc " << rc << "\n" ;
+    return rc ;
+}
+
+int main()
+{
+    QCerenkov_MockTest t ;
+    return t.main() == 0 ? 0 : 1 ;
+}
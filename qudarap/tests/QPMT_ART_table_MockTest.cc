@@ -0,0 +1,202 @@
+/**
+QPMT_ART_table_MockTest.cc : tabulated PMT TMM A,R,T compared with the stmm.h stack calculation
+==================================================================================================
+
+Three synthetic PMT categories with pyrex, ARC, photocathode and vacuum
+layers with wavelength dependent complex indices. The stmm_table.h tables
+are built with the double precision stmm.h Stack and looked up with
+qpmt::get_lpmtcat_ART_table (MOCK_CUDA) at random (wavelength, minus_cos_theta,
+polarization) points. For the cells near the critical angle flagged in the
+fbk table the lookup returns false and, as qpmt::get_lpmtid_ATQC does,
+the float stack calculation is used instead. A,R,T are compared with the
+direct double precision stmm.h calculation.
+
+The maximum deviation is required to be within the fixed absolute BOUND
+(default 1e-3, the default tol): the interpolation error of A_s,A_p,R_s,R_p
+is within FBK_SAFETY*tol at the measured points of the cells not falling
+back, T = 1-A-R accumulates the A and R errors and the float stack of the
+fallback cells itself deviates from double by up to ~4e-4 near the
+critical angle, which sets the floor for smaller tol.
+
+Also compares the time per lookup with the float stmm.h Stack calculation.
+
+Usage::
+
+    ~/o/qudarap/tests/QPMT_ART_table_MockTest.sh
+
+    NWL=64 NCT=128 ~/o/qudarap/tests/QPMT_ART_table_MockTest.sh
+    TOL=2e-3 BOUND=2e-3 ~/o/qudarap/tests/QPMT_ART_table_MockTest.sh
+
+**/
+
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "stimer.h"
+#include "stmm.h"
+#include "stmm_table.h"
+
+#include "srngcpu.h"
+using RNG = srngcpu ;
+
+#include "qpmt.h"
+
+
+template<typename T>
+StackSpec<T,4> MakeSpec(int cat, double wl)
+{
+    double x = (wl - 300.)/500. ;
+    StackSpec<T,4> ss ;
+    ss.ls[0].nr = 1.50 - 0.03*x ; ss.ls[0].ni = 0. ;                ss.ls[0].d = 0. ;
+    ss.ls[1].nr = 2.30 - 0.20*x ; ss.ls[1].ni = 0.01 ;              ss.ls[1].d = 40. + 15.*cat ;
+    ss.ls[2].nr = 2.90 - 0.60*x ; ss.ls[2].ni = 1.60 - 1.2*x*x ;    ss.ls[2].d = 20. + 5.*cat ;
+    ss.ls[3].nr = 1.   ;          ss.ls[3].ni = 0. ;                ss.ls[3].d = 0. ;
+    return ss ;
+}
+
+double QEShape(int cat, double energy_eV)
+{
+    return 0.3*exp( -(energy_eV - 3.0 - 0.1*cat)*(energy_eV - 3.0 - 0.1*cat)/0.5 ) ;
+}
+
+void Calc(double* asrs, int cat, double wl, double mct)
+{
+    Stack<double,4> stack( wl, mct, MakeSpec<double>(cat, wl) );
+    asrs[0] = stack.art.A_s ;
+    asrs[1] = stack.art.A_p ;
+    asrs[2] = stack.art.R_s ;
+    asrs[3] = stack.art.R_p ;
+}
+
+int main()
+{
+    int num = ssys::getenvint("NUM", 1000000) ;
+    int nwl = ssys::getenvint("NWL", stmm_table::NWL) ;
+    int nct = ssys::getenvint("NCT", stmm_table::NCT) ;
+    double tol = ssys::getenvdouble("TOL", stmm_table::TOL) ;
+    double BOUND = ssys::getenvdouble("BOUND", 1e-3) ;
+    const int ncat = 3 ;
+    const double wl0 = 300. ;
+    const double wl1 = 800. ;
+
+    stimer* t_build = stimer::create() ;
+    stmm_table* t = stmm_table::Create( ncat, wl0, wl1, Calc, QEShape, nwl, nct, tol );
+    t_build->done();
+    std::cout << t->desc() << " build " << t_build->desc() << "\n" ;
+
+    qpmt<float> pmt = {} ;
+    pmt.art_table = t->art->values<float>() ;
+    pmt.esc_table = t->esc->values<float>() ;
+    pmt.fbk_table = t->fbk->values<unsigned char>() ;
+    pmt.art_nwl = t->nwl ;
+    pmt.art_nct = t->nct ;
+    pmt.art_wl0 = wl0 ;
+    pmt.art_inv_dwl = double(t->nwl - 1)/(wl1 - wl0) ;
+
+    std::vector<float> wl(num), mct(num), dpcmn(num) ;
+    std::vector<int> cat(num) ;
+    RNG rng ;
+    for(int i=0 ; i < num ; i++)
+    {
+        cat[i] = i % ncat ;
+        wl[i] = wl0 + (wl1 - wl0)*curand_uniform(&rng) ;
+        mct[i] = 2.f*curand_uniform(&rng) - 1.f ;
+        if( std::abs(mct[i]) < stmm_table::CT_EPS ) mct[i] = stmm_table::CT_EPS ;
+        float st = sqrt( 1.f - mct[i]*mct[i] ) ;
+        dpcmn[i] = st*(2.f*curand_uniform(&rng) - 1.f) ;   // dot(pol,cross(mom,nrm)) consistent with mct
+    }
+
+    auto lookup = [&](float* art3, int i)
+    {
+        if(pmt.get_lpmtcat_ART_table( art3, cat[i], wl[i], mct[i], dpcmn[i] )) return true ;
+        Stack<float,4> stack( wl[i], mct[i], MakeSpec<float>(cat[i], wl[i]) );
+        float asrs[4] = { stack.art.A_s, stack.art.A_p, stack.art.R_s, stack.art.R_p } ;
+        double da[4] = { asrs[0], asrs[1], asrs[2], asrs[3] } ;
+        double a3[3] ;
+        stmm_table::Mix( a3, da, mct[i], dpcmn[i] );
+        for(int c=0 ; c < 3 ; c++) art3[c] = a3[c] ;
+        return false ;
+    };
+
+    double max_err[3] = {0., 0., 0.} ;
+    double sum_err[3] = {0., 0., 0.} ;
+    double max_err_host = 0. ;
+    double sum_table = 0. ;
+    double sum_direct = 0. ;
+    int num_fbk = 0 ;
+
+    stimer* t_table = stimer::create() ;
+    for(int i=0 ; i < num ; i++)
+    {
+        float art3[3] ;
+        num_fbk += int(!lookup( art3, i )) ;
+        sum_table += art3[0] ;
+    }
+    t_table->done();
+
+    stimer* t_direct = stimer::create() ;
+    for(int i=0 ; i < num ; i++)
+    {
+        Stack<float,4> stack( wl[i], mct[i], MakeSpec<float>(cat[i], wl[i]) );
+        sum_direct += stack.art.A ;
+    }
+    t_direct->done();
+
+    for(int i=0 ; i < num ; i++)
+    {
+        float art3[3] ;
+        bool tab = lookup( art3, i );
+        if( tab == t->fallback( cat[i], wl[i], mct[i] ) ) max_err_host = 1. ;  // fbk check differs from host reference
+
+        double asrs[4], direct[3], host[3] ;
+        Calc( asrs, cat[i], wl[i], mct[i] );
+        stmm_table::Mix( direct, asrs, mct[i], dpcmn[i] );
+        if(tab) t->lookup_art( host, cat[i], wl[i], mct[i], dpcmn[i] );
+
+        for(int c=0 ; c < 3 ; c++)
+        {
+            double e = std::abs( art3[c] - direct[c] ) ;
+            max_err[c] = std::max( max_err[c], e );
+            sum_err[c] += e ;
+            if(tab) max_err_host = std::max( max_err_host, std::abs( art3[c] - host[c] ) );
+        }
+    }
+
+    int rc = 0 ;
+    for(int c=0 ; c < 3 ; c++) if( max_err[c] > BOUND || sum_err[c]/num > 1e-4 ) rc += 1 ;
+    if( max_err_host > 1e-5 ) rc += 1 ;
+
+    float esc_0 = pmt.get_lpmtcat_esc_table( 0, 413.f ) ;
+    double asrs_n[4] ;
+    Calc( asrs_n, 0, 413., -1. );
+    double esc_x = QEShape(0, stmm_table::hc_eVnm/413.)/asrs_n[0] ;
+    double esc_err = std::abs( esc_0 - esc_x )/esc_x ;
+    if( esc_err > 1e-2 ) rc += 1 ;
+
+    const char* label[3] = { "A", "R", "T" } ;
+    for(int c=0 ; c < 3 ; c++) std::cout
+        << " " << label[c]
+        << " max_err " << std::scientific << std::setprecision(3) << max_err[c]
+        << " mean_err " << sum_err[c]/num
+        << "\n"
+        ;
+    std::cout
+        << " BOUND " << BOUND
+        << " tol " << tol
+        << " max_err_table " << t->max_err_table()
+        << " max_err_raw " << t->max_err(0)
+        << " fbk_fraction cells " << t->fbk_fraction() << " lookups " << double(num_fbk)/num
+        << "\n"
+        << " max_err_host " << max_err_host
+        << " esc_err " << esc_err
+        << "\n"
+        << " table " << std::fixed << std::setprecision(1) << 1e9*t_table->duration()/num << " ns"
+        << " stmm float " << 1e9*t_direct->duration()/num << " ns"
+        << " (" << std::setprecision(4) << sum_table/num << " " << sum_direct/num << ")"
+        << "\n"
+        << "QPMT_ART_table_MockTest rc " << rc << "\n"
+        ;
+    return rc == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,58 @@
+#!/bin/bash
+usage(){ cat << EOU
+QPMT_ART_table_MockTest.sh
+==========================
+
+Tabulated PMT TMM A,R,T (stmm_table.h, qpmt::get_lpmtcat_ART_table)
+compared with the stmm.h stack calculation using MOCK_CURAND MOCK_CUDA::
+
+   ~/o/qudarap/tests/QPMT_ART_table_MockTest.sh
+
+   NWL=64 NCT=512 ~/o/qudarap/tests/QPMT_ART_table_MockTest.sh
+   TOL=2e-3 BOUND=2e-3 ~/o/qudarap/tests/QPMT_ART_table_MockTest.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=QPMT_ART_table_MockTest
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE FOLD bin name OPTICKS_PREFIX CUDA_PREFIX"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc \
+       -O2 \
+       -std=c++17 -lstdc++ -lm -pthread \
+       -DMOCK_CURAND \
+       -DMOCK_CUDA \
+       -I.. \
+       -I../../sysrap \
+       -I$CUDA_PREFIX/include \
+       -I$OPTICKS_PREFIX/externals/glm/glm \
+       -I$OPTICKS_PREFIX/externals/plog/include \
+       -o $bin
+
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
@@ -0,0 +1,118 @@
+/**
+QProp_resample_test.cc : accuracy and speed of the qprop uniform fast path
+=============================================================================
+
+Builds synthetic properties combined with NP::Combine:
+
+0. rindex like, uniform 1nm domain, smooth
+1. dense non-uniform domain, smooth
+2. log spread domain over four decades, absorption length like
+3. kinked, step change in slope mid domain
+4. single value property (mode none, binary search)
+
+For each property random lookups with qprop::interpolate_uniform are compared
+with qprop::interpolate_search, checking the deviation is within the
+per property bound reported by QProp::Resample (plus float rounding),
+and the time per lookup of both paths is reported.
+
+Usage::
+
+    ~/o/qudarap/tests/QProp_resample_test.sh
+
+**/
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "stimer.h"
+#include "NP.hh"
+
+#include "srngcpu.h"
+#include "QProp.hh"
+#include "qprop.h"
+
+NP* MakeProp(int kind)
+{
+    std::vector<double> xx, yy ;
+    switch(kind)
+    {
+        case 0: for(int i=0 ; i <= 760 ; i++){ double x = 60. + i ; xx.push_back(x) ; yy.push_back( 1.33 + 0.05*exp(-(x-250.)*(x-250.)/(80.*80.)) ) ; } ; break ;
+        case 1: for(int i=0 ; i <  300 ; i++){ double t = i/299. ; double x = 1.5 + 14.*t*t ; xx.push_back(x) ; yy.push_back( 2. + sin(x) ) ; } ; break ;
+        case 2: for(int i=0 ; i <  200 ; i++){ double x = pow(10., -1. + 4.*i/199.) ; xx.push_back(x) ; yy.push_back( 1000.*(1. + log10(x+1.)) ) ; } ; break ;
+        case 3: for(int i=0 ; i <   50 ; i++){ double x = i/49. ; xx.push_back(x) ; yy.push_back( x < 0.5 ? x : 0.5 + 10.*(x-0.5) ) ; } ; break ;
+        case 4: xx.push_back(1.) ; yy.push_back(42.) ; break ;
+    }
+    NP* a = NP::Make<float>( xx.size(), 2 );
+    float* aa = a->values<float>();
+    for(unsigned i=0 ; i < xx.size() ; i++){ aa[2*i+0] = xx[i] ; aa[2*i+1] = yy[i] ; }
+    return a ;
+}
+
+int main()
+{
+    int num = ssys::getenvint("NUM", 1000000) ;
+    double tol = ssys::getenvdouble("TOL", 1e-4) ;
+
+    std::vector<const NP*> pp ;
+    for(int k=0 ; k < 5 ; k++) pp.push_back( MakeProp(k) );
+    NP* a = NP::Combine(pp) ;
+
+    QProp<float> qp(a, tol) ;
+    std::cout << qp.desc() << "\n" << qp.desc_resample() ;
+
+    qprop<float>* prop = qp.getDevicePtr() ;
+    const double* ee = qp.uerr->cvalues<double>() ;
+    srngcpu rng ;
+
+    int rc = 0 ;
+    std::vector<float> xx(num) ;
+    for(unsigned p=0 ; p < qp.ni ; p++)
+    {
+        const NP* src = pp[p] ;
+        float x0 = src->cvalues<float>()[0] ;
+        float x1 = src->cvalues<float>()[2*(src->shape[0]-1)] ;
+        float dx = x1 - x0 ;
+        for(int i=0 ; i < num ; i++) xx[i] = x0 - 0.05f*dx + 1.1f*dx*curand_uniform(&rng) ;
+
+        double ymax = 0. ;
+        for(int k=0 ; k < src->shape[0] ; k++) ymax = std::max( ymax, std::abs(double(src->cvalues<float>()[2*k+1])) );
+
+        double max_err = 0. ;
+        double s_search = 0., s_uniform = 0. ;
+
+        stimer* t_search = stimer::create() ;
+        for(int i=0 ; i < num ; i++) s_search += prop->interpolate_search(p, xx[i]) ;
+        t_search->done();
+
+        stimer* t_uniform = stimer::create() ;
+        for(int i=0 ; i < num ; i++) s_uniform += prop->interpolate(p, xx[i]) ;
+        t_uniform->done();
+
+        for(int i=0 ; i < num ; i++) max_err = std::max( max_err, std::abs( double(prop->interpolate(p, xx[i])) - double(prop->interpolate_search(p, xx[i])) ) );
+
+        int mode = ee[p*4+1] ;
+        double bound = mode == qprop<float>::NONE ? 0. : ee[p*4+2] + 1e-5*ymax ;
+        bool pass = max_err <= bound ;
+        if(!pass) rc += 1 ;
+
+        std::cout
+            << " iprop " << p
+            << " n " << std::setw(5) << int(ee[p*4+0])
+            << " mode " << mode
+            << " max_err " << std::scientific << std::setprecision(3) << max_err
+            << " bound " << bound
+            << " search " << std::fixed << std::setprecision(2) << 1e9*t_search->duration()/num << " ns"
+            << " uniform " << 1e9*t_uniform->duration()/num << " ns"
+            << " (" << std::setprecision(3) << (s_search - s_uniform)/num << ")"
+            << ( pass ? " PASS" : " FAIL" )
+            << "\n"
+            ;
+        delete t_search ;
+        delete t_uniform ;
+    }
+    std::cout << "QProp_resample_test rc " << rc << "\n" ;
+    return rc == 0 ? 0 : 1 ;
+}
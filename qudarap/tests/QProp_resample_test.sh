@@ -0,0 +1,56 @@
+#!/bin/bash
+usage(){ cat << EOU
+QProp_resample_test.sh
+========================
+
+Accuracy and speed of the qprop uniform/log-uniform fast path
+compared with the binary search using MOCK_CURAND::
+
+   ~/o/qudarap/tests/QProp_resample_test.sh
+
+   TOL=1e-5 ~/o/qudarap/tests/QProp_resample_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=QProp_resample_test
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE FOLD bin name OPTICKS_PREFIX CUDA_PREFIX"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc ../QProp.cc \
+       -O2 \
+       -std=c++17 -lstdc++ -lm \
+       -DMOCK_CURAND \
+       -I.. \
+       -I../../sysrap \
+       -I$CUDA_PREFIX/include \
+       -I$OPTICKS_PREFIX/externals/glm/glm \
+       -I$OPTICKS_PREFIX/externals/plog/include \
+       -o $bin
+
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
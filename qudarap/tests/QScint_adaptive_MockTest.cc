@@ -0,0 +1,229 @@
+/**
+QScint_adaptive_MockTest.cc : accuracy and throughput of adaptive scintillation ICDF
+=======================================================================================
+
+A synthetic three peak emission spectrum is inverted on a fine grid
+giving the "true" ICDF, which is sampled into a (3,4096,1) hd_factor 20
+table following U4Scint::CreateGeant4InterpolatedInverseCDF.
+
+qscint::wavelength is then compared using MOCK_TEXTURE for::
+
+    hd20        the existing fixed resolution texture (linear filtering)
+    adaptive    sscint_icdf packed table for a range of tolerances
+
+Reported for each are the texel count, the max and mean deviation from
+the sscint_icdf reference (piecewise linear source table) and from the
+true ICDF, and ns per lookup on CPU. The builder maximum error and the
+measured max_ref must both be within the tolerance, the qscint lookup must
+match the sscint_icdf::lookup host mirror exactly. The allowance *eps*
+added to the tolerance for max_ref covers only float rounding of the knots
+and of the lerp, 4 ulp of the longest wavelength (~2.4e-4 nm at 650 nm).
+
+Standalone compile and run with::
+
+   ~/o/qudarap/tests/QScint_adaptive_MockTest.sh
+
+   NUM=10000000 ~/o/qudarap/tests/QScint_adaptive_MockTest.sh
+
+**/
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+
+#include "srngcpu.h"
+using RNG = srngcpu ;
+
+#include "stexture.h"
+MockTextureManager* MockTextureManager::INSTANCE = nullptr ;
+
+#include "qscint.h"
+#include "sscint_icdf.h"
+
+
+struct QScint_adaptive_MockTest
+{
+    static constexpr const int NJ = 4096 ;
+    static constexpr const int HD = 20 ;
+    static constexpr const int NF = 200001 ;      // fine grid of the true ICDF
+    static constexpr const double WL0 = 300. ;
+    static constexpr const double WL1 = 650. ;
+
+    struct Result
+    {
+        std::string label ;
+        size_t num_texel ;
+        double max_ref ;
+        double mean_ref ;
+        double max_true ;
+        double mean_true ;
+        double ns ;
+        std::string desc() const ;
+    };
+
+    int num ;
+    std::vector<double> fcdf ;    // CDF on the fine wavelength grid
+    NP* icdf ;
+    std::vector<float> uu ;
+
+    QScint_adaptive_MockTest();
+
+    static double Spectrum( double wl );
+    double true_icdf( double u ) const ;
+    NP*    make_icdf() const ;
+
+    Result measure( const char* label, const qscint& sc, size_t num_texel, const sscint_icdf& ref ) const ;
+    int main();
+};
+
+inline std::string QScint_adaptive_MockTest::Result::desc() const
+{
+    std::stringstream ss ;
+    ss << std::setw(16) << label
+       << " num_texel " << std::setw(6) << num_texel
+       << " max_ref " << std::scientific << std::setprecision(3) << max_ref
+       << " mean_ref " << mean_ref
+       << " max_true " << max_true
+       << " mean_true " << mean_true
+       << " ns/lookup " << std::fixed << std::setprecision(2) << ns
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+double QScint_adaptive_MockTest::Spectrum( double wl ) // static
+{
+    auto g = [](double x, double mu, double sg){ return std::exp(-0.5*(x-mu)*(x-mu)/(sg*sg)) ; } ;
+    return g(wl, 425., 12.) + 0.6*g(wl, 445., 20.) + 0.15*g(wl, 490., 35.) ;
+}
+
+QScint_adaptive_MockTest::QScint_adaptive_MockTest()
+    :
+    num(ssys::getenvint("NUM", 2000000)),
+    fcdf(NF, 0.),
+    icdf(nullptr),
+    uu(num)
+{
+    double dw = (WL1 - WL0)/(NF - 1) ;
+    for(int i=1 ; i < NF ; i++)
+    {
+        double wa = WL0 + (i-1)*dw ;
+        fcdf[i] = fcdf[i-1] + 0.5*dw*(Spectrum(wa) + Spectrum(wa + dw)) ;
+    }
+    for(int i=0 ; i < NF ; i++) fcdf[i] /= fcdf[NF-1] ;
+    icdf = make_icdf();
+
+    std::mt19937_64 gen(1) ;
+    std::uniform_real_distribution<float> dis(0.f, 1.f) ;
+    for(int i=0 ; i < num ; i++) uu[i] = 1.f - dis(gen) ;   // (0,1] as curand_uniform
+}
+
+double QScint_adaptive_MockTest::true_icdf( double u ) const
+{
+    int j = int(std::upper_bound( fcdf.begin(), fcdf.end(), u ) - fcdf.begin()) ;
+    j = std::min( std::max( j, 1 ), NF - 1 ) ;
+    double f = (u - fcdf[j-1])/(fcdf[j] - fcdf[j-1]) ;
+    return WL0 + (WL1 - WL0)*(double(j-1) + f)/double(NF - 1) ;
+}
+
+/**
+QScint_adaptive_MockTest::make_icdf
+-------------------------------------
+
+Same u sampling as U4Scint::CreateGeant4InterpolatedInverseCDF
+
+**/
+
+NP* QScint_adaptive_MockTest::make_icdf() const
+{
+    NP* a = NP::Make<double>(3, NJ, 1) ;
+    a->set_meta<int>("hd_factor", HD );
+    double edge = 1./double(HD) ;
+    for(int j=0 ; j < NJ ; j++)
+    {
+        a->set<double>( true_icdf( double(j)/double(NJ) ),                      0, j, 0 );
+        a->set<double>( true_icdf( double(j)/double(HD*NJ) ),                   1, j, 0 );
+        a->set<double>( true_icdf( 1. - edge + double(j)/double(HD*NJ) ),       2, j, 0 );
+    }
+    return a ;
+}
+
+QScint_adaptive_MockTest::Result QScint_adaptive_MockTest::measure( const char* label, const qscint& sc, size_t num_texel, const sscint_icdf& ref ) const
+{
+    Result r = {} ;
+    r.label = label ;
+    r.num_texel = num_texel ;
+
+    std::vector<float> wl(num) ;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++) wl[i] = sc.wavelength(uu[i]) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    r.ns = std::chrono::duration<double, std::nano>(t1 - t0).count()/num ;
+
+    for(int i=0 ; i < num ; i++)
+    {
+        double dr = std::abs( wl[i] - ref.reference(uu[i]) ) ;
+        double dt = std::abs( wl[i] - true_icdf(uu[i]) ) ;
+        r.max_ref = std::max( r.max_ref, dr );
+        r.max_true = std::max( r.max_true, dt );
+        r.mean_ref += dr ;
+        r.mean_true += dt ;
+    }
+    r.mean_ref /= num ;
+    r.mean_true /= num ;
+    return r ;
+}
+
+int QScint_adaptive_MockTest::main()
+{
+    NP* src = NP::MakeNarrow(icdf) ;
+    sscint_icdf ref(icdf, 1e9, 1, 0) ;   // only for reference()
+
+    qscint hd = {} ;
+    hd.scint_tex = MockTextureManager::Add(src, 'L') ;
+    hd.hd_factor = HD ;
+    Result r_hd = measure( "hd20", hd, 3*NJ, ref );
+    std::cout << "QScint_adaptive_MockTest::main num " << num << std::endl << r_hd.desc() << std::endl ;
+
+    int rc = 0 ;
+    double eps = 4.*( double(std::nextafter(float(WL1), 1e9f)) - WL1 ) ;   // float rounding of knots and lerp
+    double tols[] = { 0.1, 0.01, 0.001 } ;
+    for(double tol : tols)
+    {
+        sscint_icdf ad(icdf, tol) ;
+        NP* tex = ad.make_tex() ;
+
+        qscint sc = {} ;
+        sc.icdf_tex = MockTextureManager::Add(tex, 'P') ;
+        sc.icdf_seg = ad.seg.data() ;
+        sc.icdf_nseg = ad.nseg ;
+        sc.icdf_inv_width = 1.f/float(tex->shape[1]) ;
+
+        std::stringstream ss ;
+        ss << "adaptive " << tol ;
+        std::string label = ss.str();
+        Result r = measure( label.c_str(), sc, ad.tex.size(), ref );
+
+        int num_mismatch = 0 ;
+        for(int i=0 ; i < num ; i++) if( sc.wavelength(uu[i]) != ad.lookup(uu[i]) ) num_mismatch += 1 ;
+
+        bool ok = ad.max_error() <= tol && r.max_ref <= tol + eps && num_mismatch == 0 && r.mean_ref < r_hd.mean_ref ;
+        if(!ok) rc += 1 ;
+        std::cout << r.desc() << " num_mismatch " << num_mismatch << " " << ( ok ? "PASS" : "FAIL" ) << std::endl << "    " << ad.desc() << std::endl ;
+    }
+    std::cout << "QScint_adaptive_MockTest::main rc " << rc << std::endl ;
+    return rc ;
+}
+
+int main()
+{
+    QScint_adaptive_MockTest t ;
+    return t.main() ;
+}
@@ -0,0 +1,310 @@
+/**
+QSim_weight_MockTest.cc : CPU check of weighted propagation against analogue
+===============================================================================
+
+Photons start at the centre of a sphere of scintillator-like medium
+(absorption, rayleigh scattering and reemission) and are propagated
+with qsim::propagate_to_boundary until they reach the sphere surface,
+which counts as detection, or end in the bulk.
+
+analogue
+    sevent::weight_threshold 0, detection fraction f and its binomial error
+weighted
+    sevent::weight_threshold > 0 via qsim::propagate_to_boundary_weighted,
+    mean weight at the surface (zero for rouletted photons) and its error
+
+The weighted mean must agree with the analogue fraction within 4 sigma.
+The figure of merit 1/(variance*time) is reported but not required to
+improve: for this medium weighted running is less efficient than analogue,
+fom ratio 0.3-0.8 over RADIUS 3000-6000 and THRESHOLD 0.05-0.3, which is
+why weighted propagation is off by default and documented as experimental.
+
+Also checks that the half float sphoton weight survives sphoton::reduce_op
+merging with weighted set, and that summing many small weights in float
+with a single rounding to half (as SPM does) stays within half precision
+whereas chaining the half float reduce_op does not.
+
+Standalone compile and run with::
+
+   ~/o/qudarap/tests/QSim_weight_MockTest.sh
+
+   NUM=1000000 RADIUS=5000 ~/o/qudarap/tests/QSim_weight_MockTest.sh
+
+**/
+
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "smath.h"
+#include "squad.h"
+#include "srec.h"
+#include "stag.h"
+#include "sflow.h"
+#include "sphoton.h"
+#include "sstate.h"
+#include "scerenkov.h"
+#include "sphotonlite.h"
+
+#include "srngcpu.h"
+using RNG = srngcpu ;
+
+#include "stexture.h"
+MockTextureManager* MockTextureManager::INSTANCE = nullptr ;
+
+#include "qsim.h"
+
+
+struct QSim_weight_MockTest
+{
+    struct Result
+    {
+        const char* label ;
+        int    num ;
+        double mean ;
+        double sigma ;    // standard error of mean
+        double seconds ;
+        int    num_roulette ;
+        double fom() const { return sigma > 0. ? 1./(sigma*sigma*num*seconds) : 0. ; }
+        std::string desc() const ;
+    };
+
+    int    num ;
+    float  radius ;
+    float  absorption_length ;
+    float  scattering_length ;
+    float  reemission_prob ;
+    float  threshold ;
+
+    RNG    rng ;
+    sevent evt ;
+    qscint scint ;
+    qsim   sim ;
+
+    QSim_weight_MockTest();
+
+    Result run( float weight_threshold );
+    int check_propagate();
+    int check_reduce() const ;
+    int main();
+};
+
+inline std::string QSim_weight_MockTest::Result::desc() const
+{
+    std::stringstream ss ;
+    ss << std::setw(10) << label
+       << " num " << std::setw(8) << num
+       << " mean " << std::fixed << std::setprecision(5) << mean
+       << " sigma " << std::setprecision(5) << sigma
+       << " seconds " << std::setprecision(3) << seconds
+       << " num_roulette " << std::setw(8) << num_roulette
+       << " fom " << std::scientific << std::setprecision(3) << fom()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+inline QSim_weight_MockTest::QSim_weight_MockTest()
+    :
+    num(ssys::getenvint("NUM", 200000)),
+    radius(ssys::getenvfloat("RADIUS", 3000.f)),
+    absorption_length(ssys::getenvfloat("ABSORPTION_LENGTH", 800.f)),
+    scattering_length(ssys::getenvfloat("SCATTERING_LENGTH", 2000.f)),
+    reemission_prob(ssys::getenvfloat("REEMISSION_PROB", 0.4f)),
+    threshold(ssys::getenvfloat("THRESHOLD", 0.1f)),
+    rng(),
+    evt{},
+    scint{},
+    sim{}
+{
+    NP* wl = NP::Make<float>(1, 64, 4) ;   // constant reemission wavelength
+    float* vv = wl->values<float>() ;
+    for(int i=0 ; i < wl->num_values() ; i++) vv[i] = 430.f ;
+
+    scint.scint_tex = MockTextureManager::Add(wl) ;
+    scint.hd_factor = 0 ;
+
+    sim.scint = &scint ;
+    sim.evt = &evt ;
+}
+
+/**
+QSim_weight_MockTest::run
+---------------------------
+
+The prd distance_to_boundary is the distance along the current
+direction to the sphere surface.
+
+**/
+
+inline QSim_weight_MockTest::Result QSim_weight_MockTest::run( float weight_threshold )
+{
+    evt.weight_threshold = weight_threshold ;
+    rng.seed = 1 ;
+
+    sstate s = {} ;
+    s.material1 = make_float4( 1.5f, absorption_length, scattering_length, reemission_prob );
+    s.m1group2  = make_float4( 200.f, 0.f, 0.f, 0.f );
+
+    quad2 prd = {} ;
+
+    Result r = {} ;
+    r.label = weight_threshold > 0.f ? "weighted" : "analogue" ;
+    r.num = num ;
+
+    double sum = 0. ;
+    double sum2 = 0. ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num ; i++)
+    {
+        sctx ctx = {} ;
+        ctx.evt = &evt ;
+        ctx.prd = &prd ;
+        ctx.s = s ;
+        ctx.p.pos = make_float3( 0.f, 0.f, 0.f );
+        ctx.p.mom = make_float3( 0.f, 0.f, 1.f );
+        ctx.p.pol = make_float3( 1.f, 0.f, 0.f );
+        ctx.p.wavelength = 430.f ;
+
+        int command = START ;
+        for(int bounce=0 ; bounce < 1000 ; bounce++)
+        {
+            const float3& o = ctx.p.pos ;
+            const float3& d = ctx.p.mom ;
+            float b = dot(o, d) ;
+            float c = dot(o, o) - radius*radius ;
+            prd.q0.f.w = -b + sqrtf( fmaxf( b*b - c, 0.f )) ;
+
+            unsigned flag = 0 ;
+            command = sim.propagate_to_boundary( flag, rng, ctx );
+            if( command != CONTINUE ) break ;
+        }
+
+        double w = 0. ;
+        if( command == BOUNDARY )
+        {
+            w = weight_threshold > 0.f ? expf(-ctx.tau) : 1. ;
+        }
+        else if( weight_threshold > 0.f && command == BREAK )
+        {
+            r.num_roulette += 1 ;
+        }
+        sum += w ;
+        sum2 += w*w ;
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    r.seconds = std::chrono::duration<double>(t1 - t0).count() ;
+    r.mean = sum/num ;
+    double var = sum2/num - r.mean*r.mean ;
+    r.sigma = std::sqrt( std::max(var, 0.)/num ) ;
+    return r ;
+}
+
+inline int QSim_weight_MockTest::check_propagate()
+{
+    Result a = run(0.f) ;
+    Result w = run(threshold) ;
+
+    double diff = std::abs(a.mean - w.mean) ;
+    double sig = std::sqrt( a.sigma*a.sigma + w.sigma*w.sigma ) ;
+    bool ok = diff < 4.*sig ;
+
+    std::cout
+        << "QSim_weight_MockTest::check_propagate"
+        << " radius " << radius
+        << " absorption_length " << absorption_length
+        << " scattering_length " << scattering_length
+        << " reemission_prob " << reemission_prob
+        << " threshold " << threshold
+        << std::endl
+        << a.desc() << std::endl
+        << w.desc() << std::endl
+        << " diff/sig " << std::fixed << std::setprecision(3) << ( sig > 0. ? diff/sig : 0. )
+        << " fom ratio weighted/analogue " << ( a.fom() > 0. ? w.fom()/a.fom() : 0. )
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+/**
+QSim_weight_MockTest::check_reduce
+-------------------------------------
+
+Weights stored as half float, so sums are within the half precision.
+
+**/
+
+inline int QSim_weight_MockTest::check_reduce() const
+{
+    sphoton a = {} ;
+    sphoton b = {} ;
+    a.time = 1.f ;
+    b.time = 2.f ;
+    a.set_iindex__(42) ;
+    b.set_iindex__(42) ;
+    a.set_weight(0.25f) ;
+    b.set_weight(0.6f) ;
+
+    sphoton::reduce_op op{ true } ;
+    sphoton r = op(a, b) ;
+
+    sphotonlite la = {} ;
+    sphotonlite lb = {} ;
+    la.set_weight(0.125f) ;
+    lb.set_weight(1.f) ;
+    sphotonlite::reduce_op lop{ true } ;
+    sphotonlite lr = lop(la, lb) ;
+
+    const int N = 2000 ;
+    const float w0 = 0.01f ;
+    sphotonlite h = {} ;
+    h.set_weight(w0) ;                // w0 as rounded to half
+    sphotonlite chain = h ;
+    float facc = h.weight() ;
+    for(int i=1 ; i < N ; i++)
+    {
+        chain = lop(chain, h) ;       // rounds to half at every addition
+        facc += h.weight() ;          // float accumulation as SPM
+    }
+    sphotonlite fl = {} ;
+    fl.set_weight(facc) ;
+    float expect = N*h.weight() ;
+    float chain_rel = std::abs( chain.weight() - expect )/expect ;
+    float float_rel = std::abs( fl.weight() - expect )/expect ;
+
+    bool ok = std::abs( r.weight() - 0.85f ) < 1e-3f && r.iindex() == 42 && std::abs( lr.weight() - 1.125f ) < 1e-3f ;
+    ok &= float_rel < 1e-3f ;
+    std::cout
+        << "QSim_weight_MockTest::check_reduce"
+        << " r.weight " << r.weight()
+        << " r.iindex " << r.iindex()
+        << " lr.weight " << lr.weight()
+        << " sum of " << N << " x " << w0 << " expect " << expect
+        << " float_rel " << float_rel
+        << " chained_half_rel " << chain_rel
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+inline int QSim_weight_MockTest::main()
+{
+    int rc = 0 ;
+    rc += check_reduce();
+    rc += check_propagate();
+    std::cout << "QSim_weight_MockTest::main rc " << rc << std::endl ;
+    return rc ;
+}
+
+int main()
+{
+    QSim_weight_MockTest t ;
+    return t.main() ;
+}
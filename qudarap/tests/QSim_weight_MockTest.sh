@@ -0,0 +1,57 @@
+#!/bin/bash
+usage(){ cat << EOU
+QSim_weight_MockTest.sh
+=======================
+
+CPU comparison of weighted propagation (OPTICKS_PROPAGATE_WEIGHT_THRESHOLD)
+with analogue propagation using MOCK_CUDA MOCK_CURAND MOCK_TEXTURE::
+
+   ~/o/qudarap/tests/QSim_weight_MockTest.sh
+
+   NUM=1000000 REEMISSION_PROB=0 THRESHOLD=0.01 ~/o/qudarap/tests/QSim_weight_MockTest.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=QSim_weight_MockTest
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE FOLD bin name OPTICKS_PREFIX CUDA_PREFIX"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+    gcc $name.cc \
+       -O2 \
+       -std=c++17 -lstdc++ -lm -pthread \
+       -DMOCK_CUDA \
+       -DMOCK_CURAND \
+       -DMOCK_TEXTURE \
+       -I.. \
+       -I../../sysrap \
+       -I$CUDA_PREFIX/include \
+       -I$OPTICKS_PREFIX/externals/glm/glm \
+       -o $bin
+
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
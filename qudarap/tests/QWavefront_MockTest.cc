@@ -0,0 +1,357 @@
+/**
+QWavefront_MockTest.cc : CPU check of wavefront simulation against the megakernel loop
+=========================================================================================
+
+Geometry is two concentric spheres with a mock trace standing in for OptiX::
+
+    boundary 0 : radius R0, glass inside water
+    boundary 1 : radius R1, water inside rock with a detecting, specular reflecting inner surface
+
+Torch photons are simulated twice with identical RNG initialization:
+
+megakernel
+    host replica of the CSGOptiX7.cu:simulate bounce loop, one photon at a time
+wavefront
+    qwavefront::simulate running the generate/trace/propagate/compact/finalize
+    stages over the queue of active slots
+
+The photons must be bitwise identical. Also reported is the number
+of active slots at each bounce and the SIMT lane utilization of the
+two approaches, ie the fraction of lane steps doing useful work
+with warps of 32 threads::
+
+    megakernel : sum_bounce / sum_warps( 32*max_bounce_in_warp )
+    wavefront  : sum_bounce / sum_bounces( 32*ceil(num_active/32) )
+
+Standalone compile and run with::
+
+   ~/o/qudarap/tests/QWavefront_MockTest.sh
+
+   NUM=100000 ~/o/qudarap/tests/QWavefront_MockTest.sh
+
+**/
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "ssys.h"
+#include "scuda.h"
+#include "smath.h"
+#include "squad.h"
+#include "srec.h"
+#include "stag.h"
+#include "sflow.h"
+#include "sphoton.h"
+#include "sstate.h"
+#include "scerenkov.h"
+#include "sphotonlite.h"
+
+#include "sphilox.h"
+using RNG = sphilox ;
+
+#include "stexture.h"
+MockTextureManager* MockTextureManager::INSTANCE = nullptr ;
+
+#include "qsim.h"
+#include "qwavefront.h"
+
+
+struct QWavefront_MockTest
+{
+    static constexpr const int NI = 2 ;      // boundaries
+    static constexpr const int NWL = 39 ;
+    static constexpr const float WL0 = 60.f ;
+    static constexpr const float WLS = 20.f ;
+    static constexpr const float R0 = 100.f ;
+    static constexpr const float R1 = 200.f ;
+    static constexpr const float TMIN = 0.1f ;
+    static constexpr const int WARP = 32 ;
+
+    struct Trace
+    {
+        void operator()( quad2* prd, const sctx& ctx ) const ;
+    };
+
+    int num ;
+    int max_bounce ;
+
+    NP*               bnd ;
+    std::vector<quad> optical ;
+    quad4             meta ;
+    qbnd              qb ;
+    qbase             base ;
+    qrng<RNG>         qr ;
+    quad6             gs ;
+    std::vector<int>  seed ;
+    sevent            evt ;
+    qsim              sim ;
+    Trace             trace_fn ;
+
+    std::vector<sphoton> photon_m ;
+    std::vector<sphoton> photon_w ;
+    std::vector<int>     bounce_m ;     // per slot bounce count of megakernel
+
+    QWavefront_MockTest();
+    static NP* MakeBnd();
+
+    void megakernel();
+    int  wavefront( std::vector<unsigned>& num_active_bounce );
+    int  main();
+};
+
+
+/**
+QWavefront_MockTest::MakeBnd
+------------------------------
+
+Constant properties across wavelength, materials 0:water 1:glass 2:rock
+and one surface with detect, absorb, reflect_specular 0.3 0.2 0.5
+
+**/
+
+NP* QWavefront_MockTest::MakeBnd()
+{
+    float mat[3][8] = {
+        { 1.33f, 20000.f,   3000.f, 0.f,  299.792458f/1.33f, 0.f, 0.f, 0.f },
+        { 1.50f,  5000.f, 100000.f, 0.f,  299.792458f/1.50f, 0.f, 0.f, 0.f },
+        { 1.00f,     1.f, 100000.f, 0.f,  299.792458f      , 0.f, 0.f, 0.f }
+    };
+    float sur[8]  = { 0.3f, 0.2f, 0.5f, 0.f,  0.f, 0.f, 0.f, 0.f } ;
+    float none[8] = {} ;
+
+    const float* line[NI][4] = {
+        { mat[0], none, none, mat[1] },      // OMAT OSUR ISUR IMAT
+        { mat[2], none, sur,  mat[0] }
+    };
+
+    NP* a = NP::Make<float>( NI, 4, 2, NWL, 4 );
+    float* aa = a->values<float>();
+    for(int i=0 ; i < NI ; i++)
+    for(int j=0 ; j < 4 ; j++)
+    for(int k=0 ; k < 2 ; k++)
+    for(int l=0 ; l < NWL ; l++)
+    for(int m=0 ; m < 4 ; m++) aa[((((i*4+j)*2+k)*NWL)+l)*4+m] = line[i][j][k*4+m] ;
+    return a ;
+}
+
+QWavefront_MockTest::QWavefront_MockTest()
+    :
+    num(ssys::getenvint("NUM", 20000)),
+    max_bounce(ssys::getenvint("MAX_BOUNCE", 32)),
+    bnd(MakeBnd()),
+    optical(NI*4),
+    meta{},
+    qb{},
+    base{},
+    qr(0ull, 0ull, 100000ull),
+    gs{},
+    seed(num, 0),
+    evt{},
+    sim{},
+    photon_m(num),
+    photon_w(num),
+    bounce_m(num, 0)
+{
+    for(int l=0 ; l < NI*4 ; l++) optical[l].u = l == 1*4 + 2 ? make_uint4(1u, 2u, 0u, 0u) : make_uint4(0u, 1u, 0u, 0u) ;  // smatsur_Surface OR smatsur_NoSurface
+
+    meta.q0.u.x = NWL ;
+    meta.q0.u.y = NI*4*2 ;
+    meta.q1.f.x = WL0 ;
+    meta.q1.f.z = WLS ;
+
+    qb.boundary_tex = MockTextureManager::Add(bnd, 'L') ;
+    qb.boundary_meta = &meta ;
+    qb.optical = optical.data() ;
+
+    base.pidx = -1 ;
+
+    storch::FillGenstep( (storch&)gs, 0, num );
+
+    evt.index = 0 ;
+    evt.max_bounce = max_bounce ;
+    evt.num_seed = num ;
+    evt.seed = seed.data() ;
+    evt.genstep = &gs ;
+
+    sim.evt = &evt ;
+    sim.bnd = &qb ;
+    sim.base = &base ;
+    sim.rng = &qr ;
+}
+
+/**
+QWavefront_MockTest::Trace
+----------------------------
+
+Nearest intersect beyond TMIN with either sphere, outwards normals.
+
+**/
+
+void QWavefront_MockTest::Trace::operator()( quad2* prd, const sctx& ctx ) const
+{
+    const float3& o = ctx.p.pos ;
+    const float3& d = ctx.p.mom ;
+    float b = dot(o, d) ;
+    float oo = dot(o, o) ;
+
+    float t = 1e30f ;
+    unsigned bn = 0xffffu ;
+    float radius[NI] = { R0, R1 } ;
+    for(int i=0 ; i < NI ; i++)
+    {
+        float disc = b*b - (oo - radius[i]*radius[i]) ;
+        if( disc < 0.f ) continue ;
+        float sd = sqrtf(disc) ;
+        float t0 = -b - sd ;
+        float t1 = -b + sd ;
+        float ti = t0 > TMIN ? t0 : ( t1 > TMIN ? t1 : 1e30f ) ;
+        if( ti < t ) { t = ti ; bn = i ; }
+    }
+
+    prd->zero();
+    if( bn == 0xffffu )
+    {
+        prd->set_globalPrimIdx_boundary( 0u, 0xffffu );
+        return ;
+    }
+    float3 pos = o + t*d ;
+    float3 nrm = pos/(bn == 0 ? R0 : R1) ;
+    prd->q0.f = make_float4( nrm.x, nrm.y, nrm.z, t );
+    prd->set_lpos( nrm.z, atan2f(nrm.y, nrm.x) );
+    prd->set_globalPrimIdx_boundary( bn, bn );
+    prd->set_iindex_identity( bn, bn == 1 ? 1u : 0u );
+}
+
+/**
+QWavefront_MockTest::megakernel
+---------------------------------
+
+As CSGOptiX7.cu:simulate for each slot in turn.
+
+**/
+
+void QWavefront_MockTest::megakernel()
+{
+    evt.photon = photon_m.data() ;
+    float max_time = 1.e27f ;
+    for(int idx=0 ; idx < num ; idx++)
+    {
+        quad2 prd = {} ;
+        RNG rng ;
+        sim.rng->init( rng, evt.index, idx );
+
+        sctx ctx = {} ;
+        ctx.evt = &evt ;
+        ctx.prd = &prd ;
+        ctx.idx = idx ;
+        ctx.pidx = idx ;
+
+        sim.generate_photon(ctx.p, rng, gs, idx, 0 );
+
+        int command = START ;
+        int bounce = 0 ;
+        ctx.point(bounce);
+        while( bounce < evt.max_bounce && ctx.p.time < max_time )
+        {
+            trace_fn( &prd, ctx );
+            if( prd.boundary() == 0xffffu ) break ;
+            float3* normal = prd.normal();
+            *normal = normalize(*normal);
+
+            ctx.trace(bounce);
+            command = sim.propagate(bounce, rng, ctx);
+            bounce++;
+            ctx.point(bounce) ;
+            if(command == BREAK) break ;
+        }
+        ctx.end();
+        evt.photon[idx] = ctx.p ;
+        bounce_m[idx] = bounce ;
+    }
+}
+
+int QWavefront_MockTest::wavefront( std::vector<unsigned>& num_active_bounce )
+{
+    evt.photon = photon_w.data() ;
+
+    std::vector<sctx>  ctx(num) ;
+    std::vector<RNG>   rng(num) ;
+    std::vector<quad2> prd(num) ;
+    std::vector<int>   active(num) ;
+    std::vector<int>   active_next(num) ;
+    std::vector<int>   alive(num) ;
+
+    qwavefront wf = {} ;
+    wf.ctx = ctx.data() ;
+    wf.rng = rng.data() ;
+    wf.prd = prd.data() ;
+    wf.active = active.data() ;
+    wf.active_next = active_next.data() ;
+    wf.alive = alive.data() ;
+
+    return wf.simulate( &sim, trace_fn, num, 0ull, 1.e27f, &num_active_bounce );
+}
+
+int QWavefront_MockTest::main()
+{
+    megakernel();
+    std::vector<unsigned> num_active_bounce ;
+    int num_bounce = wavefront( num_active_bounce );
+
+    int num_diff = 0 ;
+    for(int i=0 ; i < num ; i++) if( memcmp( &photon_m[i], &photon_w[i], sizeof(sphoton) ) != 0 ) num_diff += 1 ;
+
+    unsigned long long sum_bounce = 0 ;
+    unsigned long long lanes_m = 0 ;
+    for(int w=0 ; w*WARP < num ; w++)
+    {
+        int mx = 0 ;
+        for(int i=w*WARP ; i < std::min(num, (w+1)*WARP) ; i++) mx = std::max( mx, bounce_m[i] );
+        lanes_m += WARP*mx ;
+    }
+    for(int i=0 ; i < num ; i++) sum_bounce += bounce_m[i] ;
+
+    unsigned long long lanes_w = 0 ;
+    unsigned long long sum_active = 0 ;
+    for(unsigned n : num_active_bounce)
+    {
+        lanes_w += WARP*((n + WARP - 1)/WARP) ;
+        sum_active += n ;
+    }
+
+    int num_detect = 0 ;
+    for(int i=0 ; i < num ; i++) if( photon_w[i].flagmask & SURFACE_DETECT ) num_detect += 1 ;
+
+    bool ok = num_diff == 0 && sum_active == sum_bounce ;
+
+    std::cout
+        << "QWavefront_MockTest::main"
+        << " num " << num
+        << " max_bounce " << max_bounce
+        << " num_bounce " << num_bounce
+        << " num_detect " << num_detect
+        << std::endl
+        << " num_active_bounce [" ;
+    for(unsigned n : num_active_bounce) std::cout << " " << n ;
+    std::cout
+        << " ]" << std::endl
+        << " sum_bounce " << sum_bounce
+        << " sum_active " << sum_active
+        << " lane utilization megakernel " << std::fixed << std::setprecision(3) << ( lanes_m > 0 ? double(sum_bounce)/double(lanes_m) : 0. )
+        << " wavefront " << ( lanes_w > 0 ? double(sum_active)/double(lanes_w) : 0. )
+        << std::endl
+        << " num_diff " << num_diff
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+int main()
+{
+    QWavefront_MockTest t ;
+    return t.main() ;
+}
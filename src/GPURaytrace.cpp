@@ -5,6 +5,7 @@
 #include "FTFP_BERT.hh"
 #include "G4OpticalPhysics.hh"
 #include "G4VModularPhysicsList.hh"
+#include "u4/U4OpticalGenstepPhysics.hh"
 
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
@@ -55,6 +56,7 @@ int main(int argc, char **argv)
 
     string gdml_file, macro_name;
     bool interactive;
+    bool genstep_physics;
 
     program.add_argument("-g", "--gdml")
         .help("path to GDML file")
@@ -73,6 +75,11 @@ int main(int argc, char **argv)
         .flag()
         .store_into(interactive);
 
+    program.add_argument("--genstep-physics")
+        .help("collect gensteps within the Cerenkov and scintillation processes without tracking optical photons on CPU")
+        .flag()
+        .store_into(genstep_physics);
+
     program.add_argument("-s", "--seed").help("fixed random seed (default: time-based)").scan<'i', long>();
 
     try
@@ -101,12 +108,16 @@ int main(int argc, char **argv)
     // Configure Geant4
     // The physics list must be instantiated before other user actions
     G4VModularPhysicsList *physics = new FTFP_BERT;
-    physics->RegisterPhysics(new G4OpticalPhysics);
+    if (genstep_physics)
+        physics->RegisterPhysics(new U4OpticalGenstepPhysics);
+    else
+        physics->RegisterPhysics(new G4OpticalPhysics);
 
     auto *run_mgr = G4RunManagerFactory::CreateRunManager();
     run_mgr->SetUserInitialization(physics);
 
     G4App *g4app = new G4App(gdml_file);
+    g4app->stepping_->collect_genstep = !genstep_physics;
 
     ActionInitialization *actionInit = new ActionInitialization(g4app);
     run_mgr->SetUserInitialization(actionInit);
@@ -2,11 +2,11 @@
 #include <fstream>
 #include <iostream>
 
-#include "G4AutoLock.hh"
 #include "G4BooleanSolid.hh"
 #include "G4Cerenkov.hh"
 #include "G4Electron.hh"
 #include "G4Event.hh"
+#include "G4EventManager.hh"
 #include "G4GDMLParser.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4OpBoundaryProcess.hh"
@@ -35,20 +35,18 @@
 #include "g4cx/G4CXOpticks.hh"
 #include "sysrap/NP.hh"
 #include "sysrap/SEvt.hh"
+#include "sysrap/seventsplit.h"
 #include "sysrap/STrackInfo.h"
 #include "sysrap/spho.h"
 #include "sysrap/sphoton.h"
 #include "u4/U4.hh"
+#include "u4/U4HitPool.h"
+#include "u4/U4StepLimit.h"
 #include "u4/U4Random.hh"
 #include "u4/U4StepPoint.hh"
 #include "u4/U4Touchable.h"
 #include "u4/U4Track.h"
 
-namespace
-{
-G4Mutex genstep_mutex = G4MUTEX_INITIALIZER;
-}
-
 bool IsSubtractionSolid(G4VSolid *solid)
 {
     if (!solid)
@@ -183,40 +181,54 @@ struct PhotonSD : public G4VSensitiveDetector
         G4cout << "PhotonSD::EndOfEvent Number of PhotonHits: " << NbHits << G4endl;
     }
 
-    void AddOpticksHits()
+  private:
+    PhotonHitsCollection *fPhotonHitsCollection{nullptr};
+    G4int fHCID;
+};
+
+/**
+OpticksSD
+-----------
+
+Holds the Opticks hits of each event when the hits are injected per event
+via the U4HitPool (envvar U4HitPool__ENABLE). Attached to no volume, its
+EndOfEvent is called once per event after all tracking : the gensteps of the
+event are published and the worker blocks until the launch covering the
+event is done, the hits are then converted into the collection by the
+worker from its own pool.
+
+**/
+
+struct OpticksSD : public G4VSensitiveDetector
+{
+    OpticksSD(G4String name) : G4VSensitiveDetector(name), fHCID(-1)
     {
-        SEvt *sev = SEvt::Get_EGPU();
-        unsigned int num_hits = sev->GetNumHit(0);
+        collectionName.insert("OpticksHC");
+    }
 
-        for (int idx = 0; idx < int(num_hits); idx++)
-        {
-            sphoton hit;
-            sev->getHit(hit, idx);
-            G4ThreeVector position = G4ThreeVector(hit.pos.x, hit.pos.y, hit.pos.z);
-            G4ThreeVector direction = G4ThreeVector(hit.mom.x, hit.mom.y, hit.mom.z);
-            G4ThreeVector polarization = G4ThreeVector(hit.pol.x, hit.pol.y, hit.pol.z);
-            int theCreationProcessid;
-            if (OpticksPhoton::HasCerenkovFlag(hit.flagmask))
-            {
-                theCreationProcessid = 0;
-            }
-            else if (OpticksPhoton::HasScintillationFlag(hit.flagmask))
-            {
-                theCreationProcessid = 1;
-            }
-            else
-            {
-                theCreationProcessid = -1;
-            }
-            std::cout << hit.wavelength << " " << position << " " << direction << " " << polarization << std::endl;
+    void Initialize(G4HCofThisEvent *hce) override
+    {
+        fOpticksHitsCollection = new U4OpticksHitsCollection(SensitiveDetectorName, collectionName[0]);
+        if (fHCID < 0)
+            fHCID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+        hce->AddHitsCollection(fHCID, fOpticksHitsCollection);
+    }
 
-            PhotonHit *newHit = new PhotonHit(0, hit.wavelength, hit.time, position, direction, polarization);
-            fPhotonHitsCollection->insert(newHit);
-        }
+    G4bool ProcessHits(G4Step *, G4TouchableHistory *) override
+    {
+        return false;
+    }
+
+    void EndOfEvent(G4HCofThisEvent *) override
+    {
+        G4int eventID = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+        SEvt::PublishWorker(SEvt::EGPU, eventID);
+        size_t num_hits = U4HitPool::Get()->sync_inject(fOpticksHitsCollection, eventID);
+        G4cout << "OpticksSD::EndOfEvent eventID " << eventID << " Number of OpticksHits: " << num_hits << G4endl;
     }
 
   private:
-    PhotonHitsCollection *fPhotonHitsCollection{nullptr};
+    U4OpticksHitsCollection *fOpticksHitsCollection{nullptr};
     G4int fHCID;
 };
 
@@ -279,6 +291,9 @@ struct DetectorConstruction : G4VUserDetectorConstruction
                 }
             }
         }
+
+        if (U4HitPool::Enabled())
+            SDman->AddNewDetector(new OpticksSD("OpticksSD"));
     }
 
   private:
@@ -355,12 +370,57 @@ struct RunAction : G4UserRunAction
 
     void BeginOfRunAction(const G4Run *run) override
     {
+        // per-worker SEvt : genstep collection from the workers needs no locking
+        if (!G4Threading::IsMasterThread())
+            SEvt::CreateOrReuseWorker(SEvt::EGPU);
+
+        if (!U4HitPool::Enabled())
+            return;
+
+        // per event hit injection : batches of the last event of each worker are
+        // launched from the pool thread while the workers wait in OpticksSD::EndOfEvent
+        if (G4Threading::IsMasterThread())
+        {
+            U4HitPool::Get()->start([](int eventID) {
+                SEvt::MergeWorkers(SEvt::EGPU, eventID);
+                G4CXOpticks *gx = G4CXOpticks::Get();
+                gx->simulate(0, false);
+                seventsplit *split = SEvt::Get_EGPU()->makeHitSplit();
+                gx->reset(0);
+                return split;
+            });
+        }
+        if (!G4Threading::IsMasterThread() || !G4Threading::IsMultithreadedApplication())
+            U4HitPool::Get()->worker_begin();
     }
 
     void EndOfRunAction(const G4Run *run) override
     {
+        if (U4HitPool::Enabled())
+        {
+            if (!G4Threading::IsMasterThread() || !G4Threading::IsMultithreadedApplication())
+                U4HitPool::Get()->worker_end();
+            if (!G4Threading::IsMasterThread())
+                SEvt::DeleteWorker(SEvt::EGPU);
+            if (G4Threading::IsMasterThread())
+            {
+                U4HitPool::Get()->stop();
+                std::cout << U4HitPool::Get()->desc() << std::endl;
+            }
+            return;
+        }
+
+        if (!G4Threading::IsMasterThread())
+        {
+            SEvt::PublishWorker(SEvt::EGPU);
+            SEvt::DeleteWorker(SEvt::EGPU);
+        }
+
         if (G4Threading::IsMasterThread())
         {
+            int num_shard = SEvt::MergeWorkers(SEvt::EGPU);
+            std::cout << "Opticks: merged gensteps from " << num_shard << " workers" << std::endl;
+
             G4CXOpticks *gx = G4CXOpticks::Get();
 
             auto start = std::chrono::high_resolution_clock::now();
@@ -386,10 +446,28 @@ struct RunAction : G4UserRunAction
                 return;
             }
 
+            // gensteps from all events of the run were simulated together,
+            // group the hits by the G4 eventID of their genstep
+            seventsplit *split = sev->makeHitSplit();
+            if (split)
+                std::cout << split->desc();
+
+            int ievt = 0;
             for (int idx = 0; idx < int(num_hits); idx++)
             {
                 sphoton hit;
-                sev->getHit(hit, idx);
+                int eventID = -1;
+                if (split)
+                {
+                    while (idx >= split->offset[ievt + 1])
+                        ievt++;
+                    hit = split->hits(0)[idx];
+                    eventID = split->eventID[ievt];
+                }
+                else
+                {
+                    sev->getHit(hit, idx);
+                }
                 G4ThreeVector position = G4ThreeVector(hit.pos.x, hit.pos.y, hit.pos.z);
                 G4ThreeVector direction = G4ThreeVector(hit.mom.x, hit.mom.y, hit.mom.z);
                 G4ThreeVector polarization = G4ThreeVector(hit.pol.x, hit.pol.y, hit.pol.z);
@@ -413,10 +491,12 @@ struct RunAction : G4UserRunAction
                 outFile << hit.time << " " << hit.wavelength << "  " << "(" << position.x() << ", " << position.y()
                         << ", " << position.z() << ")  " << "(" << direction.x() << ", " << direction.y() << ", "
                         << direction.z() << ")  " << "(" << polarization.x() << ", " << polarization.y() << ", "
-                        << polarization.z() << ")  " << "CreationProcessID=" << theCreationProcessid << std::endl;
+                        << polarization.z() << ")  " << "CreationProcessID=" << theCreationProcessid << " EventID=" << eventID
+                        << std::endl;
             }
 
             outFile.close();
+            delete split;
         }
     }
 };
@@ -424,6 +504,7 @@ struct RunAction : G4UserRunAction
 struct SteppingAction : G4UserSteppingAction
 {
     SEvt *sev;
+    bool collect_genstep = true; // false when the processes collect, see U4OpticalGenstepPhysics
 
     SteppingAction(SEvt *sev) : sev(sev)
     {
@@ -437,14 +518,8 @@ struct SteppingAction : G4UserSteppingAction
         G4StepPoint *preStep = aStep->GetPostStepPoint();
         G4VPhysicalVolume *volume = preStep->GetPhysicalVolume();
 
-        if (aStep->GetTrack()->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition())
-        {
-            // Kill if step count exceeds 10000 to avoid reflection forever
-            if (aStep->GetTrack()->GetCurrentStepNumber() > 10000)
-            {
-                aStep->GetTrack()->SetTrackStatus(fStopAndKill);
-            }
-        }
+        // Kill optical photons reaching the GPU MaxBounce/MaxTime truncation, avoiding reflection forever
+        U4StepLimit::Get()->UserSteppingAction(aStep);
 
         if (volume && volume->GetName() == "MirrorPyramid")
         {
@@ -459,7 +534,7 @@ struct SteppingAction : G4UserSteppingAction
             G4EventManager::GetEventManager()->GetTrackingManager()->GetSteppingManager();
         G4StepStatus stepStatus = fpSteppingManager->GetfStepStatus();
 
-        if (stepStatus != fAtRestDoItProc)
+        if (collect_genstep && stepStatus != fAtRestDoItProc)
         {
             G4ProcessVector *procPost = fpSteppingManager->GetfPostStepDoItVector();
             size_t MAXofPostStepLoops = fpSteppingManager->GetMAXofPostStepLoops();
@@ -484,8 +559,6 @@ struct SteppingAction : G4UserSteppingAction
                     G4Cerenkov *proc = (G4Cerenkov *)(*procPost)[i3];
                     fNumPhotons = proc->GetNumPhotons();
 
-                    G4AutoLock lock(&genstep_mutex); // <-- Mutex is locked here
-
                     if (fNumPhotons > 0)
                     {
                         G4double Pmin = Rindex->Energy(0);
@@ -31,6 +31,7 @@
 #include "sysrap/spho.h"
 #include "sysrap/sphoton.h"
 #include "u4/U4Random.hh"
+#include "u4/U4StepLimit.h"
 #include "u4/U4StepPoint.hh"
 #include "u4/U4Touchable.h"
 #include "u4/U4Track.h"
@@ -264,6 +265,8 @@ struct EventAction : G4UserEventAction
     void EndOfEventAction(const G4Event *event) override
     {
         int eventID = event->GetEventID();
+        if (U4StepLimit::Get()->level > 0)
+            std::cout << U4StepLimit::Get()->desc() << std::endl;
         sev->addEventConfigArray();
         sev->gather();
         sev->endOfEvent(eventID);
@@ -355,6 +358,9 @@ struct SteppingAction : G4UserSteppingAction
         current_photon.set_flag(flag);
 
         sev->pointPhoton(ulabel);
+
+        // truncate as the GPU propagate loop, after recording the step
+        U4StepLimit::Get()->UserSteppingAction(step);
     }
 };
 
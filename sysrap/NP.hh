@@ -1613,7 +1613,7 @@ inline void NP::serializeToBuffer( std::vector<char>& buf, size_t size, size_t n
     size_t bytes_read = buffer - buf.data() ;
     bool expect_read = bytes_read == tot_bytes ;
 
-    if(1) std::cout
+    if(VERBOSE || !expect_read) std::cout
         << "NP::serializeToBuffer"
         << " size " << size
         << " nitems " << nitems
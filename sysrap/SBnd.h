@@ -21,12 +21,17 @@ Principal user QBnd.hh
 #include <array>
 #include <sstream>
 #include <set>
+#include <cmath>
+#include <iomanip>
+#include <unordered_map>
 
 #include "NP.hh"
 #include "sstr.h"
 #include "sdigest.h"
 #include "sproplist.h"
 #include "sidxname.h"
+#include "shash.h"
+#include "shalf.h"
 
 
 
@@ -108,6 +113,10 @@ be used::
     NP* mat_from_bd(const NP* bd) const ; 
     NP* reconstruct_sur() const ; 
 
+    static NP* MakeCompact(const NP* bnd, NP*& line_row ); 
+    static NP* MakeHalf(const NP* buf, NP*& row_scale ); 
+    static std::string DescCompact(const NP* bnd, const NP* cbnd ); 
+
 };
 
 
@@ -733,3 +742,139 @@ inline NP* SBnd::reconstruct_sur() const
     return nullptr ; 
 }
 
+
+
+/**
+SBnd::MakeCompact
+-------------------
+
+Many boundaries share materials and most have no surfaces, so most
+lines of the (ni, 4, 2, nl, 4) bnd array repeat earlier ones.
+This returns the unique lines with shape (nu, 1, 2, nl, 4),
+keeping the 5D layout expected by QBnd::MakeBoundaryTex, together
+with the line_row int array of shape (ni*4,) giving the unique row
+of every line::
+
+    cbnd[line_row[4*i+j]] == bnd[i,j]      # both property groups, all wavelengths
+
+Lines are compared with shash 64 bit digests, confirmed with memcmp
+so digest collisions cannot merge different lines. Unique rows are in
+order of first appearance. The domain metadata is copied.
+
+**/
+
+inline NP* SBnd::MakeCompact(const NP* bnd, NP*& line_row ) // static
+{
+    assert( bnd && bnd->uifc == 'f' && bnd->ebyte == 4 ); 
+    assert( bnd->shape.size() == 5 ); 
+
+    NP::INT ni = bnd->shape[0] ; 
+    NP::INT nj = bnd->shape[1] ; 
+    NP::INT num_line = ni*nj ; 
+    NP::INT line_values = bnd->shape[2]*bnd->shape[3]*bnd->shape[4] ; 
+    size_t  line_bytes = line_values*sizeof(float) ; 
+
+    const float* bb = bnd->cvalues<float>() ; 
+
+    line_row = NP::Make<int>( num_line ) ; 
+    int* lr = line_row->values<int>() ; 
+
+    std::vector<NP::INT> uline ;    // first line of each unique row 
+    std::unordered_map<uint64_t, std::vector<int>> rows ;  // digest to unique rows 
+
+    for(NP::INT l=0 ; l < num_line ; l++)
+    {
+        const float* ll = bb + l*line_values ; 
+        shash h ; 
+        h.add( (const char*)ll, line_bytes ); 
+        std::vector<int>& cand = rows[h.digest64()] ; 
+
+        int row = -1 ; 
+        for(int r : cand) if( memcmp( ll, bb + uline[r]*line_values, line_bytes ) == 0 ) { row = r ; break ; }
+        if( row == -1 )
+        {
+            row = int(uline.size()) ; 
+            uline.push_back(l) ; 
+            cand.push_back(row) ; 
+        }
+        lr[l] = row ; 
+    }
+
+    NP::INT nu = uline.size() ; 
+    NP* cbnd = NP::Make<float>( nu, 1, bnd->shape[2], bnd->shape[3], bnd->shape[4] ) ; 
+    float* cc = cbnd->values<float>() ; 
+    for(NP::INT r=0 ; r < nu ; r++) memcpy( cc + r*line_values, bb + uline[r]*line_values, line_bytes ); 
+
+    cbnd->meta = bnd->meta ; 
+    cbnd->set_meta<int>("num_line", num_line ); 
+    cbnd->set_meta<int>("num_unique", nu ); 
+    line_row->set_meta<int>("num_unique", nu ); 
+
+    return cbnd ; 
+}
+
+/**
+SBnd::MakeHalf
+----------------
+
+Encodes the float boundary texture source array into IEEE half with
+shape unchanged. Half tops out at 65504 and absorption and scattering
+lengths in mm exceed that, so each component of each texture row
+(2*line+k) is divided by a power of two scale bringing its maximum
+to at most 32768. Power of two scales are exact, so the only error
+is the half rounding of relative 2^-11. The row_scale float array of
+shape (num_row, 4) must be multiplied back after the texture fetch,
+see qbnd::boundary_lookup.
+
+**/
+
+inline NP* SBnd::MakeHalf(const NP* buf, NP*& row_scale ) // static
+{
+    assert( buf && buf->uifc == 'f' && buf->ebyte == 4 ); 
+    assert( buf->shape.size() == 5 && buf->shape[4] == 4 ); 
+
+    NP::INT num_row = buf->shape[0]*buf->shape[1]*buf->shape[2] ; 
+    NP::INT nl = buf->shape[3] ; 
+    NP::INT nm = buf->shape[4] ; 
+
+    const float* bb = buf->cvalues<float>() ; 
+
+    row_scale = NP::Make<float>( num_row, nm ) ; 
+    float* ss = row_scale->values<float>() ; 
+
+    NP* scaled = NP::MakeCopy(buf) ; 
+    float* sc = scaled->values<float>() ; 
+
+    const float limit = 32768.f ; 
+    for(NP::INT r=0 ; r < num_row ; r++)
+    for(NP::INT m=0 ; m < nm ; m++)
+    {
+        float mx = 0.f ; 
+        for(NP::INT l=0 ; l < nl ; l++) 
+        {
+            float v = std::abs( bb[(r*nl+l)*nm+m] ) ;
+            if( std::isfinite(v) ) mx = std::max( mx, v ) ; 
+        }
+        float scale = mx > limit ? std::exp2( std::ceil( std::log2( mx/limit ) ) ) : 1.f ;  
+        ss[r*nm+m] = scale ; 
+        for(NP::INT l=0 ; l < nl ; l++) sc[(r*nl+l)*nm+m] /= scale ; 
+    }
+
+    NP* hbuf = shalf::Encode(scaled) ; 
+    delete scaled ; 
+    return hbuf ; 
+}
+
+inline std::string SBnd::DescCompact(const NP* bnd, const NP* cbnd ) // static
+{
+    NP::INT num_line = bnd ? bnd->shape[0]*bnd->shape[1] : 0 ; 
+    NP::INT num_unique = cbnd ? cbnd->shape[0] : 0 ; 
+    std::stringstream ss ; 
+    ss << "SBnd::DescCompact"
+       << " num_line " << num_line 
+       << " num_unique " << num_unique 
+       << " ratio " << std::fixed << std::setprecision(3) << ( num_line > 0 ? double(num_unique)/double(num_line) : 0. )
+       ;
+    std::string str = ss.str(); 
+    return str ; 
+}
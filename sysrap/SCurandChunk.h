@@ -69,6 +69,7 @@ struct SYSRAP_API SCurandChunk
     static int OldLoad( SCurandChunk& chunk, const char* name, ULL q_num=0, const char* _dir=nullptr );
     static curandStateXORWOW* Load_( ULL& file_num, const char* path, ULL read_num, sdigest* dig ); 
 
+    static void Digest( sdigest* dig, const curandStateXORWOW* states, ULL num );
     static int Save( curandStateXORWOW* states, unsigned num_states, const char* path ) ; 
     int save( const char* _dir=nullptr ) const ; 
 };
@@ -535,6 +536,30 @@ inline curandStateXORWOW* SCurandChunk::Load_( ULL& file_num, const char* path,
 }
 
 
+/**
+SCurandChunk::Digest
+----------------------
+
+Adds states to the digest in the file layout (STATE_SIZE bytes per state, no padding)
+so the result matches the load digest of Load_ and md5sum of the file.
+
+**/
+
+inline void SCurandChunk::Digest( sdigest* dig, const curandStateXORWOW* states, ULL num ) // static
+{
+    for(ULL i = 0 ; i < num ; ++i )
+    {
+        const curandStateXORWOW& rng = states[i] ;
+        dig->add_<const unsigned>(&rng.d, 1 );
+        dig->add_<const unsigned>( rng.v, 5 );
+        dig->add_<const int>(&rng.boxmuller_flag,1);
+        dig->add_<const int>(&rng.boxmuller_flag_double,1);
+        dig->add_<const float>(&rng.boxmuller_extra,1);
+        dig->add_<const double>(&rng.boxmuller_extra_double,1);
+    }
+}
+
+
 inline int SCurandChunk::Save( curandStateXORWOW* states, unsigned num_states, const char* path ) // static
 {
     sdirectory::MakeDirsForFile(path);
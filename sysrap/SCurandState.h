@@ -36,6 +36,9 @@ sysrap/SLaunchSequence.h
 
 qudarap/QRng.{hh.cc}
 
+sysrap/sxorwow.h
+   host curand_init for XORWOW, used by SCurandState::generate
+
 **/
 
 
@@ -43,13 +46,16 @@ qudarap/QRng.{hh.cc}
 #include "SCurandSpec.h"
 #include "SYSRAP_API_EXPORT.hh"
 #include "SCU_.h"
+#include "sxorwow.h"
 
 struct SYSRAP_API SCurandState   
 {
     typedef unsigned long long ULL ;
     static constexpr const ULL M = 1000000ull ; 
+    static constexpr const char* _level = "SCurandState__level" ; 
 
     const char* dir ; 
+    int level ; 
     std::vector<ULL> spec = {} ; 
     std::vector<SCurandChunk> chunk = {} ; 
     scurandref<curandStateXORWOW> all = {} ; 
@@ -68,6 +74,9 @@ struct SYSRAP_API SCurandState
  
     bool is_complete() const ; 
 
+    int generate(int num_thread=0); 
+    int generateChunk(SCurandChunk& c, int num_thread=0) const ; 
+
     template<typename T>
     T* loadAndUpload( unsigned rngmax ) ; 
 
@@ -81,7 +90,8 @@ inline const char* SCurandState::getDir() const
 
 inline SCurandState::SCurandState(const char* _dir)
     :
-    dir( _dir ? strdup(_dir) : nullptr )
+    dir( _dir ? strdup(_dir) : nullptr ),
+    level(ssys::getenvint(_level,0))
 {
     init(); 
 }
@@ -274,6 +284,88 @@ inline bool SCurandState::is_complete() const
 } 
 
 
+/**
+SCurandState::generate
+------------------------
+
+Host alternative to the GPU chunk creation of QCurandState::init,
+writes all chunk files that are not already valid.
+As existing chunks are left untouched this extends a chunk set
+when SCurandState__init_CHUNKSIZES is extended to support a larger
+maximum number of states.
+
+Returns the number of chunks written or -1 if any failed.
+
+**/
+
+inline int SCurandState::generate(int num_thread)
+{
+    int num_chunk = chunk.size(); 
+    int count = 0 ; 
+    for(int i=0 ; i < num_chunk ; i++)
+    {
+        SCurandChunk& c = chunk[i]; 
+        if(SCurandChunk::IsValid(c, dir)) continue ;
+        int rc = generateChunk(c, num_thread); 
+        if(rc != 0) return -1 ; 
+        count += 1 ; 
+    }
+    return count ; 
+}
+
+/**
+SCurandState::generateChunk
+-----------------------------
+
+1. curand_init(seed, chunk_offset + i, offset) for the c.ref.num slots with sxorwow, multithreaded
+2. digest the states in file layout
+3. save to the file named from the chunk metadata
+4. load the file back with digest, require the digests to match
+
+The per chunk summary is only output with SCurandState__level > 0 or on mismatch.
+
+**/
+
+inline int SCurandState::generateChunk(SCurandChunk& c, int num_thread) const
+{
+    scurandref<curandStateXORWOW>& cr = c.ref ; 
+    curandStateXORWOW* h_states = (curandStateXORWOW*)malloc(sizeof(curandStateXORWOW)*cr.num);
+
+    int num_shard = sxorwow::Get()->init_states( h_states, cr.num, cr.seed, cr.chunk_offset, cr.offset, num_thread ); 
+
+    sdigest gen_dig ; 
+    SCurandChunk::Digest( &gen_dig, h_states, cr.num ); 
+    std::string gen_digest = gen_dig.finalize(); 
+
+    cr.states = h_states ; 
+    int save_rc = c.save(dir);
+    cr.states = nullptr ; 
+    free(h_states); 
+
+    sdigest load_dig ; 
+    scurandref<curandStateXORWOW> lr = c.load(0, dir, &load_dig ); 
+    std::string load_digest = load_dig.finalize(); 
+    bool loaded = lr.states != nullptr ; 
+    free(lr.states); 
+
+    bool match = save_rc == 0 && loaded && gen_digest == load_digest ;  
+
+    if(level > 0 || !match) std::cerr
+        << "SCurandState::generateChunk"
+        << " chunk_idx " << cr.chunk_idx 
+        << " num/M " << cr.num/M
+        << " num_shard " << num_shard
+        << " save_rc " << save_rc
+        << " gen_digest " << gen_digest
+        << " load_digest " << load_digest
+        << " match " << ( match ? "YES" : "NO " )
+        << "\n"
+        ;
+
+    return match ? 0 : 1 ; 
+}
+
+
 /**
 SCurandState::loadAndUpload
 ----------------------------
@@ -175,159 +175,42 @@ std::string SDigest::DigestPath(const char* path, unsigned bufsize)
 
 
 
-#if defined(__GNUC__) || defined(__clang__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
+/**
+SDigest::DigestPath2
+----------------------
 
-// https://stackoverflow.com/questions/10324611/how-to-calculate-the-md5-hash-of-a-large-file-in-c
+Formerly a standalone MD5 reference for DigestPath, now both
+use sdigest so follow the sdigest__MODE selection.
 
+**/
 
 std::string SDigest::DigestPath2(const char* path)
 {
-    int i;
-    FILE* fp = fopen (path, "rb");
-    MD5_CTX mdContext;
-    int bytes;
-    char data[8192];
-
-    if (fp == NULL) {
-        printf ("%s can't be opened.\n", path);
-        return "";
-    }
-
-    MD5_Init (&mdContext);
-    while ((bytes = fread (data, 1, 8192, fp)) != 0)
-        MD5_Update (&mdContext, data, bytes);
-
-    fclose (fp);
- 
-    assert( MD5_DIGEST_LENGTH == 16 ); 
-    unsigned char digest[MD5_DIGEST_LENGTH];
-    MD5_Final (digest,&mdContext);
-    char *out = (char*)malloc(MD5_DIGEST_LENGTH*2+1);
-    for(i = 0; i < MD5_DIGEST_LENGTH; i++) snprintf(&(out[i*2]), MD5_DIGEST_LENGTH*2, "%02x", (unsigned int)digest[i]);
-    out[MD5_DIGEST_LENGTH*2] = '\0' ; 
- 
-    return out ;
+    return sdigest::Path(path, 8192) ;
 }
 
+/**
+SDigest::Buffer
+-----------------
 
+Streaming digest of the buffer, same value as the incremental
+update/finalize of the same bytes.
 
+**/
 
-char* md5digest_str2md5_monolithic(const char *buffer, int length) 
-{
-    // user should free the returned string digest 
-
-    MD5_CTX c;
-    MD5_Init(&c);
-
-    const int blocksize = 512 ; 
-    while (length > 0) 
-    {
-        if (length > blocksize) {
-            MD5_Update(&c, buffer, blocksize);
-        } else {
-            MD5_Update(&c, buffer, length);
-        }
-        length -= blocksize ;
-        buffer += blocksize ;
-    }
-
-    unsigned char digest[16];
-    MD5_Final(digest, &c);
-
-    // 16 binary bytes, into 32 char hex string
-    char *out = (char*)malloc(32+1);
-    for (int n = 0; n < 16; ++n) snprintf(&(out[n*2]), 16*2, "%02x", (unsigned int)digest[n]);
-    out[32] = '\0' ;
-    return out;
-}
-
-
-std::string SDigest::Buffer(const char *buffer, int length) 
-{
-    MD5_CTX c;
-    MD5_Init(&c);
-
-    const int blocksize = 512 ; 
-    while (length > 0) 
-    {
-        if (length > blocksize) {
-            MD5_Update(&c, buffer, blocksize);
-        } else {
-            MD5_Update(&c, buffer, length);
-        }
-        length -= blocksize ;
-        buffer += blocksize ;
-    }
-
-    unsigned char digest[16];
-    MD5_Final(digest, &c);
-
-    // 16 binary bytes, into 32 char hex string
-
-    char buf[32+1] ; 
-    for (int n = 0; n < 16; ++n) std::snprintf( &buf[2*n], 32+1, "%02x", (unsigned int)digest[n]) ;
-    buf[32] = '\0' ; 
-
-    return std::string(buf, buf + 32); 
-}
-
-void md5digest_str2md5_update(MD5_CTX& ctx, char* buffer, int length) 
-{
-    const int blocksize = 512 ; 
-    while (length > 0) 
-    {
-        if (length > blocksize) {
-            MD5_Update(&ctx, buffer, blocksize);
-        } else {
-            MD5_Update(&ctx, buffer, length);
-        }
-        length -= blocksize ;
-        buffer += blocksize ;
-    }
-}
-
-char* md5digest_str2md5_finalize( MD5_CTX& ctx )
-{
-    unsigned char digest[16];
-    MD5_Final(digest, &ctx);
-
-    // 16 binary bytes, into 32 char hex string
-    char *out = (char*)malloc(32+1);
-    for (int n = 0; n < 16; ++n) snprintf(&(out[n*2]), 16*2, "%02x", (unsigned int)digest[n]);
-    out[32] = '\0' ;
-    return out;
-}
-
-char* md5digest_str2md5(char* buffer, int length) 
+std::string SDigest::Buffer(const char *buffer, int length)
 {
-    // user should free the returned string digest 
-
-    MD5_CTX ctx;
-    MD5_Init(&ctx);
-
-    md5digest_str2md5_update(ctx, buffer, length );
-
-    return md5digest_str2md5_finalize(ctx);
+    sdigest dig ;
+    dig.add(buffer, length);
+    return dig.finalize();
 }
 
 
 SDigest::SDigest()
 {
-   MD5_Init(&m_ctx); 
 }
 
 
-#if defined(__GNUC__) || defined(__clang__)
-#pragma GCC diagnostic pop
-#endif
-
-
-
-
-
 
 
 const char* SDigest::hexchar = "0123456789abcdef" ;  
@@ -355,38 +238,43 @@ SDigest::~SDigest()
 
 void SDigest::update(const std::string& str)
 {
-    update( (char*)str.c_str(), strlen(str.c_str()) );
+    m_dig.add( str );
 }
 
 void SDigest::update(char* buffer, int length)
 {
-    md5digest_str2md5_update(m_ctx, buffer, length );
+    m_dig.add( buffer, length );
 }
 
 void SDigest::update_str(const char* str )
 {
-    md5digest_str2md5_update(m_ctx, (char*)str, strlen(str) );
+    m_dig.add( str );
 }
 
+/**
+SDigest::finalize
+-------------------
+
+Returns malloc allocated hexdigest string that the caller should free.
+
+**/
 
 char* SDigest::finalize()
 {
-    return md5digest_str2md5_finalize(m_ctx);  
+    std::string out = m_dig.finalize();
+    return strdup(out.c_str());
 }
 
 
 
 std::string SDigest::md5digest( const char* buffer, int len )
 {
-    char* out = md5digest_str2md5_monolithic(buffer, len);
-    std::string digest(out);
-    free(out);
-    return digest;
+    return Buffer(buffer, len);
 }
 
 const char* SDigest::md5digest_( const char* buffer, int len )
 {
-    return md5digest_str2md5_monolithic(buffer, len);
+    return strdup(Buffer(buffer, len).c_str());
 }
 
 
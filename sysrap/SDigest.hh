@@ -23,9 +23,13 @@
 SDigest
 ========
 
-MD5 based hexdigest machinery, used throughout Opticks.
+Hexdigest machinery, used throughout Opticks.
 Allows incremental update building of the digest.
 
+Implemented with sdigest.h so it follows the sdigest__MODE
+selection (MD5 by default, "fast" for the shash.h hash) as
+the other digest users. The md5digest names are historical.
+
 
 DevNotes
 ----------
@@ -71,14 +75,7 @@ class SYSRAP_API SDigest
        char* finalize();
    private:
 
-#if defined(__GNUC__) || defined(__clang__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-       MD5_CTX m_ctx ;
-#if defined(__GNUC__) || defined(__clang__)
-#pragma GCC diagnostic pop
-#endif
+       sdigest m_dig ;   // MD5 or fast according to sdigest__MODE
 
 
 };
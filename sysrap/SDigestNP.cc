@@ -1,6 +1,6 @@
 #include <cassert>
 #include "NP.hh"
-#include "SDigest.hh"
+#include "sdigest.h"
 #include "SDigestNP.hh" 
    
 std::string SDigestNP::Item( const NP* a, int i, int j, int k, int l, int m, int o ) // static  
@@ -9,6 +9,6 @@ std::string SDigestNP::Item( const NP* a, int i, int j, int k, int l, int m, int
     NP::INT num_bytes = 0 ; 
     a->itembytes_(&start, num_bytes, i, j, k, l, m, o ); 
     assert( start && num_bytes > 0 ); 
-    return SDigest::Buffer( start, num_bytes ); 
+    return sdigest::Buf( start, num_bytes );   // md5 OR fast according to sdigest__MODE
 }
 
@@ -104,6 +104,8 @@ float SEventConfig::_PropagateEpsilon0Default = 0.05f ;
 const char* SEventConfig::_PropagateEpsilon0MaskDefault = "TO,CK,SI,SC,RE" ; // THESE MOSTLY HAPPEN AWAY FROM BOUNDARIES
 unsigned SEventConfig::_PropagateRefineDefault = 0u ;
 float SEventConfig::_PropagateRefineDistanceDefault = 5000.f ;
+float SEventConfig::_PropagateWeightThresholdDefault = 0.f ;
+unsigned SEventConfig::_PropagateWavefrontDefault = 0u ;
 
 
 const char* SEventConfig::_InputGenstepDefault = nullptr ;
@@ -300,6 +302,8 @@ unsigned SEventConfig::_PropagateEpsilon0Mask  = OpticksPhoton::GetFlagMask(ssys
 std::string SEventConfig::PropagateEpsilon0MaskLabel(){  return OpticksPhoton::FlagMaskLabel( _PropagateEpsilon0Mask ) ; }
 unsigned SEventConfig::_PropagateRefine = ssys::getenvunsigned(kPropagateRefine, _PropagateRefineDefault ) ;
 float SEventConfig::_PropagateRefineDistance = ssys::getenvfloat(kPropagateRefineDistance, _PropagateRefineDistanceDefault ) ;
+float SEventConfig::_PropagateWeightThreshold = ssys::getenvfloat(kPropagateWeightThreshold, _PropagateWeightThresholdDefault ) ;
+unsigned SEventConfig::_PropagateWavefront = ssys::getenvunsigned(kPropagateWavefront, _PropagateWavefrontDefault ) ;
 
 const char* SEventConfig::_InputGenstep = ssys::getenvvar(kInputGenstep, _InputGenstepDefault );
 const char* SEventConfig::_InputGenstepSelection = ssys::getenvvar(kInputGenstepSelection, _InputGenstepSelectionDefault );
@@ -425,6 +429,8 @@ float SEventConfig::PropagateEpsilon0(){ return _PropagateEpsilon0 ; }
 unsigned SEventConfig::PropagateEpsilon0Mask(){ return _PropagateEpsilon0Mask ; }
 unsigned SEventConfig::PropagateRefine(){         return _PropagateRefine ; }
 float    SEventConfig::PropagateRefineDistance(){ return _PropagateRefineDistance ; }
+float    SEventConfig::PropagateWeightThreshold(){ return _PropagateWeightThreshold ; }
+unsigned SEventConfig::PropagateWavefront(){      return _PropagateWavefront ; }
 
 
 /**
@@ -655,6 +661,8 @@ void SEventConfig::SetPropagateEpsilon0(float eps){ _PropagateEpsilon0 = eps ; L
 void SEventConfig::SetPropagateEpsilon0Mask(const char* abrseq, char delim){ _PropagateEpsilon0Mask = OpticksPhoton::GetFlagMask(abrseq,delim) ; }
 void SEventConfig::SetPropagateRefine(        unsigned refine){       _PropagateRefine         = refine ; LIMIT_Check() ; }
 void SEventConfig::SetPropagateRefineDistance(float refine_distance){ _PropagateRefineDistance = refine_distance ; LIMIT_Check() ; }
+void SEventConfig::SetPropagateWeightThreshold(float threshold){ _PropagateWeightThreshold = threshold ; LIMIT_Check() ; }
+void SEventConfig::SetPropagateWavefront(unsigned wavefront){ _PropagateWavefront = wavefront ; LIMIT_Check() ; }
 
 void SEventConfig::SetInputGenstep(const char* ig){   _InputGenstep = ig ? strdup(ig) : nullptr ; LIMIT_Check() ; }
 void SEventConfig::SetInputGenstepSelection(const char* igsel){   _InputGenstepSelection = igsel ? strdup(igsel) : nullptr ; LIMIT_Check() ; }
@@ -985,6 +993,12 @@ std::string SEventConfig::Desc()
        << std::setw(25) << kPropagateRefineDistance
        << std::setw(20) << " PropagateRefineDistance " << " : " << PropagateRefineDistance()
        << std::endl
+       << std::setw(25) << kPropagateWeightThreshold
+       << std::setw(20) << " PropagateWeightThreshold " << " : " << PropagateWeightThreshold()
+       << std::endl
+       << std::setw(25) << kPropagateWavefront
+       << std::setw(20) << " PropagateWavefront " << " : " << PropagateWavefront()
+       << std::endl
        << std::setw(25) << kInputGenstep
        << std::setw(20) << " InputGenstep " << " : " << ( InputGenstep() ? InputGenstep() : "-" )
        << std::endl
@@ -1730,6 +1744,8 @@ NP* SEventConfig::Serialize() // static
 
     meta->set_meta<float>("PropagateEpsilon", PropagateEpsilon() );
     meta->set_meta<float>("PropagateEpsilon0", PropagateEpsilon0() );
+    meta->set_meta<float>("PropagateWeightThreshold", PropagateWeightThreshold() );
+    meta->set_meta<int>("PropagateWavefront", PropagateWavefront() );
 
 
     const char* ig  = InputGenstep() ;
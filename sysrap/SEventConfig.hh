@@ -273,6 +273,8 @@ struct SYSRAP_API SEventConfig
     static constexpr const char* kPropagateEpsilon0Mask = "OPTICKS_PROPAGATE_EPSILON0_MASK" ;
     static constexpr const char* kPropagateRefine = "OPTICKS_PROPAGATE_REFINE" ;
     static constexpr const char* kPropagateRefineDistance = "OPTICKS_PROPAGATE_REFINE_DISTANCE" ;
+    static constexpr const char* kPropagateWeightThreshold = "OPTICKS_PROPAGATE_WEIGHT_THRESHOLD" ;
+    static constexpr const char* kPropagateWavefront = "OPTICKS_PROPAGATE_WAVEFRONT" ;
 
     static constexpr const char* kInputGenstep     = "OPTICKS_INPUT_GENSTEP" ;
     static constexpr const char* kInputGenstepSelection  = "OPTICKS_INPUT_GENSTEP_SELECTION" ;
@@ -353,6 +355,8 @@ struct SYSRAP_API SEventConfig
     static std::string PropagateEpsilon0MaskLabel();
     static float PropagateRefineDistance();
     static unsigned PropagateRefine();
+    static float PropagateWeightThreshold();
+    static unsigned PropagateWavefront();
 
     static const char* _InputGenstepPath(int idx=-1);
     static const char* InputGenstep(int idx=-1);
@@ -482,6 +486,8 @@ struct SYSRAP_API SEventConfig
     static void SetPropagateEpsilon0Mask( const char* abrseq, char delim=',' ) ;
     static void SetPropagateRefineDistance( float refine_distance ) ;
     static void SetPropagateRefine( unsigned refine ) ;
+    static void SetPropagateWeightThreshold( float threshold ) ;
+    static void SetPropagateWavefront( unsigned wavefront ) ;
 
     static void SetInputGenstep(const char* input_genstep);
     static void SetInputGenstepSelection(const char* input_genstep_selection);
@@ -559,7 +565,9 @@ struct SYSRAP_API SEventConfig
     static float       _PropagateEpsilon0Default  ;
     static const char* _PropagateEpsilon0MaskDefault ;
     static float       _PropagateRefineDistanceDefault  ;
+    static float       _PropagateWeightThresholdDefault  ;
     static unsigned    _PropagateRefineDefault  ;
+    static unsigned    _PropagateWavefrontDefault  ;
 
     static const char* _InputGenstepDefault ;
     static const char* _InputGenstepSelectionDefault ;
@@ -640,7 +648,9 @@ struct SYSRAP_API SEventConfig
     static float _PropagateEpsilon0 ;
     static unsigned _PropagateEpsilon0Mask ;
     static float _PropagateRefineDistance ;
+    static float _PropagateWeightThreshold ;
     static unsigned _PropagateRefine ;
+    static unsigned _PropagateWavefront ;
 
     static const char* _InputGenstep ;
     static const char* _InputGenstepSelection ;
@@ -1,6 +1,7 @@
 
 #include <limits>
 #include <array>
+#include <mutex>
 #include <csignal>
 
 #include "scuda.h"
@@ -22,8 +23,12 @@
 #include "sdebug.h"
 #include "stran.h"
 #include "stree.h"
+#include "slocalize.h"
 #include "strid.h"
 #include "stimer.h"
+#include "sthread.h"
+#include "stimeline.h"
+#include "seventsplit.h"
 #include "spath.h"
 #include "sdirectory.h"
 #include "sstr.h"
@@ -63,6 +68,8 @@ bool SEvt::RUNMETA = ssys::getenvbool(SEvt__RUNMETA) ;
 
 bool SEvt::SAVE_NOTHING = ssys::getenvbool(SEvt__SAVE_NOTHING);
 bool SEvt::SAVE_RUNDIR = ssys::getenvbool(SEvt__SAVE_RUNDIR);
+bool SEvt::LOCALIZE_NOCHECK = ssys::getenvbool(SEvt__LOCALIZE_NOCHECK);
+int  SEvt::GENSTEP_ORDER = ssys::getenvintpick(SEvt__GENSTEP_ORDER, sgsorder::Names(), sgsorder::EVENT );
 
 
 const char* SEvt::descStage() const
@@ -131,6 +138,8 @@ const int SEvt::DEBUG_CLEAR = ssys::getenvint("SEvt__DEBUG_CLEAR",-1) ;
 
 
 std::array<SEvt*, SEvt::MAX_INSTANCE> SEvt::INSTANCES = {{ nullptr, nullptr }} ;
+thread_local std::array<SEvt*, SEvt::MAX_INSTANCE> SEvt::WORKERS = {{ nullptr, nullptr }} ;
+std::array<sevtmerge, SEvt::MAX_INSTANCE> SEvt::MERGE ;
 
 std::string SEvt::DescINSTANCE()  // static
 {
@@ -180,6 +189,7 @@ SEvt::SEvt()
     cfgrc(SEventConfig::Initialize()),
     index(MISSING_INDEX),
     instance(MISSING_INSTANCE),
+    worker(-1),
     stage(SEvt__SEvt),
     gather_metadata_notopfold(0),
     t_BeginOfEvent(0),
@@ -233,6 +243,17 @@ SEvt::SEvt()
     init();
 }
 
+SEvt::~SEvt()
+{
+    delete localizer ;
+    delete photon_selector ;
+    delete photonlite_selector ;
+    if(isWorker()) delete evt ;   // QEvt shares the evt of the process wide instance
+    delete dbg ;
+    delete topfold ;
+    delete extrafold ;
+}
+
 /**
 SEvt::init
 -----------
@@ -1353,10 +1374,20 @@ int SEvt::Count()  // static
 SEvt* SEvt::Get_EGPU(){ return SEvt::Get(EGPU) ; }
 SEvt* SEvt::Get_ECPU(){ return SEvt::Get(ECPU) ; }
 
+/**
+SEvt::Get
+----------
+
+Returns the per-worker SEvt when the calling thread has one,
+otherwise the process wide instance.
+
+**/
+
 SEvt* SEvt::Get(int idx)  // static
 {
     assert( idx == 0 || idx == 1 );
-    return INSTANCES[idx] ;
+    SEvt* w = WORKERS[idx] ;
+    return w ? w : INSTANCES[idx] ;
 }
 void SEvt::Set(int idx, SEvt* inst) // static
 {
@@ -1386,7 +1417,7 @@ SEvt* SEvt::Create(int ins)  // static
     SEvt* ev = new SEvt ;
     ev->setInstance(ins) ;
     INSTANCES[ins] = ev  ;
-    assert( Get(ins) == ev );
+    assert( INSTANCES[ins] == ev );
     LOG(LEVEL) << " ins " << ins  << " " << DescINSTANCE()  ;
     return ev  ;
 }
@@ -1451,6 +1482,222 @@ SEvt* SEvt::CreateOrReuse(int idx)
 SEvt* SEvt::CreateOrReuse_EGPU(){  return CreateOrReuse(EGPU) ; }
 SEvt* SEvt::CreateOrReuse_ECPU(){  return CreateOrReuse(ECPU) ; }
 
+
+
+/**
+SEvt::CreateOrReuseWorker
+---------------------------
+
+Per-worker SEvt for use from multi-threaded Geant4, call from each
+worker thread (eg from BeginOfRunAction) after the process wide
+SEvt instance has been created on the master::
+
+    if(!G4Threading::IsMasterThread()) SEvt::CreateOrReuseWorker(SEvt::EGPU);
+
+Subsequent SEvt::Get from the worker thread return the worker SEvt,
+so the static API (SEvt::AddGenstep, SEvt::Get_ECPU used by U4Recorder)
+collects into the worker without locking. The worker SEvt shares the
+geometry of the master instance.
+
+The mutex only serializes SEvt creation (once per worker thread),
+as SEvt::SEvt is not thread safe. Free the worker SEvt with
+SEvt::DeleteWorker from the worker EndOfRunAction.
+
+The worker SEvt only collects, it has no QEvt and no device buffers.
+Running the GPU simulation per event from the worker threads
+(G4CXOpticks::simulate with a worker SEvt) is not supported : launches
+use the process wide instance from a single thread, either the master
+at end of run after SEvt::MergeWorkers or the pool thread of
+u4/U4HitPool.h for per event hits.
+
+**/
+
+SEvt* SEvt::CreateOrReuseWorker(int idx) // static
+{
+    assert( idx == 0 || idx == 1 );
+    if(WORKERS[idx]) return WORKERS[idx] ;
+
+    SEvt* master = INSTANCES[idx] ;
+    LOG_IF(fatal, master == nullptr) << " the SEvt instance must be created before the workers, idx " << idx ;
+    assert(master);
+
+    static std::mutex mtx ;
+    std::lock_guard<std::mutex> lock(mtx) ;
+
+    SEvt* ev = new SEvt ;
+    ev->setInstance(idx) ;
+    ev->worker = MERGE[idx].add_worker() ;
+    ev->cf = master->cf ;
+    ev->sim = master->sim ;
+    ev->tree = master->tree ;
+#ifdef WITH_OLD_FRAME
+    ev->frame = master->frame ;
+#else
+    ev->fr = master->fr ;
+#endif
+
+    WORKERS[idx] = ev ;
+    LOG(LEVEL) << " idx " << idx << " worker " << ev->worker ;
+    return ev ;
+}
+
+/**
+SEvt::PublishWorker
+---------------------
+
+For the batching workflow where gensteps of all events of the run
+are collected before a single launch at end of run, call from
+the worker EndOfRunAction to hand over everything collected.
+With per-event running SEvt::endOfEvent of the worker publishes
+the content of each event, as does this with eventID > -1.
+
+**/
+
+void SEvt::PublishWorker(int idx, int eventID) // static
+{
+    assert( idx == 0 || idx == 1 );
+    SEvt* w = WORKERS[idx] ;
+    if(w) w->publish(eventID) ;
+}
+
+/**
+SEvt::DeleteWorker
+--------------------
+
+Call from the worker EndOfRunAction after the last SEvt::PublishWorker,
+deletes the SEvt of the calling worker thread. Anything collected but not
+published is lost. A following SEvt::CreateOrReuseWorker, eg in the next
+run, creates a new worker SEvt.
+
+**/
+
+void SEvt::DeleteWorker(int idx) // static
+{
+    assert( idx == 0 || idx == 1 );
+    SEvt* w = WORKERS[idx] ;
+    if(w == nullptr) return ;
+    LOG_IF(error, !w->gs.empty()) << " deleting worker " << w->worker << " with unpublished gensteps " << w->gs.size() ;
+    WORKERS[idx] = nullptr ;
+    delete w ;
+}
+
+/**
+SEvt::MergeWorkers
+--------------------
+
+Call from the master thread, eg from the master EndOfRunAction before
+G4CXOpticks::simulate, to append all shards published by the workers
+to the process wide instance. Returns the number of shards merged.
+With eventID > -1 only the shards published for that event are merged,
+as needed for per event launches, see u4/U4HitPool.h.
+
+**/
+
+int SEvt::MergeWorkers(int idx, int eventID) // static
+{
+    assert( idx == 0 || idx == 1 );
+    SEvt* sev = INSTANCES[idx] ;
+    if(sev == nullptr) return 0 ;
+
+    std::vector<sevtshard*> shards = MERGE[idx].take(eventID) ;
+    sev->merge(shards) ;
+    for(size_t i=0 ; i < shards.size() ; i++) delete shards[i] ;
+
+    LOG(LEVEL) << DescWorkers(idx) ;
+    return int(shards.size()) ;
+}
+
+std::string SEvt::DescWorkers(int idx) // static
+{
+    std::stringstream ss ;
+    ss << "SEvt::DescWorkers"
+       << " idx " << idx
+       << " " << MERGE[idx].desc()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+bool SEvt::isWorker() const { return worker > -1 ; }
+
+/**
+SEvt::publish
+---------------
+
+Moves the genstep and output vectors of the worker into an sevtshard
+pushed onto the lock-free list of the instance and resets the worker
+for the next event. Collected photons not yet reached by SEvt::beginPhoton
+get their hostside allocation first so all per-photon vectors are complete.
+
+**/
+
+void SEvt::publish(int eventID)
+{
+    assert( isWorker() );
+    if(!pho.empty() && !hostside_running_resize_done) hostside_running_resize();
+
+    sevtshard* s = new sevtshard(eventID, worker) ;
+    swapShard(*s) ;
+    LOG(LEVEL) << s->desc() ;
+    MERGE[instance].push(s) ;
+
+    clear_output();
+    clear_genstep();
+    clear_extra();
+    reset_counter();
+}
+
+/**
+SEvt::merge
+-------------
+
+Appends the shards to the gensteps and output vectors with sevtmerge::Append
+and updates the collection counts and sizes as if the gensteps had been
+added with SEvt::addGenstep.
+
+**/
+
+void SEvt::merge(const std::vector<sevtshard*>& shards)
+{
+    if(shards.empty()) return ;
+
+    sevtshard acc ;
+    swapShard(acc) ;
+    for(size_t i=0 ; i < shards.size() ; i++) sevtmerge::Append( acc, *shards[i] ) ;
+    swapShard(acc) ;
+    MERGE[instance].num_merged += shards.size() ;
+
+    numgenstep_collected = int64_t(gs.size()) ;
+    numphoton_collected = 0 ;
+    numphoton_genstep_max = 0 ;
+    for(size_t i=0 ; i < gs.size() ; i++)
+    {
+        numphoton_collected += gs[i].photons ;
+        numphoton_genstep_max = std::max( numphoton_genstep_max, gs[i].photons ) ;
+    }
+
+    setNumPhoton(numphoton_collected);
+    if(!photon.empty()) hostside_running_resize();   // no-op resize that updates evt pointers
+}
+
+void SEvt::swapShard(sevtshard& s)
+{
+    genstep.swap(s.genstep);
+    gs.swap(s.gs);
+    gsid.swap(s.gsid);
+    pho.swap(s.pho);
+    slot.swap(s.slot);
+    photon.swap(s.photon);
+    record.swap(s.record);
+    rec.swap(s.rec);
+    seq.swap(s.seq);
+    prd.swap(s.prd);
+    tag.swap(s.tag);
+    flat.swap(s.flat);
+    aux.swap(s.aux);
+    sup.swap(s.sup);
+}
+
 /**
 SEvt::CreateOrReuse
 ---------------------
@@ -1563,6 +1810,13 @@ sgs SEvt::AddGenstep(const quad6& q)
     if(Exists(1)) label = Get(1)->addGenstep(q) ;
     return label ;
 }
+sgs SEvt::AddGenstep(const quad6& q, const sgsid& id)
+{
+    sgs label = {} ;
+    if(Exists(0)) label = Get(0)->addGenstep(q, id) ;
+    if(Exists(1)) label = Get(1)->addGenstep(q, id) ;
+    return label ;
+}
 sgs SEvt::AddGenstep(const NP* a)
 {
     sgs label = {} ;
@@ -1901,8 +2155,14 @@ as still need to collect the gensteps.
 
 void SEvt::beginOfEvent(int eventID)
 {
-    if(isFirstEvtInstance() && eventID == 0) BeginOfRun() ;
-    if(eventID == 0) SProf::Add( isEGPU() ? "SEvt__beginOfEvent_FIRST_EGPU" : "SEvt__beginOfEvent_FIRST_ECPU" ) ;
+    if(!isWorker())   // run level profiling and timeline are left to the master instance
+    {
+        if(isFirstEvtInstance() && eventID == 0) BeginOfRun() ;
+        if(eventID == 0) SProf::Add( isEGPU() ? "SEvt__beginOfEvent_FIRST_EGPU" : "SEvt__beginOfEvent_FIRST_ECPU" ) ;
+        static const int tag_egpu = stimeline::Tag("SEvt__Event_EGPU") ;
+        static const int tag_ecpu = stimeline::Tag("SEvt__Event_ECPU") ;
+        stimeline::Begin( isEGPU() ? tag_egpu : tag_ecpu, eventID );
+    }
 
     setStage(SEvt__beginOfEvent);
     sprof::Stamp(p_SEvt__beginOfEvent_0);
@@ -1951,10 +2211,18 @@ Called for example from::
 Only SEventConfig::SaveComp OPTICKS_SAVE_COMP are actually saved,
 so can switch off all saving wuth that config.
 
+A per-worker SEvt does not save, it publishes the event content
+for the master instance, see SEvt::MergeWorkers.
+
 **/
 
 void SEvt::endOfEvent(int eventID)
 {
+    if(isWorker())
+    {
+        publish(eventID);
+        return ;
+    }
 
     setStage(SEvt__endOfEvent);
     LOG_IF(info, LIFECYCLE) << id() ;
@@ -1972,6 +2240,10 @@ void SEvt::endOfEvent(int eventID)
 
     SaveRunMeta(); // saving run_meta.txt at end of every event incase of crashes
 
+    static const int tag_egpu = stimeline::Tag("SEvt__Event_EGPU") ;
+    static const int tag_ecpu = stimeline::Tag("SEvt__Event_ECPU") ;
+    stimeline::End( isEGPU() ? tag_egpu : tag_ecpu, eventID );
+
 
     bool is_last_eventID = SEventConfig::IsLastEvent(eventID) ;
     if(is_last_eventID)
@@ -2127,6 +2399,7 @@ void SEvt::clear_genstep_vector()
     setNumPhoton(0);
 
     gs.clear();
+    gsid.clear();
     genstep.clear();
     gather_done = false ;
 }
@@ -2437,7 +2710,23 @@ get allocated later.
 **/
 
 
-sgs SEvt::addGenstep(const quad6& q_)
+sgs SEvt::addGenstep(const quad6& q)
+{
+    return addGenstep(q, sgsid::Make(index, -1, q.trackid()) );
+}
+
+/**
+SEvt::addGenstep with provenance
+----------------------------------
+
+The sgsid provenance (eventID, threadID, trackID) is collected into
+the gsid vector parallel to the genstep vector. It allows hits from
+gensteps of many G4 events simulated in a single launch to be
+partitioned by event with SEvt::makeHitSplit.
+
+**/
+
+sgs SEvt::addGenstep(const quad6& q_, const sgsid& gsid_)
 {
     LOG_IF(info, LIFECYCLE) << id() ;
     dbg->addGenstep++ ;
@@ -2517,6 +2806,7 @@ sgs SEvt::addGenstep(const quad6& q_)
     s.gentype = q.gentype() ;
 
     gs.push_back(s) ;                 // summary labels
+    gsid.push_back(gsid_) ;           // provenance labels
     genstep.push_back(q) ;            // actual genstep params : copied into the vector
 
     numgenstep_collected += 1 ;
@@ -3506,6 +3796,7 @@ void SEvt::checkPhotonLineage(const spho& label) const
 
 NP* SEvt::gatherPho() const {  return NPX::ArrayFromData<int>( (int*)pho.data(), int(pho.size()), 4 ); }
 NP* SEvt::gatherGS() const {   return NPX::ArrayFromData<int>( (int*)gs.data(),  int(gs.size()), 4 );  }
+NP* SEvt::gatherGSID() const { return NPX::ArrayFromData<int>( (int*)gsid.data(), int(gsid.size()), sgsid::NUM ); }
 
 
 /**
@@ -3513,10 +3804,14 @@ SEvt::gatherGenstep
 --------------------
 
 As gensteps always originate on CPU its kinda silly to call access gather-ing.
+Unlike makeGenstepArrayFromVector this does not reorder the gensteps.
 
 **/
 
-NP* SEvt::gatherGenstep() const { return makeGenstepArrayFromVector() ; }
+NP* SEvt::gatherGenstep() const
+{
+    return NPX::ArrayFromData<float>( (float*)genstep.data(), int(genstep.size()), 6, 4 ) ;
+}
 
 
 quad6* SEvt::getGenstepVecData() const
@@ -3533,14 +3828,52 @@ int SEvt::getGenstepVecSize() const
 SEvt::makeGenstepArrayFromVector (formerly misnamed getGenstepArray)
 ----------------------------------------------------------------------
 
-Makes NP array from contents of genstep vector
+Makes NP array from contents of genstep vector, after sortGenstep
+so the array uploaded for simulation does not depend on thread scheduling.
 
 **/
 
 
-NP* SEvt::makeGenstepArrayFromVector() const
+NP* SEvt::makeGenstepArrayFromVector()
 {
-    return NPX::ArrayFromData<float>( (float*)genstep.data(), int(genstep.size()), 6, 4 ) ;
+    sortGenstep();
+    return gatherGenstep() ;
+}
+
+/**
+SEvt::sortGenstep
+-------------------
+
+Stable radix sort of the genstep, gs and gsid vectors by the sgsid
+provenance key according to SEvt__GENSTEP_ORDER (default "event"),
+see sgsorder.h. The sgs index and photon offsets are relabelled to
+follow the new order. Returns true when the order was changed.
+
+**/
+
+bool SEvt::sortGenstep()
+{
+    size_t num = genstep.size() ;
+    bool consistent = gs.size() == num && gsid.size() == num ;
+    LOG_IF(error, !consistent) << " inconsistent genstep/gs/gsid sizes " << num << "/" << gs.size() << "/" << gsid.size() ;
+    if(!consistent) return false ;
+
+    std::vector<uint32_t> order ;
+    bool changed = sgsorder::Make( order, gsid.data(), gs.data(), num, GENSTEP_ORDER );
+    if( changed )
+    {
+        sgsorder::Permute( genstep, order );
+        sgsorder::Permute( gs, order );
+        sgsorder::Permute( gsid, order );
+        sgsorder::Relabel( gs );
+    }
+
+    LOG(LEVEL)
+        << " GENSTEP_ORDER " << sgsorder::Name(GENSTEP_ORDER)
+        << " num " << num
+        << " changed " << ( changed ? "YES" : "NO " )
+        ;
+    return changed ;
 }
 
 std::string SEvt::descGenstepArrayFromVector() const
@@ -4157,10 +4490,15 @@ For an example of where this should be invoked from see QSim::simulate
 
 void SEvt::gather()
 {
+    static const int tag = stimeline::Tag("SEvt__gather") ;
+    stimeline::Begin(tag, index);
+
     setStage(SEvt__gather);
     LOG_IF(info, LIFECYCLE) << id() ;
 
     gather_components();
+
+    stimeline::End(tag, index);
 }
 
 
@@ -4614,7 +4952,7 @@ void SEvt::save(const char* dir_)
     const NP* hit = save_fold->get(SComp::HIT_);
     if(hit && SEventConfig::HasSaveComp(SComp::HITLOCAL_))
     {
-        bool consistency_check = true ;
+        bool consistency_check = !LOCALIZE_NOCHECK ;
         NP* hitlocal = localize_photon(hit, consistency_check);
         assert(hitlocal);
         save_fold->add(SComp::HITLOCAL_, hitlocal );
@@ -4626,7 +4964,7 @@ void SEvt::save(const char* dir_)
     const NP* photon = save_fold->get(SComp::PHOTON_);
     if(photon && SEventConfig::HasSaveComp(SComp::PHOTONLOCAL_))
     {
-        bool consistency_check = true ;
+        bool consistency_check = !LOCALIZE_NOCHECK ;
         NP* photonlocal = localize_photon(photon, consistency_check);
         assert(photonlocal);
         save_fold->add(SComp::PHOTONLOCAL_, photonlocal );
@@ -4994,6 +5332,65 @@ void SEvt::getHit(sphoton& p, unsigned idx) const
     sphoton::Get(p, hit, idx );
 }
 
+/**
+SEvt::getGenstepIndexForPhoton
+--------------------------------
+
+Binary search of the genstep photon offsets with seventsplit::GenstepIndex,
+-1 when beyond the photon total.
+
+**/
+
+int64_t SEvt::getGenstepIndexForPhoton(uint64_t photon_index) const
+{
+    int num_gs = gs.size() ;
+    if( num_gs == 0 ) return -1 ;
+    const sgs& last = gs[num_gs-1] ;
+    return seventsplit::GenstepIndex( [this](int64_t g){ return int64_t(gs[g].offset) ; }, num_gs, last.offset + last.photons, photon_index );
+}
+
+const sgsid* SEvt::getGenstepIDForPhoton(uint64_t photon_index) const
+{
+    int64_t g = getGenstepIndexForPhoton(photon_index);
+    return g > -1 && g < int64_t(gsid.size()) ? &gsid[g] : nullptr ;
+}
+
+/**
+SEvt::makeHitSplit
+--------------------
+
+Partitions the hits by the eventID of their gensteps, see seventsplit.h.
+Must be called before the gensteps are cleared, ie after G4CXOpticks::simulate
+with reset:false and before G4CXOpticks::reset.
+Returns nullptr for sphotonlite hits from more than one event as they
+lack the photon index, and likewise with SEventConfig::ModeMerge as the
+merge key does not include the eventID.
+
+**/
+
+seventsplit* SEvt::makeHitSplit() const
+{
+    const NP* hit = getHit();
+    int num_gs = gs.size() ;
+    LOG_IF(error, hit == nullptr ) << " no hit array " ;
+    LOG_IF(error, int(gsid.size()) != num_gs ) << " gsid/gs size mismatch " << gsid.size() << " " << num_gs ;
+    if( hit == nullptr || int(gsid.size()) != num_gs ) return nullptr ;
+
+    std::vector<int64_t> gs_offset(num_gs+1) ;
+    std::vector<int> gs_eventID(num_gs) ;
+    std::vector<int> gs_threadID(num_gs) ;
+    for(int i=0 ; i < num_gs ; i++)
+    {
+        gs_offset[i] = gs[i].offset ;
+        gs_eventID[i] = gsid[i].eventID ;
+        gs_threadID[i] = gsid[i].threadID ;
+    }
+    gs_offset[num_gs] = num_gs > 0 ? gs[num_gs-1].offset + gs[num_gs-1].photons : 0 ;
+
+    bool merged = SEventConfig::ModeMerge() != 0 ;
+    return seventsplit::Create( hit, gs_offset.data(), gs_eventID.data(), num_gs, gs_threadID.data(), merged );
+}
+
 /**
 SEvt::getLocalPhoton
 --------------------
@@ -5035,6 +5432,53 @@ NP* SEvt::localize_photon(const NP* photon, bool consistency_check) const
     return tree ? tree->localize_photon(photon, consistency_check) : nullptr ;
 }
 
+/**
+SEvt::get_localizer
+---------------------
+
+The slocalize affines are prepared from the stree iinst at first use
+and kept until the tree or its instances change, so repeated per event
+localization does not redo the preparation. Staleness is keyed on
+stree::iinst_stamp which, unlike the iinst address, is not reused
+by another tree.
+
+**/
+
+const slocalize* SEvt::get_localizer() const
+{
+    if(tree == nullptr) return nullptr ;
+    if(localizer && localizer_stamp == tree->iinst_stamp) return localizer ;
+    delete localizer ;
+    localizer = new slocalize(tree->iinst) ;
+    localizer_stamp = tree->iinst_stamp ;
+    LOG(LEVEL) << localizer->desc() ;
+    return localizer ;
+}
+
+/**
+SEvt::localize_hit
+--------------------
+
+Bulk alternative to calling SEvt::getLocalHit for every hit, returning
+the local frame hit array and optionally filling *ht* with the instance
+identity of each hit, see slocalize.h and U4HitGet::FromEvt_Bulk.
+The consistency check is skipped with SEvt__LOCALIZE_NOCHECK.
+
+**/
+
+NP* SEvt::localize_hit( std::vector<sphit>* ht, size_t* num_bad ) const
+{
+    const NP* hit = getHit();
+    const slocalize* loc = get_localizer();
+    if( hit == nullptr || loc == nullptr ) return nullptr ;
+
+    size_t bad = 0 ;
+    NP* hitlocal = loc->localize( hit, ht, !LOCALIZE_NOCHECK, &bad );
+    LOG_IF(error, bad > 0 ) << " num_bad " << bad << " of " << hit->shape[0] << " LOCALIZE_NOCHECK " << LOCALIZE_NOCHECK ;
+    if(num_bad) *num_bad = bad ;
+    return hitlocal ;
+}
+
 
 
 /**
@@ -5161,8 +5605,6 @@ void SEvt::getLocalHit(sphit& ht, sphoton& lp, unsigned idx) const
     lp.transform( *tr, normalize );   // inplace transforms lp (pos, mom, pol) into local frame
 
 
-    // below checking should be optional : likely hot code
-
     glm::tvec4<int64_t> col3 = {} ;
     strid::Decode( *tr, col3 );
 
@@ -5171,6 +5613,8 @@ void SEvt::getLocalHit(sphit& ht, sphoton& lp, unsigned idx) const
     ht.sensor_index      = col3[3] ;
     // Q: Where is this encoded ?i Whats 1?
 
+    if(LOCALIZE_NOCHECK) return ;   // checking is optional as this is hot code, see also SEvt::localize_hit
+
     assert( ht.iindex == iindex );
     assert( ht.sensor_identifier == sensor_identifier );
 }
@@ -5455,49 +5899,61 @@ void SEvt::applyFrameTransform(sphoton& lp) const
 
 /**
 SEvt::CountNibbles
---------------------
+---------------------
 
 Create array of ints the same length as seq with nibble counts,
-from 0 to 32(typically).
+from 0 to 32(typically). The seq array is read in place, sharded
+across threads with sthread::ParallelFor.
 
 **/
 
 NP* SEvt::CountNibbles( const NP* seq ) // static
 {
-    std::vector<sseq> qq ;
-    NPX::VecFromArray<sseq>(qq, seq );
-    int num_seq = qq.size();
+    assert( seq && seq->item_bytes() == sizeof(sseq) );
+    const sseq* qq = (const sseq*)seq->bytes() ;
+    int64_t num_seq = seq->shape[0] ;
 
-    NP* seqnib = NP::Make<int>( seq->shape[0] ) ;
+    NP* seqnib = NP::Make<int>( num_seq ) ;
     int* nn = seqnib->values<int>() ;
-    for(int i=0 ; i < num_seq ; i++)
+
+    sthread::ParallelFor( num_seq, [&](int, int64_t i0, int64_t i1)
     {
-        const sseq& q = qq[i] ;
-        nn[i] = q.seqhis_nibbles();
-    }
+        for(int64_t i=i0 ; i < i1 ; i++) nn[i] = qq[i].seqhis_nibbles();
+    });
     return seqnib ;
 }
 
 /**
 SEvt::CountNibbles_Table
---------------------------
+---------------------------
+
+Per-shard tables are summed at the end.
 
 **/
 
 NP* SEvt::CountNibbles_Table( const NP* seqnib ) // static
 {
-    int num_seqnib = seqnib->shape[0] ;
+    int64_t num_seqnib = seqnib->shape[0] ;
     const int* nn = seqnib->cvalues<int>() ;
 
     int ni =  sseq::SLOTS + 1 ;
+    int num_shard = sthread::NumShard(num_seqnib) ;
+    std::vector<int> shard_cc( num_shard*ni, 0 ) ;
+
+    sthread::ParallelFor( num_seqnib, [&](int s, int64_t i0, int64_t i1)
+    {
+        int* sc = shard_cc.data() + s*ni ;
+        for(int64_t i=i0 ; i < i1 ; i++)
+        {
+            int nibs = nn[i] ;
+            assert( nibs < ni );
+            sc[nibs] += 1 ;
+        }
+    });
+
     NP* seqnib_table = NP::Make<int>(ni, 1) ;
     int* cc = seqnib_table->values<int>() ;
-    for(int i=0 ; i < num_seqnib ; i++)
-    {
-        int nibs = nn[i] ;
-        assert( nibs < ni );
-        cc[nibs] += 1 ;
-    }
+    for(int s=0 ; s < num_shard ; s++) for(int j=0 ; j < ni ; j++) cc[j] += shard_cc[s*ni+j] ;
     return seqnib_table ;
 }
 
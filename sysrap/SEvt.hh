@@ -84,6 +84,9 @@ index and photon offset in addition to  gentype/trackid/matline/numphotons
 #endif
 
 #include "sgs.h"
+#include "sgsid.h"
+#include "sgsorder.h"
+#include "sevtmerge.h"
 #include "SComp.h"
 #include "SRandom.h"
 
@@ -98,6 +101,8 @@ struct S4RandomArray ;
 struct stimer ;
 struct stree ;
 struct SSim ;
+struct seventsplit ;
+struct slocalize ;
 
 #include "SYSRAP_API_EXPORT.hh"
 
@@ -156,6 +161,12 @@ struct SYSRAP_API SEvt : public SCompProvider
     static constexpr const char* SEvt__SAVE_RUNDIR = "SEvt__SAVE_RUNDIR" ;
     static bool SAVE_RUNDIR ;
 
+    static constexpr const char* SEvt__LOCALIZE_NOCHECK = "SEvt__LOCALIZE_NOCHECK" ;
+    static bool LOCALIZE_NOCHECK ;
+
+    static constexpr const char* SEvt__GENSTEP_ORDER = "SEvt__GENSTEP_ORDER" ;  // none/event/full, see sgsorder.h
+    static int GENSTEP_ORDER ;
+
 
 
 
@@ -188,6 +199,7 @@ struct SYSRAP_API SEvt : public SCompProvider
 
     int index ;
     int instance ;
+    int worker ;     // 0-based worker number for per-worker SEvt, -1 otherwise
     int stage ;
     int gather_metadata_notopfold ;
 
@@ -243,6 +255,8 @@ struct SYSRAP_API SEvt : public SCompProvider
     const SGeo*           cf ;
     const SSim*           sim ;
     const stree*          tree ;
+    mutable slocalize*    localizer = nullptr ;   // lazily prepared from tree->iinst by get_localizer, owned
+    mutable uint64_t      localizer_stamp = 0 ;   // tree->iinst_stamp when localizer was prepared
 
     bool              hostside_running_resize_done ; // only ever becomes true for non-GPU running
     bool              gather_done ;
@@ -278,6 +292,7 @@ struct SYSRAP_API SEvt : public SCompProvider
     // [--- these vectors are cleared by SEvt::clear_genstep_vector
     std::vector<quad6>   genstep ;
     std::vector<sgs>     gs ;
+    std::vector<sgsid>   gsid ;  // genstep provenance : eventID, threadID, trackID
     // ]
 
     // [--- these vectors are cleared by SEvt::clear_output_vector
@@ -330,6 +345,8 @@ struct SYSRAP_API SEvt : public SCompProvider
     enum { MAX_INSTANCE = 2 } ;
     enum { EGPU, ECPU };
     static std::array<SEvt*, MAX_INSTANCE> INSTANCES ;
+    static thread_local std::array<SEvt*, MAX_INSTANCE> WORKERS ;   // per-worker SEvt of the calling thread, see SEvt::CreateOrReuseWorker
+    static std::array<sevtmerge, MAX_INSTANCE> MERGE ;              // shards published by workers for the master SEvt
     static std::string DescINSTANCE();
 
 private:
@@ -337,6 +354,7 @@ private:
     SEvt();
     void init();
 public:
+    ~SEvt();
     void setFoldVerbose(bool v);
 
     static const char* GetSaveDir(int idx) ;
@@ -459,6 +477,16 @@ public:
     static SEvt* CreateOrReuse_EGPU();
     static SEvt* CreateOrReuse_ECPU();
     static void CreateOrReuse();
+
+    static SEvt* CreateOrReuseWorker(int idx);
+    static void  PublishWorker(int idx, int eventID=-1);
+    static void  DeleteWorker(int idx);
+    static int   MergeWorkers(int idx, int eventID=-1);
+    static std::string DescWorkers(int idx);
+    bool isWorker() const ;
+    void publish(int eventID);
+    void merge(const std::vector<sevtshard*>& shards);
+    void swapShard(sevtshard& s);
 #ifdef WITH_OLD_FRAME
     static void SetFrame(const sframe& fr );
 #else
@@ -485,6 +513,7 @@ public:
 #endif
 
     static sgs AddGenstep(const quad6& q);
+    static sgs AddGenstep(const quad6& q, const sgsid& id);
     static sgs AddGenstep(const NP* a);
     static void AddCarrierGenstep();
     static void AddTorchGenstep();
@@ -599,6 +628,7 @@ public:
     static constexpr const unsigned G4_INDEX_OFFSET = 1000000 ;
     sgs addGenstep(const NP* a) ;
     sgs addGenstep(const quad6& q) ;
+    sgs addGenstep(const quad6& q, const sgsid& gsid_) ;
 
     void setNumPhoton(size_t num_photon);
     void setNumSimtrace(size_t num_simtrace);
@@ -646,11 +676,13 @@ public:
     NP* gatherPho0() const ;   // unordered push_back as they come
     NP* gatherPho() const ;    // resized at genstep and slotted in
     NP* gatherGS() const ;   // genstep labels from std::vector<sgs>
+    NP* gatherGSID() const ; // genstep provenance from std::vector<sgsid>
 
     NP*    gatherGenstep() const ;  // from genstep vector
     quad6* getGenstepVecData() const ;
     int    getGenstepVecSize() const ;
-    NP*    makeGenstepArrayFromVector() const ;   // formerly misnamed getGenstepArray
+    NP*    makeGenstepArrayFromVector() ;   // formerly misnamed getGenstepArray
+    bool   sortGenstep() ;
     std::string descGenstepArrayFromVector() const;
 
 
@@ -783,6 +815,10 @@ public:
     void getPhoton(sphoton& p, unsigned idx) const ;
     void getHit(   sphoton& p, unsigned idx) const ;
 
+    int64_t      getGenstepIndexForPhoton(uint64_t photon_index) const ;
+    const sgsid* getGenstepIDForPhoton(uint64_t photon_index) const ;
+    seventsplit* makeHitSplit() const ;
+
     void getLocalPhoton(  sphoton& p, unsigned idx) const ;
     void getLocalHit_LEAKY( sphit& ht, sphoton& p, unsigned idx) const ;
     void getLocalHit(       sphit& ht, sphoton& p, unsigned idx) const ;
@@ -791,6 +827,9 @@ public:
 
     NP*  localize_photon(const NP* hit, bool consistency_check) const ;
 
+    const slocalize* get_localizer() const ;
+    NP*  localize_hit( std::vector<sphit>* ht=nullptr, size_t* num_bad=nullptr ) const ;
+
 #ifdef WITH_OLD_FRAME
     void getPhotonFrame( sframe& fr, const sphoton& p ) const ;
 #else
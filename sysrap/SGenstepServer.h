@@ -0,0 +1,594 @@
+#pragma once
+/**
+SGenstepServer.h : local genstep-to-hits service with request batching
+=========================================================================
+
+Native C++ server that accepts gensteps from multiple client processes
+over unix domain or TCP sockets (ssock.h framing of NP serialized arrays),
+coalesces the gensteps of concurrent requests into a single simulate
+call of the backend and returns to each client only its own hits.
+
+The backend S is anything with the method::
+
+    NP* simulate(NP* gs, int eventID);
+
+such as CSGOptiXService, or a mock for testing without a GPU.
+The eventID passed to the backend is the server batch counter, the
+client eventID travels in the genstep metadata and is echoed back
+in the hit metadata together with the client connection index.
+
+Batching
+---------
+
+The batcher thread waits for the first request and then collects further
+requests until either SGenstepServer__WINDOW_US microseconds have
+elapsed (default 2000) or the photon total reaches SGenstepServer__MAX_PHOTON
+(default 0, meaning no limit). A window of zero disables coalescing.
+
+The gensteps of the batch are concatenated in request order so the photon
+indices of request r occupy the contiguous range [p0[r], p0[r+1]).
+Hits are routed back with sphoton::get_index and have their index
+rebased to be relative to the request, making the returned hits look
+as if the request had been simulated alone.
+
+sphotonlite hits and merged hits do not carry the photon index so cannot
+be routed. When the backend returns such an array for a multi-request
+batch the server re-runs the requests of that batch one at a time and
+thereafter stops coalescing. The same fallback is used when a hit index
+is outside the photon range of the batch.
+
+Merged hits (OPTICKS_MODE_MERGE) can be full sphoton, but the merge
+combines hits from different photons so their index does not identify
+the request, and the merge key does not include the event so hits of
+different requests could be combined. With SEventConfig::ModeMerge set
+IsRoutable is false and the server never coalesces, giving one launch
+per client request.
+
+Stopping
+---------
+
+Once stop is called further submits are rejected, returning nullptr,
+which closes the client connection. Requests already queued are still
+simulated before the batcher exits, any left over are failed with nullptr.
+Connection threads of clients that have disconnected are joined and
+removed by the acceptor as new clients connect.
+
+Client side::
+
+    SGenstepClient cli("unix:/tmp/opticks_gs.sock") ;
+    NP* ht = cli.simulate(gs, eventID) ;
+
+**/
+
+#include <cstdint>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include <sstream>
+#include <iostream>
+
+#include "ssys.h"
+#include "ssock.h"
+#include "sphoton.h"
+#include "SGenstep.h"
+#include "SEventConfig.hh"
+#include "NP.hh"
+
+struct SGenstepRequest
+{
+    int      client ;
+    int      eventID ;
+    NP*      gs ;
+    uint64_t num_photon ;
+    std::promise<NP*> hit ;
+};
+
+
+template<typename S>
+struct SGenstepServer
+{
+    static constexpr const char* ADDR = "SGenstepServer__ADDR" ;
+    static constexpr const char* WINDOW_US = "SGenstepServer__WINDOW_US" ;
+    static constexpr const char* MAX_PHOTON = "SGenstepServer__MAX_PHOTON" ;
+    static constexpr const char* DEFAULT_ADDR = "unix:/tmp/opticks_gs.sock" ;
+
+    S*          sim ;
+    std::string addr ;
+    int         window_us ;
+    uint64_t    max_photon ;
+    int         level ;
+
+    int         lfd ;
+    std::atomic<bool> stopping ;
+    std::atomic<bool> coalesce ;
+    std::atomic<int>  num_client ;
+    std::atomic<int>  num_request ;
+    std::atomic<int>  num_batch ;
+    std::atomic<int>  num_launch ;
+
+    std::mutex mtx ;
+    std::condition_variable cv ;
+    std::deque<SGenstepRequest*> queue ;
+
+    std::thread acceptor ;
+    std::thread batcher ;
+    std::map<int, std::thread> conns ;   // keyed by client index
+    std::map<int, int> conn_fds ;
+    std::vector<int> finished ;          // clients whose connection_loop has returned
+
+    SGenstepServer(S* sim, const char* addr=nullptr );
+    ~SGenstepServer();
+
+    bool start();
+    void stop();
+    std::string desc() const ;
+
+    void accept_loop();
+    void reap_connections();
+    void connection_loop(int fd, int client);
+    NP*  submit(NP* gs, int client);
+    void batch_loop();
+    void run_batch(std::vector<SGenstepRequest*>& batch);
+
+    static NP* Combine(const std::vector<SGenstepRequest*>& batch, std::vector<uint64_t>& p0 );
+    static bool IsRoutable(const NP* ht);
+    static int  Route(const NP* ht, const std::vector<SGenstepRequest*>& batch, const std::vector<uint64_t>& p0, std::vector<NP*>& out );
+    static NP* Empty();
+};
+
+
+template<typename S>
+inline SGenstepServer<S>::SGenstepServer(S* sim_, const char* addr_ )
+    :
+    sim(sim_),
+    addr(addr_ ? addr_ : ssys::getenvvar(ADDR, DEFAULT_ADDR)),
+    window_us(ssys::getenvint(WINDOW_US, 2000)),
+    max_photon(ssys::getenvuint64spec(MAX_PHOTON, "0")),
+    level(ssys::getenvint("SGenstepServer__level", 0)),
+    lfd(-1),
+    stopping(false),
+    coalesce(SEventConfig::ModeMerge() == 0),
+    num_client(0),
+    num_request(0),
+    num_batch(0),
+    num_launch(0)
+{
+}
+
+template<typename S>
+inline SGenstepServer<S>::~SGenstepServer()
+{
+    stop();
+}
+
+/**
+SGenstepServer::start
+-----------------------
+
+Listens on the address and starts the acceptor and batcher threads.
+With TCP port 0 the addr is updated to the actually bound port.
+
+**/
+
+template<typename S>
+inline bool SGenstepServer<S>::start()
+{
+    lfd = ssock::Listen(addr.c_str());
+    if( lfd < 0 )
+    {
+        std::cerr << "SGenstepServer::start FAILED to listen on " << addr << "\n" ;
+        return false ;
+    }
+    addr = ssock::BoundAddr(lfd) ;
+    batcher = std::thread( &SGenstepServer<S>::batch_loop, this );
+    acceptor = std::thread( &SGenstepServer<S>::accept_loop, this );
+    if(level > 0) std::cout << desc() ;
+    return true ;
+}
+
+template<typename S>
+inline void SGenstepServer<S>::stop()
+{
+    if( stopping.exchange(true) ) return ;
+
+    ssock::Shutdown(lfd);
+    if(acceptor.joinable()) acceptor.join();
+    ssock::Close(lfd);
+    lfd = -1 ;
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        for(auto& kv : conn_fds) ssock::Shutdown(kv.second) ;
+    }
+    cv.notify_all();
+    for(auto& kv : conns) if(kv.second.joinable()) kv.second.join() ;
+    if(batcher.joinable()) batcher.join();
+    conns.clear();
+    conn_fds.clear();
+    finished.clear();
+
+    if(ssock::IsUnix(addr.c_str())) unlink(ssock::UnixPath(addr.c_str()).c_str());
+}
+
+template<typename S>
+inline std::string SGenstepServer<S>::desc() const
+{
+    std::stringstream ss ;
+    ss << "SGenstepServer::desc"
+       << " addr " << addr
+       << " window_us " << window_us
+       << " max_photon " << max_photon
+       << " coalesce " << ( coalesce ? "YES" : "NO " )
+       << " num_client " << num_client
+       << " num_request " << num_request
+       << " num_batch " << num_batch
+       << " num_launch " << num_launch
+       << "\n"
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+template<typename S>
+inline void SGenstepServer<S>::accept_loop()
+{
+    while(!stopping)
+    {
+        int fd = ssock::Accept(lfd);
+        if( fd < 0 ) break ;
+        reap_connections();
+        std::lock_guard<std::mutex> lk(mtx);
+        if(stopping) { ssock::Close(fd) ; break ; }
+        int client = num_client++ ;
+        conn_fds[client] = fd ;
+        conns[client] = std::thread( &SGenstepServer<S>::connection_loop, this, fd, client );
+    }
+}
+
+/**
+SGenstepServer::reap_connections
+-----------------------------------
+
+Joins and removes the threads of disconnected clients, so a long running
+server does not accumulate one thread per past client. The join is done
+outside the lock as the finishing thread may still be releasing it.
+
+**/
+
+template<typename S>
+inline void SGenstepServer<S>::reap_connections()
+{
+    std::vector<std::thread> done ;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        for(int client : finished)
+        {
+            auto it = conns.find(client) ;
+            if( it == conns.end() ) continue ;
+            done.push_back( std::move(it->second) );
+            conns.erase(it);
+            conn_fds.erase(client);
+        }
+        finished.clear();
+    }
+    for(auto& t : done) if(t.joinable()) t.join() ;
+}
+
+/**
+SGenstepServer::connection_loop
+----------------------------------
+
+One thread per client connection, each message is a genstep array
+answered by a hit array.
+
+**/
+
+template<typename S>
+inline void SGenstepServer<S>::connection_loop(int fd, int client)
+{
+    while(!stopping)
+    {
+        NP* gs = ssock::Recv(fd);
+        if(!gs) break ;
+        NP* ht = submit(gs, client);
+        if(!ht) break ;
+        bool ok = ssock::Send(fd, ht);
+        delete ht ;
+        if(!ok) break ;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        conn_fds[client] = -1 ;
+        ssock::Close(fd);
+        finished.push_back(client);
+    }
+}
+
+/**
+SGenstepServer::submit
+------------------------
+
+Queues the request and blocks until the batcher fulfils it.
+Can also be used in-process without sockets.
+Returns nullptr when the server is stopping, the request is then
+rejected without being queued as the batcher may already have exited.
+
+**/
+
+template<typename S>
+inline NP* SGenstepServer<S>::submit(NP* gs, int client)
+{
+    SGenstepRequest* req = new SGenstepRequest ;
+    req->client = client ;
+    req->eventID = gs->get_meta<int>("eventID", -1) ;
+    req->gs = gs ;
+    req->num_photon = SGenstep::GetPhotonTotal(gs) ;
+    std::future<NP*> fut = req->hit.get_future();
+    bool rejected = false ;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        rejected = stopping ;
+        if(!rejected)
+        {
+            queue.push_back(req);
+            num_request++ ;
+        }
+    }
+    if(rejected) req->hit.set_value(nullptr) ;
+    cv.notify_all();
+    NP* ht = fut.get();
+
+    if(ht)
+    {
+        ht->set_meta<int>("eventID", req->eventID );
+        ht->set_meta<int>("client", client );
+    }
+    delete req->gs ;
+    delete req ;
+    return ht ;
+}
+
+template<typename S>
+inline void SGenstepServer<S>::batch_loop()
+{
+    while(true)
+    {
+        std::vector<SGenstepRequest*> batch ;
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [this]{ return stopping || !queue.empty() ; });
+            if( queue.empty() ) break ;
+
+            if( coalesce && window_us > 0 )
+            {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(window_us) ;
+                auto full = [this]{
+                    if( max_photon == 0 ) return false ;
+                    uint64_t tot = 0 ;
+                    for(auto r : queue) tot += r->num_photon ;
+                    return tot >= max_photon ;
+                };
+                cv.wait_until(lk, deadline, [&]{ return stopping || full() ; });
+            }
+
+            uint64_t tot = 0 ;
+            while(!queue.empty())
+            {
+                SGenstepRequest* r = queue.front();
+                bool over = max_photon > 0 && !batch.empty() && tot + r->num_photon > max_photon ;
+                if( over || (!coalesce && !batch.empty()) || (window_us == 0 && !batch.empty()) ) break ;
+                batch.push_back(r);
+                tot += r->num_photon ;
+                queue.pop_front();
+            }
+        }
+        run_batch(batch);
+    }
+
+    std::lock_guard<std::mutex> lk(mtx);
+    for(SGenstepRequest* r : queue) r->hit.set_value(nullptr) ;
+    queue.clear();
+}
+
+/**
+SGenstepServer::run_batch
+---------------------------
+
+Single request batches are passed straight through. Multi-request
+batches are combined, simulated once and routed.
+
+**/
+
+template<typename S>
+inline void SGenstepServer<S>::run_batch(std::vector<SGenstepRequest*>& batch)
+{
+    int ibatch = num_batch++ ;
+    int num = batch.size() ;
+    if( num == 0 ) return ;
+
+    if( num == 1 )
+    {
+        SGenstepRequest* r = batch[0] ;
+        r->gs->set_meta<int>("eventID", ibatch );
+        num_launch++ ;
+        NP* ht = sim->simulate( r->gs, ibatch );
+        r->hit.set_value( ht ? ht : Empty() );
+        return ;
+    }
+
+    std::vector<uint64_t> p0 ;
+    NP* gs = Combine(batch, p0);
+    gs->set_meta<int>("eventID", ibatch );
+    num_launch++ ;
+    NP* ht = sim->simulate( gs, ibatch );
+    delete gs ;
+
+    std::vector<NP*> out ;
+    int num_bad = ( ht == nullptr || IsRoutable(ht) ) ? Route(ht, batch, p0, out) : -1 ;
+    if( num_bad == 0 )
+    {
+        for(int i=0 ; i < num ; i++) batch[i]->hit.set_value(out[i]);
+        if(level > 0) std::cout << "SGenstepServer::run_batch ibatch " << ibatch << " num " << num << " ht " << ( ht ? ht->sstr() : "-" ) << "\n" ;
+        delete ht ;
+        return ;
+    }
+
+    std::cerr
+        << "SGenstepServer::run_batch hits " << ht->sstr()
+        << ( num_bad < 0 ? " are not full sphoton or are merged" : " have photon index outside the batch, num_bad " + std::to_string(num_bad) )
+        << ", cannot route, disable coalescing and re-run batch unbatched\n"
+        ;
+    delete ht ;
+    coalesce = false ;
+    for(int i=0 ; i < num ; i++)
+    {
+        std::vector<SGenstepRequest*> one = { batch[i] } ;
+        run_batch(one);
+    }
+}
+
+/**
+SGenstepServer::Combine
+-------------------------
+
+Concatenates the gensteps of the batch, p0 gets num+1 cumulative photon offsets.
+
+**/
+
+template<typename S>
+inline NP* SGenstepServer<S>::Combine(const std::vector<SGenstepRequest*>& batch, std::vector<uint64_t>& p0 ) // static
+{
+    std::vector<const NP*> gss ;
+    p0.resize(batch.size()+1);
+    p0[0] = 0 ;
+    for(size_t i=0 ; i < batch.size() ; i++)
+    {
+        gss.push_back(batch[i]->gs);
+        p0[i+1] = p0[i] + batch[i]->num_photon ;
+    }
+    return NP::Concatenate(gss);
+}
+
+/**
+SGenstepServer::IsRoutable
+----------------------------
+
+Only full sphoton hits that were not merged carry a photon index
+that identifies the request.
+
+**/
+
+template<typename S>
+inline bool SGenstepServer<S>::IsRoutable(const NP* ht) // static
+{
+    if( SEventConfig::ModeMerge() ) return false ;
+    return ht && ht->uifc == 'f' && ht->ebyte == 4 && ht->has_shape(-1,4,4) ;
+}
+
+/**
+SGenstepServer::Route
+-----------------------
+
+Two passes over the hits, count per request then fill, keeping the
+hit order within each request. Returns the number of hits with photon
+index outside the range of the batch, when non-zero out is left empty.
+
+**/
+
+template<typename S>
+inline int SGenstepServer<S>::Route(const NP* ht, const std::vector<SGenstepRequest*>& batch, const std::vector<uint64_t>& p0, std::vector<NP*>& out ) // static
+{
+    int num = batch.size();
+    int64_t num_hit = ht ? ht->shape[0] : 0 ;
+    const sphoton* hh = ht ? (const sphoton*)ht->cvalues<float>() : nullptr ;
+
+    std::vector<int> owner(num_hit) ;
+    std::vector<int64_t> count(num, 0) ;
+    int num_bad = 0 ;
+    for(int64_t i=0 ; i < num_hit ; i++)
+    {
+        uint64_t idx = hh[i].get_index() ;
+        int r = int( std::upper_bound( p0.begin(), p0.end(), idx ) - p0.begin() ) - 1 ;
+        if( r < 0 || r >= num )
+        {
+            num_bad += 1 ;
+            continue ;
+        }
+        owner[i] = r ;
+        count[r] += 1 ;
+    }
+    if( num_bad > 0 ) return num_bad ;
+
+    out.resize(num);
+    std::vector<sphoton*> dst(num) ;
+    for(int r=0 ; r < num ; r++)
+    {
+        out[r] = NP::Make<float>( count[r], 4, 4 );
+        dst[r] = (sphoton*)out[r]->values<float>() ;
+    }
+    for(int64_t i=0 ; i < num_hit ; i++)
+    {
+        int r = owner[i] ;
+        sphoton p = hh[i] ;
+        p.set_index( p.get_index() - p0[r] );
+        *dst[r]++ = p ;
+    }
+    return 0 ;
+}
+
+template<typename S>
+inline NP* SGenstepServer<S>::Empty() // static
+{
+    return NP::Make<float>(0, 4, 4) ;
+}
+
+
+
+/**
+SGenstepClient
+----------------
+
+Blocking client, one request in flight per connection.
+
+**/
+
+struct SGenstepClient
+{
+    std::string addr ;
+    int fd ;
+
+    SGenstepClient(const char* addr=nullptr);
+    ~SGenstepClient();
+    bool is_connected() const { return fd >= 0 ; }
+    NP* simulate(NP* gs, int eventID);
+};
+
+inline SGenstepClient::SGenstepClient(const char* addr_)
+    :
+    addr(addr_ ? addr_ : ssys::getenvvar(SGenstepServer<void>::ADDR, SGenstepServer<void>::DEFAULT_ADDR)),
+    fd(ssock::Connect(addr.c_str()))
+{
+    if(fd < 0) std::cerr << "SGenstepClient::SGenstepClient FAILED to connect to " << addr << "\n" ;
+}
+
+inline SGenstepClient::~SGenstepClient()
+{
+    ssock::Close(fd);
+}
+
+inline NP* SGenstepClient::simulate(NP* gs, int eventID)
+{
+    if(fd < 0 || !gs) return nullptr ;
+    gs->set_meta<int>("eventID", eventID );
+    if(!ssock::Send(fd, gs)) return nullptr ;
+    return ssock::Recv(fd);
+}
@@ -8,8 +8,8 @@ SPM::merge_partial_select_async
 
 SPM::merge_partial_select
     Flagmask select hits from input photons and merge the hits by (id,timebucket)
-    with incremented counts. Obviously this requires the photons and hits to
-    simultaneously fit into VRAM.
+    with incremented counts, or summed weights with OPTICKS_PROPAGATE_WEIGHT_THRESHOLD.
+    Obviously this requires the photons and hits to simultaneously fit into VRAM.
 
 SPM::copy_device_to_host_async
 
@@ -49,12 +49,18 @@ https://github.com/NVIDIA/thrust/discussions/1616
 **/
 
 #include "SPM.hh"
+#include "SEventConfig.hh"
 #include <thrust/device_ptr.h>
 #include <thrust/sort.h>
 #include <thrust/reduce.h>
 #include <thrust/merge.h>
 #include <thrust/count.h>
 #include <thrust/copy.h>
+#include <thrust/transform.h>
+#include <thrust/for_each.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/zip_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 #include <thrust/execution_policy.h>
 #include <fstream>
 #include <vector>
@@ -63,6 +69,40 @@ https://github.com/NVIDIA/thrust/discussions/1616
 
 using namespace thrust::placeholders;
 
+/**
+SPM_weight functors
+---------------------
+
+With weighted running the hit weights are carried alongside the hits
+as float through reduce_by_key, so merging many hits accumulates in float
+and the half float in the 16 hitcount bits is only rounded once, at the end.
+Summing with T::reduce_op alone would round to the 11 bit half significand
+at every addition, biasing sums of many small weights.
+
+**/
+
+template<typename T>
+struct SPM_weight_of
+{
+    __device__ float operator()(const T& p) const { return p.weight() ; }
+};
+
+template<typename T>
+struct SPM_weight_reduce
+{
+    typename T::reduce_op op ;
+    __device__ thrust::tuple<T,float> operator()(const thrust::tuple<T,float>& a, const thrust::tuple<T,float>& b) const
+    {
+        return thrust::make_tuple( op( thrust::get<0>(a), thrust::get<0>(b) ), thrust::get<1>(a) + thrust::get<1>(b) );
+    }
+};
+
+template<typename T>
+struct SPM_weight_set
+{
+    __device__ void operator()(thrust::tuple<T&,float&> pw) const { thrust::get<0>(pw).set_weight( thrust::get<1>(pw) ) ; }
+};
+
 template<typename T>
 SPM_future<T> SPM::merge_partial_select_async(
     const T*          d_in,
@@ -116,7 +156,8 @@ simultaneously fit into VRAM.
 3. populate d_keys using T::key_functor and d_selected using copy_n
 4. sort_by_key arranging d_selected hits with same (id, timebucket) together
 5. allocate d_out_key d_out_val with space for num_in [HMM, COULD DOUBLE PASS TO REDUCE MEMORY PERHAPS?]
-6. reduce_by_key merging contiguous equal (id,timebucket) hits
+6. reduce_by_key merging contiguous equal (id,timebucket) hits, with weighted running
+   the weights are summed as float alongside and set into the merged hits at the end
 7. get number of merged hits
 8. allocate d_final to fit merged hits, d2d copy d_final from d_out_val
 9. free temporary buffers
@@ -223,18 +264,56 @@ template<typename T> void SPM::merge_partial_select(
     cudaMallocAsync(&d_out_key, num_selected * sizeof(uint64_t),   stream);
     cudaMallocAsync(&d_out_val, num_selected * sizeof(T),          stream);
 
-    // 6. reduce_by_key merging contiguous equal (id,timebucket) hits
+    // 6. reduce_by_key merging contiguous equal (id,timebucket) hits,
+    //    weighted running sums float weights alongside the hits, see SPM_weight functors
 
     auto d_out_key_begin = thrust::device_ptr<uint64_t>(d_out_key);
+    size_t merged = 0 ;
+
+    bool weighted = SEventConfig::PropagateWeightThreshold() > 0.f ;
+    if( weighted )
+    {
+        float* d_w = nullptr ;
+        float* d_out_w = nullptr ;
+        cudaMallocAsync(&d_w,     num_selected * sizeof(float), stream);
+        cudaMallocAsync(&d_out_w, num_selected * sizeof(float), stream);
+
+        auto sel = thrust::device_ptr<T>(d_selected) ;
+        auto w   = thrust::device_ptr<float>(d_w) ;
+        auto val = thrust::device_ptr<T>(d_out_val) ;
+        auto ow  = thrust::device_ptr<float>(d_out_w) ;
 
-    auto ends = thrust::reduce_by_key(policy,
+        thrust::transform(policy, sel, sel + num_selected, w, SPM_weight_of<T>{} );
+
+        auto ends = thrust::reduce_by_key(policy,
+                thrust::device_ptr<uint64_t>(d_keys),
+                thrust::device_ptr<uint64_t>(d_keys + num_selected),
+                thrust::make_zip_iterator(thrust::make_tuple(sel, w)),
+                d_out_key_begin,
+                thrust::make_zip_iterator(thrust::make_tuple(val, ow)),
+                thrust::equal_to<uint64_t>{},
+                SPM_weight_reduce<T>{ reduce_op{ true } });
+
+        merged = ends.first - d_out_key_begin ;
+        auto vw = thrust::make_zip_iterator(thrust::make_tuple(val, ow)) ;
+        thrust::for_each(policy, vw, vw + merged, SPM_weight_set<T>{} );
+
+        cudaFreeAsync(d_w, stream);
+        cudaFreeAsync(d_out_w, stream);
+    }
+    else
+    {
+        auto ends = thrust::reduce_by_key(policy,
                 thrust::device_ptr<uint64_t>(d_keys),
                 thrust::device_ptr<uint64_t>(d_keys + num_selected),
                 thrust::device_ptr<T>(d_selected),
                 d_out_key_begin,                      // output keys
                 thrust::device_ptr<T>(d_out_val),
                 thrust::equal_to<uint64_t>{},
-                reduce_op{});
+                reduce_op{ false });
+
+        merged = ends.first - d_out_key_begin ;
+    }
 
 
     if(apply_selection )
@@ -256,8 +335,7 @@ template<typename T> void SPM::merge_partial_select(
         return ;
     }
 
-    // 7. get number of merged hits
-    size_t merged = ends.first.get() - d_out_key ;
+    // 7. number of merged hits obtained from the reduce_by_key ends above
     // (Proceed to step 8 as-is; the sync ensures d_out_val is also ready for the subsequent cudaMemcpyAsync)
 
     cudaFreeAsync(d_out_key, stream);
@@ -91,6 +91,7 @@ Related developments
 
 #ifdef WITH_CUSTOM4
 #include "C4MultiLayrStack.h"
+#include "stmm_table.h"
 #endif
 
 
@@ -332,7 +333,11 @@ struct SPMT
 
 
     NPFold* make_c4scan() const ;
+
+    static constexpr const char* SPMT__ART_TABLE = "SPMT__ART_TABLE" ;
+    stmm_table* make_art_table() const ;
 #endif
+    void init_art_table();
 
     void get_stackspec( quad4& spec, int cat, float energy_eV) const ;
     NP*  get_stackspec() const ;
@@ -427,6 +432,10 @@ struct SPMT
     NP* s_qescale ;  // (NUM_SPMT, 1)
     float* s_qescale_v ;
 
+    NP* art_table ;  // optional (NUM_PMTCAT, 2, NWL, NCT, 4:[A_s,A_p,R_s,R_p]) tabulated TMM, see stmm_table.h
+    NP* esc_table ;  // optional (NUM_PMTCAT, NWL) qeshape/A_normal
+    NP* fbk_table ;  // optional (NUM_PMTCAT, 2, NWL-1, NCT-1) uint8 cells falling back to the stack calculation
+
 };
 
 
@@ -507,7 +516,10 @@ inline SPMT::SPMT(const NPFold* jpmt_)
     qeScale_v( qeScale ? qeScale->cvalues<double>() : nullptr ),
     s_qeshape(nullptr),
     s_qescale(NP::Make<float>(s_pmt::NUM_SPMT,1)),
-    s_qescale_v( s_qescale ? s_qescale->values<float>() : nullptr )
+    s_qescale_v( s_qescale ? s_qescale->values<float>() : nullptr ),
+    art_table(nullptr),
+    esc_table(nullptr),
+    fbk_table(nullptr)
 {
     init();
 }
@@ -563,6 +575,8 @@ inline void SPMT::init()
 
     init_lcqs();
     init_s_qescale();
+
+    init_art_table();
 }
 
 
@@ -1473,6 +1487,9 @@ inline NPFold* SPMT::serialize_() const   // formerly get_fold
     if(cetheta) fold->add("cetheta", cetheta) ;
     if(cecosth) fold->add("cecosth", cecosth) ;
     if(lcqs) fold->add("lcqs", lcqs) ;
+    if(art_table) fold->add("art_table", art_table) ;
+    if(esc_table) fold->add("esc_table", esc_table) ;
+    if(fbk_table) fold->add("fbk_table", fbk_table) ;
     return fold ;
 }
 
@@ -2035,9 +2052,76 @@ inline NPFold* SPMT::make_c4scan() const
     if(level > 0) std::cout << "]SPMT::make_c4scan " << std::endl;
     return fold ;
 }
+
+
+/**
+SPMT::make_art_table
+----------------------
+
+Tabulates the S and P components of the TMM A,R for each pmtcat over
+(wavelength, cos_theta) using the same float Stack calculation as qpmt,
+together with the qeshape/A_normal escape factor. Resolution and
+accuracy are controlled with envvars::
+
+    SPMT__ART_NWL   wavelength nodes (default stmm_table::NWL)
+    SPMT__ART_NCT   cos_theta nodes per half (default stmm_table::NCT)
+    SPMT__ART_TOL   interpolation error above which cells fall back to the stack
+                    calculation (default stmm_table::TOL), <= 0 for no fallback
+
+**/
+
+inline stmm_table* SPMT::make_art_table() const
+{
+    int nwl = ssys::getenvint("SPMT__ART_NWL", stmm_table::NWL );
+    int nct = ssys::getenvint("SPMT__ART_NCT", stmm_table::NCT );
+    double tol = ssys::getenvdouble("SPMT__ART_TOL", stmm_table::TOL );
+
+    auto calc = [this](double* asrs, int cat, double wavelength_nm, double minus_cos_theta)
+    {
+        quad4 spec ;
+        get_stackspec( spec, cat, hc_eVnm/wavelength_nm );
+        Stack<float,4> stack ;
+        stack.calc( wavelength_nm, minus_cos_theta, 0.f, spec.cdata(), 16u );
+        asrs[0] = stack.art.A_s ;
+        asrs[1] = stack.art.A_p ;
+        asrs[2] = stack.art.R_s ;
+        asrs[3] = stack.art.R_p ;
+    };
+    auto qe = [this](int cat, double energy_eV){ return double(get_qeshape(cat, energy_eV)) ; } ;
+
+    stmm_table* t = stmm_table::Create( NUM_PMTCAT, hc_eVnm/EN1, hc_eVnm/EN0, calc, qe, nwl, nct, tol );
+    if(level > 0) std::cout << "SPMT::make_art_table " << t->desc() ;
+    return t ;
+}
 #endif
 
 
+/**
+SPMT::init_art_table
+----------------------
+
+With SPMT__ART_TABLE envvar set (and WITH_CUSTOM4) the tabulated TMM arrays
+are serialized for QPMT to use in place of the per photon stack calculation.
+The arrays are adopted from the stmm_table which is then deleted.
+
+**/
+
+inline void SPMT::init_art_table()
+{
+#ifdef WITH_CUSTOM4
+    if(!ssys::getenvbool(SPMT__ART_TABLE)) return ;
+    stmm_table* t = make_art_table();
+    art_table = t->art ;
+    esc_table = t->esc ;
+    fbk_table = t->fbk ;
+    t->art = nullptr ;
+    t->esc = nullptr ;
+    t->fbk = nullptr ;
+    delete t ;
+#endif
+}
+
+
 
 
 
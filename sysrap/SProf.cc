@@ -1,6 +1,8 @@
 #include "SProf.hh"
 
 char SProf::TAG[N] = {} ;
+int  SProf::TAG_INDEX = -1 ;
+bool SProf::LITE = ssys::getenvbool(SProf__LITE) ;
 
 std::vector<sprof>       SProf::PROF = {} ;
 std::vector<std::string> SProf::NAME = {} ;
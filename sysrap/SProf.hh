@@ -63,6 +63,22 @@ If the PATH provided contains "%" it is treated as a format string
 which is expected to take one integer index provided from the PATH_INDEX.
 
 
+Binary timeline and lite mode
+-------------------------------
+
+Every SProf::Add also records a MARK into the per-thread stimeline.h
+ring with the event index from SetTag as value. For production running
+where the /proc VM/RSS query and text formatting of every stamp is
+too heavy enable lite mode with::
+
+    export SProf__LITE=1
+
+In lite mode SProf::Add only records into stimeline and returns
+the microsecond timestamp, so SProf::Write has nothing to write.
+Use stimeline__WRITE=1 to persist the timeline and stimeline::ChromeTrace
+to view it.
+
+
 Slurm array running without overwriting SProf.txt and other logs
 -----------------------------------------------------------------
 
@@ -94,6 +110,7 @@ was a kludge that was removed as it complicates things.
 #include <fstream>
 #include <sstream>
 #include "sprof.h"
+#include "stimeline.h"
 #include "ssys.h"
 #include "sstr.h"
 
@@ -102,6 +119,8 @@ was a kludge that was removed as it complicates things.
 struct SYSRAP_API SProf
 {
     static constexpr const char* SProf__WRITE      = "SProf__WRITE" ;
+    static constexpr const char* SProf__LITE       = "SProf__LITE" ;
+    static bool LITE ;
 
     static constexpr const char* SProf__PATH       = "SProf__PATH" ;
     static constexpr const char* PATH_DEFAULT      = "SProf.txt" ;
@@ -113,6 +132,7 @@ struct SYSRAP_API SProf
     static constexpr const char* FMT = "%0.3d" ;
     static constexpr const int N = 10 ;
     static char TAG[N] ;
+    static int  TAG_INDEX ;
     static int  SetTag(int idx, const char* fmt=FMT ); // used to distinguish profiles from multiple events
     static bool HasTag();
     static const char* Tag();
@@ -152,6 +172,7 @@ Canonically invoked from CSGOptiX::simulate
 
 inline int SProf::SetTag(int idx, const char* fmt)
 {
+    TAG_INDEX = idx ;
     return snprintf(TAG, N, fmt, idx );
 }
 inline bool SProf::HasTag()
@@ -164,6 +185,7 @@ inline const char* SProf::Tag()
 }
 inline void SProf::UnsetTag()
 {
+    TAG_INDEX = -1 ;
     TAG[0] = '\0' ;
 }
 
@@ -173,6 +195,9 @@ inline void SProf::UnsetTag()
 
 inline int64_t SProf::Add(const char* name, const char* meta)
 {
+    int64_t t = stimeline::Mark(stimeline::Tag(name), TAG_INDEX) ;  // thread_local name cache, no lock after first use
+    if(LITE) return t > 0 ? t/1000 : sstamp::Now() ;
+
     sprof prof ;
     sprof::Stamp(prof);
     Add(name, prof, meta);
@@ -27,21 +27,24 @@ struct MockTexture
     NP::INT width ; 
     NP::INT height ; 
     float4 dom ; 
+    char filterMode ;  // 'P' point (default) OR 'L' linear 
 
-    MockTexture(const NP* a); 
+    MockTexture(const NP* a, char filterMode='P'); 
 
     std::string desc() const ; 
     template<typename T> T lookup(float x, float y ) const ; 
+    template<typename T> T lookup_linear(float x, float y ) const ; 
     template<typename T> std::string dump() const ; 
 }; 
 
-inline MockTexture::MockTexture(const NP* a_ )
+inline MockTexture::MockTexture(const NP* a_, char filterMode_ )
     :
     a(NP::MakeNarrowIfWide(a_)),  // NB even if narrow already, still copies
     width(0),
-    height(0)
+    height(0),
+    filterMode(filterMode_)
 {
-    a->size_2D<4>(width, height); 
+    if( a->shape.back() == 4 ) a->size_2D<4>(width, height); else a->size_2D<1>(width, height);  // float4 OR float payload
  
     dom.x = a->get_meta<float>("domain_low",  0.f );
     dom.y = a->get_meta<float>("domain_high",  0.f );
@@ -57,6 +60,7 @@ inline std::string MockTexture::desc() const
        << " width " << width
        << " height " << height
        << " dom " << dom 
+       << " filterMode " << filterMode 
        ; 
 
     std::string str = ss.str(); 
@@ -66,6 +70,8 @@ inline std::string MockTexture::desc() const
 template<typename T> 
 inline T MockTexture::lookup(float x, float y ) const
 {
+    if( filterMode == 'L' ) return lookup_linear<T>(x, y) ; 
+
     const T* vv = a->cvalues<T>() ; 
     int nx = width ; 
     int ny = height ; 
@@ -79,6 +85,43 @@ inline T MockTexture::lookup(float x, float y ) const
     return v0  ; 
 }
 
+/**
+MockTexture::lookup_linear
+----------------------------
+
+Bilinear filtering following cudaFilterModeLinear with clamp addressing
+and normalized coordinates, texel centres at (i+0.5)/width.
+Unlike CUDA the interpolation weights are not quantized to 8 bits.
+
+**/
+
+template<typename T> 
+inline T MockTexture::lookup_linear(float x, float y ) const
+{
+    const T* vv = a->cvalues<T>() ; 
+    int nx = width ; 
+    int ny = height ; 
+
+    float xb = x*float(nx) - 0.5f ; 
+    float yb = y*float(ny) - 0.5f ; 
+    int ix = int(floorf(xb)) ; 
+    int iy = int(floorf(yb)) ; 
+    float ax = xb - float(ix) ; 
+    float ay = yb - float(iy) ; 
+
+    int ix0 = std::min( std::max( ix,   0 ), nx-1 ) ; 
+    int ix1 = std::min( std::max( ix+1, 0 ), nx-1 ) ; 
+    int iy0 = std::min( std::max( iy,   0 ), ny-1 ) ; 
+    int iy1 = std::min( std::max( iy+1, 0 ), ny-1 ) ; 
+
+    T v00 = vv[iy0*nx+ix0] ; 
+    T v01 = vv[iy0*nx+ix1] ; 
+    T v10 = vv[iy1*nx+ix0] ; 
+    T v11 = vv[iy1*nx+ix1] ; 
+
+    return (1.f-ay)*((1.f-ax)*v00 + ax*v01) + ay*((1.f-ax)*v10 + ax*v11) ; 
+}
+
 template<typename T> 
 inline std::string MockTexture::dump() const
 {
@@ -100,13 +143,13 @@ struct MockTextureManager
     static MockTextureManager* INSTANCE ; 
     static MockTextureManager* Get(); 
     static MockTexture Get(cudaTextureObject_t tex); 
-    static cudaTextureObject_t Add(const NP* a ); 
+    static cudaTextureObject_t Add(const NP* a, char filterMode='P' ); 
 
     std::vector<MockTexture> tt ; 
 
     MockTextureManager() ;
 
-    cudaTextureObject_t add( const NP* a ); 
+    cudaTextureObject_t add( const NP* a, char filterMode='P' ); 
 
     static std::string Desc(); 
     std::string desc() const ; 
@@ -135,17 +178,17 @@ inline MockTexture MockTextureManager::Get(cudaTextureObject_t obj) // static
     assert(INSTANCE); 
     return INSTANCE->get(obj) ; 
 }
-inline cudaTextureObject_t MockTextureManager::Add(const NP* a )
+inline cudaTextureObject_t MockTextureManager::Add(const NP* a, char filterMode )
 {
     if(INSTANCE == nullptr) new MockTextureManager ; 
     assert(INSTANCE); 
-    return INSTANCE->add(a); 
+    return INSTANCE->add(a, filterMode); 
 }
 
-inline cudaTextureObject_t MockTextureManager::add(const NP* a )
+inline cudaTextureObject_t MockTextureManager::add(const NP* a, char filterMode )
 {
     cudaTextureObject_t idx = tt.size() ; 
-    MockTexture tex(a) ; 
+    MockTexture tex(a, filterMode) ; 
     tt.push_back(tex); 
     return idx ; 
 }
@@ -0,0 +1,350 @@
+#pragma once
+/**
+scerenkov_icdf.h : 2D (BetaInverse, u) inverse CDF tables for Cerenkov energy sampling
+==========================================================================================
+
+The rejection sampling of qcerenkov::wavelength_sampled_bndtex has an
+acceptance that collapses as BetaInverse approaches the RINDEX maximum
+(the permitted energy range shrinks to a sliver around the peak) making
+the number of loop turns, and hence the per-photon cost, unbounded and
+divergent across a warp. This builds tables that allow sampling the
+same distribution with a fixed number of texture lookups.
+
+For each material RINDEX n(e) the energy distribution of Cerenkov
+photons for a given BetaInverse is::
+
+    pdf(e) ~ s2(e) = max( 0, 1 - (BetaInverse/n(e))^2 )     e in [e0, e1]
+
+which is what the rejection loop samples. The builder integrates s2
+on a fine energy grid for *nb* BetaInverse values from 1 up to the
+RINDEX maximum and inverts the CDF at *nu* values of u.
+
+Layout of the float4 icdf array, shape (num_slot*nb, nu, 4)::
+
+    row = slot*nb + ib        BetaInverse = bi0 + ib*(bi1-bi0)/(nb-1)
+    column j
+
+    x : energy at u = j/(nu-1)                           "all"
+    y : energy at u = j/((nu-1)*hd_factor)               lhs zoom
+    z : energy at u = 1 - 1/hd_factor + j/((nu-1)*hd_factor)   rhs zoom
+    w : CDF at energy e = e0 + j*(e1-e0)/(nu-1)
+
+The xyz payload follows the hd_factor convention of NP::MakeICDF
+(with hd_factor fixed at 10). The w slot, spare in that convention, carries
+the CDF itself allowing the sampling to be restricted to the genstep
+energy range, which may be narrower than the table range::
+
+    u' = CDF(Emin) + u*( CDF(Emax) - CDF(Emin) )
+
+Materials are deduplicated by RINDEX content, the int slot array maps
+each boundary texture line (4*boundary + OMAT/OSUR/ISUR/IMAT) to its
+material slot or -1. Surface lines and materials without RINDEX above 1
+get -1.
+
+The dom float4 array, shape (num_slot, 4), holds the table domains (bi0, bi1, e0, e1)
+with energies in eV.
+
+RINDEX is interpolated linearly in wavelength, as the boundary texture
+lookup does with linear filtering.
+
+**/
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "scuda.h"
+#include "NP.hh"
+#include "sthread.h"
+
+struct scerenkov_icdf
+{
+    static constexpr const double hc_eVnm = 1239.8418754200 ;  // consistent with smath::hc_eVnm
+    static constexpr const int HD_FACTOR = 10 ;
+    static constexpr const int NUM_MATSUR = 4 ;  // OMAT OSUR ISUR IMAT
+    static constexpr const int NB = 256 ;    // 4MB of float4 texture per material slot
+    static constexpr const int NU = 1024 ;
+    static constexpr const int NS = 16 ;
+
+    int nb ;   // BetaInverse rows per material
+    int nu ;   // u columns
+    int ns ;   // integration substeps per energy column
+
+    double wl0 ;   // wavelength domain of RINDEX input
+    double wls ;
+    int    nwl ;
+
+    std::vector<std::vector<double>> rindex ;   // per slot RINDEX on the wavelength domain
+    std::vector<int> line_slot ;
+
+    NP* icdf ;
+    NP* dom ;
+    NP* slot ;
+
+    static scerenkov_icdf* Create(const NP* bnd, int nb=NB, int nu=NU, int ns=NS );
+
+    scerenkov_icdf(int nb, int nu, int ns);
+
+    int  add_rindex( const double* ri );
+    void build();
+    void build_row( int s, int ib, float* row, float4& d ) const ;
+
+    double rindex_at( int s, double energy ) const ;
+    double energy_sample( int s, double bi, double u, double e_lo, double e_hi ) const ;
+
+    int num_slot() const { return int(rindex.size()) ; }
+    std::string desc() const ;
+};
+
+
+/**
+scerenkov_icdf::Create
+------------------------
+
+bnd is the boundary array of shape (num_bnd, 4, 2, num_wavelength, 4)
+with RINDEX in payload slot 0 of group 0 of the material entries
+and wavelength domain metadata as set by sstandard::bnd.
+
+**/
+
+inline scerenkov_icdf* scerenkov_icdf::Create(const NP* bnd, int nb, int nu, int ns ) // static
+{
+    if( bnd == nullptr || bnd->shape.size() != 5 || bnd->shape[1] != NUM_MATSUR || bnd->shape[4] != 4 ) return nullptr ;
+
+    scerenkov_icdf* ck = new scerenkov_icdf(nb, nu, ns) ;
+    ck->wl0 = bnd->get_meta<double>("domain_low", 60. ) ;
+    ck->wls = bnd->get_meta<double>("domain_step", 1. ) ;
+    ck->nwl = bnd->shape[3] ;
+
+    int num_bnd = bnd->shape[0] ;
+    int ngrp = bnd->shape[2] ;
+    int num_line = num_bnd*NUM_MATSUR ;
+    ck->line_slot.resize( num_line, -1 );
+
+    NP* wbnd = bnd->ebyte == 8 ? const_cast<NP*>(bnd) : NP::MakeWide(bnd) ;
+    const double* vv = wbnd->cvalues<double>() ;
+    std::vector<double> ri(ck->nwl) ;
+
+    for(int line=0 ; line < num_line ; line++)
+    {
+        int k = line % NUM_MATSUR ;
+        if( k != 0 && k != NUM_MATSUR - 1 ) continue ;   // OMAT, IMAT
+        const double* lv = vv + line*ngrp*ck->nwl*4 ;     // group 0
+        for(int i=0 ; i < ck->nwl ; i++) ri[i] = lv[i*4+0] ;
+        ck->line_slot[line] = ck->add_rindex( ri.data() );
+    }
+    if( wbnd != bnd ) delete wbnd ;
+
+    ck->build();
+    return ck ;
+}
+
+inline scerenkov_icdf::scerenkov_icdf(int nb_, int nu_, int ns_)
+    :
+    nb(nb_),
+    nu(nu_),
+    ns(ns_),
+    wl0(60.),
+    wls(1.),
+    nwl(0),
+    icdf(nullptr),
+    dom(nullptr),
+    slot(nullptr)
+{
+}
+
+/**
+scerenkov_icdf::add_rindex
+----------------------------
+
+Returns the slot of the RINDEX, reusing the slot of identical earlier
+RINDEX or -1 when the maximum does not exceed 1 (no Cerenkov possible).
+
+**/
+
+inline int scerenkov_icdf::add_rindex( const double* ri )
+{
+    double mx = *std::max_element( ri, ri + nwl );
+    if( !(mx > 1.) ) return -1 ;
+    for(int s=0 ; s < num_slot() ; s++) if( memcmp( rindex[s].data(), ri, nwl*sizeof(double) ) == 0 ) return s ;
+    rindex.emplace_back( ri, ri + nwl );
+    return num_slot() - 1 ;
+}
+
+inline double scerenkov_icdf::rindex_at( int s, double energy ) const
+{
+    const std::vector<double>& ri = rindex[s] ;
+    double f = ( hc_eVnm/energy - wl0 )/wls ;
+    if( f <= 0. ) return ri[0] ;
+    if( f >= double(nwl-1) ) return ri[nwl-1] ;
+    int i = int(f) ;
+    double t = f - double(i) ;
+    return ri[i]*(1.-t) + ri[i+1]*t ;
+}
+
+/**
+scerenkov_icdf::build
+----------------------
+
+Rows are independent, so they are filled in parallel.
+
+**/
+
+inline void scerenkov_icdf::build()
+{
+    int ns_ = num_slot() ;
+    icdf = NP::Make<float>( ns_*nb, nu, 4 );
+    dom = NP::Make<float>( std::max(ns_,1), 4 );
+    slot = NP::Make<int>( int(line_slot.size()) );
+    memcpy( slot->bytes(), line_slot.data(), line_slot.size()*sizeof(int) );
+
+    float* ii = icdf->values<float>() ;
+    float4* dd = (float4*)dom->values<float>() ;
+
+    sthread::ParallelFor( int64_t(ns_)*nb, [&](int, int64_t r0, int64_t r1)
+    {
+        for(int64_t r=r0 ; r < r1 ; r++)
+        {
+            int s = int(r / nb) ;
+            int ib = int(r % nb) ;
+            float4 d ;
+            build_row( s, ib, ii + r*nu*4, d );
+            if( ib == 0 ) dd[s] = d ;
+        }
+    }, 1 );
+
+    icdf->set_meta<std::string>("creator", "scerenkov_icdf::build");
+    icdf->set_meta<int>("hd_factor", HD_FACTOR );
+    icdf->set_meta<int>("nb", nb );
+    icdf->set_meta<int>("nu", nu );
+    icdf->set_meta<int>("num_slot", ns_ );
+}
+
+/**
+scerenkov_icdf::build_row
+---------------------------
+
+1. fine energy grid of (nu-1)*ns+1 points across the table energy range
+2. trapezoid cumulative integral of s2, normalized
+3. invert by bisection of the fine CDF with linear interpolation
+   between grid points, u=0 and u=1 resolve to the edges of the
+   region with non-zero s2 rather than the table edges
+
+When BetaInverse reaches the RINDEX maximum s2 vanishes everywhere, the
+row is then filled with the energy of the maximum, the limit of the
+distribution.
+
+**/
+
+inline void scerenkov_icdf::build_row( int s, int ib, float* row, float4& d ) const
+{
+    const std::vector<double>& ri = rindex[s] ;
+    int imx = int( std::max_element( ri.begin(), ri.end() ) - ri.begin() ) ;
+
+    double bi0 = 1. ;
+    double bi1 = ri[imx] ;
+    double e0 = hc_eVnm/( wl0 + wls*double(nwl-1) ) ;
+    double e1 = hc_eVnm/wl0 ;
+    double e_mx = hc_eVnm/( wl0 + wls*double(imx) ) ;
+
+    d.x = bi0 ; d.y = bi1 ; d.z = e0 ; d.w = e1 ;
+
+    double bi = bi0 + double(ib)*(bi1 - bi0)/double(nb-1) ;
+
+    int nf = (nu-1)*ns + 1 ;
+    std::vector<double> ee(nf), cc(nf) ;
+    double prev = 0. ;
+    for(int i=0 ; i < nf ; i++)
+    {
+        ee[i] = e0 + double(i)*(e1 - e0)/double(nf-1) ;
+        double ct = bi/rindex_at(s, ee[i]) ;
+        double s2 = std::max( 0., (1. - ct)*(1. + ct) ) ;
+        cc[i] = i == 0 ? 0. : cc[i-1] + 0.5*(prev + s2)*(ee[i] - ee[i-1]) ;
+        prev = s2 ;
+    }
+    double tot = cc[nf-1] ;
+    bool empty = !(tot > 0.) ;
+    if(!empty) for(int i=0 ; i < nf ; i++) cc[i] /= tot ;
+
+    auto inv = [&](double u) -> double
+    {
+        if( empty ) return e_mx ;
+        auto it = u < 1. ? std::upper_bound( cc.begin(), cc.end(), u ) : std::lower_bound( cc.begin(), cc.end(), u ) ;
+        int i = int( it - cc.begin() ) ;
+        if( i <= 0 ) return ee[0] ;
+        if( i >= nf ) return ee[nf-1] ;
+        double dc = cc[i] - cc[i-1] ;
+        double t = dc > 0. ? (u - cc[i-1])/dc : 0. ;
+        return ee[i-1] + t*(ee[i] - ee[i-1]) ;
+    };
+
+    double edge = 1./double(HD_FACTOR) ;
+    for(int j=0 ; j < nu ; j++)
+    {
+        double uj = double(j)/double(nu-1) ;
+        row[j*4+0] = inv( uj ) ;
+        row[j*4+1] = inv( uj*edge ) ;
+        row[j*4+2] = inv( 1. - edge + uj*edge ) ;
+        row[j*4+3] = empty ? ( ee[j*ns] < e_mx ? 0.f : 1.f ) : cc[j*ns] ;
+    }
+}
+
+/**
+scerenkov_icdf::energy_sample
+-------------------------------
+
+Host reference of the device lookup in qcerenkov::wavelength_sampled_icdf
+using the nearest BetaInverse row with linear interpolation along u.
+
+**/
+
+inline double scerenkov_icdf::energy_sample( int s, double bi, double u, double e_lo, double e_hi ) const
+{
+    const float4* dd = (const float4*)dom->cvalues<float>() ;
+    const float4& d = dd[s] ;
+    double fb = std::min( std::max( (bi - d.x)/(d.y - d.x)*double(nb-1), 0. ), double(nb-1) ) ;
+    int ib = int( fb + 0.5 ) ;
+    const float* row = icdf->cvalues<float>() + (s*nb + ib)*nu*4 ;
+
+    auto at = [&](int k, double x) -> double
+    {
+        double f = std::min( std::max( x*double(nu-1), 0. ), double(nu-1) ) ;
+        int j = std::min( int(f), nu-2 ) ;
+        double t = f - double(j) ;
+        return row[j*4+k]*(1.-t) + row[(j+1)*4+k]*t ;
+    };
+
+    double c_lo = at(3, (e_lo - d.z)/(d.w - d.z)) ;
+    double c_hi = at(3, (e_hi - d.z)/(d.w - d.z)) ;
+    double uu = c_lo + u*(c_hi - c_lo) ;
+    double edge = 1./double(HD_FACTOR) ;
+    return uu < edge ? at(1, uu*HD_FACTOR) : ( uu > 1. - edge ? at(2, (uu - 1. + edge)*HD_FACTOR ) : at(0, uu) ) ;
+}
+
+inline std::string scerenkov_icdf::desc() const
+{
+    std::stringstream ss ;
+    ss << "scerenkov_icdf::desc"
+       << " nb " << nb
+       << " nu " << nu
+       << " ns " << ns
+       << " nwl " << nwl
+       << " num_slot " << num_slot()
+       << " num_line " << line_slot.size()
+       << " icdf " << ( icdf ? icdf->sstr() : "-" )
+       << "\n"
+       ;
+    const float4* dd = dom ? (const float4*)dom->cvalues<float>() : nullptr ;
+    for(int s=0 ; s < num_slot() && dd ; s++)
+        ss << " slot " << std::setw(3) << s
+           << " bi " << std::fixed << std::setprecision(4) << dd[s].x << " : " << dd[s].y
+           << " eV " << dd[s].z << " : " << dd[s].w
+           << "\n"
+           ;
+    std::string str = ss.str();
+    return str ;
+}
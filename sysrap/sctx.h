@@ -77,6 +77,7 @@ struct sctx
 
     sphoton p ;
     sstate  s ;
+    float   tau ;   // accumulated absorption optical depth of weighted propagation, weight = expf(-tau)
 
 #ifndef PRODUCTION
     srec rec ;
@@ -9,12 +9,34 @@ Example from /usr/include/openssl/opensslv.h::
 
    33 # define OPENSSL_VERSION_NUMBER  0x100020bfL
 
+
+Digest modes
+--------------
+
+By default digests are MD5. Setting envvar::
+
+    export sdigest__MODE=fast
+
+switches all sdigest users (stree subtree digests, SBnd/SSim item
+digests, sphoton digests, SCurandChunk load digests) to the non-cryptographic
+shash.h 128 bit hash, which is an order of magnitude faster.
+Hexdigests remain 32 chars, but have different values, so digests persisted
+with one mode must not be compared with digests from the other.
+
+The static Buf/BufRaw/Item/Array methods and the streaming add methods
+all digest the bytes in a single stream, so a buffer gives the same
+digest whichever entry point is used and whatever its size.
+
 **/
 
 #include <string>
 #include <vector>
 #include <array>
 #include <sstream>
+#include <cstring>
+
+#include "ssys.h"
+#include "shash.h"
 
 #if defined __APPLE__
 
@@ -43,10 +65,17 @@ struct NP ;
 
 struct sdigest
 {
+    enum { MD5, FAST } ;
+    static constexpr const char* sdigest__MODE = "sdigest__MODE" ;
+    static int Mode();
+    static const char* ModeName(int mode);
     static std::string Desc();
 
+    int mode ;
     MD5_CTX ctx ;
-    sdigest();
+    shash hh ;
+
+    sdigest(int mode=Mode());
     void add( const std::string& str);
     void add( const char* str );
     void add( int i );
@@ -60,6 +89,8 @@ struct sdigest
     static std::string Item(const NP* a, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1);
     static std::array<unsigned char,16> ItemRaw(const NP* a, int i=-1, int j=-1, int k=-1, int l=-1, int m=-1, int o=-1);
 
+    static std::string Array(const NP* a);
+
     static std::string Buf(const char* buffer, int length);
     static std::array<unsigned char,16> BufRaw(const char* buffer, int length);
     static void BufRaw_(unsigned char* digest_16, const char* buffer, int length);
@@ -93,9 +124,35 @@ struct sdigest
 };
 
 
+/**
+sdigest::Mode
+---------------
+
+From envvar sdigest__MODE "md5" (default) or "fast", read once
+with thread safe static initialization as digests are made from
+worker threads.
+
+**/
+
+inline int sdigest::Mode()
+{
+    static const int _mode = []()
+    {
+        const char* m = ssys::getenvvar(sdigest__MODE, "md5") ;
+        return ( m && strcmp(m, "fast") == 0 ) ? int(FAST) : int(MD5) ;
+    }() ;
+    return _mode ;
+}
+
+inline const char* sdigest::ModeName(int mode)
+{
+    return mode == FAST ? "fast" : "md5" ;
+}
+
 inline std::string sdigest::Desc()
 {
     std::stringstream ss ;
+    ss << "sdigest::Desc " << sdigest__MODE << " " << ModeName(Mode()) << std::endl ;
 #if OPENSSL_VERSION_NUMBER == 0x100020bfL
     ss << "OPENSSL_VERSION_NUMBER == 0x100020bfL" << std::endl ;
 #elif OPENSSL_VERSION_NUMBER > 0x100020bfL
@@ -113,15 +170,15 @@ inline std::string sdigest::Desc()
 }
 
 
-inline sdigest::sdigest(){ MD5_Init(&ctx); }
-inline void sdigest::add( const std::string& str){ Update(ctx, str) ; }
-inline void sdigest::add( const char* str ){ Update(ctx, str) ; }
-inline void sdigest::add( int i ){ Update(ctx, i ) ; }
-inline void sdigest::add( const char* str, int length ){ Update(ctx, str, length ) ; }
-inline void sdigest::add( const std::vector<unsigned char>& bytes ){ Update(ctx, (char*)bytes.data(), bytes.size() ); }
+inline sdigest::sdigest(int mode_) : mode(mode_) { if(mode == MD5) MD5_Init(&ctx); }
+inline void sdigest::add( const std::string& str){ if(mode == FAST) hh.add(str) ; else Update(ctx, str) ; }
+inline void sdigest::add( const char* str ){ if(mode == FAST) hh.add(str) ; else Update(ctx, str) ; }
+inline void sdigest::add( int i ){ if(mode == FAST) hh.add(i) ; else Update(ctx, i ) ; }
+inline void sdigest::add( const char* str, int length ){ if(mode == FAST) hh.add(str, length) ; else Update(ctx, str, length ) ; }
+inline void sdigest::add( const std::vector<unsigned char>& bytes ){ if(mode == FAST) hh.add(bytes) ; else Update(ctx, (char*)bytes.data(), bytes.size() ); }
 
-inline std::string sdigest::finalize(){ return Finalize(ctx) ; }
-inline std::array<unsigned char,16> sdigest::finalize_raw(){ return FinalizeRaw(ctx) ; }
+inline std::string sdigest::finalize(){ return mode == FAST ? hh.hexdigest() : Finalize(ctx) ; }
+inline std::array<unsigned char,16> sdigest::finalize_raw(){ return mode == FAST ? hh.digest_raw() : FinalizeRaw(ctx) ; }
 
 
 
@@ -156,8 +213,29 @@ inline std::array<unsigned char,16> sdigest::ItemRaw( const NP* a, int i, int j,
 }
 
 
+/**
+sdigest::Array
+----------------
+
+Digest of all the array bytes, fed in pieces of at most 1GB as the
+Update length is an int. The digest matches Buf of the same bytes.
+
+**/
+
+inline std::string sdigest::Array(const NP* a) // static
+{
+    const char* bytes = a->bytes() ;
+    size_t num_bytes = a->uarr_bytes() ;
+    sdigest dig ;
+    const size_t piece = 1 << 30 ;
+    for(size_t b0=0 ; b0 < num_bytes ; b0 += piece ) dig.add( bytes + b0, int(std::min(piece, num_bytes - b0)) );
+    return dig.finalize();
+}
+
+
 inline std::string sdigest::Buf(const char* buffer, int length) // static
 {
+    if(Mode() == FAST) return shash::Buf(buffer, length);
     MD5_CTX c;
     MD5_Init(&c);
     Update(c, buffer, length);
@@ -165,14 +243,21 @@ inline std::string sdigest::Buf(const char* buffer, int length) // static
 }
 inline std::array<unsigned char,16> sdigest::BufRaw(const char* buffer, int length) // static
 {
-    MD5_CTX c;
-    MD5_Init(&c);
-    Update(c, buffer, length);
-    return FinalizeRaw(c);
+    std::array<unsigned char,16> raw ;
+    BufRaw_( raw.data(), buffer, length );
+    return raw ;
 }
 
 inline void sdigest::BufRaw_(unsigned char* digest_16, const char* buffer, int length) // static
 {
+    if(Mode() == FAST)
+    {
+        shash h ;
+        h.add(buffer, length);
+        std::array<unsigned char,16> raw = h.digest_raw() ;
+        memcpy(digest_16, raw.data(), 16 );
+        return ;
+    }
     MD5_CTX c;
     MD5_Init(&c);
     Update(c, buffer, length);
@@ -184,10 +269,9 @@ inline void sdigest::BufRaw_(unsigned char* digest_16, const char* buffer, int l
 
 inline std::string sdigest::Int(int i) // static
 {
-    MD5_CTX c;
-    MD5_Init(&c);
-    Update(c, i);
-    return Finalize(c);
+    sdigest dig ;
+    dig.add(i);
+    return dig.finalize();
 }
 
 
@@ -302,7 +386,7 @@ inline void sdigest::Update_(MD5_CTX& c, T* vv, size_t count )
 }
 
 template<typename T>
-inline void sdigest::add_( T* vv, size_t count ){ Update_<T>(ctx, vv, count  );  }
+inline void sdigest::add_( T* vv, size_t count ){ if(mode == FAST) hh.add_(vv, count) ; else Update_<T>(ctx, vv, count  );  }
 
 
 
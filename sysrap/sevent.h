@@ -137,6 +137,8 @@ struct sevent
 
     int   mode_lite    ; // 0 or 1 (also 2 when debug comparing)
 
+    float weight_threshold ; // 0: analogue, >0: weighted propagation with russian roulette below threshold
+
     int   index ;
 
     //[ counts and pointers, zeroed by sevent::zero
@@ -172,6 +174,7 @@ struct sevent
 
     quad6*   genstep ;    //QEvt::device_alloc_genstep
     int*     seed ;
+    int*     order ;      // optional launch order permutation of photon slots, see sseedorder.h
 
     sphoton*     photon ;     //QEvt::device_alloc_photon
     sphoton*     hit ;        //QEvt::gatherHit_ allocates event by event depending on num_hit
@@ -257,6 +260,7 @@ SEVENT_METHOD void sevent::init()
     max_sup      = SEventConfig::MaxSup()  ;
 
     mode_lite     = SEventConfig::ModeLite() ;
+    weight_threshold = SEventConfig::PropagateWeightThreshold() ;
 
     zero();  // pointers and counts
 
@@ -366,6 +370,8 @@ SEVENT_METHOD std::string sevent::descBuf() const
         << std::setw(20) << " num_seed "        << std::setw(7) << num_seed
         << std::setw(20) << " max_photon "      << std::setw(7) << max_photon
         << std::endl
+        << std::setw(20) << " evt.order  "      << std::setw(w) << ( order   ? "Y" : "N" ) << " " << std::setw(20) << order
+        << std::endl
         << std::setw(20) << " evt.photon "      << std::setw(w) << ( photon  ? "Y" : "N" ) << " " << std::setw(20) << photon
         << std::setw(20) << " num_photon "      << std::setw(7) << num_photon
         << std::setw(20) << " max_photon "      << std::setw(7) << max_photon
@@ -557,6 +563,7 @@ SEVENT_METHOD void sevent::zero()
 
     genstep = nullptr ;
     seed = nullptr ;
+    order = nullptr ;
     hit = nullptr ;
     hitlite = nullptr ;
     hitlitemerged = nullptr ;
@@ -0,0 +1,308 @@
+#pragma once
+/**
+seventsplit.h : partition hits simulated in one launch back into their G4 events
+==================================================================================
+
+When gensteps from many Geant4 events are accumulated and simulated with
+a single launch (eg at EndOfRunAction) the hit array mixes all events.
+As the photon index of each hit identifies its genstep via the cumulative
+genstep photon offsets, and the sgsid provenance of the genstep gives the
+eventID, the hits can be grouped by event with one counting sort pass::
+
+    seventsplit* split = seventsplit::Create( hit, gs_offset, gs_eventID, num_gs );
+
+    for(int i=0 ; i < split->num_event() ; i++)
+    {
+        int eventID = split->eventID[i] ;
+        const sphoton* hh = split->hits(i) ;
+        int64_t num = split->num_hit(i) ;
+    }
+
+Events are ordered by ascending eventID and the order of hits within each
+event is preserved (the sort is stable). Events with gensteps but without
+hits are present with zero hits.
+
+The counting and scattering are sharded with sthread::ParallelFor, with
+per-shard counts making the result identical to the serial one.
+
+With the optional genstep threadID each event also records the worker
+thread that collected its gensteps, so hits can go back to the thread
+that is processing the event, see u4/U4HitPool.h. All gensteps of a G4 event
+come from one worker, a conflict gives threadID -2.
+
+Partitioning requires full sphoton hits that were not merged. As sphotonlite
+hits do not carry the photon index they are accepted only when all gensteps
+belong to one event, as with the per event launches of U4HitPool.
+The same restriction applies to merged hits (OPTICKS_MODE_MERGE) of either
+layout : the merge key does not include the eventID, so hits from different
+events can be merged together and the index of a merged hit does not
+give its event.
+Usually used via SEvt::makeHitSplit.
+
+**/
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cassert>
+
+#include "sphoton.h"
+#include "sphotonlite.h"
+#include "sthread.h"
+#include "NP.hh"
+
+struct seventsplit
+{
+    std::vector<int>     eventID ;   // unique eventID of the gensteps in ascending order
+    std::vector<int>     threadID ;  // per event thread that collected the gensteps, -1 when not known
+    std::vector<int64_t> offset ;    // num_event+1 offsets into hit
+    NP*                  hit ;       // hits grouped by event, sphoton (-1,4,4) or single event sphotonlite (-1,4)
+    bool                 lite ;
+
+    template<typename F>
+    static int64_t GenstepIndex(F gs_offset, int num_gs, int64_t photon_total, uint64_t photon_index);
+    static int64_t GenstepIndex(const int64_t* gs_offset, int num_gs, uint64_t photon_index);
+    static seventsplit* Create(const NP* hit, const int64_t* gs_offset, const int* gs_eventID, int num_gs, const int* gs_threadID=nullptr, bool merged=false );
+
+    seventsplit() : hit(nullptr), lite(false) {}
+    ~seventsplit(){ delete hit ; }
+
+    int     num_event() const { return int(eventID.size()) ; }
+    int     find(int eventID) const ;
+    int64_t num_hit(int i) const { return offset[i+1] - offset[i] ; }
+    bool    is_lite() const { return lite ; }
+    const sphoton*     hits(int i) const ;
+    const sphotonlite* hits_lite(int i) const ;
+    void    events_of_thread(std::vector<int>& slots, int tid) const ;
+    NP*     slice(int i) const ;
+    std::string desc() const ;
+};
+
+/**
+seventsplit::GenstepIndex
+---------------------------
+
+Binary search for the last genstep g with gs_offset(g) <= photon_index,
+so zero photon gensteps sharing an offset resolve to the last of them.
+Returns -1 for photon indices beyond photon_total.
+The functor form allows use with the sgs labels of SEvt without
+copying the offsets, see SEvt::getGenstepIndexForPhoton.
+
+**/
+
+template<typename F>
+inline int64_t seventsplit::GenstepIndex(F gs_offset, int num_gs, int64_t photon_total, uint64_t photon_index) // static
+{
+    if( num_gs <= 0 || int64_t(photon_index) >= photon_total ) return -1 ;
+    int64_t lo = 0 ;
+    int64_t hi = num_gs ;
+    while( hi - lo > 1 )
+    {
+        int64_t mid = lo + (hi - lo)/2 ;
+        if( gs_offset(mid) <= int64_t(photon_index) ) lo = mid ;
+        else hi = mid ;
+    }
+    return lo ;
+}
+
+/**
+seventsplit::GenstepIndex
+---------------------------
+
+gs_offset has num_gs+1 entries, the last being the photon total.
+
+**/
+
+inline int64_t seventsplit::GenstepIndex(const int64_t* gs_offset, int num_gs, uint64_t photon_index) // static
+{
+    if( num_gs <= 0 ) return -1 ;
+    return GenstepIndex( [gs_offset](int64_t g){ return gs_offset[g] ; }, num_gs, gs_offset[num_gs], photon_index );
+}
+
+/**
+seventsplit::Create
+---------------------
+
+1. map genstep eventID to dense event slots
+2. per-shard count of hits in each slot, recording the slot of every hit
+3. per-shard start positions from the counts in event then shard order
+4. scatter the hits into place
+
+Returns nullptr when the hits are neither sphoton nor sphotonlite,
+when sphotonlite or merged hits come from more than one event
+or when a hit index is beyond the genstep photon total.
+
+**/
+
+inline seventsplit* seventsplit::Create(const NP* hit, const int64_t* gs_offset, const int* gs_eventID, int num_gs, const int* gs_threadID, bool merged ) // static
+{
+    bool full = hit && hit->uifc == 'f' && hit->ebyte == 4 && hit->has_shape(-1,4,4) ;
+    bool lite = hit && hit->uifc == 'u' && hit->ebyte == 4 && hit->has_shape(-1,4) ;
+    if( !full && !lite )
+    {
+        std::cerr << "seventsplit::Create requires sphoton or sphotonlite hits, not " << ( hit ? hit->sstr() : "-" ) << "\n" ;
+        return nullptr ;
+    }
+
+    seventsplit* split = new seventsplit ;
+    split->eventID.assign( gs_eventID, gs_eventID + num_gs );
+    std::sort( split->eventID.begin(), split->eventID.end() );
+    split->eventID.erase( std::unique( split->eventID.begin(), split->eventID.end() ), split->eventID.end() );
+
+    int num_event = split->num_event() ;
+    std::vector<int> gs_slot(num_gs) ;
+    for(int g=0 ; g < num_gs ; g++) gs_slot[g] = int( std::lower_bound( split->eventID.begin(), split->eventID.end(), gs_eventID[g] ) - split->eventID.begin() ) ;
+
+    split->threadID.assign( num_event, -1 );
+    if( gs_threadID ) for(int g=0 ; g < num_gs ; g++)
+    {
+        int& tid = split->threadID[gs_slot[g]] ;
+        if( gs_threadID[g] < 0 || tid == -2 ) continue ;
+        tid = ( tid == -1 || tid == gs_threadID[g] ) ? gs_threadID[g] : -2 ;
+    }
+
+    int64_t num_hit = hit->shape[0] ;
+
+    if( lite || merged )
+    {
+        if( num_event != 1 )
+        {
+            std::cerr
+                << "seventsplit::Create "
+                << ( merged ? "merged hits can combine events" : "sphotonlite hits lack the photon index" )
+                << ", cannot split " << num_event << " events\n"
+                ;
+            delete split ;
+            return nullptr ;
+        }
+        split->lite = lite ;
+        split->offset = { 0, num_hit } ;
+        split->hit = hit->copy() ;
+        split->hit->set_meta<int>("num_event", num_event );
+        return split ;
+    }
+    const sphoton* hh = (const sphoton*)hit->cvalues<float>() ;
+
+    std::vector<int> slot(num_hit) ;
+    int num_shard = sthread::NumShard(num_hit) ;
+    std::vector<int64_t> count( num_shard*num_event, 0 ) ;
+    std::vector<int64_t> bad( num_shard, 0 ) ;
+
+    sthread::ParallelFor( num_hit, [&](int s, int64_t i0, int64_t i1)
+    {
+        int64_t* cs = count.data() + s*num_event ;
+        for(int64_t i=i0 ; i < i1 ; i++)
+        {
+            int64_t g = GenstepIndex( gs_offset, num_gs, hh[i].get_index() ) ;
+            if( g < 0 ) { slot[i] = -1 ; bad[s] += 1 ; continue ; }
+            slot[i] = gs_slot[g] ;
+            cs[slot[i]] += 1 ;
+        }
+    }, sthread::MIN_PER_SHARD, num_shard );
+
+    int64_t num_bad = 0 ;
+    for(int64_t b : bad) num_bad += b ;
+    if( num_bad > 0 )
+    {
+        std::cerr << "seventsplit::Create num_bad " << num_bad << " hits with photon index beyond genstep photon total " << gs_offset[num_gs] << "\n" ;
+        delete split ;
+        return nullptr ;
+    }
+
+    split->offset.resize(num_event+1) ;
+    std::vector<int64_t> start( num_shard*num_event ) ;
+    int64_t pos = 0 ;
+    for(int e=0 ; e < num_event ; e++)
+    {
+        split->offset[e] = pos ;
+        for(int s=0 ; s < num_shard ; s++)
+        {
+            start[s*num_event+e] = pos ;
+            pos += count[s*num_event+e] ;
+        }
+    }
+    split->offset[num_event] = pos ;
+
+    split->hit = NP::Make<float>( num_hit, 4, 4 ) ;
+    split->hit->set_meta<int>("num_event", num_event );
+    sphoton* dd = (sphoton*)split->hit->values<float>() ;
+
+    sthread::ParallelFor( num_hit, [&](int s, int64_t i0, int64_t i1)
+    {
+        int64_t* ss = start.data() + s*num_event ;
+        for(int64_t i=i0 ; i < i1 ; i++) dd[ss[slot[i]]++] = hh[i] ;
+    }, sthread::MIN_PER_SHARD, num_shard );
+
+    return split ;
+}
+
+inline int seventsplit::find(int eid) const
+{
+    auto it = std::lower_bound( eventID.begin(), eventID.end(), eid );
+    return it != eventID.end() && *it == eid ? int(it - eventID.begin()) : -1 ;
+}
+
+inline const sphoton* seventsplit::hits(int i) const
+{
+    assert( !is_lite() );
+    return (const sphoton*)hit->cvalues<float>() + offset[i] ;
+}
+
+inline const sphotonlite* seventsplit::hits_lite(int i) const
+{
+    assert( is_lite() );
+    return (const sphotonlite*)hit->cvalues<uint32_t>() + offset[i] ;
+}
+
+/**
+seventsplit::events_of_thread
+-------------------------------
+
+Collects the slots of the events whose gensteps came from thread *tid*.
+
+**/
+
+inline void seventsplit::events_of_thread(std::vector<int>& slots, int tid) const
+{
+    slots.clear();
+    for(int i=0 ; i < num_event() ; i++) if( threadID[i] == tid ) slots.push_back(i) ;
+}
+
+/**
+seventsplit::slice
+--------------------
+
+Independent copy of the hits of event i with eventID metadata.
+
+**/
+
+inline NP* seventsplit::slice(int i) const
+{
+    if( i < 0 || i >= num_event() ) return nullptr ;
+    int64_t num = num_hit(i) ;
+    bool lite = is_lite() ;
+    NP* a = lite ? NP::Make<uint32_t>( num, 4 ) : NP::Make<float>( num, 4, 4 ) ;
+    if( num > 0 && lite ) memcpy( a->bytes(), hits_lite(i), num*sizeof(sphotonlite) );
+    if( num > 0 && !lite ) memcpy( a->bytes(), hits(i), num*sizeof(sphoton) );
+    a->set_meta<int>("eventID", eventID[i] );
+    return a ;
+}
+
+inline std::string seventsplit::desc() const
+{
+    std::stringstream ss ;
+    ss << "seventsplit::desc"
+       << " num_event " << num_event()
+       << " num_hit " << ( hit ? hit->shape[0] : 0 )
+       << "\n"
+       ;
+    for(int i=0 ; i < std::min(num_event(), 20) ; i++)
+        ss << " eventID " << std::setw(6) << eventID[i] << " threadID " << std::setw(3) << threadID[i] << " num_hit " << std::setw(8) << num_hit(i) << "\n" ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,335 @@
+#pragma once
+/**
+sevtmerge.h : lockless hand-off of per-worker SEvt content to a master SEvt
+=============================================================================
+
+With per-worker SEvt (see SEvt::CreateOrReuseWorker) each Geant4 worker
+thread collects gensteps and hostside photons into its own SEvt without
+locking. At end of event (or end of run in the batching workflow) the
+worker moves the content of its vectors into an sevtshard and pushes it
+onto the lock-free list of the sevtmerge for the SEvt instance::
+
+    worker thread                          master thread
+    --------------                         ---------------
+    SEvt::endOfEvent
+       sevtshard* s = new sevtshard
+       swap vectors into s
+       merge.push(s)   // CAS, no lock
+                                           SEvt::MergeWorkers
+                                              take()        // exchange, no lock
+                                              Append(acc, s) for shards in (eventID, worker) order
+
+The shards are appended in (eventID, worker) order, so the merged
+content does not depend on thread scheduling. Appending fixes up the
+indices that refer to the position of a genstep or photon within the
+event:
+
++-----------+---------------------------------------------------+
+| vector    | fixup                                             |
++===========+===================================================+
+| gs        | index += num_genstep, offset += num_photon        |
++-----------+---------------------------------------------------+
+| pho       | gs += num_genstep, id += num_photon               |
++-----------+---------------------------------------------------+
+| photon    | index += num_photon (written photons only)        |
++-----------+---------------------------------------------------+
+| record    | index += num_photon (written points only)         |
++-----------+---------------------------------------------------+
+
+The other per-photon vectors are positional, they are concatenated
+with zero padding for shards without the component.
+
+::
+
+    ~/o/sysrap/tests/sevtmerge_test.sh
+
+**/
+
+#include <atomic>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <cassert>
+
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "srec.h"
+#include "sseq.h"
+#include "stag.h"
+#include "sgs.h"
+#include "sgsid.h"
+#include "spho.h"
+
+
+struct sevtshard
+{
+    int eventID ;
+    int worker ;
+
+    std::vector<quad6>   genstep ;
+    std::vector<sgs>     gs ;
+    std::vector<sgsid>   gsid ;
+
+    std::vector<spho>    pho ;
+    std::vector<int>     slot ;
+    std::vector<sphoton> photon ;
+    std::vector<sphoton> record ;
+    std::vector<srec>    rec ;
+    std::vector<sseq>    seq ;
+    std::vector<quad2>   prd ;
+    std::vector<stag>    tag ;
+    std::vector<sflat>   flat ;
+    std::vector<quad4>   aux ;
+    std::vector<quad6>   sup ;
+
+    sevtshard* next ;
+
+    sevtshard( int eventID=-1, int worker=-1 );
+
+    int64_t num_genstep() const ;
+    int64_t num_photon() const ;
+    std::string desc() const ;
+};
+
+inline sevtshard::sevtshard( int eventID_, int worker_ )
+    :
+    eventID(eventID_),
+    worker(worker_),
+    next(nullptr)
+{
+}
+
+inline int64_t sevtshard::num_genstep() const
+{
+    return int64_t(gs.size()) ;
+}
+
+/**
+sevtshard::num_photon
+-----------------------
+
+From the genstep labels, as the photon vectors are empty when only gensteps are collected.
+
+**/
+
+inline int64_t sevtshard::num_photon() const
+{
+    return gs.empty() ? 0 : gs.back().offset + gs.back().photons ;
+}
+
+inline std::string sevtshard::desc() const
+{
+    std::stringstream ss ;
+    ss << "sevtshard::desc"
+       << " eventID " << eventID
+       << " worker " << worker
+       << " num_genstep " << num_genstep()
+       << " num_photon " << num_photon()
+       << " photon " << photon.size()
+       << " record " << record.size()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+
+struct sevtmerge
+{
+    std::atomic<sevtshard*> head ;
+    std::atomic<int>        num_worker ;
+    std::atomic<int64_t>    num_push ;
+    int64_t                 num_merged ;
+
+    sevtmerge();
+
+    int  add_worker();
+    void push( sevtshard* s );
+    std::vector<sevtshard*> take( int eventID=-1 );
+
+    static bool Order( const sevtshard* a, const sevtshard* b );
+    static void Append( sevtshard& dst, const sevtshard& src );
+
+    template<typename T>
+    static void Concat( std::vector<T>& dst, const std::vector<T>& src, int64_t dst_np, int64_t src_np );
+    static void Reindex( sphoton* pp, int64_t num, int64_t offset );
+
+    std::string desc() const ;
+};
+
+inline sevtmerge::sevtmerge()
+    :
+    head(nullptr),
+    num_worker(0),
+    num_push(0),
+    num_merged(0)
+{
+}
+
+/**
+sevtmerge::add_worker
+-----------------------
+
+Returns 0-based worker number, used to order shards from the same eventID.
+
+**/
+
+inline int sevtmerge::add_worker()
+{
+    return num_worker.fetch_add(1) ;
+}
+
+/**
+sevtmerge::push
+-----------------
+
+Called from worker threads, lock-free push onto the head of the shard list.
+
+**/
+
+inline void sevtmerge::push( sevtshard* s )
+{
+    s->next = head.load(std::memory_order_relaxed) ;
+    while(!head.compare_exchange_weak( s->next, s, std::memory_order_release, std::memory_order_relaxed )) {}
+    num_push += 1 ;
+}
+
+/**
+sevtmerge::take
+-----------------
+
+Detaches all shards pushed so far, returning them in (eventID, worker) order.
+With eventID > -1 only the shards of that event are returned, the others
+are pushed back for a later take. The caller owns the returned shards.
+
+**/
+
+inline std::vector<sevtshard*> sevtmerge::take( int eventID )
+{
+    std::vector<sevtshard*> ss ;
+    std::vector<sevtshard*> other ;
+    sevtshard* s = head.exchange(nullptr, std::memory_order_acquire) ;
+    while(s)
+    {
+        sevtshard* next = s->next ;
+        if( eventID < 0 || s->eventID == eventID ) ss.push_back(s) ;
+        else other.push_back(s) ;
+        s = next ;
+    }
+    for(sevtshard* o : other)
+    {
+        o->next = head.load(std::memory_order_relaxed) ;
+        while(!head.compare_exchange_weak( o->next, o, std::memory_order_release, std::memory_order_relaxed )) {}
+    }
+    std::stable_sort( ss.begin(), ss.end(), Order );
+    return ss ;
+}
+
+inline bool sevtmerge::Order( const sevtshard* a, const sevtshard* b ) // static
+{
+    return a->eventID != b->eventID ? a->eventID < b->eventID : a->worker < b->worker ;
+}
+
+/**
+sevtmerge::Append
+-------------------
+
+Appends src to dst with the index fixups tabulated above.
+
+**/
+
+inline void sevtmerge::Append( sevtshard& dst, const sevtshard& src ) // static
+{
+    int64_t gs0 = dst.num_genstep() ;
+    int64_t ph0 = dst.num_photon() ;
+    int64_t src_np = src.num_photon() ;
+
+    dst.genstep.insert( dst.genstep.end(), src.genstep.begin(), src.genstep.end() );
+    dst.gsid.insert(    dst.gsid.end(),    src.gsid.begin(),    src.gsid.end() );
+    for(size_t i=0 ; i < src.gs.size() ; i++)
+    {
+        sgs s = src.gs[i] ;
+        s.index  += gs0 ;
+        s.offset += ph0 ;
+        dst.gs.push_back(s) ;
+    }
+
+    Concat( dst.pho, src.pho, ph0, src_np );   // src is copied to the end of dst
+    for(size_t i=dst.pho.size() - src.pho.size() ; i < dst.pho.size() ; i++)
+    {
+        spho& p = dst.pho[i] ;
+        if(!p.isDefined()) continue ;
+        p.gs += int(gs0) ;
+        p.id += int(ph0) ;
+    }
+
+    Concat( dst.photon, src.photon, ph0, src_np );
+    Reindex( dst.photon.data() + dst.photon.size() - src.photon.size(), int64_t(src.photon.size()), ph0 );
+
+    Concat( dst.record, src.record, ph0, src_np );
+    Reindex( dst.record.data() + dst.record.size() - src.record.size(), int64_t(src.record.size()), ph0 );
+
+    Concat( dst.slot, src.slot, ph0, src_np );
+    Concat( dst.rec,  src.rec,  ph0, src_np );
+    Concat( dst.seq,  src.seq,  ph0, src_np );
+    Concat( dst.prd,  src.prd,  ph0, src_np );
+    Concat( dst.tag,  src.tag,  ph0, src_np );
+    Concat( dst.flat, src.flat, ph0, src_np );
+    Concat( dst.aux,  src.aux,  ph0, src_np );
+    Concat( dst.sup,  src.sup,  ph0, src_np );
+}
+
+/**
+sevtmerge::Concat
+-------------------
+
+The per-photon vectors hold stride items for each photon, either all
+photons of a shard or none. The stride is obtained from whichever of
+dst and src is not empty, the other is zero padded.
+
+**/
+
+template<typename T>
+inline void sevtmerge::Concat( std::vector<T>& dst, const std::vector<T>& src, int64_t dst_np, int64_t src_np ) // static
+{
+    if( src.empty() && dst.empty() ) return ;
+    if( src.empty() && src_np == 0 ) return ;
+
+    int64_t stride = dst.empty() ? int64_t(src.size())/src_np : int64_t(dst.size())/dst_np ;
+    assert( src.empty() || int64_t(src.size()) == src_np*stride );
+    assert( dst.empty() || int64_t(dst.size()) == dst_np*stride );
+
+    dst.resize( (dst_np + src_np)*stride );
+    std::copy( src.begin(), src.end(), dst.begin() + dst_np*stride );
+}
+
+/**
+sevtmerge::Reindex
+--------------------
+
+Offsets the photon index of written photons, zeroed placeholders are skipped.
+
+**/
+
+inline void sevtmerge::Reindex( sphoton* pp, int64_t num, int64_t offset ) // static
+{
+    for(int64_t i=0 ; i < num ; i++)
+    {
+        sphoton& p = pp[i] ;
+        if( p.flagmask == 0u ) continue ;
+        p.set_index( p.get_index() + offset );
+    }
+}
+
+inline std::string sevtmerge::desc() const
+{
+    std::stringstream ss ;
+    ss << "sevtmerge::desc"
+       << " num_worker " << num_worker.load()
+       << " num_push " << num_push.load()
+       << " num_merged " << num_merged
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,65 @@
+#pragma once
+/**
+sgsid.h : genstep provenance label, the G4 event, thread and track of a genstep
+==================================================================================
+
+Collected by SEvt::addGenstep into a vector parallel to the genstep vector.
+Unlike the sgs summary label this records where the genstep came from,
+allowing gensteps from many Geant4 events to be simulated in a single
+launch with the hits attributed back to their events afterwards,
+see seventsplit.h.
+
+The provenance stays on the host, hits are attributed via their photon
+index which identifies the genstep through the cumulative photon offsets.
+It also provides the key for the deterministic genstep order of sgsorder.h
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+#include <string>
+#include <sstream>
+#include <iomanip>
+#endif
+
+struct sgsid
+{
+    static constexpr const int NUM = 4 ;
+
+    int eventID ;   // G4Event::GetEventID or SEvt index when not known
+    int threadID ;  // G4Threading::G4GetThreadId, -1 when not known
+    int trackID ;   // G4Track::GetTrackID of the parent track
+    int stepID ;    // G4Track::GetCurrentStepNumber of the parent track, -1 when not known
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    static sgsid Make(int eventID, int threadID=-1, int trackID=-1, int stepID=-1);
+    std::string desc() const ;
+#endif
+};
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+inline sgsid sgsid::Make(int eventID, int threadID, int trackID, int stepID)
+{
+    sgsid id = {} ;
+    id.eventID = eventID ;
+    id.threadID = threadID ;
+    id.trackID = trackID ;
+    id.stepID = stepID ;
+    return id ;
+}
+
+inline std::string sgsid::desc() const
+{
+    std::stringstream ss ;
+    ss << "sgsid:"
+       << " evt " << std::setw(6) << eventID
+       << " thr " << std::setw(3) << threadID
+       << " trk " << std::setw(7) << trackID
+       << " stp " << std::setw(5) << stepID
+       ;
+    std::string s = ss.str();
+    return s ;
+}
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+/**
+sgsorder.h : deterministic ordering of gensteps collected from many threads
+=============================================================================
+
+With Geant4 MT the worker threads add gensteps to the shared SEvt in
+the order they win the genstep lock, so the genstep order, and with
+it the photon indices, RNG streams and hits of the GPU simulation,
+changes from run to run with the same seeds. SEvt::makeGenstepArrayFromVector
+uses this to reorder the gensteps first by the sgsid provenance label
+collected with each genstep, making the order independent of scheduling.
+
++--------+------------------------------------------------------------------+
+| mode   |  sort key, most significant first                                |
++========+==================================================================+
+| none   |  collection order                                                |
++--------+------------------------------------------------------------------+
+| event  |  eventID                                                         |
++--------+------------------------------------------------------------------+
+| full   |  eventID, trackID, stepID, gentype                               |
++--------+------------------------------------------------------------------+
+
+Ties keep the collection order as the sort is stable.
+
+"event" suffices when each event is tracked by a single thread, as
+the gensteps of one event are then collected in a deterministic order.
+It does nothing when all gensteps are from one event, so single threaded
+collection and the U4Recorder CPU comparison are unchanged.
+
+"full" is for events split across threads (eg sub-event parallelism),
+where the gensteps of one event interleave. Gensteps from the same
+step of the same process (eg the scintillation components) are always
+collected together by one thread, so ties remain deterministic.
+
+The threadID is not in the key : which thread tracks which event
+is itself down to scheduling.
+
+::
+
+    ~/o/sysrap/tests/sgsorder_test.sh
+
+**/
+
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include "sgs.h"
+#include "sgsid.h"
+#include "sradix.h"
+
+struct sgsorder
+{
+    enum { NONE, EVENT, FULL } ;
+    static constexpr const char* NONE_  = "none" ;
+    static constexpr const char* EVENT_ = "event" ;
+    static constexpr const char* FULL_  = "full" ;
+
+    static const std::vector<std::string>& Names();
+    static const char* Name(int mode);
+
+    static bool Make( std::vector<uint32_t>& order, const sgsid* id, const sgs* gs, size_t num, int mode );
+
+    template<typename T>
+    static void Permute( std::vector<T>& v, const std::vector<uint32_t>& order );
+    static void Relabel( std::vector<sgs>& gs );
+};
+
+inline const std::vector<std::string>& sgsorder::Names() // static
+{
+    static std::vector<std::string> names = { NONE_, EVENT_, FULL_ } ;
+    return names ;
+}
+
+inline const char* sgsorder::Name(int mode) // static
+{
+    const char* s = nullptr ;
+    switch(mode)
+    {
+        case NONE:  s = NONE_  ; break ;
+        case EVENT: s = EVENT_ ; break ;
+        case FULL:  s = FULL_  ; break ;
+    }
+    return s ;
+}
+
+/**
+sgsorder::Make
+----------------
+
+Sets *order* to the permutation of the gensteps, returns false
+when the gensteps are already in order.
+
+**/
+
+inline bool sgsorder::Make( std::vector<uint32_t>& order, const sgsid* id, const sgs* gs, size_t num, int mode ) // static
+{
+    sradix::Identity(order, num) ;
+    if( mode == NONE || num < 2 ) return false ;
+
+    if( mode == FULL )
+    {
+        sradix::StablePass(order, [&](uint32_t i){ return uint32_t(gs[i].gentype) ; } );
+        sradix::StablePass(order, [&](uint32_t i){ return sradix::Key(id[i].stepID) ; } );
+        sradix::StablePass(order, [&](uint32_t i){ return sradix::Key(id[i].trackID) ; } );
+    }
+    sradix::StablePass(order, [&](uint32_t i){ return sradix::Key(id[i].eventID) ; } );
+
+    return !sradix::IsIdentity(order) ;
+}
+
+template<typename T>
+inline void sgsorder::Permute( std::vector<T>& v, const std::vector<uint32_t>& order ) // static
+{
+    std::vector<T> tmp(order.size()) ;
+    for(size_t i=0 ; i < order.size() ; i++) tmp[i] = v[order[i]] ;
+    v.swap(tmp) ;
+}
+
+/**
+sgsorder::Relabel
+-------------------
+
+After permutation the sgs index and photon offset follow the new order.
+
+**/
+
+inline void sgsorder::Relabel( std::vector<sgs>& gs ) // static
+{
+    int64_t offset = 0 ;
+    for(size_t i=0 ; i < gs.size() ; i++)
+    {
+        gs[i].index = i ;
+        gs[i].offset = offset ;
+        offset += gs[i].photons ;
+    }
+}
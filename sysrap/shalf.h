@@ -0,0 +1,151 @@
+#pragma once
+/**
+shalf.h : host side IEEE 754 binary16 half float encoding of float arrays
+===========================================================================
+
+For preparing half precision textures, such as the QBnd boundary texture
+with QBnd__HALF, where the GPU texture unit promotes the texels to float
+on fetch. Conversions round to nearest even and handle subnormals, inf
+and nan like the CUDA __float2half_rn intrinsic so the host side decode
+matches what the texture unit returns.
+
+Half precision has an 11 bit significand (relative precision 2^-11 ~ 4.9e-4)
+and a maximum of 65504, so arrays with larger values (eg absorption
+lengths in mm) need scaling before encoding, see SBnd::MakeHalf.
+
+FromFloat and ToFloat are also usable on device, eg for the
+sphoton weight of OPTICKS_PROPAGATE_WEIGHT_THRESHOLD running.
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#    define SHALF_METHOD __host__ __device__ __forceinline__
+#else
+#    define SHALF_METHOD inline
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+#include "NP.hh"
+#endif
+
+struct shalf
+{
+    static constexpr const float MAX = 65504.f ;
+
+    SHALF_METHOD static uint16_t FromFloat(float f);
+    SHALF_METHOD static float    ToFloat(uint16_t h);
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    static NP* Encode(const NP* a);
+    static NP* Decode(const NP* h);
+#endif
+};
+
+SHALF_METHOD uint16_t shalf::FromFloat(float f) // static
+{
+    uint32_t x ;
+    memcpy(&x, &f, 4);
+
+    uint32_t sign = (x >> 16) & 0x8000u ;
+    uint32_t mant = x & 0x7fffffu ;
+    int      exp  = int((x >> 23) & 0xffu) ;
+
+    if( exp == 0xff ) return uint16_t(sign | 0x7c00u | ( mant ? 0x200u : 0u )) ;  // inf or nan
+
+    int e = exp - 127 + 15 ;
+    if( e >= 0x1f ) return uint16_t(sign | 0x7c00u) ;   // overflow to inf
+
+    if( e <= 0 )   // subnormal half or zero
+    {
+        if( e < -10 ) return uint16_t(sign) ;
+        mant |= 0x800000u ;
+        int shift = 14 - e ;
+        uint32_t h   = mant >> shift ;
+        uint32_t rem = mant & ((1u << shift) - 1u) ;
+        uint32_t mid = 1u << (shift - 1) ;
+        if( rem > mid || ( rem == mid && (h & 1u) )) h += 1u ;
+        return uint16_t(sign | h) ;
+    }
+
+    uint32_t h   = (uint32_t(e) << 10) | (mant >> 13) ;
+    uint32_t rem = mant & 0x1fffu ;
+    if( rem > 0x1000u || ( rem == 0x1000u && (h & 1u) )) h += 1u ;   // carry into exponent gives inf correctly
+    return uint16_t(sign | h) ;
+}
+
+SHALF_METHOD float shalf::ToFloat(uint16_t h) // static
+{
+    uint32_t sign = uint32_t(h & 0x8000u) << 16 ;
+    uint32_t exp  = (h >> 10) & 0x1fu ;
+    uint32_t mant = h & 0x3ffu ;
+    uint32_t x ;
+
+    if( exp == 0 )
+    {
+        if( mant == 0 )
+        {
+            x = sign ;
+        }
+        else    // normalize the subnormal
+        {
+            int e = 1 ;
+            while( (mant & 0x400u) == 0 ) { mant <<= 1 ; e -= 1 ; }
+            mant &= 0x3ffu ;
+            x = sign | (uint32_t(e + 112) << 23) | (mant << 13) ;
+        }
+    }
+    else if( exp == 0x1f )
+    {
+        x = sign | 0x7f800000u | (mant << 13) ;
+    }
+    else
+    {
+        x = sign | ((exp + 112) << 23) | (mant << 13) ;
+    }
+
+    float f ;
+    memcpy(&f, &x, 4);
+    return f ;
+}
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+
+/**
+shalf::Encode
+---------------
+
+float array to uint16 array of the same shape and metadata
+
+**/
+
+inline NP* shalf::Encode(const NP* a) // static
+{
+    assert( a && a->uifc == 'f' && a->ebyte == 4 );
+    NP* h = new NP( descr_<uint16_t>::dtype().c_str(), a->shape ) ;
+    const float* aa = a->cvalues<float>() ;
+    uint16_t* hh = h->values<uint16_t>() ;
+    NP::INT num = a->num_values() ;
+    for(NP::INT i=0 ; i < num ; i++) hh[i] = FromFloat(aa[i]) ;
+    h->meta = a->meta ;
+    return h ;
+}
+
+inline NP* shalf::Decode(const NP* h) // static
+{
+    assert( h && h->ebyte == 2 );
+    NP* a = new NP( descr_<float>::dtype().c_str(), h->shape ) ;
+    const uint16_t* hh = h->cvalues<uint16_t>() ;
+    float* aa = a->values<float>() ;
+    NP::INT num = h->num_values() ;
+    for(NP::INT i=0 ; i < num ; i++) aa[i] = ToFloat(hh[i]) ;
+    a->meta = h->meta ;
+    return a ;
+}
+
+#endif
@@ -0,0 +1,311 @@
+#pragma once
+/**
+shash.h : fast non-cryptographic streaming 64/128 bit hash
+=============================================================
+
+Header-only with no dependencies, for identity digests of geometry and
+arrays where MD5 (sdigest.h) is needlessly slow. Not for security.
+
+The 64 bit result is standard XXH64 (seed 0 by default), so it can be
+cross checked with python xxhash::
+
+    In [1]: import xxhash
+    In [2]: xxhash.xxh64(b"hello").hexdigest()
+
+The 128 bit result is the XXH64 value in the low half with the high half
+from an independent merge and avalanche of the same four accumulators
+and length. That is not XXH128, but gives 128 bit identity digests
+formatted as 32 hex chars, the same length as MD5 hexdigests.
+
+Usage::
+
+    shash h ;
+    h.add( "some string" );
+    h.add( buffer, length );
+    uint64_t d64 = h.digest64();        // non-destructive, can continue adding
+    std::string hex = h.hexdigest();     // 32 char hex of the 128 bit digest
+
+    std::string hex = shash::Buf(buffer, length) ;
+
+**/
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <array>
+
+struct shash
+{
+    static constexpr const uint64_t P1 = 0x9E3779B185EBCA87ULL ;
+    static constexpr const uint64_t P2 = 0xC2B2AE3D27D4EB4FULL ;
+    static constexpr const uint64_t P3 = 0x165667B19E3779F9ULL ;
+    static constexpr const uint64_t P4 = 0x85EBCA77C2B2AE63ULL ;
+    static constexpr const uint64_t P5 = 0x27D4EB2F165667C5ULL ;
+
+    uint64_t v[4] ;
+    uint64_t seed ;
+    uint64_t total ;
+    unsigned char buf[32] ;
+    unsigned nbuf ;
+
+    shash(uint64_t seed=0);
+    void reset(uint64_t seed=0);
+
+    void add( const char* buffer, size_t length );
+    void add( const std::string& str );
+    void add( const char* str );
+    void add( int i );
+    void add( uint64_t u );
+    void add( const std::vector<unsigned char>& bytes );
+    template<typename T> void add_( const T* vv, size_t count );
+
+    uint64_t digest64() const ;
+    std::array<uint64_t,2> digest128() const ;
+    std::array<unsigned char,16> digest_raw() const ;
+    std::string hexdigest() const ;
+
+    static uint64_t Rotl(uint64_t x, int r){ return (x << r) | (x >> (64 - r)) ; }
+    static uint64_t Read64(const unsigned char* p){ uint64_t x ; memcpy(&x, p, 8) ; return x ; }
+    static uint32_t Read32(const unsigned char* p){ uint32_t x ; memcpy(&x, p, 4) ; return x ; }
+    static uint64_t Round(uint64_t acc, uint64_t input);
+    static uint64_t MergeRound(uint64_t acc, uint64_t val);
+    static uint64_t Avalanche(uint64_t h);
+    static uint64_t Avalanche2(uint64_t h);
+
+    static std::string Hex(const std::array<uint64_t,2>& d);
+    static std::string Hex64(uint64_t d);
+
+    static uint64_t Buf64(const char* buffer, size_t length, uint64_t seed=0);
+    static std::string Buf(const char* buffer, size_t length);
+
+private:
+    void consume(const unsigned char* p);
+};
+
+inline shash::shash(uint64_t seed_)
+{
+    reset(seed_);
+}
+
+inline void shash::reset(uint64_t seed_)
+{
+    seed = seed_ ;
+    v[0] = seed + P1 + P2 ;
+    v[1] = seed + P2 ;
+    v[2] = seed ;
+    v[3] = seed - P1 ;
+    total = 0 ;
+    nbuf = 0 ;
+}
+
+inline uint64_t shash::Round(uint64_t acc, uint64_t input)
+{
+    acc += input * P2 ;
+    acc  = Rotl(acc, 31) ;
+    acc *= P1 ;
+    return acc ;
+}
+
+inline uint64_t shash::MergeRound(uint64_t acc, uint64_t val)
+{
+    val  = Round(0, val) ;
+    acc ^= val ;
+    acc  = acc * P1 + P4 ;
+    return acc ;
+}
+
+inline uint64_t shash::Avalanche(uint64_t h)
+{
+    h ^= h >> 33 ;
+    h *= P2 ;
+    h ^= h >> 29 ;
+    h *= P3 ;
+    h ^= h >> 32 ;
+    return h ;
+}
+
+/**
+shash::Avalanche2
+-------------------
+
+murmur3 fmix64 finalizer, used for the high half of the 128 bit digest
+
+**/
+
+inline uint64_t shash::Avalanche2(uint64_t h)
+{
+    h ^= h >> 33 ;
+    h *= 0xff51afd7ed558ccdULL ;
+    h ^= h >> 33 ;
+    h *= 0xc4ceb9fe1a85ec53ULL ;
+    h ^= h >> 33 ;
+    return h ;
+}
+
+inline void shash::consume(const unsigned char* p)
+{
+    v[0] = Round(v[0], Read64(p)) ;
+    v[1] = Round(v[1], Read64(p+8)) ;
+    v[2] = Round(v[2], Read64(p+16)) ;
+    v[3] = Round(v[3], Read64(p+24)) ;
+}
+
+inline void shash::add( const char* buffer, size_t length )
+{
+    const unsigned char* p = (const unsigned char*)buffer ;
+    const unsigned char* const end = p + length ;
+    total += length ;
+
+    if( nbuf + length < 32 )
+    {
+        memcpy(buf + nbuf, p, length);
+        nbuf += length ;
+        return ;
+    }
+    if( nbuf > 0 )
+    {
+        unsigned fill = 32 - nbuf ;
+        memcpy(buf + nbuf, p, fill);
+        consume(buf);
+        p += fill ;
+        nbuf = 0 ;
+    }
+    while( p + 32 <= end )
+    {
+        consume(p);
+        p += 32 ;
+    }
+    if( p < end )
+    {
+        nbuf = end - p ;
+        memcpy(buf, p, nbuf);
+    }
+}
+
+inline void shash::add( const std::string& str ){ add(str.c_str(), str.size()) ; }
+inline void shash::add( const char* str ){ add(str, strlen(str)) ; }
+inline void shash::add( int i ){ add((const char*)&i, sizeof(int)) ; }
+inline void shash::add( uint64_t u ){ add((const char*)&u, sizeof(uint64_t)) ; }
+inline void shash::add( const std::vector<unsigned char>& bytes ){ add((const char*)bytes.data(), bytes.size()) ; }
+
+template<typename T>
+inline void shash::add_( const T* vv, size_t count ){ add((const char*)vv, sizeof(T)*count) ; }
+
+/**
+shash::digest64
+-----------------
+
+XXH64 finalization, does not change the state.
+
+**/
+
+inline uint64_t shash::digest64() const
+{
+    uint64_t h ;
+    if( total >= 32 )
+    {
+        h = Rotl(v[0], 1) + Rotl(v[1], 7) + Rotl(v[2], 12) + Rotl(v[3], 18) ;
+        h = MergeRound(h, v[0]) ;
+        h = MergeRound(h, v[1]) ;
+        h = MergeRound(h, v[2]) ;
+        h = MergeRound(h, v[3]) ;
+    }
+    else
+    {
+        h = seed + P5 ;
+    }
+    h += total ;
+
+    const unsigned char* p = buf ;
+    const unsigned char* const end = buf + nbuf ;
+    while( p + 8 <= end )
+    {
+        h ^= Round(0, Read64(p)) ;
+        h  = Rotl(h, 27) * P1 + P4 ;
+        p += 8 ;
+    }
+    if( p + 4 <= end )
+    {
+        h ^= uint64_t(Read32(p)) * P1 ;
+        h  = Rotl(h, 23) * P2 + P3 ;
+        p += 4 ;
+    }
+    while( p < end )
+    {
+        h ^= (*p) * P5 ;
+        h  = Rotl(h, 11) * P1 ;
+        p++ ;
+    }
+    return Avalanche(h) ;
+}
+
+/**
+shash::digest128
+------------------
+
+Element 0 is the XXH64 digest, element 1 an independent mix of the
+accumulators, tail bytes and length.
+
+**/
+
+inline std::array<uint64_t,2> shash::digest128() const
+{
+    uint64_t lo = digest64();
+
+    uint64_t h = total >= 32 ? Rotl(v[0], 3) ^ Rotl(v[1], 17) ^ Rotl(v[2], 29) ^ Rotl(v[3], 41) : seed + P3 ;
+    h = Avalanche2( h + total * P4 ) ;
+    for(unsigned i=0 ; i < nbuf ; i++) h = Rotl( h ^ (buf[i] * P1), 13 ) * P2 ;
+    uint64_t hi = Avalanche2( h ^ lo ) ;
+
+    return { lo, hi } ;
+}
+
+inline std::array<unsigned char,16> shash::digest_raw() const
+{
+    std::array<uint64_t,2> d = digest128();
+    std::array<unsigned char,16> raw ;
+    for(int i=0 ; i < 8 ; i++) raw[i]   = (d[1] >> (8*(7-i))) & 0xff ;
+    for(int i=0 ; i < 8 ; i++) raw[8+i] = (d[0] >> (8*(7-i))) & 0xff ;
+    return raw ;
+}
+
+inline std::string shash::hexdigest() const
+{
+    return Hex(digest128()) ;
+}
+
+/**
+shash::Hex
+------------
+
+32 hex chars, high half first
+
+**/
+
+inline std::string shash::Hex(const std::array<uint64_t,2>& d)
+{
+    return Hex64(d[1]) + Hex64(d[0]) ;
+}
+
+inline std::string shash::Hex64(uint64_t d)
+{
+    char buf[16+1] ;
+    snprintf(buf, 16+1, "%016llx", (unsigned long long)d );
+    return std::string(buf, buf + 16) ;
+}
+
+inline uint64_t shash::Buf64(const char* buffer, size_t length, uint64_t seed) // static
+{
+    shash h(seed) ;
+    h.add(buffer, length);
+    return h.digest64() ;
+}
+
+inline std::string shash::Buf(const char* buffer, size_t length) // static
+{
+    shash h ;
+    h.add(buffer, length);
+    return h.hexdigest() ;
+}
+
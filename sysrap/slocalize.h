@@ -0,0 +1,249 @@
+#pragma once
+/**
+slocalize.h : bulk localization of hit/photon arrays with cached instance affines
+===================================================================================
+
+SEvt::getLocalHit localizes one hit at a time : copying the sphoton,
+looking up stree::get_iinst, widening into glm vec4 for three double
+precision 4x4 matrix multiplies with normalization and decoding the
+strid identity column, which for millions of PMT hits costs more
+than downloading them.
+
+This instead prepares once from the stree::iinst inverse instance transforms::
+
+    aff[iindex]   row major 3x4 affine, double and float
+    ht[iindex]    sphit decoded from the strid identity column
+
+and localizes whole arrays with::
+
+    sphoton* local, sphit* ht = ... ;
+    loc.localize( local, ht, global, num );
+
+The arrays are sharded across threads with sthread::ParallelFor. Within
+each shard the affine is looked up only at transitions of iindex, so the
+runs of same instance hits from GPU hit merging (sorted by pmtid)
+reuse the affine already in registers. The inner loop is plain
+straight line arithmetic on the 12 affine elements that the compiler
+can vectorize, with no glm temporaries.
+
+With precision double the arithmetic follows the glm order of
+sphoton::transform exactly, so results are identical to
+stree::localize_photon_inplace. Precision float is faster but can
+differ by float rounding.
+
+The consistency check that the instance identity decoded from the transform
+matches the hit iindex and pmtid is optional. When enabled, mismatches are
+counted rather than asserted, so the caller decides what to do.
+Hits with iindex beyond the instances are left in the global frame with zeroed sphit
+and are counted as bad.
+
+::
+
+    ~/o/sysrap/tests/slocalize_test.sh
+
+**/
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <atomic>
+
+#include "scuda.h"
+#include "squad.h"
+#include "sphoton.h"
+#include "sphit.h"
+#include "strid.h"
+#include "sthread.h"
+#include "NP.hh"
+
+struct slocalize
+{
+    enum { DOUBLE, FLOAT } ;
+
+    int                   precision ;
+    std::vector<double>   affd ;   // 12 per instance
+    std::vector<float>    afff ;   // 12 per instance
+    std::vector<sphit>    iht ;    // per instance
+
+    slocalize( const std::vector<glm::tmat4x4<double>>& iinst, int precision=DOUBLE );
+
+    size_t num_inst() const ;
+
+    template<typename T> static void Apply( const T* m, sphoton& p );
+
+    size_t localize( sphoton* local, sphit* ht, const sphoton* global, size_t num, bool consistency_check=false, int num_thread=0 ) const ;
+    NP*    localize( const NP* photon, std::vector<sphit>* ht=nullptr, bool consistency_check=false, size_t* num_bad=nullptr, int num_thread=0 ) const ;
+
+    std::string desc() const ;
+};
+
+
+/**
+slocalize::slocalize
+---------------------
+
+The glm matrix is column major with tr[c][r], the strid identity is
+encoded in r=3 of each column which is not used by the xyz rows.
+
+**/
+
+inline slocalize::slocalize( const std::vector<glm::tmat4x4<double>>& iinst, int precision_ )
+    :
+    precision(precision_)
+{
+    size_t ni = iinst.size() ;
+    affd.resize(12*ni) ;
+    afff.resize(12*ni) ;
+    iht.resize(ni) ;
+
+    for(size_t i=0 ; i < ni ; i++)
+    {
+        const glm::tmat4x4<double>& tr = iinst[i] ;
+        for(int r=0 ; r < 3 ; r++)
+        for(int c=0 ; c < 4 ; c++)
+        {
+            affd[12*i+4*r+c] = tr[c][r] ;
+            afff[12*i+4*r+c] = float(tr[c][r]) ;
+        }
+
+        glm::tvec4<int64_t> col3 = {} ;
+        strid::Decode( tr, col3 );
+
+        sphit& h = iht[i] ;
+        h.iindex            = col3[0] ;
+        h.sensor_identifier = col3[2] ;
+        h.sensor_index      = col3[3] ;
+    }
+}
+
+inline size_t slocalize::num_inst() const
+{
+    return iht.size() ;
+}
+
+/**
+slocalize::Apply
+------------------
+
+Position with w=1, mom and pol as directions (w=0) normalized. The order of
+the sums (c0 + c1) + (c2 + c3) is that of glm mat4*vec4, and the
+normalization v*(1/sqrt((xx+yy)+zz)) is that of glm::normalize.
+
+**/
+
+template<typename T>
+inline void slocalize::Apply( const T* m, sphoton& p ) // static
+{
+    T x = p.pos.x, y = p.pos.y, z = p.pos.z ;
+    p.pos.x = float( ( m[0]*x + m[1]*y ) + ( m[2]*z  + m[3] ) );
+    p.pos.y = float( ( m[4]*x + m[5]*y ) + ( m[6]*z  + m[7] ) );
+    p.pos.z = float( ( m[8]*x + m[9]*y ) + ( m[10]*z + m[11] ) );
+
+    float3* dd[2] = { &p.mom, &p.pol } ;
+    for(int k=0 ; k < 2 ; k++)
+    {
+        float3& d = *dd[k] ;
+        T a = d.x, b = d.y, c = d.z ;
+        T u = ( m[0]*a + m[1]*b ) + ( m[2]*c  + m[3]*T(0) ) ;
+        T v = ( m[4]*a + m[5]*b ) + ( m[6]*c  + m[7]*T(0) ) ;
+        T w = ( m[8]*a + m[9]*b ) + ( m[10]*c + m[11]*T(0) ) ;
+        T s = T(1)/std::sqrt( ( u*u + v*v ) + w*w ) ;
+        d.x = float(u*s) ;
+        d.y = float(v*s) ;
+        d.z = float(w*s) ;
+    }
+}
+
+/**
+slocalize::localize
+---------------------
+
+*local* may be the same array as *global* for inplace localization,
+*ht* may be nullptr. Returns the number of bad hits : unknown iindex
+or with consistency_check a mismatch of the decoded identity.
+
+**/
+
+inline size_t slocalize::localize( sphoton* local, sphit* ht, const sphoton* global, size_t num, bool consistency_check, int num_thread ) const
+{
+    std::atomic<size_t> num_bad(0) ;
+    unsigned ni = unsigned(num_inst()) ;
+
+    sthread::ParallelFor( int64_t(num), [&](int, int64_t i0, int64_t i1)
+    {
+        size_t bad = 0 ;
+        unsigned prev = ~0u ;
+        const double* md = nullptr ;
+        const float*  mf = nullptr ;
+        const sphit*  h  = nullptr ;
+
+        for(int64_t i=i0 ; i < i1 ; i++)
+        {
+            sphoton& l = local[i] ;
+            if( local != global ) l = global[i] ;
+
+            unsigned ii = l.iindex() ;
+            if( ii != prev )
+            {
+                prev = ii ;
+                bool valid = ii < ni ;
+                md = valid ? affd.data() + 12*ii : nullptr ;
+                mf = valid ? afff.data() + 12*ii : nullptr ;
+                h  = valid ? iht.data() + ii : nullptr ;
+            }
+
+            if( h == nullptr )
+            {
+                if(ht) ht[i].zero() ;
+                bad += 1 ;
+                continue ;
+            }
+
+            if( precision == FLOAT ) Apply<float>( mf, l );
+            else                     Apply<double>( md, l );
+
+            if(ht) ht[i] = *h ;
+            if( consistency_check && ( h->iindex != ii || h->sensor_identifier != l.pmtid() )) bad += 1 ;
+        }
+        num_bad += bad ;
+    }, 1 << 14, num_thread );
+
+    return num_bad ;
+}
+
+/**
+slocalize::localize
+---------------------
+
+Returns a localized copy of a (-1,4,4) float photon or hit array.
+
+**/
+
+inline NP* slocalize::localize( const NP* photon, std::vector<sphit>* ht, bool consistency_check, size_t* num_bad, int num_thread ) const
+{
+    if(!photon) return nullptr ;
+    assert( photon->has_shape( -1, 4, 4 ) && photon->ebyte == 4 );
+    size_t num = photon->shape[0] ;
+
+    NP* local_photon = photon->copy() ;   // keeping metadata
+    sphoton* ll = (sphoton*)local_photon->bytes() ;
+
+    if(ht) ht->resize(num) ;
+    size_t bad = localize( ll, ht ? ht->data() : nullptr, ll, num, consistency_check, num_thread );
+    if(num_bad) *num_bad = bad ;
+    return local_photon ;
+}
+
+inline std::string slocalize::desc() const
+{
+    std::stringstream ss ;
+    ss << "slocalize::desc"
+       << " num_inst " << num_inst()
+       << " precision " << ( precision == FLOAT ? "FLOAT" : "DOUBLE" )
+       << " sthread " << sthread::Desc()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
@@ -0,0 +1,247 @@
+#pragma once
+/**
+sphilox.h : portable Philox4x32-10 counter based RNG matching curandStatePhilox4_32_10
+========================================================================================
+
+Host and device implementation of the curand Philox4_32_10 generator that
+reproduces the curand sequences bit for bit, including the buffering of the
+four 32 bit outputs of each counter value (STATE) and the curand_init
+subsequence and offset conventions::
+
+    curand_init(seed, subsequence, offset, &s)   ctr = (0,0,0,0) key = seed
+    skipahead_sequence(n, &s)                    ctr.zw += n
+    skipahead(n, &s)                             advance by n 32 bit draws, ctr.xy += n/4
+
+This allows MOCK_CURAND/MOCK_CUDA and other CPU backends to use the same
+randoms as a GPU build with RNG_PHILOX for the same seed, offset, event and
+photon index, see qrng<sphilox> in qudarap/qrng.h.
+
+Unlike XORWOW the initialization is stateless and cheap, so no curandState
+chunk files or uploaded states are needed.
+
+The round function and constants follow curand_philox4x32_x.h and the
+Random123 paper (Salmon et al, SC11). The mulhi is done with a 64 bit
+multiply which compiles to mul.hi on device.
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+   #define SPHILOX_METHOD __host__ __device__ __forceinline__
+#else
+   #define SPHILOX_METHOD inline
+   #include <string>
+   #include <sstream>
+   #include <iomanip>
+#endif
+
+struct sphilox
+{
+    static constexpr const unsigned M0 = 0xD2511F53u ;
+    static constexpr const unsigned M1 = 0xCD9E8D57u ;
+    static constexpr const unsigned W0 = 0x9E3779B9u ;
+    static constexpr const unsigned W1 = 0xBB67AE85u ;
+
+    unsigned ctr[4] ;
+    unsigned output[4] ;
+    unsigned key[2] ;
+    unsigned STATE ;     // 0..3 index of next output
+
+    SPHILOX_METHOD static void Round( unsigned c[4], const unsigned k[2] );
+    SPHILOX_METHOD static void Philox4x32_10( unsigned out[4], const unsigned c[4], const unsigned k[2] );
+
+    SPHILOX_METHOD void init( unsigned long long seed, unsigned long long subsequence, unsigned long long offset );
+    SPHILOX_METHOD void incr();
+    SPHILOX_METHOD void incr( unsigned long long n );
+    SPHILOX_METHOD void incr_hi( unsigned long long n );
+    SPHILOX_METHOD void skipahead( unsigned long long n );
+    SPHILOX_METHOD void skipahead_sequence( unsigned long long n );
+    SPHILOX_METHOD unsigned next();
+    SPHILOX_METHOD void     next4( unsigned r[4] );
+    SPHILOX_METHOD float    uniform();
+    SPHILOX_METHOD double   uniform_double();
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    std::string desc() const ;
+#endif
+};
+
+SPHILOX_METHOD void sphilox::Round( unsigned c[4], const unsigned k[2] ) // static
+{
+    unsigned long long p0 = (unsigned long long)M0 * c[0] ;
+    unsigned long long p1 = (unsigned long long)M1 * c[2] ;
+    unsigned hi0 = unsigned(p0 >> 32) ;
+    unsigned lo0 = unsigned(p0) ;
+    unsigned hi1 = unsigned(p1 >> 32) ;
+    unsigned lo1 = unsigned(p1) ;
+
+    unsigned r0 = hi1 ^ c[1] ^ k[0] ;
+    unsigned r2 = hi0 ^ c[3] ^ k[1] ;
+    c[0] = r0 ;
+    c[1] = lo1 ;
+    c[2] = r2 ;
+    c[3] = lo0 ;
+}
+
+SPHILOX_METHOD void sphilox::Philox4x32_10( unsigned out[4], const unsigned c[4], const unsigned k[2] ) // static
+{
+    unsigned kk[2] = { k[0], k[1] } ;
+    for(int i=0 ; i < 4 ; i++) out[i] = c[i] ;
+    for(int r=0 ; r < 10 ; r++)
+    {
+        Round( out, kk );
+        kk[0] += W0 ;
+        kk[1] += W1 ;
+    }
+}
+
+SPHILOX_METHOD void sphilox::init( unsigned long long seed, unsigned long long subsequence, unsigned long long offset )
+{
+    for(int i=0 ; i < 4 ; i++) ctr[i] = 0u ;
+    key[0] = unsigned(seed) ;
+    key[1] = unsigned(seed >> 32) ;
+    STATE = 0u ;
+    skipahead_sequence( subsequence );
+    skipahead( offset );
+}
+
+SPHILOX_METHOD void sphilox::incr()
+{
+    if(++ctr[0]) return ;
+    if(++ctr[1]) return ;
+    if(++ctr[2]) return ;
+    ++ctr[3] ;
+}
+
+SPHILOX_METHOD void sphilox::incr( unsigned long long n )
+{
+    unsigned nlo = unsigned(n) ;
+    unsigned nhi = unsigned(n >> 32) ;
+
+    ctr[0] += nlo ;
+    if( ctr[0] < nlo ) nhi++ ;
+
+    ctr[1] += nhi ;
+    if( nhi <= ctr[1] ) return ;
+    if(++ctr[2]) return ;
+    ++ctr[3] ;
+}
+
+SPHILOX_METHOD void sphilox::incr_hi( unsigned long long n )
+{
+    unsigned nlo = unsigned(n) ;
+    unsigned nhi = unsigned(n >> 32) ;
+
+    ctr[2] += nlo ;
+    if( ctr[2] < nlo ) nhi++ ;
+
+    ctr[3] += nhi ;
+}
+
+SPHILOX_METHOD void sphilox::skipahead( unsigned long long n )
+{
+    STATE += unsigned(n & 3ull) ;
+    n /= 4 ;
+    if( STATE > 3u )
+    {
+        n += 1 ;
+        STATE -= 4u ;
+    }
+    incr(n);
+    Philox4x32_10( output, ctr, key );
+}
+
+SPHILOX_METHOD void sphilox::skipahead_sequence( unsigned long long n )
+{
+    incr_hi(n);
+    Philox4x32_10( output, ctr, key );
+}
+
+SPHILOX_METHOD unsigned sphilox::next()
+{
+    unsigned ret = output[STATE] ;
+    STATE += 1u ;
+    if( STATE == 4u )
+    {
+        incr();
+        Philox4x32_10( output, ctr, key );
+        STATE = 0u ;
+    }
+    return ret ;
+}
+
+/**
+sphilox::next4
+----------------
+
+As curand4 : the four outputs following the current position,
+always advancing the counter by one.
+
+**/
+
+SPHILOX_METHOD void sphilox::next4( unsigned r[4] )
+{
+    unsigned tmp[4] = { output[0], output[1], output[2], output[3] } ;
+    incr();
+    Philox4x32_10( output, ctr, key );
+    for(unsigned i=0 ; i < 4 ; i++) r[i] = STATE + i < 4u ? tmp[STATE+i] : output[STATE+i-4u] ;
+}
+
+/**
+sphilox::uniform
+-----------------
+
+As _curand_uniform : (0,1] with the 2^-32 scale exact, so the result does not
+depend on FMA contraction.
+
+**/
+
+SPHILOX_METHOD float sphilox::uniform()
+{
+    return float(next()) * 2.3283064e-10f + (2.3283064e-10f/2.0f) ;
+}
+
+/**
+sphilox::uniform_double
+------------------------
+
+As curand_uniform_double for Philox, _curand_uniform_double_hq of the first two
+of the four outputs of curand4, so each double consumes a whole counter value.
+
+**/
+
+SPHILOX_METHOD double sphilox::uniform_double()
+{
+    unsigned r[4] ;
+    next4(r);
+    unsigned x = r[0] ;
+    unsigned y = r[1] ;
+    unsigned long long z = (unsigned long long)x ^ ((unsigned long long)y << (53 - 32)) ;
+    return double(z) * 1.1102230246251565e-16 + (1.1102230246251565e-16/2.0) ;
+}
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+inline std::string sphilox::desc() const
+{
+    std::stringstream ss ;
+    ss << "sphilox"
+       << " ctr " << std::hex << std::setw(8) << ctr[0] << " " << ctr[1] << " " << ctr[2] << " " << ctr[3]
+       << " key " << key[0] << " " << key[1]
+       << std::dec
+       << " STATE " << STATE
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+#endif
+
+
+// curand API overloads, allowing sphilox as the RNG type of templated code
+
+SPHILOX_METHOD void curand_init( unsigned long long seed, unsigned long long subsequence, unsigned long long offset, sphilox* s ){ s->init(seed, subsequence, offset) ; }
+SPHILOX_METHOD void skipahead( unsigned long long n, sphilox* s ){ s->skipahead(n) ; }
+SPHILOX_METHOD void skipahead_sequence( unsigned long long n, sphilox* s ){ s->skipahead_sequence(n) ; }
+SPHILOX_METHOD unsigned curand( sphilox* s ){ return s->next() ; }
+SPHILOX_METHOD float  curand_uniform( sphilox* s ){ return s->uniform() ; }
+SPHILOX_METHOD double curand_uniform_double( sphilox* s ){ return s->uniform_double() ; }
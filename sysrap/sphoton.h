@@ -44,6 +44,11 @@ iindex
 hitcount (16 bit)
     WIP:use for thrust based hit merging, unclear where best to set it
 
+    With OPTICKS_PROPAGATE_WEIGHT_THRESHOLD greater than zero (weighted running,
+    see qsim::propagate_to_boundary_weighted) these 16 bits instead hold
+    the photon weight as an IEEE half float, accessed with weight/set_weight,
+    and SPM merging sums the weights, accumulating in float.
+
 boundary (16 bit)
     boundary index of intersected geometry
     index corresponds to unique combinations of four material and surface indices
@@ -145,6 +150,7 @@ See ana/p.py for python accessors such as::
 #    define SPHOTON_METHOD inline
 #endif
 #include <cstdint>
+#include "shalf.h"
 
 #if defined(__CUDACC__) || defined(__CUDABE__)
 #else
@@ -201,6 +207,9 @@ struct sphoton
     SPHOTON_METHOD unsigned iindex()   const {                 return ( hitcount_iindex & 0x0000ffffu ) >> 0  ; }
     SPHOTON_METHOD unsigned hitcount() const {                 return ( hitcount_iindex & 0xffff0000u ) >> 16 ; }
 
+    SPHOTON_METHOD void  set_weight( float w ){ hitcount_iindex = ( hitcount_iindex & 0x0000ffffu ) | ( unsigned(shalf::FromFloat(w)) << 16 ); }
+    SPHOTON_METHOD float weight() const {       return shalf::ToFloat( uint16_t( hitcount_iindex >> 16 )) ; }
+
     SPHOTON_METHOD unsigned flag() const {     return (orient_boundary_flag & 0x0000ffffu) >>  0 ; } // flag___     = lambda p:(p.view(np.uint32)[...,3,0] & 0xffff)
     SPHOTON_METHOD unsigned boundary() const { return (orient_boundary_flag & 0x7fff0000u) >> 16 ; } // boundary___ = lambda p:(p.view(np.uint32)[...,3,0] & 0x7fff0000) >> 16
     SPHOTON_METHOD float    orient() const {   return (orient_boundary_flag & 0x80000000u) ? -1.f : 1.f ; }
@@ -287,12 +296,14 @@ struct sphoton
 
     struct reduce_op
     {
+        bool weighted = false ;   // sum half float weights instead of hitcounts, SPM accumulates these in float
         SPHOTON_METHOD sphoton operator()(const sphoton& a, const sphoton& b) const
         {
             bool a_first = fminf(a.time, b.time) == a.time ;
             sphoton r   = a_first ? a : b ;
             r.flagmask  = a.flagmask | b.flagmask ;     // combined flagmask OR first flagmask ?
-            r.set_hitcount( a.hitcount() + b.hitcount() );
+            if(weighted) r.set_weight( a.weight() + b.weight() );
+            else         r.set_hitcount( a.hitcount() + b.hitcount() );
             return r;
         }
     };
@@ -12,6 +12,8 @@ sphotonlite.hh
 |    | off:0, 2              | off:4          | off:8,10              | off:12         |  off:byte offsets            |
 +----+-----------------------+----------------+-----------------------+----------------+------------------------------+
 
+With weighted running (OPTICKS_PROPAGATE_WEIGHT_THRESHOLD) the hitcount 16 bits
+hold the half float weight, as for sphoton.
 
 **/
 
@@ -24,6 +26,7 @@ sphotonlite.hh
 
 
 #include <cstdint>
+#include "shalf.h"
 #if defined(__CUDACC__) || defined(__CUDABE__)
 #else
    #include <iostream>
@@ -59,6 +62,9 @@ struct sphotonlite
 
     SPHOTONLITE_METHOD unsigned hitcount() const { return hitcount_identity >> 16 ; }
     SPHOTONLITE_METHOD unsigned identity() const { return hitcount_identity & 0xffffu ; }
+
+    SPHOTONLITE_METHOD void  set_weight( float w ){ hitcount_identity = ( hitcount_identity & 0x0000ffffu ) | ( unsigned(shalf::FromFloat(w)) << 16 ); }
+    SPHOTONLITE_METHOD float weight() const {       return shalf::ToFloat( uint16_t( hitcount_identity >> 16 )) ; }
     SPHOTONLITE_METHOD unsigned pmtid() const
     {
         unsigned id = identity() ;
@@ -78,13 +84,21 @@ struct sphotonlite
 
     struct reduce_op
     {
+        bool weighted = false ;   // sum half float weights instead of hitcounts, SPM accumulates these in float
         SPHOTONLITE_METHOD sphotonlite operator()(const sphotonlite& a, const sphotonlite& b) const
         {
             sphotonlite r = a;
             r.time = fminf(a.time, b.time);
             r.flagmask |= b.flagmask;
-            unsigned hc = a.hitcount() + b.hitcount();
-            r.set_hitcount_identity(hc, a.identity());
+            if(weighted)
+            {
+                r.set_weight( a.weight() + b.weight() );
+            }
+            else
+            {
+                unsigned hc = a.hitcount() + b.hitcount();
+                r.set_hitcount_identity(hc, a.identity());
+            }
             return r;
         }
     };
@@ -0,0 +1,97 @@
+#pragma once
+/**
+sradix.h : stable LSD radix sort of an index permutation by 32 bit keys
+=========================================================================
+
+Sorts a permutation rather than the items themselves, so several
+parallel vectors can then be permuted consistently. Multi column
+ordering is done by calling StablePass from the least to the most
+significant column, each pass being stable::
+
+    std::vector<uint32_t> order ;
+    sradix::Identity(order, num) ;
+    sradix::StablePass(order, [&](uint32_t i){ return minor[i] ; });
+    sradix::StablePass(order, [&](uint32_t i){ return sradix::Key(major[i]) ; });
+
+Each column is four counting sort passes of 8 bits, passes where all
+keys share the byte (eg the high bytes of small eventID) are skipped.
+
+**/
+
+#include <cstdint>
+#include <vector>
+#include <array>
+
+struct sradix
+{
+    static uint32_t Key(int v) ;    // signed int to unsigned key with the same order
+    static void     Identity(std::vector<uint32_t>& order, size_t num);
+    static bool     IsIdentity(const std::vector<uint32_t>& order);
+
+    template<typename F>
+    static int StablePass(std::vector<uint32_t>& order, F&& key );
+};
+
+inline uint32_t sradix::Key(int v) // static
+{
+    return uint32_t(v) ^ 0x80000000u ;
+}
+
+inline void sradix::Identity(std::vector<uint32_t>& order, size_t num) // static
+{
+    order.resize(num) ;
+    for(size_t i=0 ; i < num ; i++) order[i] = uint32_t(i) ;
+}
+
+inline bool sradix::IsIdentity(const std::vector<uint32_t>& order) // static
+{
+    for(size_t i=0 ; i < order.size() ; i++) if( order[i] != uint32_t(i) ) return false ;
+    return true ;
+}
+
+/**
+sradix::StablePass
+--------------------
+
+Stable sort of *order* by key(order[i]), returns the number of byte passes done.
+
+**/
+
+template<typename F>
+inline int sradix::StablePass(std::vector<uint32_t>& order, F&& key ) // static
+{
+    size_t num = order.size() ;
+    if( num < 2 ) return 0 ;
+
+    std::vector<uint32_t> kk(num) ;
+    for(size_t i=0 ; i < num ; i++) kk[i] = key(order[i]) ;
+
+    std::vector<uint32_t> tmp_order(num) ;
+    std::vector<uint32_t> tmp_kk(num) ;
+
+    int num_pass = 0 ;
+    for(unsigned shift=0 ; shift < 32 ; shift += 8)
+    {
+        std::array<size_t,256> count = {} ;
+        for(size_t i=0 ; i < num ; i++) count[(kk[i] >> shift) & 0xff] += 1 ;
+        if( count[(kk[0] >> shift) & 0xff] == num ) continue ;
+
+        size_t sum = 0 ;
+        for(size_t b=0 ; b < 256 ; b++)
+        {
+            size_t c = count[b] ;
+            count[b] = sum ;
+            sum += c ;
+        }
+        for(size_t i=0 ; i < num ; i++)
+        {
+            size_t j = count[(kk[i] >> shift) & 0xff]++ ;
+            tmp_order[j] = order[i] ;
+            tmp_kk[j] = kk[i] ;
+        }
+        order.swap(tmp_order) ;
+        kk.swap(tmp_kk) ;
+        num_pass += 1 ;
+    }
+    return num_pass ;
+}
@@ -0,0 +1,251 @@
+#pragma once
+/**
+sresample.h : batch resampling of property tables onto a domain
+===================================================================
+
+U4Material::MakeStandardArray formerly resampled each material property
+onto the standard domain one value at a time : for every domain point
+and every property a G4MaterialPropertiesTable::GetProperty string
+lookup and a virtual G4PhysicsVector::Value with its own bin search.
+
+This instead extracts all properties once into one contiguous table of
+(x,y) pairs, grouped by material::
+
+    sresample rs(dom, nk) ;
+    for each material
+    {
+        rs.add_group(name) ;
+        for each property
+        {
+            double* xy = rs.add(num, def) ;  // fill 2*num (x,y), or num 0 for the default
+        }
+    }
+    rs.resample(out) ;     // out[p*nk+k] for all properties p
+
+The resampling of each property is a single sweep along the monotonic
+domain with the bin only advancing. The interpolation follows G4PhysicsVector::Value
+without spline : clamped to the first/last value outside the x range
+and linear within with the bin from lower_bound, x[i] < e <= x[i+1].
+
+The sweep of all properties of a typical geometry takes milliseconds,
+so by default it is done serially : a digest keyed cache of resampled
+materials and threading over properties both cost more than they saved
+with the materials of real geometries.
+
+::
+
+    ~/o/sysrap/tests/sresample_test.sh
+
+**/
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <sstream>
+
+#include "sthread.h"
+
+struct sresample
+{
+    struct Prop
+    {
+        int64_t offset ;   // into xy in units of (x,y) pairs
+        int64_t num ;      // 0 : use def
+        double  def ;
+    };
+
+    struct Group
+    {
+        std::string name ;
+        int p0 ;           // props [p0,p1)
+        int p1 ;
+    };
+
+    const double*        dom ;
+    int                  nk ;
+    std::vector<double>  xy ;
+    std::vector<Prop>    prop ;
+    std::vector<Group>   group ;
+
+    sresample( const double* dom, int nk );
+
+    void    add_group( const char* name=nullptr );
+    double* add( int64_t num, double def );
+    int     num_prop() const ;
+
+    static double Value( const double* xy, int64_t num, double def, double e );
+    static void   Resample( double* out, int64_t out_stride, const double* xy, int64_t num, double def, const double* dom, int nk );
+
+    void resample( double* out, int num_thread=1 ) const ;
+
+    std::string desc() const ;
+};
+
+
+inline sresample::sresample( const double* dom_, int nk_ )
+    :
+    dom(dom_),
+    nk(nk_)
+{
+}
+
+/**
+sresample::add_group
+----------------------
+
+Properties added after this belong to the new group.
+
+**/
+
+inline void sresample::add_group( const char* name )
+{
+    int p = num_prop() ;
+    if(!group.empty()) group.back().p1 = p ;
+    group.push_back( { name ? name : "", p, p } );
+}
+
+/**
+sresample::add
+----------------
+
+Returns pointer to 2*num doubles for the caller to fill with (x,y) pairs
+with ascending x. The pointer is invalidated by the next add.
+
+**/
+
+inline double* sresample::add( int64_t num, double def )
+{
+    if(group.empty()) add_group();
+    int64_t offset = xy.size()/2 ;
+    prop.push_back( { offset, num, def } );
+    group.back().p1 = num_prop() ;
+    xy.resize( xy.size() + 2*num );
+    return num > 0 ? xy.data() + 2*offset : nullptr ;
+}
+
+inline int sresample::num_prop() const
+{
+    return int(prop.size()) ;
+}
+
+/**
+sresample::Value
+------------------
+
+Single value with the G4PhysicsVector::Value linear interpolation, used as reference.
+
+**/
+
+inline double sresample::Value( const double* xy, int64_t num, double def, double e ) // static
+{
+    if( num == 0 ) return def ;
+    if( num == 1 || e <= xy[0] ) return xy[1] ;
+    if( e >= xy[2*(num-1)] ) return xy[2*(num-1)+1] ;
+
+    int64_t lo = 0, hi = num ;      // lower_bound
+    while( lo < hi )
+    {
+        int64_t mid = (lo + hi)/2 ;
+        if( xy[2*mid] < e ) lo = mid + 1 ; else hi = mid ;
+    }
+    int64_t i = lo - 1 ;
+
+    double x1 = xy[2*i] ;
+    double dl = xy[2*(i+1)] - x1 ;
+    double y1 = xy[2*i+1] ;
+    double dy = xy[2*(i+1)+1] - y1 ;
+    double b = (e - x1)/dl ;
+    return y1 + b*dy ;
+}
+
+/**
+sresample::Resample
+---------------------
+
+Same values as Value for every domain point, but sweeping the domain in
+ascending order so the bin only ever advances. The domain may be
+ascending or descending (as sdomain::energy_eV).
+
+**/
+
+inline void sresample::Resample( double* out, int64_t out_stride, const double* xy, int64_t num, double def, const double* dom, int nk ) // static
+{
+    if( num == 0 )
+    {
+        for(int k=0 ; k < nk ; k++) out[k*out_stride] = def ;
+        return ;
+    }
+
+    bool ascending = nk < 2 || dom[0] <= dom[nk-1] ;
+    double x0 = xy[0] ;
+    double xn = xy[2*(num-1)] ;
+    double y0 = xy[1] ;
+    double yn = xy[2*(num-1)+1] ;
+
+    int64_t i = 0 ;
+    for(int kk=0 ; kk < nk ; kk++)
+    {
+        int k = ascending ? kk : nk - 1 - kk ;
+        double e = dom[k] ;
+        double v ;
+        if( num == 1 || e <= x0 )
+        {
+            v = y0 ;
+        }
+        else if( e >= xn )
+        {
+            v = yn ;
+        }
+        else
+        {
+            while( xy[2*(i+1)] < e ) i += 1 ;
+            double x1 = xy[2*i] ;
+            double dl = xy[2*(i+1)] - x1 ;
+            double y1 = xy[2*i+1] ;
+            double dy = xy[2*(i+1)+1] - y1 ;
+            double b = (e - x1)/dl ;
+            v = y1 + b*dy ;
+        }
+        out[k*out_stride] = v ;
+    }
+}
+
+/**
+sresample::resample
+---------------------
+
+Fills out[p*nk+k] for all properties. With num_thread other than 1
+the properties are sharded over threads with sthread::ParallelFor,
+0 for the hardware concurrency.
+
+**/
+
+inline void sresample::resample( double* out, int num_thread ) const
+{
+    auto sweep = [&](int, int64_t p0, int64_t p1)
+    {
+        for(int64_t p=p0 ; p < p1 ; p++)
+        {
+            const Prop& pr = prop[p] ;
+            const double* pxy = pr.num > 0 ? xy.data() + 2*pr.offset : nullptr ;
+            Resample( out + p*nk, 1, pxy, pr.num, pr.def, dom, nk );
+        }
+    };
+    if( num_thread == 1 ) sweep( 0, 0, num_prop() );
+    else sthread::ParallelFor( int64_t(num_prop()), sweep, 8, num_thread );
+}
+
+inline std::string sresample::desc() const
+{
+    std::stringstream ss ;
+    ss << "sresample::desc"
+       << " nk " << nk
+       << " num_group " << group.size()
+       << " num_prop " << num_prop()
+       << " num_xy " << xy.size()/2
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
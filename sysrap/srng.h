@@ -18,6 +18,7 @@ So have to implement all methods in each specialization, or use a separate helpe
 **/
 
 #include <curand_kernel.h>
+#include "sphilox.h"
 
 using XORWOW = curandStateXORWOW ;
 using Philox = curandStatePhilox4_32_10 ; 
@@ -41,6 +42,7 @@ using RNG = PhiLiteOx ;
 
 #include <sstream>
 #include <string>
+#include <cstring>
 
 template<typename T> struct srng {};
 
@@ -63,6 +65,24 @@ struct srng<Philox>
     static constexpr bool UPLOAD_RNG_STATES = false ; 
 };
 
+/**
+srng<sphilox>
+---------------
+
+Portable Philox giving the same sequences as Philox on host and device, 
+for MOCK_CURAND and CPU backends, see sphilox.h 
+
+**/
+
+template<> 
+struct srng<sphilox>  
+{ 
+    static constexpr char CODE = 'S' ;
+    static constexpr const char* NAME = "sphilox" ; 
+    static constexpr unsigned SIZE = sizeof(sphilox) ; 
+    static constexpr bool UPLOAD_RNG_STATES = false ; 
+};
+
 #if defined(RNG_PHILITEOX)
 template<> 
 struct srng<PhiLiteOx>  
@@ -96,6 +116,9 @@ inline bool srng_IsXORWOW(){ return strcmp(srng<T>::NAME, "XORWOW") == 0 ; }
 template<typename T> 
 inline bool srng_IsPhilox(){ return strcmp(srng<T>::NAME, "Philox") == 0 ; }
 
+template<typename T> 
+inline bool srng_Issphilox(){ return strcmp(srng<T>::NAME, "sphilox") == 0 ; }
+
 template<typename T> 
 inline bool srng_IsPhiLiteOx(){ return strcmp(srng<T>::NAME, "PhiLiteOx") == 0 ; }
 
@@ -106,6 +129,7 @@ inline bool srng_Matches(const char* arg)
     if( arg && strstr(arg, "XORWOW")    && srng_IsXORWOW<T>() )    match += 1 ; 
     if( arg && strstr(arg, "Philox")    && srng_IsPhilox<T>() )    match += 1 ; 
     if( arg && strstr(arg, "PhiLiteOx") && srng_IsPhiLiteOx<T>() ) match += 1 ; 
+    if( arg && strstr(arg, "sphilox")   && srng_Issphilox<T>() )   match += 1 ; 
     return match == 1 ; 
 } 
 
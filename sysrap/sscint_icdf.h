@@ -0,0 +1,324 @@
+#pragma once
+/**
+sscint_icdf.h : adaptive packed inverse CDF for scintillation wavelength sampling
+===================================================================================
+
+The scintillation ICDF from U4Scint::CreateGeant4InterpolatedInverseCDF
+has shape (3, nj, 1) holding values at::
+
+    layer 0 : u = j/nj                         "all"
+    layer 1 : u = j/(hd*nj)                    lhs zoom, hd_factor times finer
+    layer 2 : u = 1 - 1/hd + j/(hd*nj)         rhs zoom
+
+qscint::wavelength_hd0/hd10/hd20 look these up with fixed resolution
+regardless of how curved the ICDF is, so most of the 3*4096 texels
+describe the nearly straight middle of the spectrum while the error
+in the tails is not controlled.
+
+This builds a packed table with an explicit error target. The reference
+*Reference* is the piecewise linear ICDF through the source values, using the
+finest layer covering each u. The u range is split into *nseg* equal segments
+and each segment gets 2^level equal intervals, with the smallest level for
+which linear interpolation between the knots is within *tol* of the reference.
+As both are piecewise linear the maximum deviation within a segment is
+at one of the reference breakpoints, so checking those gives the exact
+maximum error, not an estimate.
+
+The tails of an ICDF are close to vertical, so with knots that miss the
+reference breakpoints no level is enough there. The default nseg of
+4*hd_factor (or 64 without hd layers) with nj a power of two puts
+the knots of the maximum level exactly on the breakpoints, so the
+tolerance can always be met, in the worst case by reproducing the
+source table over the segment.
+
+The knots of all segments are packed into a single row of texels
+with a segment table of (offset, num_interval) pairs::
+
+    x = u*nseg                 s = min(int(x), nseg-1)
+    N = nseg*num_interval      i = min(int(u*N - s*num_interval), num_interval-1)
+    w = u*N - (s*num_interval + i)
+    wl = lerp( tex[offset+i], tex[offset+i+1], w )
+
+The products u*N are done with fma so w has a single rounding,
+see qscint::wavelength_adaptive. The remaining difference from
+the Reference at the same float u is then only the float rounding
+of the knots and of the lerp, a few ulp of the wavelength.
+
+qscint::wavelength_adaptive does this with two point sampled texture
+fetches, so the bound does not depend on the 8 bit interpolation
+weights of hardware linear filtering. Where the ICDF is straight a
+segment needs only its two end knots, so the texel count is usually
+far below that of the fixed tables for tighter error::
+
+    ~/o/qudarap/tests/QScint_adaptive_MockTest.sh
+
+**/
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "NP.hh"
+
+struct sscint_icdf
+{
+    static constexpr const double TOL = 0.01 ;   // nm
+    static constexpr const int NSEG = 64 ;   // without hd layers
+
+    const NP* src ;     // (1|3, nj, 1) float or double
+    int    ni ;
+    int    nj ;
+    int    hd_factor ;
+    double tol ;
+    int    nseg ;
+    int    max_level ;
+
+    std::vector<double>   vv ;     // source values (ni*nj)
+    std::vector<float>    tex ;    // packed knots
+    std::vector<unsigned> seg ;    // (offset, num_interval) of each segment
+    std::vector<double>   err ;    // max deviation from Reference of each segment
+
+    sscint_icdf( const NP* src, double tol=TOL, int nseg=0, int max_level=0 );   // 0: aligned defaults
+
+    double layer( int i, double x ) const ;
+    double reference( double u ) const ;
+    void   breakpoints( std::vector<double>& bb, double u0, double u1 ) const ;
+
+    void   init();
+    double segment_error( double u0, double u1, int n ) const ;
+
+    float  lookup( float u ) const ;   // host mirror of qscint::wavelength_adaptive
+    double max_error() const ;
+
+    NP*    make_tex() const ;
+    NP*    make_seg() const ;
+    std::string desc() const ;
+};
+
+
+inline sscint_icdf::sscint_icdf( const NP* src_, double tol_, int nseg_, int max_level_ )
+    :
+    src(src_),
+    ni(src_->shape[0]),
+    nj(src_->shape[1]),
+    hd_factor(ni == 3 ? src_->get_meta<int>("hd_factor", 20) : 0),
+    tol(tol_),
+    nseg(nseg_ > 0 ? nseg_ : ( hd_factor > 0 ? 4*hd_factor : NSEG )),
+    max_level(max_level_)
+{
+    if( max_level == 0 )
+    {
+        int nb = hd_factor > 0 ? hd_factor*nj : nj ;   // finest breakpoint spacing 1/nb
+        while( (nseg << max_level) < nb ) max_level += 1 ;
+    }
+    init();
+}
+
+/**
+sscint_icdf::layer
+--------------------
+
+Linear interpolation of layer i at x in [0,1] with value j at x = j/nj,
+clamped beyond the last value.
+
+**/
+
+inline double sscint_icdf::layer( int i, double x ) const
+{
+    const double* v = vv.data() + i*nj ;
+    double xb = x*double(nj) ;
+    if( xb <= 0. ) return v[0] ;
+    if( xb >= double(nj-1) ) return v[nj-1] ;
+    int j = int(xb) ;
+    double f = xb - double(j) ;
+    return (1.-f)*v[j] + f*v[j+1] ;
+}
+
+/**
+sscint_icdf::reference
+------------------------
+
+The last value of the lhs layer is at u = (nj-1)/(hd_factor*nj), short
+of the edge. Over that gap the Reference continues linearly to the
+layer 0 value at the edge rather than clamping, which would leave a
+step at the edge hidden from the breakpoint check.
+
+**/
+
+inline double sscint_icdf::reference( double u ) const
+{
+    if( hd_factor == 0 ) return layer(0, u) ;
+    double edge = 1./double(hd_factor) ;
+    if( u > 1. - edge ) return layer(2, (u - (1. - edge))*hd_factor) ;
+    if( u >= edge ) return layer(0, u) ;
+
+    double xb = u*double(hd_factor*nj) ;
+    if( xb < double(nj-1) ) return layer(1, u*hd_factor) ;
+    double f = xb - double(nj-1) ;
+    return (1.-f)*vv[nj + nj-1] + f*layer(0, edge) ;
+}
+
+/**
+sscint_icdf::breakpoints
+--------------------------
+
+Reference breakpoints strictly within (u0, u1) plus the region edges.
+
+**/
+
+inline void sscint_icdf::breakpoints( std::vector<double>& bb, double u0, double u1 ) const
+{
+    bb.clear();
+    double edge = hd_factor > 0 ? 1./double(hd_factor) : 0. ;
+    double fine = hd_factor > 0 ? 1./double(hd_factor*nj) : 1./double(nj) ;
+    double coarse = 1./double(nj) ;
+
+    auto add_grid = [&](double a, double b, double origin, double step)
+    {
+        double lo = std::max(a, u0) ;
+        double hi = std::min(b, u1) ;
+        if( lo >= hi ) return ;
+        long j0 = long(std::ceil((lo - origin)/step)) ;
+        for(long j=j0 ; origin + j*step < hi ; j++)
+        {
+            double u = origin + j*step ;
+            if( u > u0 ) bb.push_back(u) ;
+        }
+    };
+
+    if( hd_factor == 0 )
+    {
+        add_grid( 0., 1., 0., coarse );
+    }
+    else
+    {
+        add_grid( 0., edge, 0., fine );
+        add_grid( edge, 1. - edge, 0., coarse );
+        add_grid( 1. - edge, 1., 1. - edge, fine );
+        if( edge > u0 && edge < u1 ) bb.push_back(edge) ;
+        if( 1. - edge > u0 && 1. - edge < u1 ) bb.push_back(1. - edge) ;
+    }
+}
+
+inline double sscint_icdf::segment_error( double u0, double u1, int n ) const
+{
+    std::vector<double> bb ;
+    breakpoints( bb, u0, u1 );
+
+    double w = (u1 - u0)/double(n) ;
+    double mx = 0. ;
+    for(double u : bb)
+    {
+        int i = std::min( int((u - u0)/w), n - 1 ) ;
+        double ua = u0 + i*w ;
+        double va = reference(ua) ;
+        double vb = reference(ua + w) ;
+        double v = va + (u - ua)/w*(vb - va) ;
+        mx = std::max( mx, std::abs(v - reference(u)) );
+    }
+    return mx ;
+}
+
+/**
+sscint_icdf::init
+-------------------
+
+Levels are raised one segment at a time until within tol or max_level.
+Knots are evaluated in double and narrowed.
+
+**/
+
+inline void sscint_icdf::init()
+{
+    vv.resize(ni*nj) ;
+    for(int i=0 ; i < ni*nj ; i++) vv[i] = src->ebyte == 8 ? src->cvalues<double>()[i] : double(src->cvalues<float>()[i]) ;
+
+    seg.resize(2*nseg) ;
+    err.resize(nseg) ;
+    tex.clear();
+
+    for(int s=0 ; s < nseg ; s++)
+    {
+        double u0 = double(s)/double(nseg) ;
+        double u1 = double(s+1)/double(nseg) ;
+        int n = 1 ;
+        double e = segment_error(u0, u1, n) ;
+        for(int level=1 ; level <= max_level && e > tol ; level++)
+        {
+            n = 1 << level ;
+            e = segment_error(u0, u1, n) ;
+        }
+        seg[2*s+0] = tex.size() ;
+        seg[2*s+1] = n ;
+        err[s] = e ;
+        for(int k=0 ; k <= n ; k++) tex.push_back( float(reference( u0 + (u1 - u0)*double(k)/double(n) )) );
+    }
+}
+
+inline float sscint_icdf::lookup( float u ) const
+{
+    float x = u*float(nseg) ;
+    unsigned s = std::min( unsigned(x), unsigned(nseg - 1) ) ;
+    unsigned offset = seg[2*s+0] ;
+    unsigned n = seg[2*s+1] ;
+    float N = float(nseg*n) ;
+    float t = std::max( std::fma(u, N, -float(s*n)), 0.f ) ;
+    unsigned i = std::min( unsigned(t), n - 1u ) ;
+    float w = std::fma(u, N, -float(s*n + i)) ;
+    float v0 = tex[offset+i] ;
+    float v1 = tex[offset+i+1] ;
+    return v0 + w*(v1 - v0) ;
+}
+
+inline double sscint_icdf::max_error() const
+{
+    return err.size() > 0 ? *std::max_element(err.begin(), err.end()) : 0. ;
+}
+
+/**
+sscint_icdf::make_tex
+-----------------------
+
+Shape (1, num_texel, 1) float for QTex<float> upload.
+
+**/
+
+inline NP* sscint_icdf::make_tex() const
+{
+    NP* a = NP::Make<float>(1, tex.size(), 1) ;
+    a->read2( tex.data() );
+    a->set_meta<double>("tol", tol );
+    a->set_meta<int>("nseg", nseg );
+    a->set_meta<double>("max_error", max_error() );
+    return a ;
+}
+
+inline NP* sscint_icdf::make_seg() const
+{
+    NP* a = NP::Make<unsigned>(nseg, 2) ;
+    a->read2( seg.data() );
+    return a ;
+}
+
+inline std::string sscint_icdf::desc() const
+{
+    int max_n = 0 ;
+    for(int s=0 ; s < nseg ; s++) max_n = std::max( max_n, int(seg[2*s+1]) ) ;
+
+    std::stringstream ss ;
+    ss << "sscint_icdf::desc"
+       << " src " << ( src ? src->sstr() : "-" )
+       << " hd_factor " << hd_factor
+       << " tol " << tol
+       << " nseg " << nseg
+       << " num_texel " << tex.size()
+       << " max_interval_per_seg " << max_n
+       << " max_error " << std::scientific << std::setprecision(3) << max_error()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
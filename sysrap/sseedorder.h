@@ -0,0 +1,236 @@
+#pragma once
+/**
+sseedorder.h : gentype coherent ordering of photon slots
+==========================================================
+
+The seed buffer maps photon slots to gensteps in genstep order, so when
+gensteps of different types alternate (eg Cerenkov, scintillation, torch)
+neighbouring threads of a warp run different generate_photon branches and
+have different propagation lengths.
+
+With an ordering mode the seed buffer is unchanged but an additional *order*
+buffer holds a permutation of the photon slots, stable sorted by a key
+taken from the genstep of each slot::
+
+    GENTYPE          key = gentype
+    GENTYPE_MATLINE  key = gentype << 32 | matline    (q0.u.z of all genstep types)
+
+The simulate kernel thread with launch index *i* handles photon slot *order[i]*,
+so RNG, genstep and output slot all follow the original photon index and
+the output is identical to that without ordering, only the assignment of
+photons to threads changes. The permutation (and its inverse) restores the
+launch order of any per-thread debug output.
+
+QEvt::fill_order_buffer does this on device with thrust, Order below is the
+host reference implementation and Divergence provides warp divergence
+proxies for comparing orderings::
+
+    ~/o/sysrap/tests/sseedorder_test.sh
+
+**/
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#    define SSEEDORDER_METHOD __host__ __device__ __forceinline__
+#else
+#    define SSEEDORDER_METHOD inline
+#endif
+
+#include "scuda.h"
+#include "squad.h"
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+#endif
+
+struct sseedorder
+{
+    enum { NONE, GENTYPE, GENTYPE_MATLINE } ;
+
+    static constexpr const char* NONE_ = "NONE" ;
+    static constexpr const char* GENTYPE_ = "GENTYPE" ;
+    static constexpr const char* GENTYPE_MATLINE_ = "GENTYPE_MATLINE" ;
+
+    SSEEDORDER_METHOD static unsigned long long Key( const quad6& gs, int mode );
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+    struct Stat
+    {
+        int    mode ;
+        size_t num_slot ;
+        size_t num_warp ;
+        size_t num_mixed_gentype ;    // warps with more than one gentype
+        size_t num_mixed_key ;        // warps with more than one key of the mode (or GENTYPE_MATLINE for NONE)
+        size_t num_transition ;       // adjacent slots with different gentype
+        double mean_gentype_per_warp ;
+        std::string desc() const ;
+    };
+
+    static int Mode( const char* name );
+    static const char* Name( int mode );
+
+    static void Seed(  std::vector<int>& seed, const quad6* gs, size_t num_gs );
+    static void Order( std::vector<int>& order, const int* seed, size_t num_seed, const quad6* gs, int mode );
+    static void Inverse( std::vector<int>& inv, const std::vector<int>& order );
+
+    static Stat Divergence( const int* seed, const int* order, size_t num_seed, const quad6* gs, int mode, int warp=32 );
+#endif
+};
+
+
+/**
+sseedorder::Key
+-----------------
+
+For NONE returns zero, so a stable sort leaves the order unchanged.
+
+**/
+
+SSEEDORDER_METHOD unsigned long long sseedorder::Key( const quad6& gs, int mode ) // static
+{
+    unsigned long long gentype = gs.q0.u.x ;
+    unsigned long long matline = gs.q0.u.z ;
+    return mode == GENTYPE ? ( gentype << 32 ) : ( mode == GENTYPE_MATLINE ? (( gentype << 32 ) | matline ) : 0ull ) ;
+}
+
+#if defined(__CUDACC__) || defined(__CUDABE__)
+#else
+
+inline int sseedorder::Mode( const char* name ) // static
+{
+    int mode = NONE ;
+    if(name && strcmp(name, GENTYPE_) == 0 )         mode = GENTYPE ;
+    if(name && strcmp(name, GENTYPE_MATLINE_) == 0 ) mode = GENTYPE_MATLINE ;
+    return mode ;
+}
+
+inline const char* sseedorder::Name( int mode ) // static
+{
+    const char* s = nullptr ;
+    switch(mode)
+    {
+        case NONE:            s = NONE_            ; break ;
+        case GENTYPE:         s = GENTYPE_         ; break ;
+        case GENTYPE_MATLINE: s = GENTYPE_MATLINE_ ; break ;
+    }
+    return s ;
+}
+
+/**
+sseedorder::Seed
+------------------
+
+Host equivalent of QEvt_count_genstep_photons_and_fill_seed_buffer,
+repeating genstep indices according to numphoton of each genstep.
+
+**/
+
+inline void sseedorder::Seed( std::vector<int>& seed, const quad6* gs, size_t num_gs ) // static
+{
+    seed.clear();
+    for(size_t i=0 ; i < num_gs ; i++)
+    {
+        unsigned num_ph = gs[i].q0.u.w ;
+        seed.insert( seed.end(), num_ph, int(i) );
+    }
+}
+
+/**
+sseedorder::Order
+-------------------
+
+Host reference of QEvt_fill_order_buffer. As the seed buffer is in genstep
+order the photon order is a stable sort of the gensteps by key,
+expanded to their photon slots.
+
+**/
+
+inline void sseedorder::Order( std::vector<int>& order, const int* seed, size_t num_seed, const quad6* gs, int mode ) // static
+{
+    order.resize(num_seed);
+    std::iota( order.begin(), order.end(), 0 );
+    if( mode == NONE ) return ;
+
+    std::vector<unsigned long long> key(num_seed) ;
+    for(size_t i=0 ; i < num_seed ; i++) key[i] = Key( gs[seed[i]], mode ) ;
+
+    std::stable_sort( order.begin(), order.end(), [&key](int a, int b){ return key[a] < key[b] ; } );
+}
+
+inline void sseedorder::Inverse( std::vector<int>& inv, const std::vector<int>& order ) // static
+{
+    inv.resize(order.size());
+    for(size_t i=0 ; i < order.size() ; i++) inv[order[i]] = int(i) ;
+}
+
+/**
+sseedorder::Divergence
+------------------------
+
+Proxies for branch divergence of launch index order, with *order* nullptr
+giving the unordered launch. The keys compared for num_mixed_key are those
+of *mode*, or GENTYPE_MATLINE for NONE.
+
+**/
+
+inline sseedorder::Stat sseedorder::Divergence( const int* seed, const int* order, size_t num_seed, const quad6* gs, int mode, int warp ) // static
+{
+    int kmode = mode == NONE ? GENTYPE_MATLINE : mode ;
+
+    Stat st = {} ;
+    st.mode = mode ;
+    st.num_slot = num_seed ;
+    st.num_warp = (num_seed + warp - 1)/warp ;
+
+    size_t sum_gentype = 0 ;
+    unsigned prev = 0u ;
+
+    for(size_t w=0 ; w < st.num_warp ; w++)
+    {
+        std::vector<unsigned> gentypes ;
+        std::vector<unsigned long long> keys ;
+        size_t i1 = std::min( num_seed, (w+1)*warp );
+        for(size_t i=w*warp ; i < i1 ; i++)
+        {
+            size_t slot = order ? order[i] : i ;
+            const quad6& g = gs[seed[slot]] ;
+            unsigned gt = g.q0.u.x ;
+            unsigned long long k = Key(g, kmode) ;
+
+            if( std::find(gentypes.begin(), gentypes.end(), gt) == gentypes.end() ) gentypes.push_back(gt) ;
+            if( std::find(keys.begin(), keys.end(), k) == keys.end() ) keys.push_back(k) ;
+            if( i > 0 && gt != prev ) st.num_transition += 1 ;
+            prev = gt ;
+        }
+        sum_gentype += gentypes.size() ;
+        if( gentypes.size() > 1 ) st.num_mixed_gentype += 1 ;
+        if( keys.size() > 1 )     st.num_mixed_key += 1 ;
+    }
+    st.mean_gentype_per_warp = st.num_warp > 0 ? double(sum_gentype)/double(st.num_warp) : 0. ;
+    return st ;
+}
+
+inline std::string sseedorder::Stat::desc() const
+{
+    std::stringstream ss ;
+    ss << "sseedorder::Stat"
+       << " mode " << std::setw(15) << Name(mode)
+       << " num_slot " << std::setw(8) << num_slot
+       << " num_warp " << std::setw(7) << num_warp
+       << " num_mixed_gentype " << std::setw(7) << num_mixed_gentype
+       << " num_mixed_key " << std::setw(7) << num_mixed_key
+       << " num_transition " << std::setw(7) << num_transition
+       << " mean_gentype_per_warp " << std::fixed << std::setprecision(3) << mean_gentype_per_warp
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
+#endif
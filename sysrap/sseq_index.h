@@ -37,26 +37,36 @@ sseq_qab
 sseq_index
    reimplementation of ~/opticks/ana/qcf.py:QU
 
-   * q:vector of sseq (populated from typically large input array within ctor)
-   * m:map of unique sseq with counts and first indices (relies on sseq.h hash specialization)
+   * q:vector of sseq (only populated by load_seq, counting reads the array directly)
+   * m:map of unique sseq with counts and first indices
    * u:descending count ordered vector of sseq_unique
 
    Holds representation of the photon history of the input array in typically
    much smaller form with just unique sseq and counts
 
+   Counting is sharded across threads (sthread.h) with per-shard
+   std::unordered_map (relies on sseq.h hash specialization) that are
+   merged in shard order, so first indices match serial counting.
+
+   Default ctor and sseq_index::add support incremental accumulation
+   event by event, without keeping the seq arrays.
+
 
 Q: reimplementation of ~/opticks/ana/qcf.py:QCF ?
 
 **/
 
+#include <unordered_map>
+
 #include "ssys.h"
 #include "sseq.h"
+#include "sthread.h"
 #include "NPX.h"
 
 
 struct sseq_index_count
 {
-    int index ;     // index of first occurrence within the source array
+    int64_t index ; // index of first occurrence within the source array
     int count ;     // count of occurrence of the same history within the source array
     std::string desc() const ;
 };
@@ -100,6 +110,7 @@ struct sseq_qab
     sseq_index_count a ;
     sseq_index_count b ;
 
+    static double C2(const sseq_index_count& a, const sseq_index_count& b, bool& included, int absum_min) ;
     double c2(bool& included, int absum_min) const ;
 
     int maxcount() const { return std::max(a.count, b.count) ; }
@@ -108,7 +119,7 @@ struct sseq_qab
     std::string desc(int absum_min) const ;
 };
 
-inline double sseq_qab::c2(bool& included, int absum_min) const
+inline double sseq_qab::C2(const sseq_index_count& a, const sseq_index_count& b, bool& included, int absum_min) // static
 {
     double _a = a.count ;
     double _b = b.count ;
@@ -118,6 +129,11 @@ inline double sseq_qab::c2(bool& included, int absum_min) const
     return included ? abdif*abdif/absum : 0 ;
 }
 
+inline double sseq_qab::c2(bool& included, int absum_min) const
+{
+    return C2(a, b, included, absum_min) ;
+}
+
 /**
 sseq_qab::desc
 ----------------
@@ -151,16 +167,23 @@ inline std::string sseq_qab::desc(int absum_min) const
 
 struct sseq_index
 {
-    std::vector<sseq> q ;                   // typically large input array
+    std::vector<sseq> q ;                   // typically large input array, only populated by load_seq
 
     std::map<sseq, sseq_index_count> m ;    // map of unique sseq with counts and first indices
 
     std::vector<sseq_unique> u ;            // unique sseq with counts in descending count ordered vector of sseq_unique
 
+    int64_t num_seq ;                       // total number of seq counted across all add calls
+    int     num_add ;
+
     sseq_index( const NP* seq);
+    sseq_index();
+
+    void add( const NP* seq );
 
     void load_seq( const NP* seq );
     void count_unique();
+    static void CountUnique( std::map<sseq, sseq_index_count>& m, const sseq* qq, int64_t num, int64_t offset );
     void order_seq();
     std::string desc(int min_count=0) const;
 };
@@ -170,17 +193,63 @@ struct sseq_index
 sseq_index::sseq_index
 ------------------------
 
-1. load array into q vector of sseq
-2. populate std::map<sseq, sseq_index_count>
-3.
+1. count unique sseq from the array populating std::map<sseq, sseq_index_count>
+2. order into u vector in descending count order
 
 **/
 
 
 inline sseq_index::sseq_index( const NP* seq)
+    :
+    num_seq(0),
+    num_add(0)
 {
-    load_seq(seq);
-    count_unique();
+    add(seq);
+}
+
+/**
+sseq_index::sseq_index default ctor for incremental use
+---------------------------------------------------------
+
+::
+
+    sseq_index a ;
+    for(int i=0 ; i < num_event ; i++) a.add( seq_from_event(i) );  // seq array can be released after each add
+
+**/
+
+inline sseq_index::sseq_index()
+    :
+    num_seq(0),
+    num_add(0)
+{
+}
+
+/**
+sseq_index::add
+------------------
+
+Accumulates counts from the seq array into m and reorders u.
+First occurrence indices are offset by the total of seq counted
+by prior add calls, so they refer to the concatenation of all added arrays.
+
+**/
+
+inline void sseq_index::add( const NP* seq )
+{
+    if(seq == nullptr || seq->shape.size() == 0) return ;
+    bool expected_sizeof_item = sizeof(sseq) == seq->item_bytes() ;
+    if(!expected_sizeof_item) std::cerr << "sseq_index::add UNEXPECTED seq item_bytes " << seq->item_bytes() << " sizeof(sseq) " << sizeof(sseq) << "\n" ;
+    assert( expected_sizeof_item );
+    if(!expected_sizeof_item) return ;
+
+    const sseq* qq = (const sseq*)seq->bytes() ;
+    int64_t num = seq->shape[0] ;
+
+    CountUnique(m, qq, num, num_seq );
+    num_seq += num ;
+    num_add += 1 ;
+
     order_seq();
 }
 
@@ -191,34 +260,70 @@ inline void sseq_index::load_seq(const NP* seq)
 }
 
 /**
-sseq_index::count_unique fill the sseq keyed map of occurence counts
-----------------------------------------------------------------------
+sseq_index::count_unique
+-------------------------
+
+Counts from the q vector, which requires prior load_seq.
+The default ctor and add do not need the q copy of the array.
+
+**/
+
+inline void sseq_index::count_unique()
+{
+    CountUnique(m, q.data(), q.size(), 0 );
+}
+
+/**
+sseq_index::CountUnique fill the sseq keyed map of occurence counts
+---------------------------------------------------------------------
 
-Iterate over the source vector populating the
+Iterate over the source array populating the
 map with the index of first occurrence and
 count of the frequency of occurrence.
 
+Each shard of the source array is counted by a separate thread
+into its own std::unordered_map. The shard maps are then merged
+into m in shard order, so the index of first occurrence is the
+same as the serial iteration would give. Entries already in m
+from prior calls keep their index.
+
 Relies on sseq hash specialization based on seqhis values
 to establish the different identify of different sseq values.
 
 **/
 
-inline void sseq_index::count_unique()
+inline void sseq_index::CountUnique( std::map<sseq, sseq_index_count>& m, const sseq* qq, int64_t num, int64_t offset ) // static
 {
-    for (int i = 0; i < int(q.size()); i++)
-    {
-        const sseq& seq = q[i];
+    typedef std::unordered_map<sseq, sseq_index_count> UM ;
+    int num_shard = sthread::NumShard(num) ;
+    std::vector<UM> shard(num_shard) ;
 
-        std::map<sseq, sseq_index_count>::iterator it  = m.find(seq);
-
-        if(it == m.end())
+    sthread::ParallelFor( num, [&](int s, int64_t i0, int64_t i1)
+    {
+        UM& um = shard[s] ;
+        for(int64_t i=i0 ; i < i1 ; i++)
         {
-            int q_index_of_first_occurrence = i ;
-            m[seq] = {q_index_of_first_occurrence, 1} ;
+            const sseq& seq = qq[i] ;
+            UM::iterator it = um.find(seq);
+            if(it == um.end())
+            {
+                int64_t q_index_of_first_occurrence = offset + i ;
+                um.emplace( seq, sseq_index_count{q_index_of_first_occurrence, 1} ) ;
+            }
+            else
+            {
+                it->second.count++ ;
+            }
         }
-        else
+    });
+
+    for(int s=0 ; s < num_shard ; s++)
+    {
+        for(auto it=shard[s].begin() ; it != shard[s].end() ; it++)
         {
-            it->second.count++ ;
+            std::map<sseq, sseq_index_count>::iterator jt = m.find(it->first);
+            if(jt == m.end()) m[it->first] = it->second ;
+            else jt->second.count += it->second.count ;
         }
     }
 }
@@ -227,26 +332,28 @@ inline void sseq_index::count_unique()
 sseq_index::order_seq : sorting unique sseq in descending count order
 ----------------------------------------------------------------------
 
-1. copy from map m into vector u
-2. sort the u vector into descending count order
+1. copy from map m into vector u, replacing any prior content
+2. sort the u vector into descending count order, with ties in sseq order
 
 **/
 
 
 inline void sseq_index::order_seq()
 {
+    u.clear();
+    u.reserve(m.size());
     for(auto it=m.begin() ; it != m.end() ; it++) u.push_back( { it->first, {it->second.index, it->second.count} } );
 
     auto descending_order = [](const sseq_unique& a, const sseq_unique& b) { return a.ic.count > b.ic.count ; } ;
 
-    std::sort( u.begin(), u.end(), descending_order  );
+    std::stable_sort( u.begin(), u.end(), descending_order  );
 }
 
 inline std::string sseq_index::desc(int min_count) const
 {
     std::stringstream ss ;
     int num = u.size();
-    ss << "[sseq_index::desc num " << num << std::endl ;
+    ss << "[sseq_index::desc num " << num << " num_seq " << num_seq << " num_add " << num_add << std::endl ;
     for(int i=0 ; i < num ; i++)
     {
         if( u[i].ic.count < min_count ) break ;
@@ -273,6 +380,10 @@ struct sseq_index_ab_chi2
     void save(const char* dir) const ;
 
     void init();
+    void add(const sseq_index_count& a, const sseq_index_count& b);
+    void calc(const sseq_index& a, const sseq_index& b);
+    static sseq_index_ab_chi2 Calc(const sseq_index& a, const sseq_index& b);
+
     std::string desc() const ;
     std::string desc_rst() const ;
     std::string desc_html() const ;
@@ -305,6 +416,53 @@ inline void sseq_index_ab_chi2::init()
     spare = 0 ;
 }
 
+inline void sseq_index_ab_chi2::add(const sseq_index_count& a, const sseq_index_count& b)
+{
+    bool included = false ;
+    double c2 = sseq_qab::C2(a, b, included, int(absum_min)) ;
+    if(!included) return ;
+    sum += c2 ;
+    ndf += 1 ;
+}
+
+/**
+sseq_index_ab_chi2::calc
+--------------------------
+
+Fast chi2 directly from the merged count maps of a and b without
+collecting and ordering the sseq_qab comparison vector.
+As both maps share the same sseq ordering a single linear merge-join
+pass visits every history. Histories only in one of a or b are
+never included (same as sseq_qab::c2) so only matched keys contribute.
+
+**/
+
+inline void sseq_index_ab_chi2::calc(const sseq_index& a, const sseq_index& b)
+{
+    init();
+    auto ia = a.m.begin() ;
+    auto ib = b.m.begin() ;
+    while( ia != a.m.end() && ib != b.m.end() )
+    {
+        if(      ia->first < ib->first ) ia++ ;
+        else if( ib->first < ia->first ) ib++ ;
+        else
+        {
+            add( ia->second, ib->second );
+            ia++ ;
+            ib++ ;
+        }
+    }
+}
+
+inline sseq_index_ab_chi2 sseq_index_ab_chi2::Calc(const sseq_index& a, const sseq_index& b) // static
+{
+    sseq_index_ab_chi2 chi2 ;
+    chi2.calc(a, b);
+    return chi2 ;
+}
+
+
 std::string sseq_index_ab_chi2::desc() const
 {
     return desc_rst();
@@ -416,7 +574,7 @@ sseq_index_ab::collect_seq
 ---------------------------
 
 sseq_index_count_ab
-     4 integers with index and count from A and B
+     index (int64_t) and count from A and B
 
 
 **/
@@ -475,13 +633,7 @@ inline void sseq_index_ab::calc_chi2()
     for(int i=0 ; i < num ; i++)
     {
         const sseq_qab& qab = u[i] ;
-        bool included = false ;
-        double c2 = qab.c2(included, chi2.absum_min) ;
-        if(included)
-        {
-            chi2.sum += c2 ;
-            chi2.ndf +=  1 ;
-        }
+        chi2.add(qab.a, qab.b) ;
     }
 }
 
@@ -489,8 +641,8 @@ inline void sseq_index_ab::calc_chi2()
 inline NP* sseq_index_ab::serialize() const
 {
     int num = u.size();
-    NP* a = NP::Make<int>(num, 4) ;
-    int* aa = a->values<int>();
+    NP* a = NP::Make<int64_t>(num, 4) ;
+    int64_t* aa = a->values<int64_t>();
 
     for(int i=0 ; i < num ; i++)
     {
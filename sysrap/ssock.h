@@ -0,0 +1,291 @@
+#pragma once
+/**
+ssock.h : minimal POSIX socket transport of NP arrays
+=======================================================
+
+Blocking stream sockets, either unix domain or TCP, with each message
+a fixed 16 byte frame header followed by the NP serialized bytes
+(header, data and metadata as written by NP::serializeToBuffer)::
+
+    char     magic[8] ;   // "NPSOCK01"
+    uint64_t nbytes ;     // little endian, size of serialized array
+
+Addresses are strings::
+
+    unix:/tmp/opticks.sock      unix domain socket path
+    /tmp/opticks.sock           same, leading slash implies unix
+    tcp:127.0.0.1:5555          TCP host:port
+    127.0.0.1:5555              same
+    tcp:127.0.0.1:0             TCP ephemeral port, see ssock::BoundAddr
+
+Note that NP::serializeToBuffer does not include the names, so anything
+that needs to travel with an array must go into its metadata.
+
+**/
+
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#include "NP.hh"
+
+struct ssock
+{
+    static constexpr const char* MAGIC = "NPSOCK01" ;
+    static constexpr const size_t FRAME = 16 ;
+    static constexpr const uint64_t MAX_BYTES = uint64_t(1) << 40 ;
+
+    static bool IsUnix(const char* addr);
+    static std::string UnixPath(const char* addr);
+    static bool SplitHostPort(const char* addr, std::string& host, std::string& port );
+
+    static int Listen(const char* addr, int backlog=64 );
+    static int Accept(int lfd);
+    static int Connect(const char* addr);
+    static void Close(int fd);
+    static void Shutdown(int fd);
+    static std::string BoundAddr(int lfd);
+
+    static bool ReadAll(int fd, char* buf, size_t n);
+    static bool WriteAll(int fd, const char* buf, size_t n);
+
+    static bool Send(int fd, NP* a);
+    static NP*  Recv(int fd);
+};
+
+inline bool ssock::IsUnix(const char* addr)
+{
+    return addr && ( strncmp(addr, "unix:", 5) == 0 || addr[0] == '/' ) ;
+}
+
+inline std::string ssock::UnixPath(const char* addr)
+{
+    return strncmp(addr, "unix:", 5) == 0 ? addr + 5 : addr ;
+}
+
+inline bool ssock::SplitHostPort(const char* addr, std::string& host, std::string& port )
+{
+    std::string s = strncmp(addr, "tcp:", 4) == 0 ? addr + 4 : addr ;
+    size_t colon = s.rfind(':') ;
+    if( colon == std::string::npos ) return false ;
+    host = s.substr(0, colon) ;
+    port = s.substr(colon+1) ;
+    if(host.empty()) host = "127.0.0.1" ;
+    return !port.empty() ;
+}
+
+/**
+ssock::Listen
+--------------
+
+Returns listening fd or -1. Any stale unix socket file is unlinked first.
+
+**/
+
+inline int ssock::Listen(const char* addr, int backlog )
+{
+    if(!addr) return -1 ;
+    int fd = -1 ;
+    if(IsUnix(addr))
+    {
+        std::string path = UnixPath(addr);
+        sockaddr_un sa = {} ;
+        sa.sun_family = AF_UNIX ;
+        if( path.size() >= sizeof(sa.sun_path) ) return -1 ;
+        strncpy( sa.sun_path, path.c_str(), sizeof(sa.sun_path) - 1 );
+        unlink(path.c_str());
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if( fd < 0 ) return -1 ;
+        if( bind(fd, (sockaddr*)&sa, sizeof(sa)) != 0 ) { Close(fd) ; return -1 ; }
+    }
+    else
+    {
+        std::string host, port ;
+        if(!SplitHostPort(addr, host, port)) return -1 ;
+        addrinfo hints = {} ;
+        hints.ai_family = AF_INET ;
+        hints.ai_socktype = SOCK_STREAM ;
+        hints.ai_flags = AI_PASSIVE ;
+        addrinfo* res = nullptr ;
+        if( getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res ) return -1 ;
+
+        fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        int one = 1 ;
+        if( fd >= 0 ) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if( fd >= 0 && bind(fd, res->ai_addr, res->ai_addrlen) != 0 ) { Close(fd) ; fd = -1 ; }
+        freeaddrinfo(res);
+        if( fd < 0 ) return -1 ;
+    }
+    if( listen(fd, backlog) != 0 ) { Close(fd) ; return -1 ; }
+    return fd ;
+}
+
+inline int ssock::Accept(int lfd)
+{
+    int fd = -1 ;
+    do { fd = accept(lfd, nullptr, nullptr) ; } while( fd < 0 && errno == EINTR );
+    if( fd < 0 ) return -1 ;
+
+    sockaddr_storage ss = {} ;
+    socklen_t len = sizeof(ss) ;
+    getsockname(fd, (sockaddr*)&ss, &len);
+    int one = 1 ;
+    if( ss.ss_family == AF_INET ) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd ;
+}
+
+inline int ssock::Connect(const char* addr)
+{
+    if(!addr) return -1 ;
+    int fd = -1 ;
+    if(IsUnix(addr))
+    {
+        std::string path = UnixPath(addr);
+        sockaddr_un sa = {} ;
+        sa.sun_family = AF_UNIX ;
+        if( path.size() >= sizeof(sa.sun_path) ) return -1 ;
+        strncpy( sa.sun_path, path.c_str(), sizeof(sa.sun_path) - 1 );
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if( fd >= 0 && connect(fd, (sockaddr*)&sa, sizeof(sa)) != 0 ) { Close(fd) ; fd = -1 ; }
+    }
+    else
+    {
+        std::string host, port ;
+        if(!SplitHostPort(addr, host, port)) return -1 ;
+        addrinfo hints = {} ;
+        hints.ai_family = AF_INET ;
+        hints.ai_socktype = SOCK_STREAM ;
+        addrinfo* res = nullptr ;
+        if( getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 || !res ) return -1 ;
+        fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+        if( fd >= 0 && connect(fd, res->ai_addr, res->ai_addrlen) != 0 ) { Close(fd) ; fd = -1 ; }
+        freeaddrinfo(res);
+        int one = 1 ;
+        if( fd >= 0 ) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd ;
+}
+
+inline void ssock::Close(int fd)
+{
+    if( fd >= 0 ) close(fd);
+}
+
+/**
+ssock::Shutdown
+----------------
+
+Unblocks any thread blocked in accept or read on the fd.
+
+**/
+
+inline void ssock::Shutdown(int fd)
+{
+    if( fd >= 0 ) shutdown(fd, SHUT_RDWR);
+}
+
+/**
+ssock::BoundAddr
+-----------------
+
+For TCP listeners returns "tcp:127.0.0.1:<port>" with the actually bound
+port, needed when listening on port 0.
+
+**/
+
+inline std::string ssock::BoundAddr(int lfd)
+{
+    sockaddr_storage ss = {} ;
+    socklen_t len = sizeof(ss) ;
+    if( getsockname(lfd, (sockaddr*)&ss, &len) != 0 ) return "" ;
+    std::stringstream str ;
+    if( ss.ss_family == AF_UNIX )
+    {
+        str << "unix:" << ((sockaddr_un*)&ss)->sun_path ;
+    }
+    else if( ss.ss_family == AF_INET )
+    {
+        str << "tcp:127.0.0.1:" << ntohs(((sockaddr_in*)&ss)->sin_port) ;
+    }
+    return str.str() ;
+}
+
+inline bool ssock::ReadAll(int fd, char* buf, size_t n)
+{
+    size_t got = 0 ;
+    while( got < n )
+    {
+        ssize_t r = read(fd, buf + got, n - got );
+        if( r < 0 && errno == EINTR ) continue ;
+        if( r <= 0 ) return false ;
+        got += r ;
+    }
+    return true ;
+}
+
+inline bool ssock::WriteAll(int fd, const char* buf, size_t n)
+{
+    size_t put = 0 ;
+    while( put < n )
+    {
+        ssize_t w = send(fd, buf + put, n - put, MSG_NOSIGNAL );
+        if( w < 0 && errno == EINTR ) continue ;
+        if( w <= 0 ) return false ;
+        put += w ;
+    }
+    return true ;
+}
+
+inline bool ssock::Send(int fd, NP* a)
+{
+    if(!a) return false ;
+    std::vector<char> buf ;
+    a->serializeToBuffer(buf, 1 << 20, 1);
+
+    char frame[FRAME] ;
+    memcpy( frame, MAGIC, 8 );
+    uint64_t nbytes = buf.size() ;
+    memcpy( frame + 8, &nbytes, 8 );
+
+    return WriteAll(fd, frame, FRAME) && WriteAll(fd, buf.data(), buf.size()) ;
+}
+
+/**
+ssock::Recv
+------------
+
+Returns nullptr on EOF, bad magic or unparseable array.
+
+**/
+
+inline NP* ssock::Recv(int fd)
+{
+    char frame[FRAME] ;
+    if(!ReadAll(fd, frame, FRAME)) return nullptr ;
+    if( memcmp(frame, MAGIC, 8) != 0 )
+    {
+        std::cerr << "ssock::Recv bad magic\n" ;
+        return nullptr ;
+    }
+    uint64_t nbytes = 0 ;
+    memcpy( &nbytes, frame + 8, 8 );
+    if( nbytes > MAX_BYTES ) return nullptr ;
+
+    std::vector<char> buf(nbytes) ;
+    if(!ReadAll(fd, buf.data(), nbytes)) return nullptr ;
+    return NP::LoadFromBuffer_(buf.data(), buf.size());
+}
@@ -0,0 +1,109 @@
+#pragma once
+/**
+sthread.h : minimal std::thread based parallel-for over index ranges
+======================================================================
+
+Splits [0,num_item) into contiguous shards, one per thread, and calls
+the functor with the shard index and range::
+
+    sthread::ParallelFor( num_item, [&](int ishard, int64_t i0, int64_t i1)
+    {
+        for(int64_t i=i0 ; i < i1 ; i++) ... ;
+    });
+
+Shards are contiguous and in index order, so merging per-shard results
+in shard order reproduces the serial iteration order. That allows
+"index of first occurrence" style results to be identical to the
+single threaded implementation.
+
+The number of threads is controlled by envvar sthread__NUM, defaulting
+to std::thread::hardware_concurrency. Small inputs (less than min_per_shard
+items per thread) use fewer threads, down to running inline on the
+calling thread with no thread creation at all.
+
+**/
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "ssys.h"
+
+struct sthread
+{
+    static constexpr const char* EKEY = "sthread__NUM" ;
+    static constexpr const int64_t MIN_PER_SHARD = 1<<16 ;
+
+    static int Concurrency();
+    static int NumShard(int64_t num_item, int64_t min_per_shard=MIN_PER_SHARD, int num_thread=0 );
+
+    template<typename F>
+    static int ParallelFor(int64_t num_item, F&& fn, int64_t min_per_shard=MIN_PER_SHARD, int num_thread=0 );
+
+    static std::string Desc();
+};
+
+inline int sthread::Concurrency()
+{
+    int hc = int(std::thread::hardware_concurrency()) ;
+    int num = ssys::getenvint(EKEY, hc > 0 ? hc : 1 ) ;
+    return std::max(1, num) ;
+}
+
+/**
+sthread::NumShard
+------------------
+
+Number of shards to split num_item into, never more than the thread count
+and never so many that shards have fewer than min_per_shard items.
+
+**/
+
+inline int sthread::NumShard(int64_t num_item, int64_t min_per_shard, int num_thread )
+{
+    int nt = num_thread > 0 ? num_thread : Concurrency() ;
+    int64_t max_shard = std::max( int64_t(1), num_item/std::max(int64_t(1), min_per_shard) ) ;
+    return int(std::min( int64_t(nt), max_shard )) ;
+}
+
+/**
+sthread::ParallelFor
+----------------------
+
+Returns the number of shards used. Shard 0 runs on the calling thread.
+
+**/
+
+template<typename F>
+inline int sthread::ParallelFor(int64_t num_item, F&& fn, int64_t min_per_shard, int num_thread )
+{
+    if( num_item <= 0 ) return 0 ;
+    int num_shard = NumShard(num_item, min_per_shard, num_thread );
+    int64_t per_shard = (num_item + num_shard - 1)/num_shard ;
+
+    std::vector<std::thread> tt ;
+    tt.reserve(num_shard) ;
+    for(int s=1 ; s < num_shard ; s++)
+    {
+        int64_t i0 = std::min( num_item, s*per_shard );
+        int64_t i1 = std::min( num_item, i0 + per_shard );
+        tt.emplace_back( [&fn, s, i0, i1](){ fn(s, i0, i1) ; } );
+    }
+    fn(0, 0, std::min(num_item, per_shard) );
+    for(auto& t : tt) t.join();
+    return num_shard ;
+}
+
+inline std::string sthread::Desc()
+{
+    std::stringstream ss ;
+    ss << "sthread::Desc"
+       << " " << EKEY << " " << Concurrency()
+       << " hardware_concurrency " << std::thread::hardware_concurrency()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
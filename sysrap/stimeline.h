@@ -0,0 +1,559 @@
+#pragma once
+/**
+stimeline.h : low overhead per-thread binary event timeline with Chrome trace export
+=======================================================================================
+
+Each thread that records gets its own fixed capacity ring of 24 byte
+stimeline_rec (timestamp, value, tag, kind, thread index). Recording is a
+clock read and a store into the calling thread's ring with no lock, no
+string formatting and no /proc access, so unlike SProf::Add/sprof::Stamp
+it can be left enabled in production running.
+
+Tag names are interned once into a process wide table under a mutex.
+The string overloads of the record methods resolve the name with a
+thread_local cache keyed on the name pointer (checked against the cached
+string), so after the first call from a thread with a name no lock is
+taken. For hot call sites keep the int to also skip the cache lookup::
+
+    static const int tag = stimeline::Tag("SEvt__gather") ;
+    stimeline::Begin(tag);
+    ...
+    stimeline::End(tag);
+
+Kinds of record
+-----------------
+
+MARK
+    sequential stage marker, eg QSim__simulate_HEAD QSim__simulate_PRUP ...
+    The stage named by the marker lasts until the next MARK from the same
+    thread with the same scope, where the scope is the tag name up to and
+    including its last '_' ("QSim__simulate_"). A "_TAIL" suffixed MARK
+    closes the sequence.
+BEGIN, END
+    bracketing pair, eg SEvt__beginOfEvent SEvt__endOfEvent
+INSTANT
+    point in time
+
+Persisting and export
+-----------------------
+
+stimeline::Serialize gathers all rings into an int64 NP array of shape (n,3)
+in time order with the interned tag names as NP::names. The three int64
+columns hold t(ns since epoch), value and (tag | kind << 32 | tid << 48)::
+
+    a = np.load("stimeline.npy")
+    t, v, k = a[:,0], a[:,1], a[:,2]
+    tag, kind, tid = k & 0xffffffff, (k >> 32) & 0xffff, k >> 48
+
+stimeline::ChromeTrace converts that array into Chrome trace event JSON
+that can be opened with chrome://tracing or https://ui.perfetto.dev
+
+Config via envvars
+--------------------
+
+stimeline__DISABLE
+    when set recording calls return immediately
+stimeline__CAPACITY
+    ring capacity per thread in records, rounded up to power of two, default 65536 (1.5 MB)
+stimeline__WRITE
+    enable stimeline::Write, otherwise it does nothing
+stimeline__PATH
+    default "stimeline.npy", when the path contains "%" it is formatted with SProf__PATH_INDEX
+
+Thread safety
+---------------
+
+Each ring has a single writer (its thread). stimeline::Serialize may be
+called from any thread, records being written by other threads concurrently
+with the serialize may be missed or torn, so serialize at quiescent points
+(end of event, end of run). Rings are owned by the process wide table and
+outlive their threads, so worker rings remain readable after the threads exit.
+
+**/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <unordered_map>
+
+#include "ssys.h"
+#include "sstr.h"
+#include "NP.hh"
+
+struct stimeline_rec
+{
+    int64_t t ;      // ns since epoch
+    int64_t value ;
+    int32_t tag ;
+    int16_t kind ;
+    int16_t tid ;
+};
+
+struct stimeline_ring
+{
+    std::vector<stimeline_rec> buf ;
+    uint64_t mask ;
+    std::atomic<uint64_t> head ;
+    int16_t tid ;
+
+    stimeline_ring(uint64_t capacity, int16_t tid_);
+    void add(int64_t t, int64_t value, int32_t tag, int16_t kind);
+    uint64_t num() const ;
+    uint64_t dropped() const ;
+};
+
+inline stimeline_ring::stimeline_ring(uint64_t capacity, int16_t tid_)
+    :
+    buf(capacity),
+    mask(capacity - 1),
+    head(0),
+    tid(tid_)
+{
+}
+
+inline void stimeline_ring::add(int64_t t, int64_t value, int32_t tag, int16_t kind)
+{
+    uint64_t h = head.load(std::memory_order_relaxed) ;
+    stimeline_rec& r = buf[h & mask] ;
+    r.t = t ;
+    r.value = value ;
+    r.tag = tag ;
+    r.kind = kind ;
+    r.tid = tid ;
+    head.store(h + 1, std::memory_order_release) ;
+}
+
+inline uint64_t stimeline_ring::num() const
+{
+    uint64_t h = head.load(std::memory_order_acquire) ;
+    return std::min( h, uint64_t(buf.size()) );
+}
+inline uint64_t stimeline_ring::dropped() const
+{
+    uint64_t h = head.load(std::memory_order_acquire) ;
+    return h > buf.size() ? h - buf.size() : 0 ;
+}
+
+
+struct stimeline
+{
+    enum { MARK, BEGIN, END, INSTANT } ;
+
+    static constexpr const char* stimeline__DISABLE  = "stimeline__DISABLE" ;
+    static constexpr const char* stimeline__CAPACITY = "stimeline__CAPACITY" ;
+    static constexpr const char* stimeline__WRITE    = "stimeline__WRITE" ;
+    static constexpr const char* stimeline__PATH     = "stimeline__PATH" ;
+    static constexpr const char* PATH_DEFAULT        = "stimeline.npy" ;
+    static constexpr const char* PATH_INDEX          = "SProf__PATH_INDEX" ;
+    static constexpr const int   CAPACITY_DEFAULT    = 1 << 16 ;
+
+    struct Table
+    {
+        std::mutex mtx ;
+        std::vector<std::string> names ;
+        std::unordered_map<std::string, int> index ;
+        std::vector<std::unique_ptr<stimeline_ring>> rings ;
+        bool enabled ;
+        uint64_t capacity ;
+        std::atomic<int64_t> num_lock ;   // acquisitions of mtx, for contention checks
+        Table();
+    };
+
+    static Table& Get();
+    static bool Enabled();
+    static stimeline_ring* Ring();
+    static int64_t Now();
+
+    static int  Tag(const char* name);
+    static int  Tag_(const char* name);
+    static const char* Kind(int kind);
+
+    static int64_t Add(int tag, int kind, int64_t value=0);
+    static int64_t Mark(   int tag, int64_t value=0) { return Add(tag, MARK,    value) ; }
+    static int64_t Begin(  int tag, int64_t value=0) { return Add(tag, BEGIN,   value) ; }
+    static int64_t End(    int tag, int64_t value=0) { return Add(tag, END,     value) ; }
+    static int64_t Instant(int tag, int64_t value=0) { return Add(tag, INSTANT, value) ; }
+
+    static int64_t Mark(   const char* name, int64_t value=0) { return Add(Tag(name), MARK,    value) ; }
+    static int64_t Begin(  const char* name, int64_t value=0) { return Add(Tag(name), BEGIN,   value) ; }
+    static int64_t End(    const char* name, int64_t value=0) { return Add(Tag(name), END,     value) ; }
+    static int64_t Instant(const char* name, int64_t value=0) { return Add(Tag(name), INSTANT, value) ; }
+
+    static NP* Serialize();
+    static void Clear();
+    static const char* Path();
+    static void Write();
+
+    static std::string Scope(const char* name);
+    static std::string JSONEscape(const std::string& str);
+    static std::string ChromeTrace(const NP* a, int pid=0);
+    static void SaveChromeTrace(const NP* a, const char* path, int pid=0);
+
+    static std::string Desc();
+};
+
+
+inline stimeline::Table::Table()
+    :
+    enabled(!ssys::getenvbool(stimeline__DISABLE)),
+    capacity(1),
+    num_lock(0)
+{
+    int cap = std::max(2, ssys::getenvint(stimeline__CAPACITY, CAPACITY_DEFAULT)) ;
+    while( capacity < uint64_t(cap) ) capacity <<= 1 ;
+}
+
+inline stimeline::Table& stimeline::Get()
+{
+    static Table table ;
+    return table ;
+}
+
+inline bool stimeline::Enabled()
+{
+    return Get().enabled ;
+}
+
+/**
+stimeline::Ring
+-----------------
+
+The first call from each thread creates and registers the ring for that
+thread, subsequent calls just return the thread_local pointer.
+
+**/
+
+inline stimeline_ring* stimeline::Ring()
+{
+    thread_local stimeline_ring* ring = nullptr ;
+    if( ring == nullptr )
+    {
+        Table& tab = Get();
+        std::lock_guard<std::mutex> lock(tab.mtx);
+        tab.num_lock += 1 ;
+        int16_t tid = int16_t(tab.rings.size()) ;
+        tab.rings.emplace_back( new stimeline_ring(tab.capacity, tid) );
+        ring = tab.rings.back().get() ;
+    }
+    return ring ;
+}
+
+inline int64_t stimeline::Now()
+{
+    using Clock = std::chrono::system_clock;
+    using Unit  = std::chrono::nanoseconds ;
+    return std::chrono::duration_cast<Unit>(Clock::now().time_since_epoch()).count() ;
+}
+
+/**
+stimeline::Tag
+----------------
+
+Lock free after the first call from the thread with the name pointer.
+The cache entry is replaced when the pointer is reused for another name,
+and the cache is reset if it grows large from many transient names.
+
+**/
+
+inline int stimeline::Tag(const char* name)
+{
+    if( name == nullptr ) return Tag_(name) ;
+    thread_local std::unordered_map<const char*, std::pair<int, std::string>> cache ;
+    auto it = cache.find(name) ;
+    if( it != cache.end() && it->second.second == name ) return it->second.first ;
+    if( cache.size() > 1024 ) cache.clear() ;
+    int tag = Tag_(name) ;
+    cache[name] = { tag, name } ;
+    return tag ;
+}
+
+inline int stimeline::Tag_(const char* name)
+{
+    Table& tab = Get();
+    std::lock_guard<std::mutex> lock(tab.mtx);
+    tab.num_lock += 1 ;
+    std::string key = name ? name : "" ;
+    auto it = tab.index.find(key) ;
+    if( it != tab.index.end() ) return it->second ;
+    int tag = tab.names.size() ;
+    tab.names.push_back(key);
+    tab.index[key] = tag ;
+    return tag ;
+}
+
+inline const char* stimeline::Kind(int kind)
+{
+    const char* s = nullptr ;
+    switch(kind)
+    {
+        case MARK:    s = "MARK"    ; break ;
+        case BEGIN:   s = "BEGIN"   ; break ;
+        case END:     s = "END"     ; break ;
+        case INSTANT: s = "INSTANT" ; break ;
+    }
+    return s ;
+}
+
+/**
+stimeline::Add
+----------------
+
+Returns the ns timestamp of the record, or zero when disabled.
+
+**/
+
+inline int64_t stimeline::Add(int tag, int kind, int64_t value)
+{
+    if(!Enabled()) return 0 ;
+    int64_t t = Now();
+    Ring()->add(t, value, tag, int16_t(kind));
+    return t ;
+}
+
+/**
+stimeline::Serialize
+----------------------
+
+Collects the records from all thread rings into a single time ordered
+array of shape (n,3) with the tag names. Metadata records the number
+of threads and the number of records dropped due to ring overwrites.
+
+**/
+
+inline NP* stimeline::Serialize()
+{
+    Table& tab = Get();
+    std::vector<stimeline_rec> rr ;
+    std::vector<std::string> names ;
+    uint64_t dropped = 0 ;
+    int num_ring = 0 ;
+    {
+        std::lock_guard<std::mutex> lock(tab.mtx);
+        names = tab.names ;
+        num_ring = tab.rings.size() ;
+        for(int i=0 ; i < num_ring ; i++)
+        {
+            const stimeline_ring* ring = tab.rings[i].get() ;
+            uint64_t h = ring->head.load(std::memory_order_acquire) ;
+            uint64_t n = ring->num() ;
+            for(uint64_t j=h-n ; j < h ; j++) rr.push_back( ring->buf[j & ring->mask] ) ;
+            dropped += ring->dropped() ;
+        }
+    }
+
+    auto time_order = [](const stimeline_rec& a, const stimeline_rec& b){ return a.t < b.t ; } ;
+    std::stable_sort( rr.begin(), rr.end(), time_order );
+
+    int num = rr.size();
+    NP* a = NP::Make<int64_t>( num, 3 );
+    int64_t* aa = a->values<int64_t>();
+    for(int i=0 ; i < num ; i++)
+    {
+        const stimeline_rec& r = rr[i] ;
+        aa[i*3+0] = r.t ;
+        aa[i*3+1] = r.value ;
+        aa[i*3+2] = int64_t(uint32_t(r.tag)) | ( int64_t(uint16_t(r.kind)) << 32 ) | ( int64_t(uint16_t(r.tid)) << 48 ) ;
+    }
+    a->set_names(names);
+    a->set_meta<int>("num_thread", num_ring );
+    a->set_meta<uint64_t>("dropped", dropped );
+    return a ;
+}
+
+inline void stimeline::Clear()
+{
+    Table& tab = Get();
+    std::lock_guard<std::mutex> lock(tab.mtx);
+    for(auto& ring : tab.rings) ring->head.store(0, std::memory_order_release) ;
+}
+
+inline const char* stimeline::Path()
+{
+    const char* PATH = ssys::getenvvar(stimeline__PATH, PATH_DEFAULT);
+    int INDEX        = ssys::getenvint(PATH_INDEX, 0);
+    bool looks_like_fmt = strstr(PATH,"%") != nullptr ;
+    return looks_like_fmt ? sstr::Format(PATH, INDEX) : PATH ;
+}
+
+/**
+stimeline::Write
+------------------
+
+Like SProf::Write this overwrites the full timeline on every call,
+so can be called at end of every event to have something in case of crash.
+The binary write costs a few ms for the default capacity.
+
+**/
+
+inline void stimeline::Write()
+{
+    if(!ssys::getenvbool(stimeline__WRITE)) return ;
+    const char* path = Path();
+    if(!path) return ;
+    NP* a = Serialize();
+    a->save(path);
+    delete a ;
+}
+
+inline std::string stimeline::Scope(const char* name)
+{
+    const char* p = name ? strrchr(name, '_') : nullptr ;
+    return p ? std::string(name, p - name + 1) : std::string(name ? name : "") ;
+}
+
+/**
+stimeline::JSONEscape
+-----------------------
+
+Names are arbitrary strings, so quote, backslash and control characters
+are escaped to keep the trace valid JSON.
+
+**/
+
+inline std::string stimeline::JSONEscape(const std::string& str)
+{
+    std::string out ;
+    out.reserve(str.size()) ;
+    for(char c : str)
+    {
+        switch(c)
+        {
+            case '"':  out += "\\\"" ; break ;
+            case '\\': out += "\\\\" ; break ;
+            case '\n': out += "\\n"  ; break ;
+            case '\r': out += "\\r"  ; break ;
+            case '\t': out += "\\t"  ; break ;
+            default:
+                if( (unsigned char)c < 0x20 )
+                {
+                    char buf[8] ;
+                    snprintf(buf, sizeof(buf), "\\u%04x", unsigned((unsigned char)c)) ;
+                    out += buf ;
+                }
+                else
+                {
+                    out += c ;
+                }
+                break ;
+        }
+    }
+    return out ;
+}
+
+/**
+stimeline::ChromeTrace
+------------------------
+
+Chrome trace event format JSON with "ts" "dur" in microseconds from the first record.
+
+* MARK records become complete "X" events lasting until the next MARK of the same scope
+  and thread, the last MARK of a scope and MARK named with suffix "_TAIL" become instant "i" events
+* BEGIN/END records become "B"/"E" events
+* INSTANT records become "i" events
+
+The record value is included in "args". Names and scopes are escaped with JSONEscape.
+
+**/
+
+inline std::string stimeline::ChromeTrace(const NP* a, int pid)
+{
+    int num = a ? a->shape[0] : 0 ;
+    const int64_t* aa = a ? a->cvalues<int64_t>() : nullptr ;
+    int64_t t0 = num > 0 ? aa[0] : 0 ;
+
+    std::vector<std::string> scope(a ? a->names.size() : 0) ;
+    for(int i=0 ; i < int(scope.size()) ; i++) scope[i] = JSONEscape(Scope(a->names[i].c_str())) ;
+
+    // index of next MARK record with same thread and scope, -1 for none
+    std::vector<int> next(num, -1) ;
+    std::unordered_map<std::string, int> last ;
+    for(int i=num-1 ; i >= 0 ; i--)
+    {
+        int64_t k = aa[i*3+2] ;
+        int tag = k & 0xffffffff ;
+        int kind = (k >> 32) & 0xffff ;
+        int tid = (k >> 48) & 0xffff ;
+        if( kind != MARK ) continue ;
+        std::string key = std::to_string(tid) + ":" + scope[tag] ;
+        auto it = last.find(key) ;
+        bool tail = sstr::EndsWith(a->names[tag].c_str(), "_TAIL") ;
+        if( it != last.end() && !tail ) next[i] = it->second ;
+        last[key] = i ;
+    }
+
+    std::stringstream ss ;
+    ss << "{\"traceEvents\":[\n" ;
+    for(int i=0 ; i < num ; i++)
+    {
+        int64_t t = aa[i*3+0] ;
+        int64_t v = aa[i*3+1] ;
+        int64_t k = aa[i*3+2] ;
+        int tag = k & 0xffffffff ;
+        int kind = (k >> 32) & 0xffff ;
+        int tid = (k >> 48) & 0xffff ;
+        const char* name = tag < int(a->names.size()) ? a->names[tag].c_str() : "?" ;
+
+        const char* ph = "i" ;
+        int64_t dur = -1 ;
+        switch(kind)
+        {
+            case MARK:    ph = next[i] > -1 ? "X" : "i" ; dur = next[i] > -1 ? aa[next[i]*3+0] - t : -1 ; break ;
+            case BEGIN:   ph = "B" ; break ;
+            case END:     ph = "E" ; break ;
+            case INSTANT: ph = "i" ; break ;
+        }
+
+        ss << ( i == 0 ? "" : ",\n" )
+           << "{\"name\":\"" << JSONEscape(name) << "\""
+           << ",\"cat\":\"" << scope[tag] << "\""
+           << ",\"ph\":\"" << ph << "\""
+           << ",\"pid\":" << pid
+           << ",\"tid\":" << tid
+           << ",\"ts\":" << std::fixed << std::setprecision(3) << double(t - t0)/1e3
+           ;
+        if( dur > -1 ) ss << ",\"dur\":" << std::fixed << std::setprecision(3) << double(dur)/1e3 ;
+        if( *ph == 'i' ) ss << ",\"s\":\"t\"" ;
+        ss << ",\"args\":{\"value\":" << v << "}}" ;
+    }
+    ss << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"t0_ns\":" << t0 << "}}\n" ;
+    std::string str = ss.str();
+    return str ;
+}
+
+inline void stimeline::SaveChromeTrace(const NP* a, const char* path, int pid)
+{
+    std::ofstream fp(path, std::ios::out);
+    fp << ChromeTrace(a, pid) ;
+    fp.close();
+}
+
+inline std::string stimeline::Desc()
+{
+    Table& tab = Get();
+    std::lock_guard<std::mutex> lock(tab.mtx);
+    std::stringstream ss ;
+    ss << "stimeline::Desc"
+       << " enabled " << ( tab.enabled ? "YES" : "NO " )
+       << " capacity " << tab.capacity
+       << " num_tag " << tab.names.size()
+       << " num_ring " << tab.rings.size()
+       << "\n"
+       ;
+    for(const auto& ring : tab.rings) ss
+       << " tid " << std::setw(3) << ring->tid
+       << " num " << std::setw(8) << ring->num()
+       << " dropped " << std::setw(8) << ring->dropped()
+       << "\n"
+       ;
+    std::string str = ss.str();
+    return str ;
+}
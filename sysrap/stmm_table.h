@@ -0,0 +1,439 @@
+#pragma once
+/**
+stmm_table.h : tabulated multi-layer TMM A,R,T for PMT categories
+====================================================================
+
+The full TMM stack calculation with complex arithmetic (stmm.h/C4MultiLayrStack.h)
+is done for every photon reaching a PMT. As the result for a PMT category depends
+only on wavelength, incidence angle and polarization it can instead be tabulated
+and interpolated. The polarization dependence is a linear mix of S and P
+components so tabulating the components suffices::
+
+    E_s2 = (dot_pol_cross_mom_nrm/sin_theta)^2     S power fraction, 0 at normal incidence
+    A    = E_s2*A_s + (1-E_s2)*A_p
+    R    = E_s2*R_s + (1-E_s2)*R_p
+    T    = 1 - A - R
+
+*art* array shape (ncat, 2, nwl, nct, 4) holds [A_s, A_p, R_s, R_p] with:
+
+* half 0 : minus_cos_theta < 0, ingoing against the normal
+* half 1 : minus_cos_theta >= 0, outgoing with the normal (reversed stack)
+* wavelength nodes uniform from wl0 to wl1
+* cos_theta = |minus_cos_theta| nodes uniform from 0 to 1, node 0 evaluated at CT_EPS
+  to avoid the glancing incidence nan
+
+*esc* array shape (ncat, nwl) holds qeshape/A at normal incidence, the
+escape factor that is multiplied by the per-PMT qescale to give theEfficiency.
+
+Accuracy is measured at the midpoints of the grid in each direction
+and at the cell centres, giving *err* shape (ncat, 3, 4).
+
+The interpolation error concentrates in the few cells around the critical
+angle of the ingoing half, where R_p rises steeply to total internal
+reflection. Refining a uniform grid does little for that, with 128x256
+nodes the error there is ~0.2. Instead the cells whose measured error
+exceeds FBK_SAFETY*tol are flagged for fallback to the exact stack
+calculation, with *fbk* uint8 shape (ncat, 2, nwl-1, nct-1) holding 1 for
+cells to skip. Flags are widened by one cos_theta cell on each side as the
+measurement only samples the cell centre and edge midpoints. The flagged
+cells are those at glancing incidence and around the critical angle.
+Default tol is TOL, tol <= 0 disables the fallback leaving the raw table error.
+
+The TMM calculation is supplied by the caller, avoiding the clash between
+the stmm.h and Custom4 Stack templates::
+
+    void calc(double* asrs, int cat, double wavelength_nm, double minus_cos_theta)
+    double qeshape(int cat, double energy_eV)
+
+See SPMT::make_art_table and qudarap/tests/QPMT_ART_table_MockTest.cc
+
+**/
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <functional>
+#include <algorithm>
+
+#include "sthread.h"
+#include "NP.hh"
+
+struct stmm_table
+{
+    static constexpr const int NWL = 128 ;
+    static constexpr const int NCT = 256 ;
+    static constexpr const double CT_EPS = 1e-3 ;
+    static constexpr const double TOL = 1e-3 ;
+    static constexpr const double FBK_SAFETY = 0.25 ;
+    static constexpr const double hc_eVnm = 1239.84198433200208455673 ;
+
+    using CalcFn = std::function<void(double*, int, double, double)> ;
+    using QEFn   = std::function<double(int, double)> ;
+
+    int    ncat ;
+    int    nwl ;
+    int    nct ;
+    double wl0 ;
+    double wl1 ;
+    double tol ;
+    double err_table ;
+
+    CalcFn calc ;
+    QEFn   qeshape ;
+
+    NP* art ;
+    NP* esc ;
+    NP* err ;
+    NP* fbk ;
+
+    static stmm_table* Create(int ncat, double wl0, double wl1, CalcFn calc, QEFn qeshape, int nwl=NWL, int nct=NCT, double tol=TOL );
+
+    stmm_table(int ncat, double wl0, double wl1, CalcFn calc, QEFn qeshape, double tol );
+    ~stmm_table();
+
+    double wavelength(double j) const ;
+    double costh(double k) const ;
+    double minus_cos_theta(int half, double k) const ;
+
+    void   build(int nwl, int nct);
+    void   measure();
+    double max_err(int row) const ;
+    double max_err_table() const ;
+    double fbk_fraction() const ;
+
+    bool   fallback(int cat, double wavelength_nm, double minus_cos_theta) const ;
+    void   lookup_asrs(double* asrs, int cat, double wavelength_nm, double minus_cos_theta) const ;
+    void   lookup_art(double* art3, int cat, double wavelength_nm, double minus_cos_theta, double dot_pol_cross_mom_nrm) const ;
+    static void Mix(double* art3, const double* asrs, double minus_cos_theta, double dot_pol_cross_mom_nrm );
+
+    std::string desc() const ;
+};
+
+
+inline stmm_table* stmm_table::Create(int ncat, double wl0, double wl1, CalcFn calc, QEFn qeshape, int nwl, int nct, double tol ) // static
+{
+    stmm_table* t = new stmm_table(ncat, wl0, wl1, calc, qeshape, tol) ;
+    t->build(nwl, nct);
+    t->measure();
+    return t ;
+}
+
+inline stmm_table::stmm_table(int ncat_, double wl0_, double wl1_, CalcFn calc_, QEFn qeshape_, double tol_ )
+    :
+    ncat(ncat_),
+    nwl(0),
+    nct(0),
+    wl0(wl0_),
+    wl1(wl1_),
+    tol(tol_),
+    err_table(0.),
+    calc(calc_),
+    qeshape(qeshape_),
+    art(nullptr),
+    esc(nullptr),
+    err(nullptr),
+    fbk(nullptr)
+{
+}
+
+/**
+stmm_table::~stmm_table
+-------------------------
+
+Users adopting the arrays must null the members before deleting the table,
+see SPMT::init_art_table.
+
+**/
+
+inline stmm_table::~stmm_table()
+{
+    delete art ;
+    delete esc ;
+    delete err ;
+    delete fbk ;
+}
+
+inline double stmm_table::wavelength(double j) const { return wl0 + j*(wl1 - wl0)/double(nwl-1) ; }
+inline double stmm_table::costh(double k) const { return std::max( CT_EPS, k/double(nct-1) ) ; }
+inline double stmm_table::minus_cos_theta(int half, double k) const { return half == 0 ? -costh(k) : costh(k) ; }
+
+/**
+stmm_table::build
+-------------------
+
+Rows of (cat, half, wavelength) are independent and computed in parallel,
+so calc must be thread safe.
+
+**/
+
+inline void stmm_table::build(int nwl_, int nct_)
+{
+    nwl = std::max(2, nwl_) ;
+    nct = std::max(2, nct_) ;
+
+    delete art ;
+    delete esc ;
+    art = NP::Make<float>( ncat, 2, nwl, nct, 4 );
+    esc = NP::Make<float>( ncat, nwl );
+    float* aa = art->values<float>();
+    float* ee = esc->values<float>();
+
+    int num_row = ncat*2*nwl ;
+    sthread::ParallelFor( num_row, [&](int, int64_t r0, int64_t r1)
+    {
+        double asrs[4] ;
+        for(int64_t r=r0 ; r < r1 ; r++)
+        {
+            int cat = r/(2*nwl) ;
+            int half = (r/nwl) % 2 ;
+            int j = r % nwl ;
+            double wl = wavelength(j) ;
+            for(int k=0 ; k < nct ; k++)
+            {
+                calc( asrs, cat, wl, minus_cos_theta(half, k) );
+                for(int c=0 ; c < 4 ; c++) aa[(r*nct + k)*4 + c] = asrs[c] ;
+            }
+            if( half == 0 )
+            {
+                calc( asrs, cat, wl, -1. );
+                double A_normal = 0.5*(asrs[0] + asrs[1]) ;
+                ee[cat*nwl + j] = qeshape && A_normal > 0. ? qeshape(cat, hc_eVnm/wl)/A_normal : 0. ;
+            }
+        }
+    }, 1 );
+
+    art->set_meta<double>("wl0", wl0 );
+    art->set_meta<double>("wl1", wl1 );
+    art->set_meta<double>("ct_eps", CT_EPS );
+    art->set_meta<int>("nwl", nwl );
+    art->set_meta<int>("nct", nct );
+}
+
+/**
+stmm_table::measure
+---------------------
+
+Maximum absolute deviation of the interpolated A_s,A_p,R_s,R_p from
+the direct calculation for each category at:
+
+0. cell centres
+1. wavelength midpoints at cos_theta nodes
+2. cos_theta midpoints at wavelength nodes
+
+The per point maximum over components is kept to form the fallback
+ranges, a cell (j,k) takes the maximum of its centre, its two cos_theta
+edge midpoints at wavelength nodes j and j+1 and its two wavelength edge
+midpoints at cos_theta nodes k and k+1.
+
+**/
+
+inline void stmm_table::measure()
+{
+    delete err ;
+    delete fbk ;
+    err = NP::Make<double>( ncat, 3, 4 );
+    fbk = NP::Make<unsigned char>( ncat, 2, nwl-1, nct-1 );
+    double* ee = err->values<double>() ;
+    unsigned char* ff = fbk->values<unsigned char>() ;
+
+    int num_row = ncat*2*nwl ;
+    std::vector<double> rerr( num_row*3*4, 0. );
+    std::vector<double> perr( num_row*3*nct, 0. );    // per point max over components
+
+    sthread::ParallelFor( num_row, [&](int, int64_t r0, int64_t r1)
+    {
+        double direct[4], interp[4] ;
+        for(int64_t r=r0 ; r < r1 ; r++)
+        {
+            int cat = r/(2*nwl) ;
+            int half = (r/nwl) % 2 ;
+            int j = r % nwl ;
+            double* re = rerr.data() + r*3*4 ;
+            for(int k=0 ; k < nct ; k++)
+            {
+                double jj[3] = { j + 0.5, j + 0.5, double(j) } ;
+                double kk[3] = { k + 0.5, double(k), k + 0.5 } ;
+                for(int m=0 ; m < 3 ; m++)
+                {
+                    if( jj[m] > nwl - 1 || kk[m] > nct - 1 ) continue ;
+                    double wl = wavelength(jj[m]) ;
+                    double mct = minus_cos_theta(half, kk[m]) ;
+                    calc( direct, cat, wl, mct );
+                    lookup_asrs( interp, cat, wl, mct );
+                    double& pe = perr[(r*3 + m)*nct + k] ;
+                    for(int c=0 ; c < 4 ; c++)
+                    {
+                        double e = std::abs(direct[c] - interp[c]) ;
+                        re[m*4+c] = std::max( re[m*4+c], e );
+                        pe = std::max( pe, e );
+                    }
+                }
+            }
+        }
+    }, 1 );
+
+    for(int r=0 ; r < num_row ; r++)
+    {
+        int cat = r/(2*nwl) ;
+        for(int i=0 ; i < 3*4 ; i++) ee[cat*3*4+i] = std::max( ee[cat*3*4+i], rerr[r*3*4+i] );
+    }
+
+    err_table = 0. ;
+    std::vector<double> cerr(nct-1) ;
+    for(int r=0 ; r < num_row ; r++)
+    {
+        int j = r % nwl ;
+        if( j == nwl - 1 ) continue ;
+        int ch = r/nwl ;      // (cat, half)
+        unsigned char* f = ff + (ch*(nwl-1) + j)*(nct-1) ;
+        for(int k=0 ; k < nct - 1 ; k++)
+        {
+            cerr[k] = std::max({ perr[(r*3 + 0)*nct + k],
+                                 perr[(r*3 + 2)*nct + k],
+                                 perr[((r+1)*3 + 2)*nct + k],
+                                 perr[(r*3 + 1)*nct + k],
+                                 perr[(r*3 + 1)*nct + k + 1] }) ;
+            if( tol <= 0. || cerr[k] <= FBK_SAFETY*tol ) continue ;
+            for(int d=-1 ; d <= 1 ; d++) if( k+d >= 0 && k+d < nct - 1 ) f[k+d] = 1 ;
+        }
+        for(int k=0 ; k < nct - 1 ; k++) if( f[k] == 0 ) err_table = std::max( err_table, cerr[k] );
+    }
+
+    art->set_meta<double>("tol", tol );
+    art->set_meta<double>("max_err", max_err_table() );
+    art->set_meta<double>("max_err_raw", max_err(0) );
+    art->set_meta<double>("fbk_fraction", fbk_fraction() );
+}
+
+inline double stmm_table::max_err(int row) const
+{
+    const double* ee = err->cvalues<double>() ;
+    double mx = 0. ;
+    for(int cat=0 ; cat < ncat ; cat++)
+    for(int c=0 ; c < 4 ; c++) mx = std::max( mx, ee[(cat*3+row)*4+c] );
+    return mx ;
+}
+
+/**
+stmm_table::max_err_table
+---------------------------
+
+Max error of the measured points in the cells that do not fall back,
+at most FBK_SAFETY*tol. Between the measured points the error can be
+larger, hence the safety factor.
+
+**/
+
+inline double stmm_table::max_err_table() const
+{
+    return err_table ;
+}
+
+inline double stmm_table::fbk_fraction() const
+{
+    const unsigned char* ff = fbk->cvalues<unsigned char>() ;
+    int64_t num_cell = fbk->num_values() ;
+    int64_t num_fbk = 0 ;
+    for(int64_t i=0 ; i < num_cell ; i++) num_fbk += ff[i] ;
+    return num_cell > 0 ? double(num_fbk)/double(num_cell) : 0. ;
+}
+
+/**
+stmm_table::fallback
+----------------------
+
+Host reference of the fbk check done by qpmt::get_lpmtcat_ASRS_table,
+true when the cell containing the point is to use the exact calculation.
+
+**/
+
+inline bool stmm_table::fallback(int cat, double wavelength_nm, double mct) const
+{
+    int half = mct < 0. ? 0 : 1 ;
+    double fw = (wavelength_nm - wl0)/(wl1 - wl0)*double(nwl-1) ;
+    double fc = std::abs(mct)*double(nct-1) ;
+    fw = std::min( std::max( fw, 0. ), double(nwl-1) );
+    fc = std::min( std::max( fc, 0. ), double(nct-1) );
+    int iw = std::min( int(fw), nwl - 2 ) ;
+    int ic = std::min( int(fc), nct - 2 ) ;
+    return fbk->cvalues<unsigned char>()[((cat*2 + half)*(nwl-1) + iw)*(nct-1) + ic] != 0 ;
+}
+
+/**
+stmm_table::lookup_asrs
+-------------------------
+
+Host reference of the bilinear interpolation done by qpmt::get_lpmtcat_ASRS_table
+
+**/
+
+inline void stmm_table::lookup_asrs(double* asrs, int cat, double wavelength_nm, double mct) const
+{
+    int half = mct < 0. ? 0 : 1 ;
+    double fw = (wavelength_nm - wl0)/(wl1 - wl0)*double(nwl-1) ;
+    double fc = std::abs(mct)*double(nct-1) ;
+    fw = std::min( std::max( fw, 0. ), double(nwl-1) );
+    fc = std::min( std::max( fc, 0. ), double(nct-1) );
+    int iw = std::min( int(fw), nwl - 2 ) ;
+    int ic = std::min( int(fc), nct - 2 ) ;
+    double tw = fw - iw ;
+    double tc = fc - ic ;
+
+    const float* aa = art->cvalues<float>() + ((cat*2 + half)*nwl + iw)*nct*4 ;
+    for(int c=0 ; c < 4 ; c++)
+    {
+        double v00 = aa[(ic+0)*4+c] ;
+        double v01 = aa[(ic+1)*4+c] ;
+        double v10 = aa[(nct + ic+0)*4+c] ;
+        double v11 = aa[(nct + ic+1)*4+c] ;
+        asrs[c] = (1.-tw)*((1.-tc)*v00 + tc*v01) + tw*((1.-tc)*v10 + tc*v11) ;
+    }
+}
+
+inline void stmm_table::lookup_art(double* art3, int cat, double wavelength_nm, double mct, double dot_pol_cross_mom_nrm) const
+{
+    double asrs[4] ;
+    lookup_asrs( asrs, cat, wavelength_nm, mct );
+    Mix( art3, asrs, mct, dot_pol_cross_mom_nrm );
+}
+
+inline void stmm_table::Mix(double* art3, const double* asrs, double mct, double dot_pol_cross_mom_nrm ) // static
+{
+    double st2 = 1. - mct*mct ;
+    double E_s2 = st2 > 0. ? dot_pol_cross_mom_nrm*dot_pol_cross_mom_nrm/st2 : 0. ;
+    E_s2 = std::min( E_s2, 1. );
+    art3[0] = E_s2*asrs[0] + (1. - E_s2)*asrs[1] ;
+    art3[1] = E_s2*asrs[2] + (1. - E_s2)*asrs[3] ;
+    art3[2] = 1. - art3[0] - art3[1] ;
+}
+
+inline std::string stmm_table::desc() const
+{
+    std::stringstream ss ;
+    ss << "stmm_table::desc"
+       << " ncat " << ncat
+       << " nwl " << nwl
+       << " nct " << nct
+       << " wl0 " << wl0
+       << " wl1 " << wl1
+       << " tol " << tol
+       << " fbk_fraction " << ( fbk ? fbk_fraction() : 0. )
+       << " art " << ( art ? art->sstr() : "-" )
+       << " esc " << ( esc ? esc->sstr() : "-" )
+       << "\n"
+       ;
+    const double* ee = err ? err->cvalues<double>() : nullptr ;
+    const char* label[3] = { "centre", "wl_mid", "ct_mid" } ;
+    for(int cat=0 ; cat < ncat && ee ; cat++)
+    for(int m=0 ; m < 3 ; m++)
+    {
+        ss << " cat " << cat << " " << label[m] << " max_err A_s,A_p,R_s,R_p" ;
+        for(int c=0 ; c < 4 ; c++) ss << " " << std::scientific << std::setprecision(2) << ee[(cat*3+m)*4+c] ;
+        ss << "\n" ;
+    }
+    std::string str = ss.str();
+    return str ;
+}
@@ -208,6 +208,7 @@ When SSim not in use can also use::
 #include <sstream>
 #include <map>
 #include <functional>
+#include <atomic>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -249,6 +250,7 @@ When SSim not in use can also use::
 #include "sphoton.h"
 #include "sphotonlite.h"
 #include "sphit.h"
+#include "slocalize.h"
 
 
 
@@ -413,6 +415,7 @@ struct stree
     std::vector<glm::tmat4x4<float>>  inst_f4 ;
     std::vector<glm::tmat4x4<double>> iinst ;
     std::vector<glm::tmat4x4<float>>  iinst_f4 ;
+    uint64_t                          iinst_stamp ;   // process unique, renewed when iinst changes, see stree::Stamp
 
     std::vector<int4>                 inst_info ;
     std::vector<int>                  inst_nidx ;
@@ -423,6 +426,7 @@ struct stree
     const char*                       loaddir ;
 
     stree();
+    static uint64_t Stamp();
 
     void init();
     void set_level(int level_);
@@ -929,11 +933,29 @@ inline stree::stree()
     surface(new NPFold),
     mesh(new NPFold),
     MOI(ssys::getenvvar("MOI", "0:0:-1")),
+    iinst_stamp(Stamp()),
     loaddir(nullptr)
 {
     init();
 }
 
+/**
+stree::Stamp
+--------------
+
+Process unique stamp used to key state derived from iinst, such as the
+slocalize affines of SEvt::get_localizer. Unlike the address of iinst
+it is not reused by a different stree allocated at the same address.
+The stamp is renewed by add_inst, clear_inst and import_.
+
+**/
+
+inline uint64_t stree::Stamp() // static
+{
+    static std::atomic<uint64_t> count(0) ;
+    return ++count ;
+}
+
 inline void stree::init()
 {
     if(level > 0) std::cout
@@ -5054,6 +5076,7 @@ inline void stree::import_(const NPFold* fold)
 
     ImportArray<glm::tmat4x4<double>, double>(inst,   fold->get(INST), INST);
     ImportArray<glm::tmat4x4<double>, double>(iinst,  fold->get(IINST), IINST);
+    iinst_stamp = Stamp();
     ImportArray<glm::tmat4x4<float>, float>(inst_f4,  fold->get(INST_F4), INST_F4);
     ImportArray<glm::tmat4x4<float>, float>(iinst_f4, fold->get(IINST_F4), IINST_F4);
 
@@ -6658,6 +6681,7 @@ inline void stree::add_inst(
 
     inst.push_back(tr_m2w);
     iinst.push_back(tr_w2m);
+    iinst_stamp = Stamp();
 
     inst_nidx.push_back(nidx);
 }
@@ -6828,6 +6852,7 @@ inline void stree::clear_inst()
     iinst.clear();
     inst_f4.clear();
     iinst_f4.clear();
+    iinst_stamp = Stamp();
 }
 
 inline std::string stree::desc_inst() const
@@ -7937,16 +7962,17 @@ Note that the corresponding strid::Encode into the transform
 is done by the above stree::add_inst
 
 
-TODO : multiple-photon localization optimization
-~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+Multiple-photon localization
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-GPU hit merging increases the usefulness of grouped localization
-as the hits will arrive sorted by (pmtid, timebucket) so in big events
-there will be many contiguous hits that all need the same transform
+Uses slocalize.h which prepares the affines from iinst once and localizes
+the array across threads, looking up the affine only at transitions of iindex,
+so the contiguous hits from GPU hit merging sorted by (pmtid, timebucket)
+share it. Results are identical to localize_photon_inplace.
 
-sphoton::transform uses  Tran<double>::ApplyToFloat with count = 1, stride = 4*4
-arguments suggesting it may be quite straightforward to implement more efficient
-transformation just by finding the indices of transitions between pmtid
+Photons with unknown iindex are left in the global frame. Those and,
+with consistency_check, photons whose identity does not match that
+encoded in the transform are counted and reported.
 
 **/
 
@@ -7954,20 +7980,19 @@ inline NP* stree::localize_photon(const NP* photon, bool consistency_check ) con
 {
     if(!photon) return nullptr ;
     assert( photon->has_shape( -1, 4, 4 ) );
-    size_t num = photon->shape[0] ;
 
-    NP* local_photon = photon->copy();
-    sphoton* ll = (sphoton*)local_photon->bytes() ;
+    slocalize loc(iinst) ;
+    size_t num_bad = 0 ;
+    NP* local_photon = loc.localize( photon, nullptr, consistency_check, &num_bad );
+
+    if(num_bad > 0) std::cerr
+        << "stree::localize_photon"
+        << " num_bad " << num_bad
+        << " of " << photon->shape[0]
+        << " consistency_check " << ( consistency_check ? "YES" : "NO " )
+        << "\n"
+        ;
 
-    for(size_t i=0 ; i < num ; i++)
-    {
-        sphoton& l = ll[i] ; // start with global frame fields
-        localize_photon_inplace(l);
-#ifdef NDEBUG
-#else
-        if(consistency_check) transform_consistency_check(l);
-#endif
-    }
     return local_photon ;
 }
 
@@ -0,0 +1,289 @@
+#pragma once
+/**
+sxorwow.h : host side curand_init for curandStateXORWOW using GF(2) jump matrices
+====================================================================================
+
+Reproduces on the CPU the state that the device call::
+
+    curand_init(seed, subsequence, offset, &state)
+
+leaves in a curandStateXORWOW, bit for bit, allowing SCurandChunk files to be
+generated without a GPU, see SCurandState::generate.
+
+The five word xorshift part of XORWOW is linear over GF(2) so advancing by
+n draws is multiplication of the 160 bit state by the 160x160 bit matrix M^n.
+Like curand_precalc.h the powers are tabulated, here computed at first use
+by repeated squaring of the one step matrix M::
+
+    off[k] = M^(2^k)          k = 0..63   skipahead(offset)
+    seq[k] = M^(2^(67+k))     k = 0..63   skipahead_sequence(subsequence), 2^67 draws per subsequence
+
+As matrix powers commute the order of application does not matter, so the
+result is identical to curand whatever block scheme its precalc tables use.
+The Weyl counter d is only advanced by offset, as 362437*2^67 is 0 mod 2^32.
+
+Consecutive subsequences differ by one seq[0] multiplication, so chunks
+of states for consecutive ids are generated with one full init per thread
+followed by a byte table (20 lookups of 256 entries) application of seq[0]
+per state.
+
+::
+
+    ~/o/sysrap/tests/sxorwow_test.sh
+
+**/
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sstream>
+
+#include "sthread.h"
+
+struct sxorwow
+{
+    typedef unsigned long long ULL ;
+    static constexpr const int NW = 5 ;            // words of xorshift state
+    static constexpr const int NB = 32*NW ;        // bits of xorshift state
+    static constexpr const int NBYTE = 4*NW ;
+    static constexpr const unsigned WEYL = 362437u ;
+    static constexpr const int SEQ_SHIFT = 67 ;
+
+    struct Mat { unsigned col[NB][NW] ; } ;     // col[j] is the image of bit j
+    struct Tab { unsigned t[NBYTE][256][NW] ; } ;
+
+    Mat off[64] ;
+    Mat seq[64] ;
+    Tab seq0 ;
+
+    static const sxorwow* Get();
+
+    static void Step( unsigned v[NW] );
+    static void MatVec( unsigned v[NW], const Mat& m );
+    static void TabVec( unsigned v[NW], const Tab& t );
+    static void MatMul( Mat& c, const Mat& a, const Mat& b );
+    static void Identity( Mat& m );
+    static void OneStep( Mat& m );
+    static void MakeTab( Tab& t, const Mat& m );
+
+    static void Seed( unsigned& d, unsigned v[NW], ULL seed );
+
+    sxorwow();
+
+    void skipahead( ULL n, unsigned& d, unsigned v[NW] ) const ;
+    void skipahead_sequence( ULL n, unsigned v[NW] ) const ;
+    void next_sequence( unsigned v[NW] ) const ;
+
+    template<typename S> void curand_init( ULL seed, ULL subsequence, ULL offset, S* s ) const ;
+    template<typename S> int  init_states( S* states, ULL num, ULL seed, ULL id0, ULL offset, int num_thread=0 ) const ;
+
+    std::string desc() const ;
+};
+
+/**
+sxorwow::Get
+--------------
+
+Table construction is around 250 squarings of 160x160 bit matrices, a few ms.
+
+**/
+
+inline const sxorwow* sxorwow::Get() // static
+{
+    static sxorwow* INSTANCE = new sxorwow ;
+    return INSTANCE ;
+}
+
+/**
+sxorwow::Step
+---------------
+
+The linear part of curand(curandStateXORWOW*) without the Weyl counter.
+
+**/
+
+inline void sxorwow::Step( unsigned v[NW] ) // static
+{
+    unsigned t = v[0] ^ (v[0] >> 2) ;
+    v[0] = v[1] ;
+    v[1] = v[2] ;
+    v[2] = v[3] ;
+    v[3] = v[4] ;
+    v[4] = (v[4] ^ (v[4] << 4)) ^ (t ^ (t << 1)) ;
+}
+
+inline void sxorwow::MatVec( unsigned v[NW], const Mat& m ) // static
+{
+    unsigned r[NW] = {} ;
+    for(int w=0 ; w < NW ; w++)
+    {
+        unsigned x = v[w] ;
+        while(x)
+        {
+            int b = __builtin_ctz(x) ;
+            const unsigned* c = m.col[32*w+b] ;
+            for(int k=0 ; k < NW ; k++) r[k] ^= c[k] ;
+            x &= x - 1u ;
+        }
+    }
+    for(int k=0 ; k < NW ; k++) v[k] = r[k] ;
+}
+
+inline void sxorwow::TabVec( unsigned v[NW], const Tab& t ) // static
+{
+    unsigned r[NW] = {} ;
+    for(int i=0 ; i < NBYTE ; i++)
+    {
+        const unsigned* e = t.t[i][(v[i/4] >> (8*(i%4))) & 0xffu] ;
+        for(int k=0 ; k < NW ; k++) r[k] ^= e[k] ;
+    }
+    for(int k=0 ; k < NW ; k++) v[k] = r[k] ;
+}
+
+inline void sxorwow::MatMul( Mat& c, const Mat& a, const Mat& b ) // static
+{
+    for(int j=0 ; j < NB ; j++)
+    {
+        for(int k=0 ; k < NW ; k++) c.col[j][k] = b.col[j][k] ;
+        MatVec( c.col[j], a );
+    }
+}
+
+inline void sxorwow::Identity( Mat& m ) // static
+{
+    memset( &m, 0, sizeof(Mat) );
+    for(int j=0 ; j < NB ; j++) m.col[j][j/32] = 1u << (j%32) ;
+}
+
+inline void sxorwow::OneStep( Mat& m ) // static
+{
+    Identity(m);
+    for(int j=0 ; j < NB ; j++) Step( m.col[j] );
+}
+
+inline void sxorwow::MakeTab( Tab& t, const Mat& m ) // static
+{
+    for(int i=0 ; i < NBYTE ; i++)
+    for(int x=0 ; x < 256 ; x++)
+    {
+        unsigned* e = t.t[i][x] ;
+        for(int k=0 ; k < NW ; k++) e[k] = 0u ;
+        for(int b=0 ; b < 8 ; b++)
+        {
+            if(((x >> b) & 1) == 0) continue ;
+            const unsigned* c = m.col[8*i+b] ;
+            for(int k=0 ; k < NW ; k++) e[k] ^= c[k] ;
+        }
+    }
+}
+
+/**
+sxorwow::Seed
+---------------
+
+As the start of _curand_init_scratch for curandStateXORWOW.
+
+**/
+
+inline void sxorwow::Seed( unsigned& d, unsigned v[NW], ULL seed ) // static
+{
+    unsigned s0 = unsigned(seed) ^ 0xaad26b49u ;
+    unsigned s1 = unsigned(seed >> 32) ^ 0xf7dcefddu ;
+    unsigned t0 = 1099087573u * s0 ;
+    unsigned t1 = 2591861531u * s1 ;
+    d    = 6615241u + t1 + t0 ;
+    v[0] = 123456789u + t0 ;
+    v[1] = 362436069u ^ t0 ;
+    v[2] = 521288629u + t1 ;
+    v[3] = 88675123u ^ t1 ;
+    v[4] = 5783321u + t0 ;
+}
+
+inline sxorwow::sxorwow()
+{
+    OneStep( off[0] );
+    for(int k=1 ; k < 64 ; k++) MatMul( off[k], off[k-1], off[k-1] );
+
+    Mat a, b ;
+    MatMul( a, off[63], off[63] );   // M^(2^64)
+    MatMul( b, a, a );
+    MatMul( a, b, b );
+    MatMul( seq[0], a, a );          // M^(2^67)
+    for(int k=1 ; k < 64 ; k++) MatMul( seq[k], seq[k-1], seq[k-1] );
+
+    MakeTab( seq0, seq[0] );
+}
+
+inline void sxorwow::skipahead( ULL n, unsigned& d, unsigned v[NW] ) const
+{
+    for(int k=0 ; k < 64 ; k++) if((n >> k) & 1ull) MatVec( v, off[k] );
+    d += WEYL*unsigned(n) ;
+}
+
+inline void sxorwow::skipahead_sequence( ULL n, unsigned v[NW] ) const
+{
+    for(int k=0 ; k < 64 ; k++) if((n >> k) & 1ull) MatVec( v, seq[k] );
+}
+
+inline void sxorwow::next_sequence( unsigned v[NW] ) const
+{
+    TabVec( v, seq0 );
+}
+
+/**
+sxorwow::curand_init
+----------------------
+
+S is curandStateXORWOW or any struct with the same members.
+
+**/
+
+template<typename S>
+inline void sxorwow::curand_init( ULL seed, ULL subsequence, ULL offset, S* s ) const
+{
+    Seed( s->d, s->v, seed );
+    skipahead_sequence( subsequence, s->v );
+    skipahead( offset, s->d, s->v );
+    s->boxmuller_flag = 0 ;
+    s->boxmuller_flag_double = 0 ;
+    s->boxmuller_extra = 0.f ;
+    s->boxmuller_extra_double = 0. ;
+}
+
+/**
+sxorwow::init_states
+----------------------
+
+Equivalent of the QCurandState.cu kernel for subsequences id0..id0+num-1,
+sharded over threads with sthread::ParallelFor. Returns the number of shards.
+
+**/
+
+template<typename S>
+inline int sxorwow::init_states( S* states, ULL num, ULL seed, ULL id0, ULL offset, int num_thread ) const
+{
+    return sthread::ParallelFor( int64_t(num), [&](int, int64_t i0, int64_t i1)
+    {
+        if( i0 >= i1 ) return ;
+        curand_init( seed, id0 + ULL(i0), offset, states + i0 );
+        for(int64_t i=i0+1 ; i < i1 ; i++)
+        {
+            const S& p = states[i-1] ;
+            S& s = states[i] ;
+            s = p ;
+            next_sequence( s.v );
+        }
+    }, 1 << 14, num_thread );
+}
+
+inline std::string sxorwow::desc() const
+{
+    std::stringstream ss ;
+    ss << "sxorwow::desc"
+       << " sizeof(Mat) " << sizeof(Mat)
+       << " sizeof(Tab) " << sizeof(Tab)
+       << " num_off 64 num_seq 64 SEQ_SHIFT " << SEQ_SHIFT
+       ;
+    std::string str = ss.str();
+    return str ;
+}
@@ -0,0 +1,310 @@
+/**
+SGenstepServer_test.cc
+========================
+
+Mock simulator gives every photon a hit unless its global index is 3 mod 4,
+with the hit position carrying the genstep tag and the index within the
+genstep. Clients check they get back exactly their own hits with request
+relative indices, whether or not the server coalesced their requests.
+
+**/
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "SGenstepServer.h"
+
+struct MockSimulator
+{
+    bool lite ;
+    std::atomic<int> num_call ;
+    std::atomic<int> max_gs ;
+
+    MockSimulator(bool lite_=false) : lite(lite_), num_call(0), max_gs(0) {}
+
+    NP* simulate(NP* gs, int eventID)
+    {
+        assert( gs->get_meta<int>("eventID", -1) == eventID );
+        num_call++ ;
+        if( gs->shape[0] > max_gs ) max_gs = gs->shape[0] ;
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+
+        const quad6* qq = (const quad6*)gs->cvalues<float>() ;
+        std::vector<sphoton> hh ;
+        uint64_t idx = 0 ;
+        for(int g=0 ; g < gs->shape[0] ; g++)
+        {
+            int num = SGenstep::GetNumPhoton(qq[g]) ;
+            for(int j=0 ; j < num ; j++)
+            {
+                if( idx % 4 != 3 )
+                {
+                    sphoton p = {} ;
+                    p.pos.x = qq[g].q1.f.x ;
+                    p.pos.y = j ;
+                    p.set_index(idx) ;
+                    hh.push_back(p) ;
+                }
+                idx++ ;
+            }
+        }
+        if( lite ) return NP::Make<float>( hh.size(), 4 );  // no index, cannot be routed
+        NP* ht = NP::Make<float>( hh.size(), 4, 4 );
+        ht->read2<float>( (float*)hh.data() );
+        return ht ;
+    }
+};
+
+
+/**
+MakeGenstep
+------------
+
+num_gs gensteps with num_photon varying per genstep and tag in q1.x
+
+**/
+
+NP* MakeGenstep(int client, int eventID, std::vector<int>& num_ph )
+{
+    int num_gs = 1 + (client + eventID) % 4 ;
+    NP* gs = NP::Make<float>(num_gs, 6, 4);
+    quad6* qq = (quad6*)gs->values<float>() ;
+    num_ph.resize(num_gs);
+    for(int g=0 ; g < num_gs ; g++)
+    {
+        num_ph[g] = 10 + 7*client + 3*eventID + g ;
+        qq[g].q0.u.w = num_ph[g] ;
+        qq[g].q1.f.x = float(client*10000 + eventID*100 + g) ;
+    }
+    return gs ;
+}
+
+/**
+Check
+------
+
+Expected hits are the photons that are not 3 mod 4 in the global index,
+which depends on the position of the request within the batch, so here
+only check consistency : every hit belongs to this request, indices are
+request relative, strictly increasing and all within range.
+
+**/
+
+int Check(const NP* ht, int client, int eventID, const std::vector<int>& num_ph, bool lite )
+{
+    int tot = 0 ;
+    for(int n : num_ph) tot += n ;
+    if( ht == nullptr ) return 1 ;
+    if( ht->get_meta<int>("eventID", -1) != eventID ) return 2 ;
+    if( lite ) return 0 ;
+    if( !ht->has_shape(-1,4,4) ) return 3 ;
+
+    int num_hit = ht->shape[0] ;
+    int min_hit = (3*tot)/4 - 1 ;
+    int max_hit = (3*tot)/4 + 1 ;
+    if( num_hit < min_hit || num_hit > max_hit ) return 4 ;
+
+    const sphoton* hh = (const sphoton*)ht->cvalues<float>() ;
+    int64_t prev = -1 ;
+    for(int i=0 ; i < num_hit ; i++)
+    {
+        const sphoton& p = hh[i] ;
+        int64_t idx = p.get_index() ;
+        if( idx <= prev || idx >= tot ) return 5 ;
+        prev = idx ;
+
+        int g = 0 ;
+        int64_t start = 0 ;
+        while( idx >= start + num_ph[g] ) start += num_ph[g++] ;
+        float tag = float(client*10000 + eventID*100 + g) ;
+        if( p.pos.x != tag ) return 6 ;
+        if( int64_t(p.pos.y) != idx - start ) return 7 ;
+    }
+    return 0 ;
+}
+
+template<typename S>
+int Clients(SGenstepServer<S>& svr, int num_client, int num_event, int client_offset, bool lite )
+{
+    std::atomic<int> rc(0) ;
+    std::vector<std::thread> tt ;
+    for(int c=0 ; c < num_client ; c++)
+    {
+        tt.emplace_back([&, c]{
+            int client = client_offset + c ;
+            SGenstepClient cli(svr.addr.c_str()) ;
+            if(!cli.is_connected()) { rc += 100 ; return ; }
+            for(int e=0 ; e < num_event ; e++)
+            {
+                std::vector<int> num_ph ;
+                NP* gs = MakeGenstep(client, e, num_ph) ;
+                NP* ht = cli.simulate(gs, e) ;
+                int chk = Check(ht, client, e, num_ph, lite) ;
+                if(chk) std::cerr << "Clients FAIL client " << client << " event " << e << " chk " << chk << "\n" ;
+                rc += chk ;
+                delete gs ;
+                delete ht ;
+            }
+        });
+    }
+    for(auto& t : tt) t.join();
+    return rc ;
+}
+
+int test_unix()
+{
+    MockSimulator sim ;
+    SGenstepServer<MockSimulator> svr(&sim, "unix:/tmp/SGenstepServer_test.sock") ;
+    if(!svr.start()) return 1 ;
+    int rc = Clients(svr, 8, 10, 0, false) ;
+    svr.stop();
+    std::cout << "test_unix rc " << rc << " num_call " << sim.num_call << " max_gs " << sim.max_gs << "\n" << svr.desc() ;
+    assert( svr.num_request == 80 );
+    return rc ;
+}
+
+int test_tcp()
+{
+    MockSimulator sim ;
+    SGenstepServer<MockSimulator> svr(&sim, "tcp:127.0.0.1:0") ;
+    if(!svr.start()) return 1 ;
+    int rc = Clients(svr, 4, 10, 100, false) ;
+    svr.stop();
+    std::cout << "test_tcp rc " << rc << " num_call " << sim.num_call << "\n" << svr.desc() ;
+    return rc ;
+}
+
+int test_lite()
+{
+    MockSimulator sim(true) ;
+    SGenstepServer<MockSimulator> svr(&sim, "unix:/tmp/SGenstepServer_test_lite.sock") ;
+    if(!svr.start()) return 1 ;
+    int rc = Clients(svr, 4, 5, 0, true) ;
+    svr.stop();
+    std::cout << "test_lite rc " << rc << " num_call " << sim.num_call << "\n" << svr.desc() ;
+    return rc ;
+}
+
+/**
+test_merge
+------------
+
+With ModeMerge the hits cannot be routed, so the server does not
+coalesce and every request gets its own launch.
+
+**/
+
+int test_merge()
+{
+    SEventConfig::SetModeMerge(1);
+    MockSimulator sim ;
+    SGenstepServer<MockSimulator> svr(&sim, "unix:/tmp/SGenstepServer_test_merge.sock") ;
+    int rc = svr.start() ? 0 : 1 ;
+    if( rc == 0 ) rc += Clients(svr, 4, 5, 0, false) ;
+    svr.stop();
+    SEventConfig::SetModeMerge(0);
+    std::cout << "test_merge rc " << rc << " num_call " << sim.num_call << "\n" << svr.desc() ;
+    if( svr.coalesce ) rc += 1 ;
+    if( sim.num_call != svr.num_request ) rc += 1 ;
+    return rc ;
+}
+
+/**
+test_reap
+-----------
+
+Sequential clients that each disconnect, the connection threads of the
+earlier clients are joined and removed as later clients connect.
+
+**/
+
+int test_reap()
+{
+    MockSimulator sim ;
+    SGenstepServer<MockSimulator> svr(&sim, "unix:/tmp/SGenstepServer_test_reap.sock") ;
+    if(!svr.start()) return 1 ;
+    int rc = 0 ;
+    for(int c=0 ; c < 20 ; c++) rc += Clients(svr, 1, 2, c, false) ;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    Clients(svr, 1, 1, 20, false) ;
+    size_t num_conn = 0 ;
+    {
+        std::lock_guard<std::mutex> lk(svr.mtx);
+        num_conn = svr.conns.size() ;
+    }
+    svr.stop();
+    std::cout << "test_reap rc " << rc << " num_conn " << num_conn << "\n" ;
+    if( num_conn > 2 ) rc += 1 ;
+    return rc ;
+}
+
+/**
+test_stop
+-----------
+
+Submit after stop is rejected rather than blocking forever.
+
+**/
+
+int test_stop()
+{
+    MockSimulator sim ;
+    SGenstepServer<MockSimulator> svr(&sim, "unix:/tmp/SGenstepServer_test_stop.sock") ;
+    if(!svr.start()) return 1 ;
+    svr.stop();
+    std::vector<int> num_ph ;
+    NP* ht = svr.submit( MakeGenstep(0, 0, num_ph), 0 );
+    std::cout << "test_stop ht " << ( ht ? ht->sstr() : "-" ) << "\n" ;
+    return ht == nullptr ? 0 : 1 ;
+}
+
+/**
+test_route_bad
+----------------
+
+Hit with photon index beyond the batch is reported, not asserted.
+
+**/
+
+int test_route_bad()
+{
+    std::vector<int> num_ph ;
+    SGenstepRequest a, b ;
+    a.gs = MakeGenstep(0, 0, num_ph) ; a.num_photon = SGenstep::GetPhotonTotal(a.gs) ;
+    b.gs = MakeGenstep(1, 0, num_ph) ; b.num_photon = SGenstep::GetPhotonTotal(b.gs) ;
+    std::vector<SGenstepRequest*> batch = { &a, &b } ;
+    std::vector<uint64_t> p0 ;
+    NP* gs = SGenstepServer<MockSimulator>::Combine(batch, p0);
+
+    NP* ht = NP::Make<float>(2, 4, 4);
+    sphoton* hh = (sphoton*)ht->values<float>() ;
+    hh[0].set_index(0) ;
+    hh[1].set_index(p0.back() + 5) ;
+
+    std::vector<NP*> out ;
+    int num_bad = SGenstepServer<MockSimulator>::Route(ht, batch, p0, out);
+    std::cout << "test_route_bad num_bad " << num_bad << " out " << out.size() << "\n" ;
+    delete gs ;
+    delete ht ;
+    delete a.gs ;
+    delete b.gs ;
+    return num_bad == 1 && out.empty() ? 0 : 1 ;
+}
+
+int main()
+{
+    int rc = 0 ;
+    rc += test_unix();
+    rc += test_tcp();
+    rc += test_lite();
+    rc += test_merge();
+    rc += test_reap();
+    rc += test_stop();
+    rc += test_route_bad();
+    std::cout << "SGenstepServer_test rc " << rc << "\n" ;
+    return rc == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,42 @@
+#!/bin/bash
+usage(){ cat << EOU
+SGenstepServer_test.sh
+========================
+
+Loopback test of SGenstepServer.h batching and hit routing using a mock
+simulator, with concurrent clients over unix domain and TCP sockets::
+
+    ~/o/sysrap/tests/SGenstepServer_test.sh
+    SGenstepServer__WINDOW_US=0 ~/o/sysrap/tests/SGenstepServer_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=SGenstepServer_test
+bin=/tmp/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+defarg=info_build_run
+arg=${1:-$defarg}
+
+vars="BASH_SOURCE defarg arg name bin CUDA_PREFIX"
+
+if [ "${arg/info}" != "$arg" ]; then
+    for var in $vars ; do printf "%20s : %s\n" "$var" "${!var}" ; done
+fi
+
+if [ "${arg/build}" != "$arg" ]; then
+   gcc $name.cc -std=c++17 -Wall -O2 -pthread -lstdc++ -lm -I.. -I$CUDA_PREFIX/include -I$OPTICKS_PREFIX/externals/glm/glm -I$OPTICKS_PREFIX/externals/plog/include -L$OPTICKS_PREFIX/lib64 -lSysRap -o $bin
+   [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+   $bin
+   [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
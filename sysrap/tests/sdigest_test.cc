@@ -3,6 +3,8 @@ sdigest_test.cc
 =================
 
 ~/o/sysrap/tests/sdigest_test.sh
+sdigest__MODE=fast ~/o/sysrap/tests/sdigest_test.sh
+TEST=bench MB=1024 ~/o/sysrap/tests/sdigest_test.sh
 
 
 When comparing with digests from files beware of the newline::
@@ -58,6 +60,7 @@ When comparing with digests from files beware of the newline::
 #include "sdigest.h"
 #include "ssys.h"
 #include "sstr.h"
+#include "sstamp.h"
 
 
 struct sdigest_test
@@ -67,6 +70,8 @@ struct sdigest_test
     static int int_();
     static int Desc();
     static int Hit();
+    static int fast();
+    static int bench();
 
     static int main();
 
@@ -147,7 +152,9 @@ int sdigest_test::hello()
     sstr::Write(path, m );
     dig[9] = sdigest::Path(path) ;
 
-    return compare("hello", dig, hello_digest );
+    bool md5 = sdigest::Mode() == sdigest::MD5 ;
+    if(!md5) dig[3] = dig[0] ;  // popen known digest is MD5
+    return compare("hello", dig, md5 ? hello_digest : nullptr );
 }
 
 int sdigest_test::int_()
@@ -193,6 +200,99 @@ int sdigest_test::Hit()
 
 
 
+/**
+sdigest_test::fast
+--------------------
+
+1. shash 64 bit matches XXH64 known values
+2. streaming in uneven pieces matches single add
+3. sdigest in FAST mode matches shash
+4. static Buf/BufRaw/Array entry points match the streaming digest
+   for buffers larger than 1MB, in whichever mode is configured
+
+**/
+
+int sdigest_test::fast()
+{
+    int rc = 0 ;
+    rc += shash::Buf64("", 0) == 0xef46db3751d8e999ULL ? 0 : 1 ;
+    rc += shash::Buf64("abc", 3) == 0x44bc2cf5ad770999ULL ? 0 : 1 ;
+
+    std::vector<char> buf(3*1000*1000 + 17) ;
+    for(size_t i=0 ; i < buf.size() ; i++) buf[i] = char( (i*2654435761u) >> 13 ) ;
+
+    shash h0 ;
+    h0.add( buf.data(), buf.size() );
+
+    shash h1 ;
+    for(size_t i=0 ; i < buf.size() ; i += 7 ) h1.add( buf.data() + i, std::min(size_t(7), buf.size() - i) );
+    rc += h0.hexdigest() == h1.hexdigest() ? 0 : 1 ;
+
+    sdigest d(sdigest::FAST) ;
+    d.add( buf.data(), buf.size() );
+    rc += d.finalize() == h0.hexdigest() ? 0 : 1 ;
+
+    NP* a = NP::Make<char>( buf.size() );
+    memcpy( a->bytes(), buf.data(), buf.size() );
+
+    sdigest s ;
+    s.add( buf.data(), buf.size() );
+    std::string ds = s.finalize();
+
+    sdigest r ;
+    r.add( buf.data(), buf.size() );
+    std::array<unsigned char,16> rs = r.finalize_raw();
+    std::string db = sdigest::Buf( buf.data(), buf.size() );
+    std::array<unsigned char,16> rb = sdigest::BufRaw( buf.data(), buf.size() );
+    std::string da = sdigest::Array( a );
+    rc += ds == db && db == da && rs == rb ? 0 : 1 ;
+    delete a ;
+
+    std::cout
+        << "sdigest_test::fast"
+        << " h0 " << h0.hexdigest()
+        << " " << sdigest::ModeName(sdigest::Mode()) << " " << ds
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc ;
+}
+
+/**
+sdigest_test::bench
+---------------------
+
+Throughput of MD5 against shash streaming digests
+
+**/
+
+int sdigest_test::bench()
+{
+    int64_t MB = ssys::getenvint("MB", 256) ;
+    NP* a = NP::Make<float>( MB*1024*1024/sizeof(float) ) ;
+    float* aa = a->values<float>();
+    for(int64_t i=0 ; i < a->num_values() ; i++) aa[i] = float(i) ;
+
+    int64_t t0 = sstamp::Now();
+    sdigest m(sdigest::MD5) ;
+    m.add( a->bytes(), a->arr_bytes() );
+    std::string dm = m.finalize();
+    int64_t t1 = sstamp::Now();
+    shash h ;
+    h.add( a->bytes(), a->arr_bytes() );
+    std::string dh = h.hexdigest();
+    int64_t t2 = sstamp::Now();
+
+    std::cout
+        << "sdigest_test::bench MB " << MB << "\n"
+        << " md5     " << dm << " " << std::setw(10) << double(MB)/(double(t1-t0)/1e6) << " MB/s\n"
+        << " shash   " << dh << " " << std::setw(10) << double(MB)/(double(t2-t1)/1e6) << " MB/s\n"
+        ;
+    delete a ;
+    return 0 ;
+}
+
+
 int sdigest_test::main()
 {
     const char* TEST = ssys::getenvvar("TEST", "ALL");
@@ -203,6 +303,8 @@ int sdigest_test::main()
     if(ALL||strcmp(TEST, "int_")==0)  rc += int_();
     if(ALL||strcmp(TEST, "Desc")==0)  rc += Desc();
     if(ALL||strcmp(TEST, "Hit")==0)   rc += Hit();
+    if(ALL||strcmp(TEST, "fast")==0)  rc += fast();
+    if(ALL||strcmp(TEST, "bench")==0) rc += bench();
 
     std::cout << "sdigest_test::main rc:" << rc << "\n" ;
     return rc ;
@@ -32,7 +32,7 @@ if [ "${arg/info}" != "$arg" ]; then
 fi 
 
 if [ "${arg/build}" != "$arg" ]; then
-   gcc $name.cc -std=c++11 -Wall -lstdc++ $opt -I.. -o $bin
+   gcc $name.cc -std=c++17 -Wall -O2 -pthread -lstdc++ $opt -I.. -o $bin
    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1 
 fi
 
@@ -0,0 +1,121 @@
+/**
+seventsplit_test.cc
+=====================
+
+Synthetic gensteps from interleaved G4 events, as collected when worker
+threads process events concurrently, and synthetic hits with photon index.
+The counting sort partition is compared with a std::stable_sort reference
+and the per event threadID with the thread assigned to each event.
+Single event sphotonlite or merged hits are accepted, multiple events refused.
+
+**/
+
+#include <cassert>
+#include <random>
+#include <iostream>
+#include "stimer.h"
+#include "ssys.h"
+#include "seventsplit.h"
+
+int main()
+{
+    int num_gs = ssys::getenvint("NUM_GS", 100000) ;
+    int num_evt = ssys::getenvint("NUM_EVT", 50) ;
+    int num_thr = ssys::getenvint("NUM_THR", 4) ;
+
+    std::mt19937_64 rng(42) ;
+    std::vector<int64_t> gs_offset(num_gs+1) ;
+    std::vector<int> gs_eventID(num_gs) ;
+    std::vector<int> gs_threadID(num_gs) ;
+    gs_offset[0] = 0 ;
+    for(int g=0 ; g < num_gs ; g++)
+    {
+        gs_eventID[g] = 1000 + int(rng() % num_evt) ;
+        gs_threadID[g] = gs_eventID[g] % num_thr ;
+        gs_offset[g+1] = gs_offset[g] + int64_t(rng() % 200) ;
+    }
+    int64_t num_photon = gs_offset[num_gs] ;
+
+    std::vector<sphoton> hh ;
+    for(int64_t i=0 ; i < num_photon ; i++)
+    {
+        if( rng() % 3 ) continue ;
+        sphoton p = {} ;
+        p.set_index(i) ;
+        p.time = float(i) ;
+        hh.push_back(p) ;
+    }
+    NP* hit = NP::Make<float>( hh.size(), 4, 4 );
+    hit->read2<float>( (float*)hh.data() );
+
+    stimer* t = stimer::create();
+    seventsplit* split = seventsplit::Create( hit, gs_offset.data(), gs_eventID.data(), num_gs, gs_threadID.data() );
+    double dt = t->done();
+    assert( split );
+    std::cout << split->desc() << " num_photon " << num_photon << " num_hit " << hh.size() << " dt " << dt << "\n" ;
+
+    auto evt = [&](const sphoton& p){ return gs_eventID[seventsplit::GenstepIndex(gs_offset.data(), num_gs, p.get_index())] ; } ;
+    std::vector<sphoton> ref(hh) ;
+    t = stimer::create();
+    std::stable_sort( ref.begin(), ref.end(), [&](const sphoton& a, const sphoton& b){ return evt(a) < evt(b) ; } );
+    std::cout << " std::stable_sort reference dt " << t->done() << "\n" ;
+
+    int rc = 0 ;
+    const sphoton* ss = split->hits(0) ;
+    for(size_t i=0 ; i < ref.size() ; i++) if( ss[i].get_index() != ref[i].get_index() ) rc += 1 ;
+
+    for(int e=0 ; e < split->num_event() ; e++)
+    {
+        int eventID = split->eventID[e] ;
+        assert( split->find(eventID) == e );
+        if( split->threadID[e] != eventID % num_thr ) rc += 1 ;
+        const sphoton* he = split->hits(e) ;
+        for(int64_t j=0 ; j < split->num_hit(e) ; j++) if( evt(he[j]) != eventID ) rc += 1 ;
+        NP* a = split->slice(e) ;
+        assert( a->shape[0] == split->num_hit(e) );
+        assert( a->get_meta<int>("eventID", -1) == eventID );
+        delete a ;
+    }
+    assert( split->find(-1) == -1 );
+
+    for(int64_t i=0 ; i < num_photon ; i += 7)   // zero photon gensteps resolve as std::upper_bound
+    {
+        int64_t g_ref = int64_t( std::upper_bound( gs_offset.begin(), gs_offset.end(), i ) - gs_offset.begin() ) - 1 ;
+        if( seventsplit::GenstepIndex(gs_offset.data(), num_gs, i) != g_ref ) rc += 1 ;
+    }
+    assert( seventsplit::GenstepIndex(gs_offset.data(), num_gs, num_photon) == -1 );
+
+    std::vector<int> slots ;
+    int num_slot = 0 ;
+    for(int tid=0 ; tid < num_thr ; tid++)
+    {
+        split->events_of_thread(slots, tid);
+        for(int e : slots) if( split->eventID[e] % num_thr != tid ) rc += 1 ;
+        num_slot += slots.size() ;
+    }
+    if( num_slot != split->num_event() ) rc += 1 ;
+
+    // sphotonlite hits lack the photon index : only a single event is accepted
+    NP* lhit = NP::Make<uint32_t>( 10, 4 ) ;
+    std::vector<int> one_eventID(num_gs, 7) ;
+    seventsplit* lsplit = seventsplit::Create( lhit, gs_offset.data(), one_eventID.data(), num_gs ) ;
+    seventsplit* lbad = seventsplit::Create( lhit, gs_offset.data(), gs_eventID.data(), num_gs ) ;
+    if( lsplit == nullptr || lsplit->num_event() != 1 || lsplit->num_hit(0) != 10 || !lsplit->is_lite() ) rc += 1 ;
+    if( lbad != nullptr ) rc += 1 ;
+    NP* la = lsplit ? lsplit->slice(0) : nullptr ;
+    if( la == nullptr || !sphotonlite::expected(la) || la->get_meta<int>("eventID", -1) != 7 ) rc += 1 ;
+    delete la ;
+    delete lsplit ;
+    delete lhit ;
+
+    // merged hits can combine events : likewise only a single event is accepted
+    seventsplit* msplit = seventsplit::Create( hit, gs_offset.data(), one_eventID.data(), num_gs, nullptr, true ) ;
+    seventsplit* mbad = seventsplit::Create( hit, gs_offset.data(), gs_eventID.data(), num_gs, gs_threadID.data(), true ) ;
+    if( msplit == nullptr || msplit->num_event() != 1 || msplit->num_hit(0) != int64_t(hh.size()) || msplit->is_lite() ) rc += 1 ;
+    if( mbad != nullptr ) rc += 1 ;
+    delete msplit ;
+
+    std::cout << "seventsplit_test rc " << rc << "\n" ;
+    delete split ;
+    return rc == 0 ? 0 : 1 ;
+}
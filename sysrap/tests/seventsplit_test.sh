@@ -0,0 +1,28 @@
+#!/bin/bash
+usage(){ cat << EOU
+seventsplit_test.sh
+=====================
+
+Check counting sort partition of hits by G4 eventID against
+a std::stable_sort reference::
+
+    ~/o/sysrap/tests/seventsplit_test.sh
+    NUM_GS=1000000 NUM_EVT=1000 ~/o/sysrap/tests/seventsplit_test.sh
+    sthread__NUM=1 ~/o/sysrap/tests/seventsplit_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+name=seventsplit_test
+bin=/tmp/$name
+
+gcc $name.cc \
+    -I$CUDA_PREFIX/include \
+    -I$OPTICKS_PREFIX/externals/glm/glm \
+    -I.. \
+    -std=c++17 -lstdc++ -lm -pthread -O2 -o $bin && $bin
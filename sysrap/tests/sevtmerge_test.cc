@@ -0,0 +1,382 @@
+/**
+sevtmerge_test.cc
+===================
+
+::
+
+    ~/o/sysrap/tests/sevtmerge_test.sh
+
+    NUM_EVT=1000 NUM_THREAD=8 ~/o/sysrap/tests/sevtmerge_test.sh
+
+Per-worker collection of gensteps and hostside photons as with
+per-worker SEvt, each event published as an sevtshard and merged
+on the "master":
+
+1. merged content matches a serial collection of all events
+   in eventID order, including the index fixups
+2. merged content is identical between runs with different
+   thread scheduling
+3. a worker without photon recording is zero padded
+4. timing compared with collection into shared vectors under a lock
+5. taking the shards of one event leaves the others
+
+**/
+
+#include <random>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "sevtmerge.h"
+
+struct sevtmerge_test
+{
+    static constexpr const int MAX_RECORD = 3 ;
+
+    int num_evt ;
+    int num_thread ;
+    int num_gs ;
+
+    sevtmerge_test();
+
+    static void AddGenstep( sevtshard& s, int evt, int g, int64_t photons );
+    static void AddPhoton( sevtshard& s, int64_t idx, bool record );
+    static void Collect( sevtshard& s, int evt, int num_gs, bool record );
+
+    void collect_serial( sevtshard& ref ) const ;
+    void collect_locked( sevtshard& ref ) const ;
+    void collect_merged( sevtshard& acc, unsigned seed, int norecord_worker=-1 ) const ;
+
+    static bool Same( const sevtshard& a, const sevtshard& b );
+    template<typename T> static bool SameBytes( const std::vector<T>& a, const std::vector<T>& b );
+
+    int check_merge();
+    int check_padding();
+    int check_take();
+    int main();
+};
+
+inline sevtmerge_test::sevtmerge_test()
+    :
+    num_evt(ssys::getenvint("NUM_EVT", 100)),
+    num_thread(ssys::getenvint("NUM_THREAD", 4)),
+    num_gs(ssys::getenvint("NUM_GS", 20))
+{
+}
+
+/**
+sevtmerge_test::AddGenstep
+----------------------------
+
+Bookkeeping as SEvt::addGenstep with indices relative to the shard.
+
+**/
+
+inline void sevtmerge_test::AddGenstep( sevtshard& s, int evt, int g, int64_t photons ) // static
+{
+    sgs gs = {} ;
+    gs.index = s.gs.size() ;
+    gs.photons = photons ;
+    gs.offset = s.num_photon() ;
+    gs.gentype = 1 + g%2 ;
+
+    quad6 q = {} ;
+    q.q0.i.x = evt ;
+    q.q0.i.y = g ;
+    q.q0.i.w = int(photons) ;
+
+    s.gs.push_back(gs) ;
+    s.gsid.push_back( sgsid::Make(evt, -1, g+1) ) ;
+    s.genstep.push_back(q) ;
+}
+
+/**
+sevtmerge_test::AddPhoton
+---------------------------
+
+As SEvt::beginPhoton/pointPhoton/finalPhoton, with the photon index
+relative to the shard. Only the first points of the record are written.
+
+**/
+
+inline void sevtmerge_test::AddPhoton( sevtshard& s, int64_t idx, bool record ) // static
+{
+    const sgs* gs = nullptr ;
+    for(size_t i=0 ; i < s.gs.size() && gs == nullptr ; i++)
+        if( idx < s.gs[i].offset + s.gs[i].photons ) gs = &s.gs[i] ;
+    assert(gs);
+
+    s.pho[idx] = spho::MakePho( int(gs->index), int(idx - gs->offset), int(idx) ) ;
+    s.slot[idx] = 1 + idx%MAX_RECORD ;
+
+    sphoton p = {} ;
+    p.set_index(idx) ;
+    p.flagmask = 1u ;
+    p.time = float(idx) ;
+    s.photon[idx] = p ;
+
+    if(!record) return ;
+    for(int r=0 ; r < s.slot[idx] ; r++)
+    {
+        sphoton rp = p ;
+        rp.pos.x = float(r) ;
+        s.record[idx*MAX_RECORD+r] = rp ;
+    }
+}
+
+inline void sevtmerge_test::Collect( sevtshard& s, int evt, int num_gs, bool record ) // static
+{
+    std::mt19937 rng(evt) ;
+    std::uniform_int_distribution<int> nph(0, 50) ;
+    for(int g=0 ; g < num_gs ; g++) AddGenstep( s, evt, g, nph(rng) ) ;
+
+    int64_t np = s.num_photon() ;
+    s.pho.resize(np) ;
+    s.slot.resize(np) ;
+    s.photon.resize(np) ;
+    if(record) s.record.resize(np*MAX_RECORD) ;
+    for(int64_t i=0 ; i < np ; i++) AddPhoton( s, i, record ) ;
+}
+
+/**
+sevtmerge_test::collect_serial
+--------------------------------
+
+Reference : all events collected into a single shard in eventID order.
+
+**/
+
+inline void sevtmerge_test::collect_serial( sevtshard& ref ) const
+{
+    for(int evt=0 ; evt < num_evt ; evt++)
+    {
+        sevtshard s(evt) ;
+        Collect( s, evt, num_gs, true );
+        sevtmerge::Append( ref, s );
+    }
+}
+
+/**
+sevtmerge_test::collect_locked
+--------------------------------
+
+All threads append their events into one shard under a lock,
+as with a single SEvt shared by the Geant4 workers.
+
+**/
+
+inline void sevtmerge_test::collect_locked( sevtshard& ref ) const
+{
+    std::mutex mtx ;
+    std::atomic<int> next(0) ;
+    std::vector<std::thread> tt ;
+    for(int t=0 ; t < num_thread ; t++)
+    {
+        tt.emplace_back( [&]()
+        {
+            int evt ;
+            while( (evt = next++) < num_evt )
+            {
+                sevtshard s(evt) ;
+                Collect( s, evt, num_gs, true );
+                std::lock_guard<std::mutex> lock(mtx) ;
+                sevtmerge::Append( ref, s );
+            }
+        });
+    }
+    for(auto& t : tt) t.join() ;
+}
+
+/**
+sevtmerge_test::collect_merged
+--------------------------------
+
+Threads take events from a shared counter and publish each event
+as a shard without locking, the shards are then merged.
+
+**/
+
+inline void sevtmerge_test::collect_merged( sevtshard& acc, unsigned seed, int norecord_worker ) const
+{
+    sevtmerge merge ;
+    std::atomic<int> next(0) ;
+    std::vector<std::thread> tt ;
+    for(int t=0 ; t < num_thread ; t++)
+    {
+        tt.emplace_back( [&, t]()
+        {
+            int worker = merge.add_worker() ;
+            std::mt19937 jitter(seed*100 + t) ;
+            int evt ;
+            while( (evt = next++) < num_evt )
+            {
+                if( jitter() % 4 == 0 ) std::this_thread::yield() ;
+                sevtshard* s = new sevtshard(evt, worker) ;
+                Collect( *s, evt, num_gs, worker != norecord_worker );
+                merge.push(s) ;
+            }
+        });
+    }
+    for(auto& t : tt) t.join() ;
+
+    std::vector<sevtshard*> ss = merge.take() ;
+    for(size_t i=0 ; i < ss.size() ; i++)
+    {
+        sevtmerge::Append( acc, *ss[i] );
+        delete ss[i] ;
+    }
+    assert( int(ss.size()) == num_evt );
+}
+
+template<typename T>
+inline bool sevtmerge_test::SameBytes( const std::vector<T>& a, const std::vector<T>& b ) // static
+{
+    return a.size() == b.size() && ( a.empty() || memcmp( a.data(), b.data(), a.size()*sizeof(T) ) == 0 ) ;
+}
+
+inline bool sevtmerge_test::Same( const sevtshard& a, const sevtshard& b ) // static
+{
+    return SameBytes(a.genstep, b.genstep)
+        && SameBytes(a.gs, b.gs)
+        && SameBytes(a.gsid, b.gsid)
+        && SameBytes(a.pho, b.pho)
+        && SameBytes(a.slot, b.slot)
+        && SameBytes(a.photon, b.photon)
+        && SameBytes(a.record, b.record)
+        ;
+}
+
+inline int sevtmerge_test::check_merge()
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+    sevtshard ref ;
+    collect_serial(ref) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+    sevtshard locked ;
+    collect_locked(locked) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    sevtshard a ;
+    collect_merged(a, 1) ;
+    auto t3 = std::chrono::high_resolution_clock::now();
+    sevtshard b ;
+    collect_merged(b, 2) ;
+
+    bool indices_ok = true ;
+    for(int64_t i=0 ; indices_ok && i < a.num_photon() ; i++)
+    {
+        const spho& p = a.pho[i] ;
+        const sgs& gs = a.gs[p.gs] ;
+        indices_ok = p.id == i
+                  && a.photon[i].get_index() == uint64_t(i)
+                  && a.record[i*MAX_RECORD].get_index() == uint64_t(i)
+                  && gs.offset + p.ix == i ;
+    }
+    for(size_t i=0 ; indices_ok && i < a.gs.size() ; i++) indices_ok = a.gs[i].index == int64_t(i) ;
+
+    bool same_ref = Same(a, ref) ;
+    bool same_run = Same(a, b) ;
+    bool ok = same_ref && same_run && indices_ok ;
+
+    auto ms = [](auto a, auto b){ return std::chrono::duration<double, std::milli>(b - a).count() ; } ;
+
+    std::cout
+        << "sevtmerge_test::check_merge"
+        << " num_evt " << num_evt
+        << " num_thread " << num_thread
+        << " num_gs " << a.gs.size()
+        << " num_photon " << a.num_photon()
+        << " same ref " << same_ref
+        << " run " << same_run
+        << " indices " << indices_ok
+        << std::fixed << std::setprecision(2)
+        << " ms serial " << ms(t0,t1)
+        << " locked " << ms(t1,t2)
+        << " merged " << ms(t2,t3)
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+/**
+sevtmerge_test::check_padding
+-------------------------------
+
+Record of events from the worker without recording are zero, the other records
+and the photons match the reference.
+
+**/
+
+inline int sevtmerge_test::check_padding()
+{
+    sevtshard ref ;
+    collect_serial(ref) ;
+    sevtshard a ;
+    collect_merged(a, 3, 0) ;
+
+    bool photon_ok = SameBytes(a.photon, ref.photon) && a.record.size() == ref.record.size() ;
+    int64_t num_zero = 0 ;
+    bool record_ok = photon_ok ;
+    for(size_t i=0 ; record_ok && i < a.record.size() ; i++)
+    {
+        const sphoton& r = a.record[i] ;
+        if( r.flagmask == 0u && ref.record[i].flagmask != 0u ) num_zero += 1 ;
+        else record_ok = memcmp( &r, &ref.record[i], sizeof(sphoton) ) == 0 ;
+    }
+    bool ok = photon_ok && record_ok ;
+
+    std::cout
+        << "sevtmerge_test::check_padding"
+        << " num_record " << a.record.size()
+        << " num_zero " << num_zero
+        << " photon " << photon_ok
+        << " record " << record_ok
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+inline int sevtmerge_test::check_take()
+{
+    sevtmerge merge ;
+    for(int w=0 ; w < 2 ; w++) for(int evt=0 ; evt < 3 ; evt++) merge.push( new sevtshard(evt, w) ) ;
+
+    std::vector<sevtshard*> s1 = merge.take(1) ;
+    std::vector<sevtshard*> rest = merge.take() ;
+
+    bool ok = s1.size() == 2 && rest.size() == 4 ;
+    for(size_t i=0 ; ok && i < s1.size() ; i++) ok = s1[i]->eventID == 1 && s1[i]->worker == int(i) ;
+    for(size_t i=0 ; ok && i < rest.size() ; i++) ok = rest[i]->eventID != 1 ;
+    for(sevtshard* s : s1) delete s ;
+    for(sevtshard* s : rest) delete s ;
+
+    std::cout
+        << "sevtmerge_test::check_take"
+        << " num_event1 " << s1.size()
+        << " num_rest " << rest.size()
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+inline int sevtmerge_test::main()
+{
+    int rc = 0 ;
+    rc += check_merge() ;
+    rc += check_padding() ;
+    rc += check_take() ;
+    return rc ;
+}
+
+int main()
+{
+    sevtmerge_test t ;
+    return t.main() ;
+}
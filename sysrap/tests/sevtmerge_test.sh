@@ -0,0 +1,22 @@
+#!/bin/bash 
+usage(){ cat << EOU
+sevtmerge_test.sh
+===================
+
+Lockless merge of per-worker SEvt content with sevtmerge.h::
+
+   ~/o/sysrap/tests/sevtmerge_test.sh 
+
+   NUM_EVT=1000 NUM_THREAD=8 ~/o/sysrap/tests/sevtmerge_test.sh 
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=sevtmerge_test 
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+gcc $name.cc -I.. -O2 -std=c++17 -pthread -lstdc++ -lm -o $bin && $bin
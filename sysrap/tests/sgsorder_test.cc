@@ -0,0 +1,263 @@
+/**
+sgsorder_test.cc
+==================
+
+::
+
+    ~/o/sysrap/tests/sgsorder_test.sh
+
+    NUM_EVT=1000 NUM_THREAD=8 ~/o/sysrap/tests/sgsorder_test.sh
+
+Gensteps of many events collected into shared vectors under a lock from
+several threads, as U4 collection into SEvt with Geant4 MT:
+
+1. whole events per thread : the collection order differs between runs,
+   "event" and "full" orders are identical between runs
+2. events split across threads in blocks of tracks : "event" is not
+   enough, "full" order is identical between runs
+3. sgsorder::Make matches std::stable_sort with the same key
+4. sgs labels are relabelled with offsets following the new order
+5. timing of radix ordering compared with std::stable_sort
+
+**/
+
+#include <random>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "sgsorder.h"
+
+struct sgsorder_test
+{
+    struct Collect
+    {
+        std::vector<sgs>     gs ;
+        std::vector<sgsid>   gsid ;
+        std::vector<int64_t> payload ;   // standin for the quad6
+    };
+
+    int num_evt ;
+    int num_thread ;
+    int num_track ;
+
+    sgsorder_test();
+
+    void collect_task( Collect& c, std::mutex& mtx, int evt, int trk0, int trk1, int tid, std::mt19937& jitter ) const ;
+    void collect( Collect& c, int split, unsigned seed ) const ;
+    static std::vector<int64_t> Ordered( const Collect& c, int mode, std::vector<sgs>* relabel=nullptr );
+
+    int check_order( int split );
+    int check_reference();
+    int main();
+};
+
+inline sgsorder_test::sgsorder_test()
+    :
+    num_evt(ssys::getenvint("NUM_EVT", 100)),
+    num_thread(ssys::getenvint("NUM_THREAD", 4)),
+    num_track(ssys::getenvint("NUM_TRACK", 20))
+{
+}
+
+/**
+sgsorder_test::collect_task
+-----------------------------
+
+The gensteps of tracks [trk0,trk1) of an event are deterministic given the
+event. Each step can give Cerenkov and two scintillation component gensteps,
+the latter tie in the full key.
+
+**/
+
+inline void sgsorder_test::collect_task( Collect& c, std::mutex& mtx, int evt, int trk0, int trk1, int tid, std::mt19937& jitter ) const
+{
+    for(int trk=trk0 ; trk < trk1 ; trk++)
+    {
+        std::mt19937 rng(1000*evt + trk) ;
+        std::uniform_int_distribution<int> nstep(1, 10) ;
+        std::uniform_int_distribution<int> nph(0, 100) ;
+        int ns = nstep(rng) ;
+        for(int stp=1 ; stp <= ns ; stp++)
+        {
+            for(int g=0 ; g < 3 ; g++)
+            {
+                int64_t photons = nph(rng) ;
+                if( photons < 30 ) continue ;
+
+                sgsid id = sgsid::Make(evt, tid, trk, stp) ;
+                sgs s = {} ;
+                s.photons = photons ;
+                s.gentype = g == 0 ? 1 : 2 ;
+                int64_t payload = ((int64_t(evt)*1000 + trk)*100 + stp)*10 + g ;
+
+                if( jitter() % 4 == 0 ) std::this_thread::yield() ;
+                std::lock_guard<std::mutex> lock(mtx) ;
+                s.index = c.gs.size() ;
+                s.offset = c.gs.empty() ? 0 : c.gs.back().offset + c.gs.back().photons ;
+                c.gs.push_back(s) ;
+                c.gsid.push_back(id) ;
+                c.payload.push_back(payload) ;
+            }
+        }
+    }
+}
+
+/**
+sgsorder_test::collect
+------------------------
+
+Threads take tasks from a shared counter, split 1 gives whole
+events as tasks, split N gives N blocks of tracks per event.
+
+**/
+
+inline void sgsorder_test::collect( Collect& c, int split, unsigned seed ) const
+{
+    std::mutex mtx ;
+    std::atomic<int> next(0) ;
+    int num_task = num_evt*split ;
+    int per = (num_track + split - 1)/split ;
+
+    std::vector<std::thread> tt ;
+    for(int t=0 ; t < num_thread ; t++)
+    {
+        tt.emplace_back( [&, t]()
+        {
+            std::mt19937 jitter(seed*100 + t) ;
+            int task ;
+            while( (task = next++) < num_task )
+            {
+                int evt = task/split ;
+                int blk = task%split ;
+                int trk0 = 1 + blk*per ;
+                int trk1 = std::min(num_track + 1, trk0 + per) ;
+                collect_task( c, mtx, evt, trk0, trk1, t, jitter );
+            }
+        });
+    }
+    for(auto& t : tt) t.join() ;
+}
+
+inline std::vector<int64_t> sgsorder_test::Ordered( const Collect& c, int mode, std::vector<sgs>* relabel ) // static
+{
+    std::vector<uint32_t> order ;
+    sgsorder::Make( order, c.gsid.data(), c.gs.data(), c.gs.size(), mode );
+    std::vector<int64_t> payload(c.payload) ;
+    sgsorder::Permute( payload, order );
+    if(relabel)
+    {
+        *relabel = c.gs ;
+        sgsorder::Permute( *relabel, order );
+        sgsorder::Relabel( *relabel );
+    }
+    return payload ;
+}
+
+inline int sgsorder_test::check_order( int split )
+{
+    Collect a ;
+    Collect b ;
+    collect(a, split, 1) ;
+    collect(b, split, 2) ;
+
+    bool same_none  = Ordered(a, sgsorder::NONE)  == Ordered(b, sgsorder::NONE) ;
+    bool same_event = Ordered(a, sgsorder::EVENT) == Ordered(b, sgsorder::EVENT) ;
+    std::vector<sgs> ra, rb ;
+    bool same_full  = Ordered(a, sgsorder::FULL, &ra)  == Ordered(b, sgsorder::FULL, &rb) ;
+
+    bool same_offsets = ra.size() == rb.size() ;
+    for(size_t i=0 ; same_offsets && i < ra.size() ; i++)
+        same_offsets = ra[i].index == int64_t(i) && ra[i].offset == rb[i].offset && ra[i].photons == rb[i].photons ;
+
+    bool ok = same_full && same_offsets && ( split > 1 || same_event ) ;
+
+    std::cout
+        << "sgsorder_test::check_order"
+        << " split " << split
+        << " num_gs " << a.gs.size()
+        << " same none " << same_none
+        << " event " << same_event
+        << " full " << same_full
+        << " offsets " << same_offsets
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+inline int sgsorder_test::check_reference()
+{
+    int64_t num = ssys::getenvint("NUM_GS", 1000000) ;
+    std::mt19937 rng(3) ;
+    std::uniform_int_distribution<int> evt(0, 999), trk(1, 100000), stp(1, 500), gen(1, 2) ;
+
+    std::vector<sgsid> id(num) ;
+    std::vector<sgs> gs(num) ;
+    for(int64_t i=0 ; i < num ; i++)
+    {
+        id[i] = sgsid::Make( evt(rng), -1, trk(rng), stp(rng) ) ;
+        gs[i] = {} ;
+        gs[i].gentype = gen(rng) ;
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::vector<uint32_t> order ;
+    sgsorder::Make( order, id.data(), gs.data(), num, sgsorder::FULL );
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::vector<uint32_t> ref(num) ;
+    std::iota( ref.begin(), ref.end(), 0u ) ;
+    std::stable_sort( ref.begin(), ref.end(), [&](uint32_t a, uint32_t b)
+    {
+        return std::make_tuple(id[a].eventID, id[a].trackID, id[a].stepID, gs[a].gentype)
+             < std::make_tuple(id[b].eventID, id[b].trackID, id[b].stepID, gs[b].gentype) ;
+    });
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    std::vector<uint32_t> negs = { 0, 1, 2 } ;
+    std::vector<sgsid> nid = { sgsid::Make(5), sgsid::Make(-1), sgsid::Make(0) } ;
+    std::vector<sgs> ngs(3, sgs{}) ;
+    std::vector<uint32_t> norder ;
+    sgsorder::Make( norder, nid.data(), ngs.data(), 3, sgsorder::EVENT );
+    bool neg_ok = norder == std::vector<uint32_t>{ 1, 2, 0 } ;
+
+    auto ms = [](auto a, auto b){ return std::chrono::duration<double, std::milli>(b - a).count() ; } ;
+    bool ok = order == ref && neg_ok ;
+
+    std::cout
+        << "sgsorder_test::check_reference"
+        << " num " << num
+        << " match " << ( order == ref )
+        << " neg_ok " << neg_ok
+        << std::fixed << std::setprecision(2)
+        << " ms radix " << ms(t0,t1)
+        << " stable_sort " << ms(t1,t2)
+        << " speedup " << ms(t1,t2)/ms(t0,t1)
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+inline int sgsorder_test::main()
+{
+    int rc = 0 ;
+    rc += check_order(1) ;
+    rc += check_order(4) ;
+    rc += check_reference() ;
+    return rc ;
+}
+
+int main()
+{
+    sgsorder_test t ;
+    return t.main() ;
+}
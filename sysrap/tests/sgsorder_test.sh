@@ -0,0 +1,22 @@
+#!/bin/bash 
+usage(){ cat << EOU
+sgsorder_test.sh
+===================
+
+Deterministic genstep ordering with sgsorder.h::
+
+   ~/o/sysrap/tests/sgsorder_test.sh 
+
+   NUM_EVT=1000 NUM_THREAD=8 ~/o/sysrap/tests/sgsorder_test.sh 
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=sgsorder_test 
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+gcc $name.cc -I.. -O2 -std=c++17 -pthread -lstdc++ -lm -o $bin && $bin
@@ -0,0 +1,200 @@
+/**
+slocalize_test.cc
+===================
+
+::
+
+    ~/o/sysrap/tests/slocalize_test.sh
+
+    NUM_INST=50000 NUM_HIT=5000000 ~/o/sysrap/tests/slocalize_test.sh
+
+Random rotation+translation instance transforms with strid encoded identity
+as stree::add_inst, and hits in runs of the same iindex as from GPU hit merging.
+
+1. double precision bulk localization is bitwise identical to per hit sphoton::transform
+   with the inverse instance transform, as done by SEvt::getLocalHit
+2. float precision bulk is close
+3. sphit from the decoded identity column matches
+4. consistency_check counts hits with wrong identity, unknown iindex always bad
+5. timings of the per hit and bulk localization
+
+**/
+
+#include <cstdlib>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "slocalize.h"
+
+struct slocalize_test
+{
+    int num_inst ;
+    int num_hit ;
+    std::vector<glm::tmat4x4<double>> iinst ;
+    std::vector<sphoton> global ;
+
+    slocalize_test();
+
+    void init_inst();
+    void init_hit();
+
+    int check();
+    int main();
+};
+
+inline slocalize_test::slocalize_test()
+    :
+    num_inst(ssys::getenvint("NUM_INST", 20000)),
+    num_hit(ssys::getenvint("NUM_HIT", 1000000))
+{
+    init_inst();
+    init_hit();
+}
+
+inline void slocalize_test::init_inst()
+{
+    std::mt19937_64 rng(1) ;
+    std::uniform_real_distribution<double> u(0., 1.) ;
+
+    iinst.resize(num_inst) ;
+    for(int i=0 ; i < num_inst ; i++)
+    {
+        glm::tvec3<double> axis = glm::normalize( glm::tvec3<double>( u(rng) - 0.5, u(rng) - 0.5, u(rng) - 0.5 )) ;
+        glm::tmat4x4<double> m2w = glm::rotate( glm::tmat4x4<double>(1.), 2.*M_PI*u(rng), axis ) ;
+        m2w[3] = glm::tvec4<double>( 20000.*(u(rng) - 0.5), 20000.*(u(rng) - 0.5), 20000.*(u(rng) - 0.5), 1. ) ;
+
+        glm::tmat4x4<double> w2m = glm::inverse(m2w) ;
+
+        glm::tvec4<int64_t> col3 ;
+        col3.x = i ;
+        col3.y = 1 + i % 3 ;
+        col3.z = 100000 + i ;   // sensor_id
+        col3.w = i ;            // sensor_index
+        strid::Encode(w2m, col3 );
+        iinst[i] = w2m ;
+    }
+}
+
+inline void slocalize_test::init_hit()
+{
+    std::mt19937_64 rng(2) ;
+    std::uniform_real_distribution<float> u(0.f, 1.f) ;
+    std::uniform_int_distribution<int> ii(0, num_inst - 1) ;
+    std::uniform_int_distribution<int> run(1, 8) ;
+
+    global.resize(num_hit) ;
+    int i = 0 ;
+    while( i < num_hit )
+    {
+        int inst = ii(rng) ;
+        int n = std::min( run(rng), num_hit - i ) ;
+        for(int j=0 ; j < n ; j++)
+        {
+            sphoton& p = global[i+j] ;
+            p.zero();
+            p.pos = make_float3( 20000.f*(u(rng) - 0.5f), 20000.f*(u(rng) - 0.5f), 20000.f*(u(rng) - 0.5f) );
+            p.time = 10.f*u(rng) ;
+            p.mom = normalize(make_float3( u(rng) - 0.5f, u(rng) - 0.5f, u(rng) - 0.5f ));
+            p.pol = normalize(make_float3( u(rng) - 0.5f, u(rng) - 0.5f, u(rng) - 0.5f ));
+            p.wavelength = 420.f ;
+            p.set_iindex__(inst) ;
+            p.set_identity( 100000 + inst + 1 ) ;   // identity is sensor_identifier + 1
+        }
+        i += n ;
+    }
+}
+
+inline int slocalize_test::check()
+{
+    // 1. per hit reference, as SEvt::getLocalHit
+    std::vector<sphoton> ref(global) ;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < num_hit ; i++) ref[i].transform( iinst[ref[i].iindex()], true ) ;
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    slocalize locd(iinst, slocalize::DOUBLE) ;
+    slocalize locf(iinst, slocalize::FLOAT) ;
+
+    std::vector<sphoton> ld(num_hit) ;
+    std::vector<sphoton> lf(num_hit) ;
+    std::vector<sphit>   ht(num_hit) ;
+
+    auto t2 = std::chrono::high_resolution_clock::now();
+    size_t bad_d = locd.localize( ld.data(), ht.data(), global.data(), num_hit, true );
+    auto t3 = std::chrono::high_resolution_clock::now();
+    size_t bad_f = locf.localize( lf.data(), nullptr, global.data(), num_hit, false );
+    auto t4 = std::chrono::high_resolution_clock::now();
+    size_t bad_1 = locd.localize( lf.data(), nullptr, global.data(), num_hit, false, 1 );  // single thread into lf for timing
+    auto t5 = std::chrono::high_resolution_clock::now();
+    locf.localize( lf.data(), nullptr, global.data(), num_hit, false );
+
+    int num_diff = 0 ;
+    int num_ht_diff = 0 ;
+    float max_df = 0.f ;
+    for(int i=0 ; i < num_hit ; i++)
+    {
+        if( memcmp( &ld[i], &ref[i], sizeof(sphoton) ) != 0 ) num_diff += 1 ;
+        const float* a = (const float*)&lf[i] ;
+        const float* b = (const float*)&ref[i] ;
+        for(int k=0 ; k < 12 ; k++) if( k % 4 != 3 ) max_df = std::max( max_df, std::abs(a[k] - b[k]) );
+
+        unsigned inst = global[i].iindex() ;
+        sphit x = {} ;
+        x.iindex = inst ;
+        x.sensor_identifier = 100000 + inst ;
+        x.sensor_index = inst ;
+        if(!(ht[i] == x)) num_ht_diff += 1 ;
+    }
+
+    // 4. corrupt some identities and one iindex
+    std::vector<sphoton> bad(global.begin(), global.begin() + std::min(num_hit, 1000)) ;
+    for(size_t i=0 ; i < bad.size() ; i += 10) bad[i].set_identity( 7 ) ;
+    bad[1].set_iindex__( num_inst ) ;
+    size_t num_bad_nocheck = locd.localize( bad.data(), nullptr, bad.data(), bad.size(), false );
+    size_t num_bad_check   = locd.localize( bad.data(), nullptr, bad.data(), bad.size(), true );
+    size_t expect_bad = (bad.size() + 9)/10 + 1 ;
+
+    auto ms = [](auto a, auto b){ return std::chrono::duration<double, std::milli>(b - a).count() ; } ;
+
+    bool ok = num_diff == 0 && num_ht_diff == 0 && bad_d == 0 && bad_f == 0 && bad_1 == 0
+              && max_df < 1e-2f
+              && num_bad_nocheck == 1 && num_bad_check == expect_bad ;
+
+    std::cout
+        << "slocalize_test::check" << std::endl
+        << locd.desc() << std::endl
+        << " num_inst " << num_inst
+        << " num_hit " << num_hit << std::endl
+        << " double num_diff(bitwise vs sphoton::transform) " << num_diff
+        << " num_ht_diff " << num_ht_diff << std::endl
+        << " float max_abs_diff " << std::scientific << std::setprecision(3) << max_df << std::fixed << std::endl
+        << " num_bad_nocheck " << num_bad_nocheck
+        << " num_bad_check " << num_bad_check
+        << " expect_bad " << expect_bad << std::endl
+        << std::setprecision(2)
+        << " ms per_hit_reference " << ms(t0,t1)
+        << " bulk_double " << ms(t2,t3)
+        << " bulk_float " << ms(t3,t4)
+        << " bulk_double_1thread " << ms(t4,t5) << std::endl
+        << " speedup bulk_double " << ms(t0,t1)/ms(t2,t3)
+        << " bulk_double_1thread " << ms(t0,t1)/ms(t4,t5)
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+inline int slocalize_test::main()
+{
+    return check();
+}
+
+int main()
+{
+    slocalize_test t ;
+    return t.main() ;
+}
+
@@ -0,0 +1,25 @@
+#!/bin/bash 
+usage(){ cat << EOU
+slocalize_test.sh
+===================
+
+Bulk hit localization with slocalize.h compared with per hit sphoton::transform::
+
+   ~/o/sysrap/tests/slocalize_test.sh 
+
+   NUM_INST=50000 NUM_HIT=5000000 ~/o/sysrap/tests/slocalize_test.sh 
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=slocalize_test 
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+gcc $name.cc -I.. -I$CUDA_PREFIX/include -O2 -std=c++17 -pthread -lstdc++ -lm -o $bin && $bin
@@ -0,0 +1,214 @@
+/**
+sphilox_test.cc
+=================
+
+::
+
+    ~/o/sysrap/tests/sphilox_test.sh
+
+1. Random123 known answer tests of the Philox4x32-10 block function
+2. skipahead(n) matches n discarded draws, across counter boundaries
+3. skipahead_sequence(n) separates subsequences on ctr.zw
+4. per (event, photon) stateless init as used by qrng<sphilox>
+5. uniform ranges and timing
+
+**/
+
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+
+#include "sphilox.h"
+
+
+int test_KAT()
+{
+    struct KAT { unsigned c[4] ; unsigned k[2] ; unsigned x[4] ; } ;
+    KAT kat[3] = {
+        { {0u,0u,0u,0u}, {0u,0u}, {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u} },
+        { {0xffffffffu,0xffffffffu,0xffffffffu,0xffffffffu}, {0xffffffffu,0xffffffffu}, {0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu} },
+        { {0x243f6a88u,0x85a308d3u,0x13198a2eu,0x03707344u}, {0xa4093822u,0x299f31d0u}, {0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u} }
+    };
+
+    int rc = 0 ;
+    for(int i=0 ; i < 3 ; i++)
+    {
+        unsigned out[4] ;
+        sphilox::Philox4x32_10( out, kat[i].c, kat[i].k );
+        bool ok = out[0] == kat[i].x[0] && out[1] == kat[i].x[1] && out[2] == kat[i].x[2] && out[3] == kat[i].x[3] ;
+        printf("test_KAT %d : %08x %08x %08x %08x %s\n", i, out[0], out[1], out[2], out[3], ok ? "PASS" : "FAIL" );
+        if(!ok) rc += 1 ;
+    }
+    return rc ;
+}
+
+/**
+test_skipahead
+----------------
+
+Starting from every STATE 0..3 with the low counter word near wraparound.
+
+**/
+
+int test_skipahead()
+{
+    unsigned long long nn[] = { 0, 1, 2, 3, 4, 5, 7, 8, 13, 1000, 4097 } ;
+    int num_bad = 0 ;
+    for(unsigned long long start=0 ; start < 4 ; start++)
+    for(unsigned long long n : nn)
+    {
+        unsigned long long offset = 0xfffffff0ull*4ull + start ;
+
+        sphilox a ;
+        curand_init( 42ull, 7ull, offset, &a );
+        for(unsigned long long i=0 ; i < n ; i++) curand(&a) ;
+
+        sphilox b ;
+        curand_init( 42ull, 7ull, offset, &b );
+        skipahead( n, &b );
+
+        sphilox c ;
+        curand_init( 42ull, 7ull, offset + n, &c );
+
+        for(int i=0 ; i < 9 ; i++)
+        {
+            unsigned ua = curand(&a) ;
+            unsigned ub = curand(&b) ;
+            unsigned uc = curand(&c) ;
+            if( ua != ub || ua != uc ) num_bad += 1 ;
+        }
+    }
+    printf("test_skipahead num_bad %d %s\n", num_bad, num_bad == 0 ? "PASS" : "FAIL" );
+    return num_bad == 0 ? 0 : 1 ;
+}
+
+int test_skipahead_sequence()
+{
+    sphilox a ;
+    curand_init( 1ull, 0ull, 0ull, &a );
+    sphilox b ;
+    curand_init( 1ull, 1ull, 0ull, &b );
+    sphilox c ;
+    curand_init( 1ull, 0ull, 0ull, &c );
+    skipahead_sequence( 1ull, &c );
+
+    bool ok = b.ctr[2] == 1u && b.ctr[3] == 0u && b.ctr[0] == 0u ;
+    int num_same_ab = 0 ;
+    for(int i=0 ; i < 100 ; i++)
+    {
+        unsigned ua = curand(&a) ;
+        unsigned ub = curand(&b) ;
+        unsigned uc = curand(&c) ;
+        if( ua == ub ) num_same_ab += 1 ;
+        ok &= ub == uc ;
+    }
+    ok &= num_same_ab == 0 ;
+
+    sphilox d ;
+    curand_init( 1ull, 0xffffffffull, 0ull, &d );
+    skipahead_sequence( 1ull, &d );
+    ok &= d.ctr[2] == 0u && d.ctr[3] == 1u ;
+
+    printf("test_skipahead_sequence %s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1 ;
+}
+
+/**
+test_event_photon
+-------------------
+
+The qrng<sphilox>::init sequence for (event, photon) is stateless,
+with event e starting skipahead_event_offset*e draws into the photon
+subsequence.
+
+**/
+
+int test_event_photon()
+{
+    unsigned long long seed = 0ull ;
+    unsigned long long offset = 0ull ;
+    unsigned long long skip = 100000ull ;
+
+    auto init = [&](sphilox& rng, unsigned long long event_idx, unsigned long long photon_idx)
+    {
+        curand_init( seed, photon_idx, offset, &rng );
+        skipahead( skip*event_idx, &rng );
+    };
+
+    int num_bad = 0 ;
+    for(unsigned long long p=0 ; p < 200 ; p++)
+    {
+        sphilox e0 ;
+        init(e0, 0ull, p);
+        for(unsigned long long i=0 ; i < skip ; i += 1) curand(&e0) ;
+
+        sphilox e1 ;
+        init(e1, 1ull, p);
+
+        sphilox r1 ;
+        init(r1, 1ull, p);
+
+        for(int i=0 ; i < 16 ; i++)
+        {
+            float u0 = curand_uniform(&e0) ;
+            float u1 = curand_uniform(&e1) ;
+            float v1 = curand_uniform(&r1) ;
+            if( u0 != u1 || u1 != v1 ) num_bad += 1 ;
+        }
+    }
+    printf("test_event_photon num_bad %d %s\n", num_bad, num_bad == 0 ? "PASS" : "FAIL" );
+    return num_bad == 0 ? 0 : 1 ;
+}
+
+int test_uniform()
+{
+    sphilox rng ;
+    curand_init( 0ull, 0ull, 0ull, &rng );
+
+    const int N = 10000000 ;
+    float mn = 2.f, mx = -1.f ;
+    double sum = 0. ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int i=0 ; i < N ; i++)
+    {
+        float u = curand_uniform(&rng) ;
+        mn = std::min(mn, u);
+        mx = std::max(mx, u);
+        sum += u ;
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count()/N ;
+
+    double dmn = 2., dmx = -1. ;
+    for(int i=0 ; i < 100000 ; i++)
+    {
+        double d = curand_uniform_double(&rng) ;
+        dmn = std::min(dmn, d);
+        dmx = std::max(dmx, d);
+    }
+
+    double mean = sum/N ;
+    bool ok = mn > 0.f && mx <= 1.f && std::abs(mean - 0.5) < 1e-3 && dmn > 0. && dmx <= 1. ;
+    printf("test_uniform min %.3g max %.9f mean %.6f dmin %.3g dmax %.9f %.2f ns/float %s\n", mn, mx, mean, dmn, dmx, ns, ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1 ;
+}
+
+int main()
+{
+    int rc = 0 ;
+    rc += test_KAT();
+    rc += test_skipahead();
+    rc += test_skipahead_sequence();
+    rc += test_event_photon();
+    rc += test_uniform();
+
+    sphilox rng ;
+    curand_init( 0ull, 0ull, 0ull, &rng );
+    std::cout << rng.desc() << "\n" ;
+    for(int i=0 ; i < 8 ; i++) printf(" %10.8f", curand_uniform(&rng)) ;
+    printf("\nsphilox_test rc %d\n", rc );
+    return rc == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,18 @@
+#!/bin/bash 
+usage(){ cat << EOU
+sphilox_test.sh
+=================
+
+Host checks of the portable Philox4x32-10 in sphilox.h::
+
+   ~/o/sysrap/tests/sphilox_test.sh 
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=sphilox_test 
+bin=/tmp/$name
+
+gcc $name.cc -I.. -O2 -std=c++17 -lstdc++ -lm -o $bin && $bin
@@ -0,0 +1,154 @@
+/**
+sresample_test.cc
+===================
+
+::
+
+    ~/o/sysrap/tests/sresample_test.sh
+
+    NUM_MAT=2000 ~/o/sysrap/tests/sresample_test.sh
+
+Random material property tables like those of G4MaterialPropertyVector,
+including points on the domain and single value and default properties.
+
+1. batch sresample::resample, serial and threaded, is bitwise identical to the
+   per value sresample::Value with G4PhysicsVector::Value semantics for
+   ascending and descending domains
+2. timings of per value, serial sweep and threaded sweep resampling
+
+**/
+
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+#include "ssys.h"
+#include "sdomain.h"
+#include "sresample.h"
+
+struct sresample_test
+{
+    static constexpr const int NUM_PROP = 8 ;
+
+    int num_mat ;
+    sdomain dom ;
+    std::vector<double> asc ;
+
+    sresample_test();
+
+    void fill( sresample& rs, const double* d, int nk ) const ;
+    int check_domain( const double* d, int nk, const char* label );
+    int main();
+};
+
+inline sresample_test::sresample_test()
+    :
+    num_mat(ssys::getenvint("NUM_MAT", 500))
+{
+    asc.resize(dom.length) ;
+    for(int k=0 ; k < dom.length ; k++) asc[k] = dom.wavelength_nm[k] ;
+}
+
+/**
+sresample_test::fill
+---------------------
+
+Properties have from 0 (default) to 64 values on x ranges that may extend beyond the domain, some with x
+on the domain points to exercise the bin edges.
+
+**/
+
+inline void sresample_test::fill( sresample& rs, const double* d, int nk ) const
+{
+    std::mt19937_64 rng(1) ;
+    std::uniform_real_distribution<double> u(0., 1.) ;
+    std::uniform_int_distribution<int> nv(0, 64) ;
+
+    double dlo = std::min(d[0], d[nk-1]) ;
+    double dhi = std::max(d[0], d[nk-1]) ;
+    double range = dhi - dlo ;
+
+    for(int i=0 ; i < num_mat ; i++)
+    {
+        std::stringstream ss ;
+        ss << "mat" << i ;
+        rs.add_group(ss.str().c_str()) ;
+
+        for(int p=0 ; p < NUM_PROP ; p++)
+        {
+            int64_t num = nv(rng) ;
+            double def = double(p) ;
+            double* xy = rs.add( num, def );
+
+            double x = dlo - 0.1*range + 0.2*range*u(rng) ;
+            for(int64_t v=0 ; v < num ; v++)
+            {
+                bool on_domain = v % 3 == 0 && x > dlo && x < dhi ;
+                double xv = on_domain ? d[int((x - dlo)/range*(nk-1))] : x ;
+                if( v > 0 && xv <= xy[2*(v-1)] ) xv = x ;
+                xy[2*v+0] = xv ;
+                xy[2*v+1] = 100.*u(rng) ;
+                x = xv + range*(0.001 + 0.05*u(rng)) ;
+            }
+        }
+    }
+}
+
+inline int sresample_test::check_domain( const double* d, int nk, const char* label )
+{
+    sresample a(d, nk) ;
+    fill(a, d, nk) ;
+    int np = a.num_prop() ;
+
+    std::vector<double> ref(int64_t(np)*nk) ;
+    std::vector<double> out(int64_t(np)*nk) ;
+    std::vector<double> out2(int64_t(np)*nk) ;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for(int p=0 ; p < np ; p++)
+    {
+        const sresample::Prop& pr = a.prop[p] ;
+        const double* xy = pr.num > 0 ? a.xy.data() + 2*pr.offset : nullptr ;
+        for(int k=0 ; k < nk ; k++) ref[int64_t(p)*nk+k] = sresample::Value( xy, pr.num, pr.def, d[k] ) ;
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    a.resample( out.data() ) ;
+    auto t2 = std::chrono::high_resolution_clock::now();
+    a.resample( out2.data(), 0 ) ;
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    int num_diff = memcmp( ref.data(), out.data(), ref.size()*sizeof(double) ) != 0 ;
+    int num_diff2 = memcmp( ref.data(), out2.data(), ref.size()*sizeof(double) ) != 0 ;
+    bool ok = num_diff == 0 && num_diff2 == 0 ;
+
+    auto ms = [](auto x, auto y){ return std::chrono::duration<double, std::milli>(y - x).count() ; } ;
+
+    std::cout
+        << "sresample_test::check_domain " << label << std::endl
+        << " " << a.desc() << std::endl
+        << " num_diff serial " << num_diff
+        << " threaded " << num_diff2 << std::endl
+        << std::fixed << std::setprecision(3)
+        << " ms per_value " << ms(t0,t1)
+        << " sweep " << ms(t1,t2)
+        << " threaded_sweep " << ms(t2,t3)
+        << " speedup sweep " << ms(t0,t1)/ms(t1,t2)
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+inline int sresample_test::main()
+{
+    int rc = 0 ;
+    rc += check_domain( dom.energy_eV, dom.length, "energy_eV(descending)" ) ;
+    rc += check_domain( asc.data(), dom.length, "wavelength_nm(ascending)" ) ;
+    return rc ;
+}
+
+int main()
+{
+    sresample_test t ;
+    return t.main() ;
+}
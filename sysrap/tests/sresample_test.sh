@@ -0,0 +1,26 @@
+#!/bin/bash 
+usage(){ cat << EOU
+sresample_test.sh
+===================
+
+Batch property resampling with sresample.h compared with per value interpolation::
+
+   ~/o/sysrap/tests/sresample_test.sh 
+
+   NUM_MAT=2000 ~/o/sysrap/tests/sresample_test.sh 
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=sresample_test 
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+case $(uname) in 
+   Linux) opt="-lssl -lcrypto " ;;
+esac
+
+gcc $name.cc -I.. -O2 -std=c++17 -pthread -lstdc++ -lm $opt -o $bin && $bin
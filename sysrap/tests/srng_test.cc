@@ -11,6 +11,7 @@ int main()
 {
     std::cout << "srng_Desc<XORWOW>()\n" << srng_Desc<XORWOW>() << "\n\n" ; 
     std::cout << "srng_Desc<Philox>()\n" << srng_Desc<Philox>() << "\n\n" ; 
+    std::cout << "srng_Desc<sphilox>()\n" << srng_Desc<sphilox>() << "\n\n" ; 
 
 #if defined(RNG_PHILITEOX)
     std::cout << "srng_Desc<PhiLiteOx>()\n" << srng_Desc<PhiLiteOx>() << "\n\n" ; 
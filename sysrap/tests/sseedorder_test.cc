@@ -0,0 +1,122 @@
+/**
+sseedorder_test.cc
+====================
+
+::
+
+    ~/o/sysrap/tests/sseedorder_test.sh
+
+Host reference of the QEvt__ORDER gentype coherent launch order
+with a benchmark of warp divergence proxies for gensteps
+alternating between Cerenkov, scintillation and torch.
+
+**/
+
+#include <iostream>
+#include <chrono>
+#include <random>
+
+#include "OpticksGenstep.h"
+#include "sseedorder.h"
+
+struct sseedorder_test
+{
+    static void Gensteps( std::vector<quad6>& gs, int num_gs, unsigned seed );
+    static int check( const std::vector<int>& seed, const std::vector<int>& order, const std::vector<quad6>& gs, int mode );
+    static int Main();
+};
+
+/**
+sseedorder_test::Gensteps
+---------------------------
+
+Gensteps cycling between types as from interleaved G4 tracks, with
+small Cerenkov gensteps over several matlines and larger scintillation ones.
+
+**/
+
+inline void sseedorder_test::Gensteps( std::vector<quad6>& gs, int num_gs, unsigned seed )
+{
+    std::mt19937 gen(seed) ;
+    std::uniform_int_distribution<unsigned> ck(1, 40) ;
+    std::uniform_int_distribution<unsigned> sc(10, 400) ;
+    std::uniform_int_distribution<unsigned> ml(0, 5) ;
+
+    gs.resize(num_gs);
+    for(int i=0 ; i < num_gs ; i++)
+    {
+        quad6& g = gs[i] ;
+        g.zero();
+        int r = i % 5 ;
+        unsigned gentype = r < 2 ? OpticksGenstep_CERENKOV : ( r < 4 ? OpticksGenstep_SCINTILLATION : OpticksGenstep_TORCH ) ;
+        g.q0.u.x = gentype ;
+        g.q0.u.y = i ;
+        g.q0.u.z = gentype == OpticksGenstep_TORCH ? 0u : ml(gen) ;
+        g.q0.u.w = gentype == OpticksGenstep_CERENKOV ? ck(gen) : ( gentype == OpticksGenstep_SCINTILLATION ? sc(gen) : 64u ) ;
+    }
+}
+
+/**
+sseedorder_test::check
+------------------------
+
+1. order is a permutation of the slots
+2. keys are non-decreasing in launch order
+3. slots with equal key keep their original relative order (stable)
+
+**/
+
+inline int sseedorder_test::check( const std::vector<int>& seed, const std::vector<int>& order, const std::vector<quad6>& gs, int mode )
+{
+    std::vector<int> inv ;
+    sseedorder::Inverse( inv, order );
+
+    int num_bad = 0 ;
+    std::vector<int> count(order.size(), 0) ;
+    for(size_t i=0 ; i < order.size() ; i++) count[order[i]] += 1 ;
+    for(size_t i=0 ; i < count.size() ; i++) if( count[i] != 1 || order[inv[i]] != int(i) ) num_bad += 1 ;
+
+    for(size_t i=1 ; i < order.size() ; i++)
+    {
+        unsigned long long k0 = sseedorder::Key( gs[seed[order[i-1]]], mode ) ;
+        unsigned long long k1 = sseedorder::Key( gs[seed[order[i]]], mode ) ;
+        if( k1 < k0 ) num_bad += 1 ;
+        if( k1 == k0 && order[i] < order[i-1] ) num_bad += 1 ;
+    }
+    return num_bad ;
+}
+
+inline int sseedorder_test::Main()
+{
+    std::vector<quad6> gs ;
+    Gensteps( gs, 20000, 42u );
+
+    std::vector<int> seed ;
+    sseedorder::Seed( seed, gs.data(), gs.size() );
+    std::cout << "sseedorder_test::Main num_genstep " << gs.size() << " num_seed " << seed.size() << "\n" ;
+
+    int rc = 0 ;
+    for(int mode=sseedorder::NONE ; mode <= sseedorder::GENTYPE_MATLINE ; mode++)
+    {
+        std::vector<int> order ;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        sseedorder::Order( order, seed.data(), seed.size(), gs.data(), mode );
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        int num_bad = check( seed, order, gs, mode );
+        sseedorder::Stat st = sseedorder::Divergence( seed.data(), order.data(), seed.size(), gs.data(), mode );
+
+        std::cout
+            << st.desc()
+            << " order_ms " << std::setprecision(2) << std::chrono::duration<double,std::milli>(t1-t0).count()
+            << " num_bad " << num_bad
+            << "\n"
+            ;
+        if(num_bad > 0) rc += 1 ;
+        if(mode != sseedorder::NONE && st.num_mixed_gentype > 2 ) rc += 1 ;   // at most one warp per boundary between gentypes
+    }
+    std::cout << "sseedorder_test rc " << rc << "\n" ;
+    return rc ;
+}
+
+int main(){ return sseedorder_test::Main() == 0 ? 0 : 1 ; }
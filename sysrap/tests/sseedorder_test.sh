@@ -0,0 +1,21 @@
+#!/bin/bash 
+usage(){ cat << EOU
+sseedorder_test.sh
+====================
+
+Host reference and divergence proxy benchmark of gentype coherent photon ordering::
+
+   ~/o/sysrap/tests/sseedorder_test.sh 
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=sseedorder_test 
+bin=/tmp/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+gcc $name.cc -I.. -I$CUDA_PREFIX/include -O2 -std=c++17 -lstdc++ -lm -o $bin && $bin
@@ -0,0 +1,142 @@
+/**
+sseq_index_add_test.cc
+========================
+
+::
+
+    ~/o/sysrap/tests/sseq_index_add_test.sh
+
+1. create synthetic seq arrays with a skewed distribution of histories
+2. compare sharded parallel sseq_index counts and first indices with a serial std::map reference
+3. compare incremental sseq_index::add over event sized pieces with the single shot index
+4. compare fast sseq_index_ab_chi2::Calc with the full sseq_index_ab chi2
+
+**/
+
+#include <random>
+#include "NP.hh"
+#include "ssys.h"
+#include "sstamp.h"
+#include "sseq_index.h"
+
+struct sseq_index_add_test
+{
+    static NP* MakeSeq(int64_t num, unsigned seed);
+    static void Reference( std::map<sseq, sseq_index_count>& m, const NP* seq );
+    static int Compare( const std::map<sseq, sseq_index_count>& a, const std::map<sseq, sseq_index_count>& b );
+    static int main();
+};
+
+/**
+sseq_index_add_test::MakeSeq
+------------------------------
+
+Histories of 1-20 nibbles with short histories much more frequent,
+giving a few hundred distinct sseq as typical of real events.
+
+**/
+
+inline NP* sseq_index_add_test::MakeSeq(int64_t num, unsigned seed)
+{
+    NP* seq = NP::Make<unsigned long long>(num, 2, sseq::NSEQ) ;
+    sseq* qq = (sseq*)seq->bytes() ;
+    std::mt19937_64 rng(seed);
+    std::geometric_distribution<int> nstep(0.3) ;
+    std::uniform_int_distribution<unsigned> flag(1, 4) ;
+    for(int64_t i=0 ; i < num ; i++)
+    {
+        sseq& q = qq[i] ;
+        q.zero();
+        int n = 1 + std::min(19, nstep(rng)) ;
+        for(int j=0 ; j < n ; j++) q.add_nibble(j, 0x1 << flag(rng), 0 );
+    }
+    return seq ;
+}
+
+inline void sseq_index_add_test::Reference( std::map<sseq, sseq_index_count>& m, const NP* seq )
+{
+    std::vector<sseq> q ;
+    NPX::VecFromArray<sseq>(q, seq );
+    for(int i=0 ; i < int(q.size()) ; i++)
+    {
+        auto it = m.find(q[i]) ;
+        if(it == m.end()) m[q[i]] = {i, 1} ;
+        else it->second.count++ ;
+    }
+}
+
+inline int sseq_index_add_test::Compare( const std::map<sseq, sseq_index_count>& a, const std::map<sseq, sseq_index_count>& b )
+{
+    int mismatch = a.size() == b.size() ? 0 : 1 ;
+    for(auto it=a.begin() ; it != a.end() ; it++)
+    {
+        auto jt = b.find(it->first);
+        bool match = jt != b.end() && jt->second.index == it->second.index && jt->second.count == it->second.count ;
+        if(!match) mismatch += 1 ;
+    }
+    return mismatch ;
+}
+
+inline int sseq_index_add_test::main()
+{
+    int64_t NUM = ssys::getenvint("NUM", 1000000) ;
+    int NEVT = ssys::getenvint("NEVT", 10) ;
+
+    NP* a_seq = MakeSeq(NUM, 1u) ;
+    NP* b_seq = MakeSeq(NUM, 2u) ;
+
+    int64_t t0 = sstamp::Now();
+    std::map<sseq, sseq_index_count> ref ;
+    Reference(ref, a_seq);
+    int64_t t1 = sstamp::Now();
+
+    sseq_index a(a_seq) ;
+    int64_t t2 = sstamp::Now();
+
+    int mismatch_parallel = Compare( ref, a.m );
+
+    sseq_index ai ;
+    int64_t per_evt = NUM/NEVT ;
+    for(int e=0 ; e < NEVT ; e++)
+    {
+        int64_t i0 = e*per_evt ;
+        int64_t i1 = e == NEVT - 1 ? NUM : i0 + per_evt ;
+        NP* evt_seq = NP::Make<unsigned long long>(i1-i0, 2, sseq::NSEQ) ;
+        memcpy( evt_seq->bytes(), a_seq->bytes() + i0*sizeof(sseq), (i1-i0)*sizeof(sseq) );
+        ai.add(evt_seq);
+        delete evt_seq ;   // incremental index does not keep the array
+    }
+    int mismatch_incremental = Compare( ref, ai.m );
+
+    sseq_index b(b_seq) ;
+    int64_t t3 = sstamp::Now();
+    sseq_index_ab ab(a, b);
+    int64_t t4 = sstamp::Now();
+    sseq_index_ab_chi2 c2 = sseq_index_ab_chi2::Calc(a, b) ;
+    int64_t t5 = sstamp::Now();
+
+    bool chi2_match = c2.ndf == ab.chi2.ndf && std::abs(c2.sum - ab.chi2.sum) < 1e-6*std::max(1., ab.chi2.sum) ;
+
+    std::cout
+        << sthread::Desc() << "\n"
+        << " NUM " << NUM << " NEVT " << NEVT << " unique " << a.m.size() << "\n"
+        << " serial reference  (t1-t0) " << std::setw(10) << (t1 - t0) << " us\n"
+        << " sharded sseq_index (t2-t1) " << std::setw(10) << (t2 - t1) << " us\n"
+        << " sseq_index_ab      (t4-t3) " << std::setw(10) << (t4 - t3) << " us\n"
+        << " chi2::Calc         (t5-t4) " << std::setw(10) << (t5 - t4) << " us\n"
+        << " mismatch_parallel " << mismatch_parallel << "\n"
+        << " mismatch_incremental " << mismatch_incremental << "\n"
+        << " ab.chi2 " << ab.chi2.desc() << "\n"
+        << "    c2   " << c2.desc() << "\n"
+        << " chi2_match " << chi2_match << "\n"
+        ;
+
+    std::cout << a.desc(NUM/100) ;
+
+    return mismatch_parallel == 0 && mismatch_incremental == 0 && chi2_match ? 0 : 1 ;
+}
+
+int main()
+{
+    return sseq_index_add_test::main() ;
+}
@@ -0,0 +1,31 @@
+#!/bin/bash
+usage(){ cat << EOU
+sseq_index_add_test.sh
+========================
+
+Standalone check of sharded parallel sseq_index counting,
+incremental sseq_index::add and the fast merge-join chi2
+against a serial reference, using synthetic seq arrays.
+
+::
+
+    ~/o/sysrap/tests/sseq_index_add_test.sh
+    NUM=100000000 ~/o/sysrap/tests/sseq_index_add_test.sh
+    sthread__NUM=1 ~/o/sysrap/tests/sseq_index_add_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+name=sseq_index_add_test
+bin=/tmp/$name
+
+gcc $name.cc \
+    -I$CUDA_PREFIX/include \
+    -I.. \
+    -std=c++17 -lstdc++ -lm -pthread -O2 -o $bin && $bin
+
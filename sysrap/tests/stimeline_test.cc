@@ -0,0 +1,206 @@
+/**
+stimeline_test.cc
+===================
+
+::
+
+    ~/o/sysrap/tests/stimeline_test.sh
+
+**/
+
+#include <thread>
+#include <atomic>
+#include "spath.h"
+#include "sprof.h"
+#include "stimeline.h"
+
+struct stimeline_test
+{
+    static constexpr const char* STAGES[] = { "HEAD", "PRUP", "PREL", "POST", "DOWN", "PCAT", "BRES", "TAIL" } ;
+    static void Simulate(int eventID);
+    static int Overhead();
+    static int Threads();
+    static int Contention();
+    static int Escape();
+    static int main();
+};
+
+inline void stimeline_test::Simulate(int eventID)
+{
+    stimeline::Begin("SEvt__Event_EGPU", eventID);
+    for(int i=0 ; i < 8 ; i++)
+    {
+        std::string name = std::string("QSim__simulate_") + STAGES[i] ;
+        stimeline::Mark(name.c_str(), eventID) ;
+        if(i == 3) stimeline::Begin("SEvt__gather", eventID) ;
+        std::this_thread::sleep_for(std::chrono::microseconds(100*(i+1)));
+        if(i == 3) stimeline::End("SEvt__gather", eventID) ;
+    }
+    stimeline::End("SEvt__Event_EGPU", eventID);
+}
+
+/**
+stimeline_test::Overhead
+--------------------------
+
+Compare cost of int tag records with the string interning records
+and with the /proc reading sprof::Stamp used by SProf::Add
+
+**/
+
+inline int stimeline_test::Overhead()
+{
+    int N = 1000000 ;
+    int tag = stimeline::Tag("overhead") ;
+
+    int64_t t0 = stimeline::Now();
+    for(int i=0 ; i < N ; i++) stimeline::Instant(tag, i) ;
+    int64_t t1 = stimeline::Now();
+    for(int i=0 ; i < N/10 ; i++) stimeline::Instant("overhead", i) ;
+    int64_t t2 = stimeline::Now();
+
+    int M = 1000 ;
+    sprof p ;
+    for(int i=0 ; i < M ; i++) sprof::Stamp(p) ;
+    int64_t t3 = stimeline::Now();
+
+    std::cout
+        << "stimeline_test::Overhead\n"
+        << " stimeline int tag    ns/record " << std::setw(10) << double(t1 - t0)/N << "\n"
+        << " stimeline string tag ns/record " << std::setw(10) << double(t2 - t1)/(N/10) << "\n"
+        << " sprof::Stamp         ns/record " << std::setw(10) << double(t3 - t2)/M << "\n"
+        ;
+
+    stimeline::Clear();
+    return 0 ;
+}
+
+inline int stimeline_test::Threads()
+{
+    std::vector<std::thread> tt ;
+    for(int t=0 ; t < 4 ; t++) tt.emplace_back( [t](){ for(int e=0 ; e < 3 ; e++) Simulate(t*100 + e) ; } );
+    for(auto& t : tt) t.join();
+    Simulate(1000) ;
+
+    NP* a = stimeline::Serialize();
+    std::cout << stimeline::Desc() << " a " << a->sstr() << " names " << a->names.size() << "\n" ;
+
+    int expect = (4*3 + 1)*(8 + 2 + 2) ;
+    int rc = a->shape[0] == expect ? 0 : 1 ;
+
+    const char* fold = spath::Resolve("$FOLD") ;
+    a->save(fold, "stimeline.npy");
+    std::string json = spath::Join(fold, "stimeline.json") ;
+    stimeline::SaveChromeTrace(a, json.c_str()) ;
+    std::cout << "saved " << json << " rc " << rc << "\n" ;
+    return rc ;
+}
+
+/**
+stimeline_test::Contention
+----------------------------
+
+Concurrent string and int tag marks from several threads, after the
+first call from each thread with each name no further locks are taken.
+The per record cost per core with all threads recording is compared
+with the single thread cost from a serial pass, without contention
+they are similar.
+
+**/
+
+inline int stimeline_test::Contention()
+{
+    stimeline::Clear();
+    const char* names[] = { "QSim__simulate_HEAD", "QSim__simulate_TAIL", "SEvt__gather" } ;
+    int num_thread = 8 ;
+    int N = 200000 ;
+
+    auto work = [&](int n)
+    {
+        for(int i=0 ; i < n ; i++) stimeline::Mark(names[i%3], i) ;
+    };
+
+    int64_t t0 = stimeline::Now();
+    work(N) ;
+    int64_t t1 = stimeline::Now();
+
+    std::atomic<int> ready(0) ;
+    std::atomic<bool> go(false) ;
+    std::atomic<int64_t> locks_before(0) ;
+    std::vector<std::thread> tt ;
+    for(int t=0 ; t < num_thread ; t++) tt.emplace_back( [&]()
+    {
+        work(3) ;              // warmup : ring creation and tag cache fill
+        ready += 1 ;
+        while(!go) std::this_thread::yield() ;
+        work(N) ;
+    });
+    while( ready < num_thread ) std::this_thread::yield() ;
+    locks_before = stimeline::Get().num_lock.load() ;
+    int64_t t2 = stimeline::Now();
+    go = true ;
+    for(auto& t : tt) t.join();
+    int64_t t3 = stimeline::Now();
+    int64_t locks_after = stimeline::Get().num_lock.load() ;
+
+    double serial_ns = double(t1 - t0)/N ;
+    int num_core = std::min(num_thread, int(std::max(1u, std::thread::hardware_concurrency()))) ;
+    double thread_ns = double(t3 - t2)*num_core/(double(N)*num_thread) ;   // per record per core in use
+    bool no_lock = locks_after == locks_before ;
+
+    std::cout
+        << "stimeline_test::Contention\n"
+        << " num_thread " << num_thread
+        << " locks during concurrent marks " << ( locks_after - locks_before ) << "\n"
+        << " serial     ns/record " << std::setw(10) << serial_ns << "\n"
+        << " concurrent ns/record " << std::setw(10) << thread_ns << " (per core, num_core " << num_core << ")\n"
+        << " " << ( no_lock ? "PASS" : "FAIL" ) << "\n"
+        ;
+
+    stimeline::Clear();
+    return no_lock ? 0 : 1 ;
+}
+
+/**
+stimeline_test::Escape
+------------------------
+
+Names with quote, backslash and control characters are escaped in the trace JSON.
+
+**/
+
+inline int stimeline_test::Escape()
+{
+    stimeline::Clear();
+    stimeline::Mark("Esc__a\"b\\c\td", 1) ;
+    NP* a = stimeline::Serialize();
+    std::string json = stimeline::ChromeTrace(a) ;
+    stimeline::Clear();
+
+    bool escaped = json.find("\"name\":\"Esc__a\\\"b\\\\c\\td\"") != std::string::npos ;
+    bool no_ctrl = json.find('\t') == std::string::npos ;
+    bool ok = escaped && no_ctrl ;
+
+    std::cout
+        << "stimeline_test::Escape"
+        << " escaped " << escaped
+        << " no_ctrl " << no_ctrl
+        << " " << ( ok ? "PASS" : "FAIL" ) << "\n"
+        ;
+    return ok ? 0 : 1 ;
+}
+
+inline int stimeline_test::main()
+{
+    int rc = 0 ;
+    rc += Overhead();
+    rc += Contention();
+    rc += Escape();
+    rc += Threads();
+    return rc ;
+}
+
+int main()
+{
+    return stimeline_test::main() ;
+}
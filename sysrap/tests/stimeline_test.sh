@@ -0,0 +1,33 @@
+#!/bin/bash
+usage(){ cat << EOU
+stimeline_test.sh
+===================
+
+Records QSim::simulate like stage markers from several threads,
+measures the per-record overhead compared with sprof::Stamp,
+saves the binary timeline and the Chrome trace JSON into FOLD.
+
+::
+
+    ~/o/sysrap/tests/stimeline_test.sh
+
+Open $FOLD/stimeline.json with chrome://tracing or https://ui.perfetto.dev
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+name=stimeline_test
+export FOLD=/tmp/$USER/opticks/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+gcc $name.cc \
+    -I$CUDA_PREFIX/include \
+    -I.. \
+    -std=c++17 -lstdc++ -lm -pthread -O2 -o $bin && $bin
+
@@ -0,0 +1,187 @@
+/**
+sxorwow_test.cc
+=================
+
+::
+
+    ~/o/sysrap/tests/sxorwow_test.sh
+
+1. skipahead(n) with the offset jump matrices matches n curand draws
+2. byte table next_sequence matches seq[0] matrix and skipahead_sequence is additive
+3. init_states digest matches the GPU generated reference for 3M states, seed 0, offset 0
+4. SCurandState::generate writes chunks and then extends them, with concatenated
+   chunk digest again matching the reference
+
+The reference digest is from md5sum of QCurandStateMonolithic_3000000_0_0.bin
+created by curand_init on GPU, see QRng.cc notes. Digest comparisons need the
+default MD5 sdigest mode.
+
+**/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include "curand_kernel.h"
+#include "SCurandState.h"
+
+struct sxorwow_test
+{
+    static constexpr const char* REF_DIGEST_3M = "c5a80f522e9393efe0302b916affda06" ;
+    static unsigned Curand( curandStateXORWOW& s );
+
+    static int skipahead();
+    static int sequence();
+    static int reference();
+    static int generate();
+    static int Main();
+};
+
+/**
+sxorwow_test::Curand
+----------------------
+
+As curand(curandStateXORWOW*)
+
+**/
+
+inline unsigned sxorwow_test::Curand( curandStateXORWOW& s )
+{
+    sxorwow::Step(s.v);
+    s.d += 362437u ;
+    return s.v[4] + s.d ;
+}
+
+inline int sxorwow_test::skipahead()
+{
+    const sxorwow* x = sxorwow::Get();
+    unsigned long long nn[] = { 0, 1, 2, 3, 5, 64, 1000, 65537, 1000003 } ;
+    int num_bad = 0 ;
+    for(unsigned long long n : nn)
+    {
+        curandStateXORWOW a ;
+        x->curand_init( 42ull, 7ull, 0ull, &a );
+        for(unsigned long long i=0 ; i < n ; i++) Curand(a) ;
+
+        curandStateXORWOW b ;
+        x->curand_init( 42ull, 7ull, n, &b );
+
+        for(int i=0 ; i < 8 ; i++) if( Curand(a) != Curand(b) ) num_bad += 1 ;
+    }
+    printf("sxorwow_test::skipahead num_bad %d %s\n", num_bad, num_bad == 0 ? "PASS" : "FAIL" );
+    return num_bad == 0 ? 0 : 1 ;
+}
+
+inline int sxorwow_test::sequence()
+{
+    const sxorwow* x = sxorwow::Get();
+    int num_bad = 0 ;
+    for(unsigned long long id=0 ; id < 1000 ; id++)
+    {
+        curandStateXORWOW a ;
+        x->curand_init( 1ull, id, 0ull, &a );
+
+        curandStateXORWOW b = a ;
+        x->next_sequence( b.v );
+
+        curandStateXORWOW c = a ;
+        sxorwow::MatVec( c.v, x->seq[0] );
+
+        curandStateXORWOW d ;
+        x->curand_init( 1ull, id + 1ull, 0ull, &d );
+
+        curandStateXORWOW e ;
+        x->curand_init( 1ull, id*0x10001ull, 0ull, &e );
+        x->skipahead_sequence( id*0xfffeffffull + 0x12345ull, e.v );
+
+        curandStateXORWOW f ;
+        x->curand_init( 1ull, id*0x100000000ull + 0x12345ull, 0ull, &f );
+
+        for(int k=0 ; k < 5 ; k++)
+        {
+            if( b.v[k] != c.v[k] || b.v[k] != d.v[k] ) num_bad += 1 ;
+            if( e.v[k] != f.v[k] ) num_bad += 1 ;
+        }
+    }
+    printf("sxorwow_test::sequence num_bad %d %s\n", num_bad, num_bad == 0 ? "PASS" : "FAIL" );
+    return num_bad == 0 ? 0 : 1 ;
+}
+
+inline int sxorwow_test::reference()
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+    const sxorwow* x = sxorwow::Get();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    unsigned long long num = 3000000ull ;
+    std::vector<curandStateXORWOW> states(num) ;
+    int num_shard = x->init_states( states.data(), num, 0ull, 0ull, 0ull );
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    sdigest dig ;
+    SCurandChunk::Digest( &dig, states.data(), num );
+    std::string digest = dig.finalize();
+
+    bool md5 = sdigest::Mode() == sdigest::MD5 ;
+    bool ok = md5 ? digest == REF_DIGEST_3M : true ;
+
+    printf("sxorwow_test::reference tables %.4f s init_states %.4f s num_shard %d digest %s %s\n",
+        std::chrono::duration<double>(t1-t0).count(),
+        std::chrono::duration<double>(t2-t1).count(),
+        num_shard, digest.c_str(), ok ? ( md5 ? "PASS" : "SKIP" ) : "FAIL" );
+    return ok ? 0 : 1 ;
+}
+
+/**
+sxorwow_test::generate
+------------------------
+
+Writes 2x1M chunks, then extends the spec to 3x1M so only the
+third chunk is generated.
+
+**/
+
+inline int sxorwow_test::generate()
+{
+    const char* dir = ssys::getenvvar("FOLD", "/tmp/sxorwow_test") ;
+    std::string rngdir = std::string(dir) + "/RNG" ;
+    system( ("rm -f " + rngdir + "/SCurandChunk_*.bin").c_str() );
+
+    setenv("SCurandState__init_CHUNKSIZES", "2x1M", 1 );
+    SCurandState cs0(rngdir.c_str()) ;
+    int num_gen0 = cs0.generate() ;
+
+    setenv("SCurandState__init_CHUNKSIZES", "3x1M", 1 );
+    SCurandState cs1(rngdir.c_str()) ;
+    int num_gen1 = cs1.generate() ;
+    int num_gen2 = cs1.generate() ;
+
+    sdigest dig ;
+    for(int i=0 ; i < int(cs1.chunk.size()) ; i++)
+    {
+        scurandref<curandStateXORWOW> r = cs1.chunk[i].load(0, rngdir.c_str(), &dig );
+        free(r.states);
+    }
+    std::string digest = dig.finalize();
+    bool md5 = sdigest::Mode() == sdigest::MD5 ;
+
+    bool ok = num_gen0 == 2 && num_gen1 == 1 && num_gen2 == 0 && cs1.is_complete() && ( md5 ? digest == REF_DIGEST_3M : true ) ;
+    printf("sxorwow_test::generate num_gen0 %d num_gen1 %d num_gen2 %d digest %s %s\n", num_gen0, num_gen1, num_gen2, digest.c_str(), ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1 ;
+}
+
+inline int sxorwow_test::Main()
+{
+    std::cout << sxorwow::Get()->desc() << "\n" ;
+    int rc = 0 ;
+    rc += skipahead();
+    rc += sequence();
+    rc += reference();
+    rc += generate();
+    printf("sxorwow_test rc %d\n", rc );
+    return rc ;
+}
+
+int main(){ return sxorwow_test::Main() == 0 ? 0 : 1 ; }
@@ -0,0 +1,24 @@
+#!/bin/bash 
+usage(){ cat << EOU
+sxorwow_test.sh
+=================
+
+Host generation of XORWOW curand states with sxorwow.h and SCurandState::generate,
+checked against the GPU created reference digest::
+
+   ~/o/sysrap/tests/sxorwow_test.sh 
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+
+name=sxorwow_test 
+export FOLD=/tmp/$name
+mkdir -p $FOLD
+bin=$FOLD/$name
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+gcc $name.cc -I.. -I$CUDA_PREFIX/include -O2 -std=c++17 -pthread -lstdc++ -lm -lcrypto -lssl -o $bin && $bin
@@ -69,6 +69,7 @@
 
 #include "SLOG.hh"
 #include "U4.hh"
+#include "U4GenstepSelect.h"
 #else
 #include <boost/python.hpp>
 #endif
@@ -178,6 +179,7 @@ Local_DsG4Scintillation::Local_DsG4Scintillation(G4int opticksMode, const G4Stri
     , fPreQE(1.)
     , m_noop(false)
     , m_opticksMode(opticksMode)
+    , m_genstep_select(nullptr)
 {
     SetProcessSubType(fScintillation);
     fTrackSecondariesFirst = false;
@@ -230,6 +232,9 @@ Local_DsG4Scintillation::~Local_DsG4Scintillation()
         theReemissionIntegralTable->clearAndDestroy();
         delete theReemissionIntegralTable;
     }
+#ifdef STANDALONE
+    delete m_genstep_select ; 
+#endif
 }
 
 ////////////
@@ -531,9 +536,14 @@ Local_DsG4Scintillation::PostStepDoIt(const G4Track& aTrack, const G4Step& aStep
 
     ////////////////////////////////////////////////////////////////
 
-    aParticleChange.SetNumberOfSecondaries(NumTracks);
+    bool genstep_only = false ; 
+#ifdef STANDALONE
+    genstep_only = m_genstep_select && !flagReemission && m_genstep_select->select(aStep) ; 
+#endif
+
+    aParticleChange.SetNumberOfSecondaries(genstep_only ? 0 : NumTracks);
 
-    if (fTrackSecondariesFirst) {
+    if (fTrackSecondariesFirst && !genstep_only) {
         if (!flagReemission) 
             if (aTrack.GetTrackStatus() == fAlive )
                 aParticleChange.ProposeTrackStatus(fSuspend);
@@ -652,6 +662,16 @@ Local_DsG4Scintillation::PostStepDoIt(const G4Track& aTrack, const G4Step& aStep
 #endif
 
 #ifdef STANDALONE
+        if(genstep_only)   // no debug reduction of NumPhoton and no tracks
+        {
+            if(NumPhoton > 0)
+            {
+                if(!m_genstep_select->checked) m_genstep_select->checked = U4::CheckWorkerSEvt() ;
+                U4::CollectGenstep_DsG4Scintillation_r4695( &aTrack, &aStep, NumPhoton, scnt, ScintillationTime); 
+            }
+            continue ; 
+        }
+
         if(flagReemission) assert( NumPhoton == 0 || NumPhoton == 1);   // expecting only 0 or 1 remission photons
         bool is_opticks_genstep = NumPhoton > 0 && !flagReemission ; 
         if(is_opticks_genstep && (m_opticksMode & 1))
@@ -108,6 +108,8 @@ class G4UIdirectory;
 // Class Definition
 /////////////////////
 
+struct U4GenstepSelect ; 
+
 class Local_DsG4Scintillation : public G4VRestDiscreteProcess, public G4UImessenger
 { //too lazy to create another UImessenger class
 
@@ -287,6 +289,12 @@ public: // With description
         // photocathode (???) 
         void SetNoOp(bool tf = true) { m_noop = tf; }
 
+        // Steps chosen by select collect a genstep with full photon count
+        // and make no secondaries, reemission is unaffected.
+        // Takes ownership of select. See U4OpticalGenstepPhysics.
+        void SetGenstepOnly(U4GenstepSelect* select) { m_genstep_select = select; }
+        U4GenstepSelect* GetGenstepOnly() const { return m_genstep_select; }
+
 public:
         // interface for OP simulator. Reuse part of code.
         G4PhysicsTable* getSlowIntegralTable();
@@ -355,6 +363,7 @@ private:
         G4double fPreQE;
         bool m_noop;
         G4int m_opticksMode ; 
+        U4GenstepSelect* m_genstep_select ; 
 };
 
 ////////////////////
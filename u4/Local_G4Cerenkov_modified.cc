@@ -83,6 +83,7 @@
 #ifdef STANDALONE
 #include "SLOG.hh"
 #include "U4.hh"
+#include "U4GenstepSelect.h"
 #endif
 
 
@@ -115,7 +116,8 @@ Local_G4Cerenkov_modified::Local_G4Cerenkov_modified(const G4String& processName
 #ifdef INSTRUMENTED
              override_fNumPhotons(0),
 #endif
-             fNumPhotons(0)
+             fNumPhotons(0),
+             fGenstepSelect(nullptr)
 {
   SetProcessSubType(fCerenkov);
 
@@ -140,6 +142,9 @@ Local_G4Cerenkov_modified::~Local_G4Cerenkov_modified()
      thePhysicsTable->clearAndDestroy();
      delete thePhysicsTable;
   }
+#ifdef STANDALONE
+  delete fGenstepSelect;
+#endif
 }
 
   ////////////
@@ -173,6 +178,19 @@ void Local_G4Cerenkov_modified::SetMaxNumPhotonsPerStep(const G4int NumPhotons)
   fMaxPhotons = NumPhotons;
 }
 
+/**
+Local_G4Cerenkov_modified::SetGenstepOnly
+-------------------------------------------
+
+Takes ownership of the select, which must not be shared between threads.
+
+**/
+
+void Local_G4Cerenkov_modified::SetGenstepOnly(U4GenstepSelect* select)
+{
+  fGenstepSelect = select;
+}
+
 void Local_G4Cerenkov_modified::BuildPhysicsTable(const G4ParticleDefinition&)
 {
   if (!thePhysicsTable) BuildThePhysicsTable();
@@ -353,6 +371,29 @@ G4VParticleChange* Local_G4Cerenkov_modified::PostStepDoIt(const G4Track& aTrack
      return pParticleChange;
   }
 
+#ifdef STANDALONE
+  // genstep only : the photons are generated on GPU from the genstep, no tracks are created
+  // and there is no debug reduction of fNumPhotons
+  if (fGenstepSelect && fGenstepSelect->select(aStep)) {
+     if(!fGenstepSelect->checked) fGenstepSelect->checked = U4::CheckWorkerSEvt() ;
+     U4::CollectGenstep_G4Cerenkov_modified(
+         &aTrack,
+         &aStep,
+         fNumPhotons,
+         BetaInverse,
+         Pmin,
+         Pmax,
+         maxCos,
+         maxSin2,
+         MeanNumberOfPhotons1,
+         MeanNumberOfPhotons2
+     );
+     aParticleChange.SetNumberOfSecondaries(0);
+
+     return pParticleChange;
+  }
+#endif
+
   ////////////////////////////////////////////////////////////////
 
 #ifdef STANDALONE
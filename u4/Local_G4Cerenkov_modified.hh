@@ -82,6 +82,7 @@
 template <typename T> struct OpticksDebug ; 
 struct OpticksRandom ; 
 #endif 
+struct U4GenstepSelect ; 
 
 
 class Local_G4Cerenkov_modified : public G4VProcess
@@ -207,6 +208,13 @@ public:
       fNumPhotons2 = 0;
   }
 
+  void SetGenstepOnly(U4GenstepSelect* select);
+  // When set, steps chosen by select collect a genstep with
+  // U4::CollectGenstep_G4Cerenkov_modified and make no secondaries,
+  // other steps generate photons as normal. See U4OpticalGenstepPhysics.
+
+  U4GenstepSelect* GetGenstepOnly() const { return fGenstepSelect; }
+
   G4PhysicsTable* GetPhysicsTable() const;
   // Returns the address of the physics table.
 
@@ -262,6 +270,8 @@ private:
   G4int fNumPhotons1; // mean
   G4int fNumPhotons2; // mean
 
+  U4GenstepSelect* fGenstepSelect;
+
 private:
 
 };
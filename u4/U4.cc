@@ -10,6 +10,8 @@
 #include "G4Track.hh"
 #include "G4OpticalPhoton.hh"
 #include "G4Event.hh"
+#include "G4EventManager.hh"
+#include "G4Threading.hh"
 
 #include "SEvt.hh"
 #include "scuda.h"
@@ -24,6 +26,7 @@
 #include "sscint.h"
 #include "scerenkov.h"
 #include "sgs.h"
+#include "sgsid.h"
 
 #ifdef WITH_CUSTOM4
 #include "C4GS.h"
@@ -54,19 +57,22 @@ That is like the PImpl pattern : pointer to implementation.
 
 HMM: perhapa this state belongs better within SEvt together with the full gensteps ?
 
+The state is thread_local as with per-worker SEvt (SEvt::CreateOrReuseWorker)
+each Geant4 worker collects gensteps and labels photons concurrently.
+
 **/
 
 
 #ifdef WITH_CUSTOM4
-static C4GS gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
-static C4Pho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
-static C4Pho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
-static C4Pho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
+static thread_local C4GS gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
+static thread_local C4Pho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
+static thread_local C4Pho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
+static thread_local C4Pho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
 #else
-static sgs gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
-static spho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
-static spho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
-static spho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
+static thread_local sgs gs = {} ;            // updated by eg U4::CollectGenstep_DsG4Scintillation_r4695 prior to each photon generation loop
+static thread_local spho ancestor = {} ;     // updated by U4::GenPhotonAncestor prior to the photon generation loop(s)
+static thread_local spho pho = {} ;          // updated by U4::GenPhotonBegin at start of photon generation loop
+static thread_local spho secondary = {} ;    // updated by U4::GenPhotonEnd   at end of photon generation loop
 #endif
 
 static bool dump = false ;
@@ -79,6 +85,27 @@ Using hidden static non-member functions allows keeping Opticks types like quad6
 
 **/
 
+/**
+MakeGenstepID
+---------------
+
+Provenance of the genstep from the current G4Event of this thread,
+allowing the hits to be attributed back to their event when gensteps
+from many events are simulated together, see SEvt::makeHitSplit.
+Without a current event falls back to the SEvt index.
+The track and step also give the deterministic genstep order, see sgsorder.h
+
+**/
+
+static sgsid MakeGenstepID(const G4Track* aTrack)
+{
+    G4EventManager* em = G4EventManager::GetEventManager() ;
+    const G4Event* event = em ? em->GetConstCurrentEvent() : nullptr ;
+    int eventID = event ? event->GetEventID() : SEvt::GetIndex(0) ;
+    return sgsid::Make( eventID, G4Threading::G4GetThreadId(), aTrack->GetTrackID(), aTrack->GetCurrentStepNumber() );
+}
+
+
 static quad6 MakeGenstep_DsG4Scintillation_r4695(
      const G4Track* aTrack,
      const G4Step* aStep,
@@ -180,10 +207,10 @@ void U4::CollectGenstep_DsG4Scintillation_r4695(
     quad6 gs_ = MakeGenstep_DsG4Scintillation_r4695( aTrack, aStep, numPhotons, scnt, ScintillationTime);
 
 #ifdef WITH_CUSTOM4
-    sgs _gs = SEvt::AddGenstep(gs_);    // returns sgs struct which is a simple 4 int label
+    sgs _gs = SEvt::AddGenstep(gs_, MakeGenstepID(aTrack));    // returns sgs struct which is a simple 4 int label
     gs = C4GS::Make(_gs.index, _gs.photons, _gs.offset, _gs.gentype );
 #else
-    gs = SEvt::AddGenstep(gs_);    // returns sgs struct which is a simple 4 int label
+    gs = SEvt::AddGenstep(gs_, MakeGenstepID(aTrack));    // returns sgs struct which is a simple 4 int label
 #endif
     // gs is private static genstep label
 
@@ -305,10 +332,10 @@ void U4::CollectGenstep_G4Cerenkov_modified(
     quad6 gs_ = MakeGenstep_G4Cerenkov_modified( aTrack, aStep, numPhotons, betaInverse, pmin, pmax, maxCos, maxSin2, meanNumberOfPhotons1, meanNumberOfPhotons2 );
 
 #ifdef WITH_CUSTOM4
-    sgs _gs = SEvt::AddGenstep(gs_);    // returns sgs struct which is a simple 4 int label
+    sgs _gs = SEvt::AddGenstep(gs_, MakeGenstepID(aTrack));    // returns sgs struct which is a simple 4 int label
     gs = C4GS::Make(_gs.index, _gs.photons, _gs.offset , _gs.gentype );
 #else
-    gs = SEvt::AddGenstep(gs_);    // returns sgs struct which is a simple 4 int label
+    gs = SEvt::AddGenstep(gs_, MakeGenstepID(aTrack));    // returns sgs struct which is a simple 4 int label
 #endif
     // gs is primate static genstep label
     // TODO: avoid the duplication betweek C and S with common SetGenstep private method
@@ -319,7 +346,31 @@ void U4::CollectGenstep_G4Cerenkov_modified(
 
 
 
+/**
+U4::CheckWorkerSEvt
+---------------------
+
+Genstep collection from the processes is not locked, so from a worker
+thread each SEvt instance must have the per-worker SEvt of the thread
+(see SEvt::CreateOrReuseWorker) otherwise the workers would append
+to the vectors of the shared instance concurrently. Always true on the
+master thread and in sequential running.
+
+**/
 
+bool U4::CheckWorkerSEvt() // static
+{
+    if(G4Threading::IsMasterThread()) return true ;
+    bool ok = true ;
+    for(int idx=0 ; idx < SEvt::MAX_INSTANCE ; idx++) if(SEvt::INSTANCES[idx] && SEvt::WORKERS[idx] == nullptr) ok = false ;
+    LOG_IF(fatal, !ok)
+        << " worker thread " << G4Threading::G4GetThreadId()
+        << " collecting gensteps without per-worker SEvt, call SEvt::CreateOrReuseWorker from the worker BeginOfRunAction "
+        << SEvt::DescINSTANCE()
+        ;
+    assert(ok);
+    return ok ;
+}
 
 
 
@@ -125,6 +125,8 @@ struct U4_API U4
         G4double    meanNumberOfPhotons2
     );
 
+    static bool CheckWorkerSEvt();   // unlocked collection from worker threads needs per-worker SEvt
+
     // optical photon labelling 
     static void GenPhotonAncestor(const G4Track* aTrack );                    // prior to photon generation loop(s)
     static void GenPhotonBegin( int genloop_idx );                            // start of generation loop
@@ -39,6 +39,7 @@ is a default one with zero ce.w extent.
 #include "U4Material.hh"
 #include "U4VolumeMaker.hh"
 #include "U4Recorder.hh"
+#include "U4StepLimit.h"
 #include "U4Random.hh"
 #include "U4Physics.hh"
 #include "U4VPrimaryGenerator.h"
@@ -172,7 +173,7 @@ void U4App::BeginOfRunAction(const G4Run* run)
 }
 void U4App::EndOfRunAction(const G4Run* run)
 {   
-    LOG(info); 
+    LOG(info) << U4StepLimit::Get()->desc() ; 
     fRecorder->EndOfRunAction(run);     
 }
 
@@ -230,7 +231,11 @@ void U4App::EndOfEventAction(const G4Event* event)
 
 void U4App::PreUserTrackingAction(const G4Track* trk){  fRecorder->PreUserTrackingAction(trk); }
 void U4App::PostUserTrackingAction(const G4Track* trk){ fRecorder->PostUserTrackingAction(trk); }
-void U4App::UserSteppingAction(const G4Step* step){     fRecorder->UserSteppingAction(step) ; }
+void U4App::UserSteppingAction(const G4Step* step)
+{
+    fRecorder->UserSteppingAction(step) ; 
+    U4StepLimit::Get()->UserSteppingAction(step) ;  // after recording, truncating as the GPU loop  
+}
 
 
 U4App::~U4App(){  G4GeometryManager::GetInstance()->OpenGeometry(); }
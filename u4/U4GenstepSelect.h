@@ -0,0 +1,119 @@
+#pragma once
+/**
+U4GenstepSelect.h : per material and volume choice of genstep collection
+==========================================================================
+
+Used by Local_G4Cerenkov_modified and Local_DsG4Scintillation in
+genstep only mode (see U4OpticalGenstepPhysics.hh) to decide for each step
+whether to collect a genstep for GPU simulation without creating any
+optical photon tracks or to generate the photons as normal Geant4 secondaries.
+
+The pre-step material and logical volume names are compared with
+prefix match against comma delimited lists, a step is selected when
+either matches. With both lists empty every step is selected.
+
+The answer is cached per G4Material and G4LogicalVolume pointer so after
+the first step in each there is no string comparison. As processes are
+constructed separately for each worker thread there is no sharing of
+the caches between threads.
+
+Collection is not locked either. With multi-threaded Geant4 each worker
+must collect into its own SEvt, see SEvt::CreateOrReuseWorker, which the
+processes check with U4::CheckWorkerSEvt at the first selected step
+recording the result in *checked*.
+
+**/
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <unordered_map>
+
+#include "sstr.h"
+
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Material.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+
+struct U4GenstepSelect
+{
+    std::vector<std::string> material ;
+    std::vector<std::string> volume ;
+
+    std::unordered_map<const G4Material*, bool>      material_cache ;
+    std::unordered_map<const G4LogicalVolume*, bool> volume_cache ;
+
+    bool checked ;
+
+    U4GenstepSelect( const char* materials, const char* volumes );
+
+    bool all() const ;
+    static bool Listed( const std::vector<std::string>& names, const char* name );
+    bool select( const G4Step& step );
+
+    std::string desc() const ;
+};
+
+inline U4GenstepSelect::U4GenstepSelect( const char* materials, const char* volumes )
+    :
+    checked(false)
+{
+    if(materials) sstr::SplitTrimSuppress( materials, ',', material );
+    if(volumes)   sstr::SplitTrimSuppress( volumes,   ',', volume );
+}
+
+inline bool U4GenstepSelect::all() const
+{
+    return material.size() == 0 && volume.size() == 0 ;
+}
+
+inline bool U4GenstepSelect::Listed( const std::vector<std::string>& names, const char* name ) // static
+{
+    for(const std::string& n : names) if( sstr::MatchStart( name, n.c_str() ) ) return true ;
+    return false ;
+}
+
+inline bool U4GenstepSelect::select( const G4Step& step )
+{
+    if( all() ) return true ;
+
+    const G4StepPoint* pre = step.GetPreStepPoint() ;
+
+    const G4Material* mat = pre->GetMaterial() ;
+    if( mat && material.size() > 0 )
+    {
+        auto it = material_cache.find(mat) ;
+        bool sel = it != material_cache.end() ? it->second : ( material_cache[mat] = Listed( material, mat->GetName().c_str() )) ;
+        if( sel ) return true ;
+    }
+
+    const G4VPhysicalVolume* pv = pre->GetPhysicalVolume() ;
+    const G4LogicalVolume* lv = pv ? pv->GetLogicalVolume() : nullptr ;
+    if( lv && volume.size() > 0 )
+    {
+        auto it = volume_cache.find(lv) ;
+        bool sel = it != volume_cache.end() ? it->second : ( volume_cache[lv] = Listed( volume, lv->GetName().c_str() )) ;
+        if( sel ) return true ;
+    }
+    return false ;
+}
+
+inline std::string U4GenstepSelect::desc() const
+{
+    std::stringstream ss ;
+    ss << "U4GenstepSelect::desc"
+       << " all " << ( all() ? "Y" : "N" )
+       << " material [" ;
+    for(size_t i=0 ; i < material.size() ; i++) ss << ( i > 0 ? "," : "" ) << material[i] ;
+    ss << "] volume [" ;
+    for(size_t i=0 ; i < volume.size() ; i++) ss << ( i > 0 ? "," : "" ) << volume[i] ;
+    ss << "]"
+       << " num_material_cached " << material_cache.size()
+       << " num_volume_cached " << volume_cache.size()
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
@@ -5,12 +5,22 @@ U4HitGet.h
 
 See: u4/tests/U4HitTest.cc
 
+FromEvt gets one hit at a time, for all hits of an event use FromEvt_Bulk
+which localizes the hit array with SEvt::localize_hit (see slocalize.h)
+and converts across threads::
+
+    std::vector<U4Hit> hits ;
+    U4HitGet::FromEvt_Bulk(hits, SEvt::EGPU);
+
 
 **/
 
+#include <vector>
+
 #include "scuda.h"
 #include "sphoton.h"
 #include "sphit.h"
+#include "sthread.h"
 
 #include "SEvt.hh"
 #include "U4Hit.h"
@@ -22,6 +32,7 @@ struct U4HitGet
     static void FromEvt_EGPU(U4Hit& hit, unsigned idx );
     static void FromEvt_ECPU(U4Hit& hit, unsigned idx );
     static void FromEvt(U4Hit& hit, unsigned idx, int eidx );
+    static size_t FromEvt_Bulk(std::vector<U4Hit>& hits, int eidx, int num_thread=0 );
 };
 
 
@@ -93,4 +104,37 @@ inline void U4HitGet::FromEvt(U4Hit& hit, unsigned idx, int eidx )
 }
 
 
+/**
+U4HitGet::FromEvt_Bulk
+------------------------
+
+Equivalent to FromEvt for every hit index, returning the number of
+hits that failed localization (see slocalize::localize).
+
+**/
+
+inline size_t U4HitGet::FromEvt_Bulk(std::vector<U4Hit>& hits, int eidx, int num_thread )
+{
+    SEvt* sev = SEvt::Get(eidx);
+    const NP* hit = sev->getHit();
+    size_t num = hit ? hit->shape[0] : 0 ;
+    hits.resize(num);
+    if( num == 0 ) return 0 ;
+
+    std::vector<sphit> ht ;
+    size_t num_bad = 0 ;
+    NP* hitlocal = sev->localize_hit( &ht, &num_bad );
+    assert( hitlocal && ht.size() == num );
+
+    const sphoton* gg = (const sphoton*)hit->cvalues<float>() ;
+    const sphoton* ll = (const sphoton*)hitlocal->cvalues<float>() ;
+
+    sthread::ParallelFor( int64_t(num), [&](int, int64_t i0, int64_t i1)
+    {
+        for(int64_t i=i0 ; i < i1 ; i++) ConvertFromPhoton(hits[i], gg[i], ll[i], ht[i] );
+    }, 1 << 14, num_thread );
+
+    delete hitlocal ;
+    return num_bad ;
+}
 
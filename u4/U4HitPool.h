@@ -0,0 +1,540 @@
+#pragma once
+/**
+U4HitPool.h : pooled bulk injection of Opticks hits into Geant4 hit collections
+==================================================================================
+
+Converting Opticks hits one at a time with *new* of a hit holding three
+G4ThreeVector, classifying the creation process from the flagmask and
+inserting into a shared collection under a global mutex serializes
+all worker threads on heap allocation and the lock.
+
+Instead:
+
+U4OpticksHit
+    compact G4VHit holding the float hit fields, allocated from a
+    thread local G4Allocator : so worker threads never contend on
+    the heap and G4THitsCollection deletion returns hits to the pool
+
+U4HitPool::Convert
+    bulk conversion of an sphoton or sphotonlite span into a collection,
+    reserving the collection vector once
+
+U4HitPool::sync_inject
+    end of batch synchronization for gensteps of several events simulated
+    with one launch. Hits must be injected into the G4HCofThisEvent of
+    each event before the worker finishes the event, so the worker blocks
+    at the end of each event until the launch covering it is done.
+    A launch happens on a dedicated pool thread when every active worker
+    is waiting, so each batch holds the last event of each worker::
+
+        // master BeginOfRunAction
+        U4HitPool::Get()->start( [](int eventID)
+        {
+            SEvt::MergeWorkers(SEvt::EGPU, eventID) ;   // eventID -1 : all published
+            G4CXOpticks::Get()->simulate(0, false) ;
+            seventsplit* split = SEvt::Get_EGPU()->makeHitSplit() ;
+            G4CXOpticks::Get()->reset(0) ;
+            return split ;
+        });
+
+        // worker BeginOfRunAction, in sequential running the master does worker_begin
+        SEvt::CreateOrReuseWorker(SEvt::EGPU) ;
+        U4HitPool::Get()->worker_begin() ;
+
+        // worker, eg G4VSensitiveDetector::EndOfEvent
+        SEvt::PublishWorker(SEvt::EGPU, eventID) ;
+        U4HitPool::Get()->sync_inject( hc, eventID ) ;
+
+        // worker EndOfRunAction
+        U4HitPool::Get()->worker_end() ;
+        SEvt::DeleteWorker(SEvt::EGPU) ;
+
+        // master EndOfRunAction
+        U4HitPool::Get()->stop() ;
+
+    The launch runs on the pool thread, which has no per-worker SEvt,
+    so SEvt::Get_EGPU there is the process wide instance that the worker
+    shards are merged into. The workers only block on the pool mutex and
+    condition at the end of each event, the hits of each event are
+    converted by its own worker from the pool of that thread.
+
+    With sphotonlite hits, which lack the photon index needed to split
+    a multi event launch (see seventsplit.h), start with per_event true:
+    the waiting events are then launched one at a time with their eventID.
+
+When each event is simulated in its own launch outside the pool no split
+is needed, use *Convert* with the SEvt hit array directly.
+
+Applications that also support the end of run batch launch select the
+pool with envvar U4HitPool__ENABLE, see U4HitPool::Enabled and the
+OpticksSD of src/GPURaytrace.h.
+
+::
+
+    ~/opticks/u4/tests/U4HitPool_test.sh
+
+**/
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <string>
+#include <sstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "scuda.h"
+#include "sphoton.h"
+#include "sphotonlite.h"
+#include "seventsplit.h"
+#include "OpticksPhoton.hh"
+#include "NP.hh"
+#include "ssys.h"
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+#include "G4ThreeVector.hh"
+#include "G4Threading.hh"
+#include "G4ios.hh"
+
+
+struct U4OpticksHit : public G4VHit
+{
+    enum { CREATOR_OTHER=-1, CREATOR_CERENKOV=0, CREATOR_SCINTILLATION=1 } ;
+
+    float    time ;
+    float    wavelength ;
+    float3   pos ;         // global frame, zero from sphotonlite
+    float3   mom ;
+    float3   pol ;
+    float    lposcost ;    // local position from sphotonlite only
+    float    lposfphi ;
+    unsigned identity ;
+    unsigned flagmask ;
+    unsigned index ;
+    int      eventID ;
+
+    static G4Allocator<U4OpticksHit>*& Allocator();
+    inline void* operator new(size_t);
+    inline void  operator delete(void* hit);
+
+    void set( const sphoton& p, int eventID=-1 );
+    void set( const sphotonlite& l, int eventID=-1 );
+
+    int creator() const ;
+    G4ThreeVector position() const {     return G4ThreeVector(pos.x, pos.y, pos.z) ; }
+    G4ThreeVector direction() const {    return G4ThreeVector(mom.x, mom.y, mom.z) ; }
+    G4ThreeVector polarization() const { return G4ThreeVector(pol.x, pol.y, pol.z) ; }
+
+    void Print() override ;
+};
+
+using U4OpticksHitsCollection = G4THitsCollection<U4OpticksHit> ;
+
+
+/**
+U4OpticksHit::Allocator
+-------------------------
+
+One pool per thread, created on first use by that thread.
+Hits must be deleted by the thread that created them, as
+G4THitsCollection does at the end of the event.
+
+**/
+
+inline G4Allocator<U4OpticksHit>*& U4OpticksHit::Allocator() // static
+{
+    static G4ThreadLocal G4Allocator<U4OpticksHit>* alloc = nullptr ;
+    return alloc ;
+}
+
+inline void* U4OpticksHit::operator new(size_t)
+{
+    G4Allocator<U4OpticksHit>*& alloc = Allocator() ;
+    if( alloc == nullptr ) alloc = new G4Allocator<U4OpticksHit> ;
+    return (void*)alloc->MallocSingle();
+}
+
+inline void U4OpticksHit::operator delete(void* hit)
+{
+    Allocator()->FreeSingle((U4OpticksHit*)hit);
+}
+
+inline void U4OpticksHit::set( const sphoton& p, int eventID_ )
+{
+    time = p.time ;
+    wavelength = p.wavelength ;
+    pos = p.pos ;
+    mom = p.mom ;
+    pol = p.pol ;
+    lposcost = 0.f ;
+    lposfphi = 0.f ;
+    identity = p.pmtid() ;
+    flagmask = p.flagmask ;
+    index = unsigned(p.get_index()) ;
+    eventID = eventID_ ;
+}
+
+inline void U4OpticksHit::set( const sphotonlite& l, int eventID_ )
+{
+    time = l.time ;
+    wavelength = 0.f ;
+    pos = make_float3(0.f, 0.f, 0.f) ;
+    mom = pos ;
+    pol = pos ;
+    l.get_lpos(lposcost, lposfphi);
+    identity = l.identity() ;
+    flagmask = l.flagmask ;
+    index = 0u ;
+    eventID = eventID_ ;
+}
+
+/**
+U4OpticksHit::creator
+-----------------------
+
+Creation process from the flagmask of the genstep type, 0:Cerenkov 1:Scintillation -1:other
+
+**/
+
+inline int U4OpticksHit::creator() const
+{
+    if( OpticksPhoton::HasCerenkovFlag(flagmask) ) return CREATOR_CERENKOV ;
+    if( OpticksPhoton::HasScintillationFlag(flagmask) ) return CREATOR_SCINTILLATION ;
+    return CREATOR_OTHER ;
+}
+
+inline void U4OpticksHit::Print()
+{
+    G4cout
+        << "U4OpticksHit"
+        << " identity " << identity
+        << " time " << time
+        << " wavelength " << wavelength
+        << " pos " << position()
+        << " creator " << creator()
+        << " eventID " << eventID
+        << G4endl
+        ;
+}
+
+
+
+struct U4HitPool
+{
+    using Launch = std::function<seventsplit*(int eventID)> ;   // eventID -1 : all waiting events in one launch
+
+    static U4HitPool* Get();
+    static bool Enabled();
+
+    mutable std::mutex      mtx ;
+    std::condition_variable cv ;
+    std::thread             launcher ;
+
+    Launch           launch ;
+    bool             per_event ;
+    bool             running ;
+    int              num_active ;     // workers between worker_begin and worker_end
+    std::vector<int> waiting ;        // eventIDs of blocked workers not yet launched
+    std::map<int, std::shared_ptr<const seventsplit>> done ;   // by eventID, until injected
+
+    int64_t num_launch ;
+    int64_t num_injected ;
+    int64_t num_refused ;
+
+    U4HitPool();
+    ~U4HitPool();
+
+    template<typename T>
+    static size_t Convert( U4OpticksHitsCollection* hc, const T* hh, int64_t num, int eventID=-1 );
+    static size_t Convert( U4OpticksHitsCollection* hc, const NP* hit, int eventID=-1 );
+    static size_t Convert( U4OpticksHitsCollection* hc, const seventsplit* split, int i, int eventID );
+
+    void start( Launch launch, bool per_event=false );
+    void worker_begin();
+    void worker_end();
+    size_t sync_inject( U4OpticksHitsCollection* hc, int eventID );
+    void stop();
+
+    bool ready() const ;
+    void launch_loop();
+
+    std::string desc() const ;
+};
+
+inline U4HitPool* U4HitPool::Get() // static
+{
+    static U4HitPool pool ;
+    return &pool ;
+}
+
+/**
+U4HitPool::Enabled
+--------------------
+
+Envvar U4HitPool__ENABLE selects per event hit injection via the pool
+over the end of run batch launch in applications supporting both.
+
+**/
+
+inline bool U4HitPool::Enabled() // static
+{
+    static bool enabled = ssys::getenvbool("U4HitPool__ENABLE") ;
+    return enabled ;
+}
+
+inline U4HitPool::U4HitPool()
+    :
+    per_event(false),
+    running(false),
+    num_active(0),
+    num_launch(0),
+    num_injected(0),
+    num_refused(0)
+{
+}
+
+inline U4HitPool::~U4HitPool()
+{
+    stop();
+}
+
+/**
+U4HitPool::Convert
+--------------------
+
+Appends *num* hits to the collection, allocating from the pool of
+the calling thread. T is sphoton or sphotonlite.
+
+**/
+
+template<typename T>
+inline size_t U4HitPool::Convert( U4OpticksHitsCollection* hc, const T* hh, int64_t num, int eventID ) // static
+{
+    if( hc == nullptr || hh == nullptr || num <= 0 ) return 0 ;
+    std::vector<U4OpticksHit*>* vec = hc->GetVector() ;
+    vec->reserve( vec->size() + num );
+    for(int64_t i=0 ; i < num ; i++)
+    {
+        U4OpticksHit* hit = new U4OpticksHit ;
+        hit->set( hh[i], eventID );
+        vec->push_back(hit);
+    }
+    return size_t(num) ;
+}
+
+/**
+U4HitPool::Convert
+--------------------
+
+Full (-1,4,4) float sphoton or (-1,4) uint sphotonlite hit array, as from SEvt::getHit.
+
+**/
+
+inline size_t U4HitPool::Convert( U4OpticksHitsCollection* hc, const NP* hit, int eventID ) // static
+{
+    if( hit == nullptr ) return 0 ;
+    if( hit->uifc == 'f' && hit->has_shape(-1,4,4) ) return Convert( hc, (const sphoton*)hit->bytes(), hit->shape[0], eventID );
+    if( sphotonlite::expected(hit) ) return Convert( hc, (const sphotonlite*)hit->bytes(), hit->shape[0], eventID );
+    G4cerr << "U4HitPool::Convert unexpected hit array " << hit->sstr() << G4endl ;
+    return 0 ;
+}
+
+/**
+U4HitPool::Convert
+--------------------
+
+Hits of event slot i of the split, sphoton or sphotonlite.
+
+**/
+
+inline size_t U4HitPool::Convert( U4OpticksHitsCollection* hc, const seventsplit* split, int i, int eventID ) // static
+{
+    if( split == nullptr || i < 0 ) return 0 ;
+    return split->is_lite()
+        ? Convert( hc, split->hits_lite(i), split->num_hit(i), eventID )
+        : Convert( hc, split->hits(i),      split->num_hit(i), eventID )
+        ;
+}
+
+/**
+U4HitPool::start
+------------------
+
+Call from the master BeginOfRunAction, before the workers begin.
+Starts the pool thread that runs *launch* for each batch.
+
+**/
+
+inline void U4HitPool::start( Launch launch_, bool per_event_ )
+{
+    stop();
+    std::lock_guard<std::mutex> lock(mtx) ;
+    launch = launch_ ;
+    per_event = per_event_ ;
+    running = true ;
+    num_active = 0 ;
+    waiting.clear();
+    done.clear();
+    launcher = std::thread( &U4HitPool::launch_loop, this ) ;
+}
+
+inline void U4HitPool::worker_begin()
+{
+    std::lock_guard<std::mutex> lock(mtx) ;
+    num_active += 1 ;
+}
+
+/**
+U4HitPool::worker_end
+-----------------------
+
+Call from the worker EndOfRunAction, the worker no longer holds back
+a batch of the remaining workers.
+
+**/
+
+inline void U4HitPool::worker_end()
+{
+    std::lock_guard<std::mutex> lock(mtx) ;
+    num_active -= 1 ;
+    cv.notify_all();
+}
+
+/**
+U4HitPool::ready
+------------------
+
+With the mutex held : a batch is launched when every active worker waits.
+
+**/
+
+inline bool U4HitPool::ready() const
+{
+    return !waiting.empty() && int(waiting.size()) >= num_active ;
+}
+
+/**
+U4HitPool::sync_inject
+------------------------
+
+Call from the worker at the end of event *eventID*, after publishing
+the gensteps of the event. Blocks until the launch covering the event
+is done then converts its hits into *hc* from the calling thread.
+Hits are refused when the gensteps of the event came from another
+thread, unless either is not known (-1, eg sequential mode).
+Returns the number of hits added.
+
+**/
+
+inline size_t U4HitPool::sync_inject( U4OpticksHitsCollection* hc, int eventID )
+{
+    std::shared_ptr<const seventsplit> s ;
+    {
+        std::unique_lock<std::mutex> lock(mtx) ;
+        if(!running) return 0 ;
+        waiting.push_back(eventID) ;
+        cv.notify_all();
+        cv.wait( lock, [this, eventID]{ return done.count(eventID) > 0 || !running ; } );
+        auto it = done.find(eventID) ;
+        if( it == done.end() ) return 0 ;
+        s = it->second ;
+        done.erase(it) ;
+    }
+
+    int i = s ? s->find(eventID) : -1 ;
+    if( i < 0 ) return 0 ;
+
+    int tid = G4Threading::G4GetThreadId() ;
+    int owner = s->threadID[i] ;
+    if( tid >= 0 && owner != -1 && owner != tid )
+    {
+        std::lock_guard<std::mutex> lock(mtx) ;
+        num_refused += s->num_hit(i) ;
+        G4cerr << "U4HitPool::sync_inject refused eventID " << eventID << " from thread " << tid << " owner " << owner << G4endl ;
+        return 0 ;
+    }
+
+    size_t num = Convert( hc, s.get(), i, eventID );
+    std::lock_guard<std::mutex> lock(mtx) ;
+    num_injected += num ;
+    return num ;
+}
+
+/**
+U4HitPool::launch_loop
+------------------------
+
+Pool thread : takes the waiting events when the batch is ready, runs
+the launch without the mutex held and makes the splits available to
+the waiting workers. Events missing from a split, eg without gensteps,
+get no hits. A nullptr split releases its workers without hits.
+
+**/
+
+inline void U4HitPool::launch_loop()
+{
+    std::unique_lock<std::mutex> lock(mtx) ;
+    while(true)
+    {
+        cv.wait( lock, [this]{ return ready() || !running ; } );
+        if(!running) break ;
+
+        std::vector<int> evts ;
+        evts.swap(waiting) ;
+        lock.unlock();
+
+        std::map<int, std::shared_ptr<const seventsplit>> result ;
+        if( per_event )
+        {
+            for(int e : evts) result[e] = std::shared_ptr<const seventsplit>( launch(e) ) ;
+        }
+        else
+        {
+            std::shared_ptr<const seventsplit> s( launch(-1) ) ;
+            for(int e : evts) result[e] = s ;
+        }
+
+        lock.lock();
+        num_launch += per_event ? int64_t(evts.size()) : 1 ;
+        for(auto& r : result) done[r.first] = r.second ;
+        cv.notify_all();
+    }
+}
+
+/**
+U4HitPool::stop
+-----------------
+
+Call from the master EndOfRunAction, after the workers are done.
+Releases any still waiting workers without hits and joins the pool thread.
+
+**/
+
+inline void U4HitPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx) ;
+        running = false ;
+        cv.notify_all();
+    }
+    if( launcher.joinable() ) launcher.join();
+}
+
+inline std::string U4HitPool::desc() const
+{
+    std::lock_guard<std::mutex> lock(mtx) ;
+    std::stringstream ss ;
+    ss << "U4HitPool::desc"
+       << " per_event " << ( per_event ? "Y" : "N" )
+       << " num_launch " << num_launch
+       << " num_injected " << num_injected
+       << " num_refused " << num_refused
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
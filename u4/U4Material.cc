@@ -4,6 +4,7 @@
 #include <sstream>
 #include <limits>
 #include <csignal>
+#include <cmath>
 
 #include "ssys.h"
 #include "spath.h"
@@ -16,6 +17,7 @@
 #include "SBnd.h"
 #include "sdomain.h"
 #include "sproplist.h"
+#include "sresample.h"
 
 #include "NPFold.h"
 #include "NP.hh"
@@ -616,7 +618,25 @@ NP* U4Material::MakePropertyArray( double value ) // static
 U4Material::MakeStandardArray
 -----------------------------
 
-Canonically invoked from U4Tree::initMaterials
+Canonically invoked from U4Tree::initMaterials, uses the sweep of
+MakeStandardArray_Batch unless U4Material__MakeStandardArray_Value is set.
+
+**/
+
+NP* U4Material::MakeStandardArray(
+    std::vector<const G4Material*>& mats,
+    const std::map<std::string,G4PhysicsVector*>& prop_override ) // static
+{
+    bool value = ssys::getenvbool(_MakeStandardArray_Value) ;
+    LOG(LEVEL) << _MakeStandardArray_Value << " " << value ;
+    return value ? MakeStandardArray_Value(mats, prop_override) : MakeStandardArray_Batch(mats, prop_override) ;
+}
+
+/**
+U4Material::MakeStandardArray_Value
+-------------------------------------
+
+Per value G4PhysicsVector::Value for every domain point of every property.
 
 Hmm this is just accessing the MPT of each material and
 getting the standard properties or defaults when not present.
@@ -629,7 +649,7 @@ So need to override the source of some props.
 
 **/
 
-NP* U4Material::MakeStandardArray(
+NP* U4Material::MakeStandardArray_Value(
     std::vector<const G4Material*>& mats,
     const std::map<std::string,G4PhysicsVector*>& prop_override ) // static
 {
@@ -721,6 +741,118 @@ NP* U4Material::MakeStandardArray(
 
 
 
+/**
+U4Material::MakeStandardArray_Batch
+-------------------------------------
+
+Same array as MakeStandardArray_Value. Each property vector is extracted
+once into the contiguous table of sresample, with one MPT lookup per
+property rather than per domain point, and each is resampled with a
+single sweep along the domain.
+
+sresample follows the linear G4PhysicsVector::Value, a property vector
+with spline interpolation is detected by comparing with Value at the
+midpoint of every bin and is then filled per value as before.
+
+**/
+
+NP* U4Material::MakeStandardArray_Batch(
+    std::vector<const G4Material*>& mats,
+    const std::map<std::string,G4PhysicsVector*>& prop_override ) // static
+{
+    sdomain dom ;
+    const sproplist* pl = sproplist::Material() ;
+
+    int ni = mats.size() ;
+    int nj = sprop::NUM_PAYLOAD_GRP ;
+    int nk = dom.length ;
+    int nl = sprop::NUM_PAYLOAD_VAL ;
+    int np = nj*nl ;
+
+    std::vector<double> energy(nk) ;
+    for(int k=0 ; k < nk ; k++) energy[k] = dom.energy_eV[k] * eV ;
+
+    sresample rs(energy.data(), nk) ;
+    std::vector<std::pair<int,const G4PhysicsVector*>> spline ;
+
+    std::vector<std::string> names ;
+    typedef std::map<std::string,int> SI ;
+    SI override_count ;
+
+    for(int i=0 ; i < ni ; i++)
+    {
+        const G4Material* mat = mats[i] ;
+        const G4String& name = mat->GetName() ;
+        names.push_back(name.c_str()) ;
+        G4MaterialPropertiesTable* mpt = mat->GetMaterialPropertiesTable();
+        LOG_IF(LEVEL, mpt == nullptr ) << "U4Material::MakeStandardArray_Batch NO MPT " << name ;
+
+        rs.add_group(name.c_str()) ;
+        for(int p=0 ; p < np ; p++)
+        {
+            const sprop* pr = pl->get(p/nl, p%nl) ;
+            assert( pr );
+            const char* key = pr->name ;
+
+            std::stringstream ss ;
+            ss << name << "/" << key ;
+            std::string spec = ss.str() ; // eg "Water/RAYLEIGH"
+
+            bool has_override = prop_override.count(spec) > 0 ;
+            if(has_override) override_count[spec] += nk ;
+
+            const G4PhysicsVector* prop = has_override ? prop_override.at(spec) : ( mpt ? mpt->GetProperty(key) : nullptr ) ;
+            int64_t num = prop ? prop->GetVectorLength() : 0 ;
+            double* xy = rs.add( num, pr->def );
+            for(int64_t v=0 ; v < num ; v++)
+            {
+                xy[2*v+0] = prop->Energy(v) ;
+                xy[2*v+1] = (*prop)[v] ;
+            }
+
+            for(int64_t v=0 ; v + 1 < num && num > 2 ; v++)
+            {
+                double e = 0.5*(xy[2*v] + xy[2*(v+1)]) ;
+                double lin = xy[2*v+1] + 0.5*(xy[2*(v+1)+1] - xy[2*v+1]) ;
+                double val = prop->Value(e) ;
+                if( std::abs(lin - val) <= 1e-9*std::max(1., std::abs(val)) ) continue ;
+                spline.push_back( {i*np + p, prop} );
+                break ;
+            }
+        }
+    }
+
+    std::vector<double> out(int64_t(ni)*np*nk) ;
+    rs.resample( out.data() ) ;
+
+    for(const auto& sp : spline)
+    {
+        LOG(LEVEL) << "spline property " << names[sp.first/np] << " " << pl->get((sp.first%np)/nl, sp.first%nl)->name ;
+        for(int k=0 ; k < nk ; k++) out[int64_t(sp.first)*nk + k] = sp.second->Value(energy[k]) ;
+    }
+
+    NP* a = NP::Make<double>(ni, nj, nk, nl );
+    double* aa = a->values<double>() ;
+    for(int i=0 ; i < ni ; i++)
+    for(int p=0 ; p < np ; p++)
+    {
+        const double* src = out.data() + (int64_t(i)*np + p)*nk ;
+        double* dst = aa + int64_t(i)*nj*nk*nl + (p/nl)*nk*nl + p%nl ;
+        for(int k=0 ; k < nk ; k++) dst[k*nl] = src[k] ;
+    }
+    a->set_names(names) ;
+
+    std::stringstream oc ;
+    for(SI::const_iterator it=override_count.begin() ; it != override_count.end() ; it++)
+        oc << it->first << ":" << it->second << "," ;
+    std::string oc_report = oc.str();
+    a->set_meta<std::string>("override_count", oc_report );
+
+    LOG(LEVEL) << rs.desc() << " num_spline " << spline.size() ;
+    return a ;
+}
+
+
 /**
 U4Material::Classify
 ---------------------
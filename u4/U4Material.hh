@@ -65,10 +65,19 @@ struct U4_API U4Material
     static G4MaterialPropertyVector* MakeProperty( double value ); 
     static G4MaterialPropertyVector* MakeProperty(const NP* a); 
     static NP* MakePropertyArray( double value ); 
+    static constexpr const char* _MakeStandardArray_Value = "U4Material__MakeStandardArray_Value" ; 
     static NP* MakeStandardArray(
           std::vector<const G4Material*>& mats,
           const std::map<std::string,G4PhysicsVector*>& prop_override
        ); 
+    static NP* MakeStandardArray_Value(
+          std::vector<const G4Material*>& mats,
+          const std::map<std::string,G4PhysicsVector*>& prop_override
+       ); 
+    static NP* MakeStandardArray_Batch(
+          std::vector<const G4Material*>& mats,
+          const std::map<std::string,G4PhysicsVector*>& prop_override
+       ); 
 
     static char Classify(const NP* a); 
     static std::string Desc(const char* key, const NP* a ); 
@@ -23,11 +23,44 @@ allowing 3D visualization with quads as well as triangles.
 
 For use with OpenGL rendering its natural to use "vtx" and "tri".
 
+
+Mesh cache
+-----------
+
+Polygonization of tori, polycones and multi-unions is expensive and
+is repeated on every translation although solid parameters rarely change.
+U4Mesh::MakeFold therefore keys each solid by a digest of its
+parameters (G4VSolid::StreamInfo without the names), the number of rotation
+steps and G4VERSION_NUMBER, so solids with identical parameters are
+polygonized once. When enabled the serialized arrays are persisted in a
+content addressed cache directory that is reused across runs::
+
+    $HOME/.opticks/U4MeshCache/<digest>/{vtx,fpd,face,tri,tpd}.npy
+
+The cache is opt-in with envvar U4Mesh__CACHE, value "1" for the above
+default directory or the path of another directory, unset or "0" for
+no cache. Each entry is saved into a temporary sibling directory which
+is then renamed, so concurrent processes never load partial entries.
+Cache misses are polygonized concurrently
+with sthread::ParallelFor. As G4Polyhedron rotation steps are thread local
+that is safe for primitives, but boolean and multi-union polygonization
+goes through HepPolyhedronProcessor and is serialized with a mutex.
+
+Bump CACHE_VERSION when the serialized arrays change.
+
 **/
 
 #include <map>
+#include <mutex>
+#include <dirent.h>
+#include "G4Version.hh"
 #include "G4Polyhedron.hh"
+#include "G4BooleanSolid.hh"
+#include "G4MultiUnion.hh"
 #include "ssys.h"
+#include "spath.h"
+#include "sdigest.h"
+#include "sthread.h"
 #include "NPX.h"
 #include "NPFold.h"
 
@@ -36,6 +69,9 @@ struct U4Mesh
 {
     static constexpr const char* U4Mesh__NumberOfRotationSteps = "U4Mesh__NumberOfRotationSteps" ;
     static constexpr const char* _NumberOfRotationSteps_DUMP = "U4Mesh__NumberOfRotationSteps_DUMP" ;
+    static constexpr const char* _CACHE = "U4Mesh__CACHE" ;
+    static constexpr const char* CACHE_DEFAULT = "$HOME/.opticks/U4MeshCache" ;
+    static constexpr int CACHE_VERSION = 1 ;
 
 
     const G4VSolid* solid ;
@@ -67,6 +103,15 @@ struct U4Mesh
        const std::vector<std::string>& keys
       );
     static NPFold* Serialize(const G4VSolid* solid) ;
+
+    static const char* CacheDir();
+    static void CacheSave(NPFold* fold, const char* cache, const char* digest);
+    static void RemoveDir(const char* dir);
+    static std::string SolidParam(const G4VSolid* solid);
+    static std::string Digest(const G4VSolid* solid, int numberOfRotationSteps);
+    static bool IsSerialOnly(const G4VSolid* solid);
+    static std::mutex& SerialMutex();
+    static NPFold* Serialize_Concurrent(const G4VSolid* solid);
     static const char* EType(const G4VSolid* solid);
     static const char* SolidName(const G4VSolid* solid);
 
@@ -116,6 +161,15 @@ inline void U4Mesh::Save(const G4VSolid* solid, const char* base, const char* na
 U4Mesh::MakeFold
 ----------------
 
+1. digest each solid, the first solid with each digest is the unique one
+2. load unique digests from the cache
+3. polygonize the cache misses concurrently and save them into the cache
+4. each solid gets its own subfold with its own metadata, solids sharing
+   a digest get copies of the arrays
+
+The subfolds are the same as from U4Mesh::Serialize with the addition
+of "digest" metadata.
+
 **/
 
 inline NPFold* U4Mesh::MakeFold(
@@ -123,22 +177,80 @@ inline NPFold* U4Mesh::MakeFold(
     const std::vector<std::string>& keys
    ) // static
 {
-    NPFold* mesh = new NPFold ;
     int num_solid = solids.size();
     int num_key = keys.size();
     assert( num_solid == num_key );
 
+    const char* cache = CacheDir() ;
+
+    std::vector<const char*> etype(num_solid) ;
+    std::vector<const char*> sname(num_solid) ;
+    std::vector<int> nrs(num_solid) ;
+    std::vector<std::string> digest(num_solid) ;
+    std::vector<int> slot(num_solid) ;    // index into uniq
+    std::vector<int> uniq ;               // index of first solid with each digest
+    std::map<std::string, int> digest_slot ;
+
     for(int i=0 ; i < num_solid ; i++)
     {
-        int lvid = i ;
         const G4VSolid* so = solids[i];
+        etype[i] = EType(so) ;
+        sname[i] = SolidName(so) ;
+        nrs[i] = NumberOfRotationSteps(etype[i], sname[i]) ;
+        digest[i] = Digest(so, nrs[i]) ;
+
+        auto it = digest_slot.find(digest[i]) ;
+        if( it == digest_slot.end() )
+        {
+            slot[i] = uniq.size() ;
+            digest_slot[digest[i]] = slot[i] ;
+            uniq.push_back(i) ;
+        }
+        else
+        {
+            slot[i] = it->second ;
+        }
+    }
+
+    int num_uniq = uniq.size() ;
+    std::vector<NPFold*> ufold(num_uniq, nullptr) ;
+    std::vector<int> miss ;
+    for(int u=0 ; u < num_uniq ; u++)
+    {
+        if(cache) ufold[u] = NPFold::LoadIfExists( spath::Resolve(cache, digest[uniq[u]].c_str()) ) ;
+        if(ufold[u] == nullptr) miss.push_back(u) ;
+    }
+
+    sthread::ParallelFor( miss.size(), [&](int, int64_t m0, int64_t m1)
+    {
+        for(int64_t m=m0 ; m < m1 ; m++) ufold[miss[m]] = Serialize_Concurrent( solids[uniq[miss[m]]] ) ;
+    }, 1 );
+
+    if(cache) for(int u : miss) CacheSave( ufold[u], cache, digest[uniq[u]].c_str() );
+
+    NPFold* mesh = new NPFold ;
+    std::vector<bool> used(num_uniq, false) ;
+    for(int i=0 ; i < num_solid ; i++)
+    {
+        int lvid = i ;
+        int u = slot[i] ;
         const char* _key = keys[i].c_str();
 
-        NPFold* sub = Serialize(so) ;
+        NPFold* sub = used[u] ? ufold[u]->deepcopy() : ufold[u] ;
+        used[u] = true ;
+
+        sub->set_meta<std::string>("entityType", etype[i]);
+        sub->set_meta<std::string>("solidName",  sname[i]);
+        if( nrs[i] > 0 ) sub->set_meta<int>("numberOfRotationSteps", nrs[i] );
+        sub->set_meta<std::string>("digest", digest[i]);
         sub->set_meta<int>("lvid", lvid );
 
         mesh->add_subfold( _key, sub );
     }
+
+    mesh->set_meta<int>("num_solid", num_solid );
+    mesh->set_meta<int>("num_uniq", num_uniq );
+    mesh->set_meta<int>("num_miss", int(miss.size()) );
     return mesh ;
 }
 
@@ -148,6 +260,125 @@ inline NPFold* U4Mesh::Serialize(const G4VSolid* solid) // static
     return mesh.serialize() ;
 }
 
+/**
+U4Mesh::CacheDir
+------------------
+
+Resolved U4Mesh__CACHE directory, CACHE_DEFAULT for "1", nullptr when unset or "0"
+
+**/
+
+inline const char* U4Mesh::CacheDir() // static
+{
+    const char* cache = ssys::getenvvar(_CACHE) ;
+    if( cache == nullptr || strcmp(cache, "0") == 0 ) return nullptr ;
+    return spath::Resolve( strcmp(cache, "1") == 0 ? CACHE_DEFAULT : cache ) ;
+}
+
+/**
+U4Mesh::CacheSave
+-------------------
+
+Saves into "<digest>.tmp<pid>" then renames to "<digest>". When another
+process got there first the rename fails and the temporary is removed,
+the entries are identical as the digest includes everything they depend on.
+
+**/
+
+inline void U4Mesh::CacheSave(NPFold* fold, const char* cache, const char* digest) // static
+{
+    std::stringstream ss ;
+    ss << digest << ".tmp" << getpid() ;
+    std::string tmp = ss.str();
+
+    fold->save( cache, tmp.c_str() );
+
+    const char* tmpdir = spath::Resolve(cache, tmp.c_str()) ;
+    const char* dir = spath::Resolve(cache, digest) ;
+    if( rename(tmpdir, dir) != 0 ) RemoveDir(tmpdir) ;
+}
+
+/**
+U4Mesh::RemoveDir
+-------------------
+
+Removes a directory of files, as written by NPFold::save without subfolds.
+
+**/
+
+inline void U4Mesh::RemoveDir(const char* dir) // static
+{
+    DIR* d = opendir(dir) ;
+    if( d == nullptr ) return ;
+    struct dirent* e ;
+    while( (e = readdir(d)) != nullptr )
+    {
+        if( strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0 ) continue ;
+        remove( spath::Resolve(dir, e->d_name) );
+    }
+    closedir(d);
+    rmdir(dir);
+}
+
+/**
+U4Mesh::SolidParam
+--------------------
+
+G4VSolid::StreamInfo lists the solid parameters recursively through
+boolean constituents and displacements. The "*** Dump for solid - name ***"
+header lines are skipped so differently named solids with the same parameters match.
+
+As MakeFold deduplicates solids by this digest even without the cache,
+the parameters are streamed with precision 17, enough to round trip a
+double, so solids differing only beyond the default 6 significant digits
+do not share a mesh. Solids whose StreamInfo sets its own precision
+(many use 16) keep that.
+
+**/
+
+inline std::string U4Mesh::SolidParam(const G4VSolid* solid) // static
+{
+    std::stringstream info ;
+    info.precision(17);
+    solid->StreamInfo(info);
+
+    std::stringstream ss ;
+    std::string line ;
+    while(std::getline(info, line))
+    {
+        bool named = line.find("Dump for") != std::string::npos || line.find("name") != std::string::npos ;
+        if(!named) ss << line << "\n" ;
+    }
+    std::string str = ss.str();
+    return str ;
+}
+
+inline std::string U4Mesh::Digest(const G4VSolid* solid, int numberOfRotationSteps) // static
+{
+    std::stringstream ss ;
+    ss << "U4Mesh:" << CACHE_VERSION << ":" << G4VERSION_NUMBER << ":" << numberOfRotationSteps << "\n" << SolidParam(solid) ;
+    std::string str = ss.str();
+    return sdigest::Buf(str.c_str(), str.size()) ;
+}
+
+inline bool U4Mesh::IsSerialOnly(const G4VSolid* solid) // static
+{
+    return dynamic_cast<const G4BooleanSolid*>(solid) != nullptr || dynamic_cast<const G4MultiUnion*>(solid) != nullptr ;
+}
+
+inline std::mutex& U4Mesh::SerialMutex() // static
+{
+    static std::mutex mtx ;
+    return mtx ;
+}
+
+inline NPFold* U4Mesh::Serialize_Concurrent(const G4VSolid* solid) // static
+{
+    if(!IsSerialOnly(solid)) return Serialize(solid) ;
+    std::lock_guard<std::mutex> lock(SerialMutex()) ;
+    return Serialize(solid) ;
+}
+
 inline const char* U4Mesh::EType(const G4VSolid* solid)  // static
 {
     G4GeometryType _etype = solid->GetEntityType();  // G4GeometryType typedef for G4String
@@ -0,0 +1,126 @@
+#include <iomanip>
+#include <sstream>
+
+#include "ssys.h"
+#include "SLOG.hh"
+
+#include "G4ParticleDefinition.hh"
+#include "G4ProcessManager.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4OpAbsorption.hh"
+#include "G4OpRayleigh.hh"
+
+#include "Local_G4Cerenkov_modified.hh"
+#include "Local_DsG4Scintillation.hh"
+#include "U4GenstepSelect.h"
+#include "U4Physics.hh"
+#include "U4OpticalGenstepPhysics.hh"
+
+const plog::Severity U4OpticalGenstepPhysics::LEVEL = SLOG::EnvLevel("U4OpticalGenstepPhysics", "DEBUG") ;
+
+U4OpticalGenstepPhysics::U4OpticalGenstepPhysics( const char* materials_, const char* volumes_ )
+    :
+    G4VPhysicsConstructor("OpticalGenstep"),
+    materials( materials_ ? materials_ : ssys::getenvvar(_MATERIALS) ),
+    volumes(   volumes_   ? volumes_   : ssys::getenvvar(_VOLUMES) ),
+    Cerenkov_DISABLE(ssys::getenvint(_Cerenkov_DISABLE, 0)),
+    Scintillation_DISABLE(ssys::getenvint(_Scintillation_DISABLE, 0))
+{
+}
+
+bool U4OpticalGenstepPhysics::all() const
+{
+    U4GenstepSelect sel(materials, volumes) ;
+    return sel.all() ;
+}
+
+void U4OpticalGenstepPhysics::ConstructParticle()
+{
+    G4OpticalPhoton::Definition();
+}
+
+/**
+U4OpticalGenstepPhysics::ConstructProcess
+-------------------------------------------
+
+Called for the master and each worker thread, so every thread gets
+its own processes and selection caches.  Process ordering follows
+U4Physics::ConstructOp.
+
+**/
+
+void U4OpticalGenstepPhysics::ConstructProcess()
+{
+    LOG(LEVEL) << desc() ;
+
+    Local_G4Cerenkov_modified* cerenkov = nullptr ;
+    if(Cerenkov_DISABLE == 0)
+    {
+        cerenkov = new Local_G4Cerenkov_modified ;
+        cerenkov->SetMaxNumPhotonsPerStep(10000);
+        cerenkov->SetMaxBetaChangePerStep(10.0);
+        cerenkov->SetTrackSecondariesFirst(true);
+        cerenkov->SetGenstepOnly(new U4GenstepSelect(materials, volumes));
+    }
+
+    Local_DsG4Scintillation* scintillation = nullptr ;
+    if(Scintillation_DISABLE == 0)
+    {
+        scintillation = new Local_DsG4Scintillation(0) ;
+        scintillation->SetTrackSecondariesFirst(true);
+        scintillation->SetGenstepOnly(new U4GenstepSelect(materials, volumes));
+    }
+
+    bool tracking = !all() ;   // some steps make optical photon secondaries
+
+    auto particleIterator = GetParticleIterator();
+    particleIterator->reset();
+    while( (*particleIterator)() )
+    {
+        G4ParticleDefinition* particle = particleIterator->value();
+        G4ProcessManager* pmanager = particle->GetProcessManager();
+        G4String particleName = particle->GetParticleName();
+
+        if( cerenkov && cerenkov->IsApplicable(*particle))
+        {
+            pmanager->AddProcess(cerenkov);
+            pmanager->SetProcessOrdering(cerenkov, idxPostStep);
+        }
+
+        if( scintillation && scintillation->IsApplicable(*particle) && particleName != "opticalphoton")
+        {
+            pmanager->AddProcess(scintillation);
+            pmanager->SetProcessOrderingToLast(scintillation, idxAtRest);
+            pmanager->SetProcessOrderingToLast(scintillation, idxPostStep);
+        }
+
+        if( particleName == "opticalphoton" && tracking )
+        {
+            if(scintillation)
+            {
+                pmanager->AddProcess(scintillation);
+                pmanager->SetProcessOrderingToLast(scintillation, idxAtRest);
+                pmanager->SetProcessOrderingToLast(scintillation, idxPostStep);
+            }
+            pmanager->AddDiscreteProcess(new G4OpAbsorption);
+            pmanager->AddDiscreteProcess(new G4OpRayleigh);
+            pmanager->AddDiscreteProcess(U4Physics::CreateBoundaryProcess());
+        }
+    }
+}
+
+std::string U4OpticalGenstepPhysics::desc() const
+{
+    std::stringstream ss ;
+    ss
+        << "U4OpticalGenstepPhysics::desc" << "\n"
+        << std::setw(50) << _MATERIALS              << " : " << ( materials ? materials : "-" ) << "\n"
+        << std::setw(50) << _VOLUMES                << " : " << ( volumes ? volumes : "-" ) << "\n"
+        << std::setw(50) << _Cerenkov_DISABLE       << " : " << Cerenkov_DISABLE << "\n"
+        << std::setw(50) << _Scintillation_DISABLE  << " : " << Scintillation_DISABLE << "\n"
+        << std::setw(50) << "all"                   << " : " << ( all() ? "YES" : "NO" ) << "\n"
+        ;
+    std::string str = ss.str();
+    return str ;
+}
+
@@ -0,0 +1,60 @@
+#pragma once
+/**
+U4OpticalGenstepPhysics.hh : drop-in replacement for G4OpticalPhysics that collects gensteps
+=============================================================================================
+
+Collecting gensteps from a G4UserSteppingAction that scans the post step
+process vector for "Cerenkov" and "Scintillation" by name on every step
+of every track, while G4OpticalPhysics also generates and tracks the
+optical photons on CPU, duplicates the cost of the GPU simulation.
+
+This constructor instead adds Local_G4Cerenkov_modified and
+Local_DsG4Scintillation in genstep only mode : the genstep is collected
+within PostStepDoIt with the full photon count and the step
+gets SetNumberOfSecondaries(0), so no optical photon tracks are created::
+
+    G4VModularPhysicsList* physics = new FTFP_BERT ;
+    physics->RegisterPhysics(new U4OpticalGenstepPhysics) ;
+
+Genstep collection can be restricted to steps in materials or logical volumes
+with names starting with any of the comma delimited entries of the envvars
+(or ctor arguments)::
+
+    U4OpticalGenstepPhysics__MATERIALS    eg "LS,Water"
+    U4OpticalGenstepPhysics__VOLUMES      eg "lTarget"
+
+Steps elsewhere generate their photons as normal Geant4 secondaries,
+in which case optical photon absorption, rayleigh, boundary and reemission
+processes are also added for tracking them on CPU. With neither envvar
+set every step is collected and no optical photon processes are added.
+
+**/
+
+#include <string>
+#include "plog/Severity.h"
+#include "G4VPhysicsConstructor.hh"
+#include "U4_API_EXPORT.hh"
+
+struct U4_API U4OpticalGenstepPhysics : public G4VPhysicsConstructor
+{
+    static const plog::Severity LEVEL ;
+
+    static constexpr const char* _MATERIALS = "U4OpticalGenstepPhysics__MATERIALS" ;
+    static constexpr const char* _VOLUMES = "U4OpticalGenstepPhysics__VOLUMES" ;
+    static constexpr const char* _Cerenkov_DISABLE = "U4OpticalGenstepPhysics__Cerenkov_DISABLE" ;
+    static constexpr const char* _Scintillation_DISABLE = "U4OpticalGenstepPhysics__Scintillation_DISABLE" ;
+
+    const char* materials ;
+    const char* volumes ;
+    int Cerenkov_DISABLE ;
+    int Scintillation_DISABLE ;
+
+    U4OpticalGenstepPhysics( const char* materials=nullptr, const char* volumes=nullptr );   // nullptr: from envvars
+
+    bool all() const ;
+    void ConstructParticle() override ;
+    void ConstructProcess() override ;
+
+    std::string desc() const ;
+};
+
@@ -97,6 +97,48 @@ const int U4Recorder::PIDX = ssys::getenvint("PIDX",-1) ;
 const int U4Recorder::EIDX = ssys::getenvint("EIDX",-1) ;
 const int U4Recorder::GIDX = ssys::getenvint("GIDX",-1) ;
 
+#ifndef U4RECORDER_DISABLE
+const int U4Recorder::MODE = ssys::getenvintpick(_MODE, {"Disabled", "Hit", "Sample", "Full"}, MODE_FULL ) ;
+#endif
+const int U4Recorder::SAMPLE = ssys::getenvint(_SAMPLE, 100) ;
+const int U4Recorder::SAMPLE_ID0 = SampleRange(0) ;
+const int U4Recorder::SAMPLE_ID1 = SampleRange(1) ;
+
+const char* U4Recorder::ModeName(int mode) // static
+{
+    const char* s = nullptr ;
+    switch(mode)
+    {
+        case MODE_DISABLED: s = "Disabled" ; break ;
+        case MODE_HIT:      s = "Hit"      ; break ;
+        case MODE_SAMPLE:   s = "Sample"   ; break ;
+        case MODE_FULL:     s = "Full"     ; break ;
+        default:            s = "ERROR"    ; break ;
+    }
+    return s ;
+}
+
+/**
+U4Recorder::SampleRange
+-------------------------
+
+Photon id range i0,i1 (end exclusive) from U4Recorder__SAMPLE_RANGE, -1 when not set.
+
+**/
+
+int U4Recorder::SampleRange(int i) // static
+{
+    std::vector<int>* v = ssys::getenvintvec(_SAMPLE_RANGE, ',') ;
+    int r = v && v->size() == 2 ? (*v)[i] : -1 ;
+    delete v ;
+    return r ;
+}
+
+bool U4Recorder::Sampled(int id) // static
+{
+    return ( SAMPLE > 0 && id % SAMPLE == 0 ) || ( id >= SAMPLE_ID0 && id < SAMPLE_ID1 ) ;
+}
+
 std::string U4Recorder::Desc() // static
 {
     std::stringstream ss ;
@@ -118,6 +160,9 @@ std::string U4Recorder::DescFull() // static
        << " U4Recorder__SEvt_NPFold_VERBOSE     : " << ( SEvt_NPFold_VERBOSE     ? "YES" : "NO " ) << std::endl
        << " U4Recorder__EndOfRunAction_Simtrace : " << ( EndOfRunAction_Simtrace ? "YES" : "NO " ) << std::endl
        << " U4Recorder__REPLICA_NAME_SELECT     : " << ( REPLICA_NAME_SELECT     ? REPLICA_NAME_SELECT : "-" ) << std::endl
+       << " U4Recorder__MODE                    : " << ModeName(MODE) << std::endl
+       << " U4Recorder__SAMPLE                  : " << SAMPLE << std::endl
+       << " U4Recorder__SAMPLE_RANGE            : " << SAMPLE_ID0 << "," << SAMPLE_ID1 << std::endl
        << " PIDX                                : " << PIDX << std::endl
        << " EIDX                                : " << EIDX << std::endl
        << " GIDX                                : " << GIDX << std::endl
@@ -172,6 +217,12 @@ std::string U4Recorder::Switches()  // static
     ss << "NOT:WITH_INSTRUMENTED_DEBUG" << std::endl ;
 #endif
 
+#ifdef U4RECORDER_DISABLE
+    ss << "U4RECORDER_DISABLE" << std::endl ;
+#else
+    ss << "NOT:U4RECORDER_DISABLE" << std::endl ;
+#endif
+
     std::string str = ss.str();
     return str ;
 }
@@ -207,6 +258,8 @@ early exits from::
 
 Hence GIDX and EIDX provide a way to skip the expensive recording
 of other photons whilst debugging single gensteps or photons.
+With U4Recorder__MODE Sample photons not picked by U4Recorder::Sampled
+are skipped in the same way.
 
 Formerly used PIDX rather than EIDX but that was confusing because it
 is contrary to the normal use of PIDX to control debug printout for an idx.
@@ -217,6 +270,7 @@ This is typically used only during early stage debugging.
 
 bool U4Recorder::Enabled(const spho& label)
 {
+    if( MODE == MODE_SAMPLE && !Sampled(label.id) ) return false ;
     return GIDX == -1 ?
                         ( EIDX == -1 || label.id == EIDX )
                       :
@@ -277,6 +331,7 @@ void U4Recorder::init_SEvt()
 #endif
 
     NP::SetMeta<int>(sev->meta, _UseGivenVelocity_KLUDGE,  UseGivenVelocity_KLUDGE );
+    NP::SetMeta<std::string>(sev->meta, _MODE, ModeName(MODE) );
     NP::SetMeta<int>(sev->meta, "G4VERSION_NUMBER", G4VERSION_NUMBER );
 
     LOG(LEVEL) << " sev " << std::hex << sev << std::dec ;
@@ -410,11 +465,11 @@ void U4Recorder::EndOfEventAction_(int eventID_)
 }
 
 
-void U4Recorder::PreUserTrackingAction(const G4Track* track){  LOG(LEVEL) ; if(U4Track::IsOptical(track)) PreUserTrackingAction_Optical(track); }
-void U4Recorder::PostUserTrackingAction(const G4Track* track){ LOG(LEVEL) ; if(U4Track::IsOptical(track)) PostUserTrackingAction_Optical(track); }
+void U4Recorder::PreUserTrackingAction(const G4Track* track){  if(MODE == MODE_DISABLED) return ; LOG(LEVEL) ; if(U4Track::IsOptical(track)) PreUserTrackingAction_Optical(track); }
+void U4Recorder::PostUserTrackingAction(const G4Track* track){ if(MODE == MODE_DISABLED) return ; LOG(LEVEL) ; if(U4Track::IsOptical(track)) PostUserTrackingAction_Optical(track); }
 
-void U4Recorder::PreUserTrackingAction_(const G4Track* track, int* label){  LOG(LEVEL) ; if(U4Track::IsOptical(track)) PreUserTrackingAction_Optical_(track, label); }
-void U4Recorder::PostUserTrackingAction_(const G4Track* track, int* label){ LOG(LEVEL) ; if(U4Track::IsOptical(track)) PostUserTrackingAction_Optical_(track, label); }
+void U4Recorder::PreUserTrackingAction_(const G4Track* track, int* label){  if(MODE == MODE_DISABLED) return ; LOG(LEVEL) ; if(U4Track::IsOptical(track)) PreUserTrackingAction_Optical_(track, label); }
+void U4Recorder::PostUserTrackingAction_(const G4Track* track, int* label){ if(MODE == MODE_DISABLED) return ; LOG(LEVEL) ; if(U4Track::IsOptical(track)) PostUserTrackingAction_Optical_(track, label); }
 
 
 
@@ -422,17 +477,21 @@ void U4Recorder::PostUserTrackingAction_(const G4Track* track, int* label){ LOG(
 
 void U4Recorder::UserSteppingAction(const G4Step* step)
 {
+    if(MODE == MODE_DISABLED) return ;
     if(!U4Track::IsOptical(step->GetTrack())) return ;
 
 #if defined(WITH_CUSTOM4)
-     UserSteppingAction_Optical<C4OpBoundaryProcess>(step);
+     typedef C4OpBoundaryProcess BOP ;
 #elif defined(WITH_PMTSIM)
-     UserSteppingAction_Optical<CustomG4OpBoundaryProcess>(step);
+     typedef CustomG4OpBoundaryProcess BOP ;
 #elif defined(WITH_INSTRUMENTED_DEBUG)
-     UserSteppingAction_Optical<InstrumentedG4OpBoundaryProcess>(step);
+     typedef InstrumentedG4OpBoundaryProcess BOP ;
 #else
-     UserSteppingAction_Optical<G4OpBoundaryProcess>(step);
+     typedef G4OpBoundaryProcess BOP ;
 #endif
+
+     if(MODE == MODE_HIT) UserSteppingAction_Optical_Hit<BOP>(step);
+     else                 UserSteppingAction_Optical<BOP>(step);
 }
 
 
@@ -493,7 +552,7 @@ void U4Recorder::PreUserTrackingAction_Optical_(const G4Track* track, int* label
 
 
     bool skip = !Enabled(ulabel) ;
-    LOG_IF( info, skip ) << " Enabled-SKIP  EIDX/GIDX " << EIDX << "/" << GIDX ;
+    LOG_IF( info, skip && MODE != MODE_SAMPLE ) << " Enabled-SKIP  EIDX/GIDX " << EIDX << "/" << GIDX ;
     if(skip) return ;
 
     bool modulo = ulabel.id % 100000 == 0  ;
@@ -1105,15 +1164,7 @@ void U4Recorder::UserSteppingAction_Optical(const G4Step* step)
         // label->uc4.w = '_' ;
         // scrub after access : HMM IS THIS NEEDED ? NOT EASY NOW THAN USE COPY: ulabel
 
-        switch(fstrackinfo_stat)
-        {
-           case 'T': flag = BOUNDARY_TRANSMIT ; break ;
-           case 'R': flag = BOUNDARY_REFLECT  ; break ;
-           case 'A': flag = SURFACE_ABSORB    ; break ;
-           case 'D': flag = SURFACE_DETECT    ; break ;
-           case '_': flag = 0                 ; break ;
-           default:  flag = 0                 ; break ;
-        }
+        flag = FSTrackInfoFlag(fstrackinfo_stat) ;
         LOG_IF(error, flag == 0)
             << " DEFER_FSTRACKINFO "
             << " FAILED TO GET THE FastSim status from trackinfo "
@@ -1249,6 +1300,104 @@ void U4Recorder::UserSteppingAction_Optical(const G4Step* step)
 }
 
 
+/**
+U4Recorder::UserSteppingAction_Optical_Hit
+--------------------------------------------
+
+Used with U4Recorder__MODE Hit instead of UserSteppingAction_Optical.
+Only what is needed for the photon and hit arrays is done:
+
+1. first step records the generation point from the pre point,
+   as the full recording does
+2. intermediate steps (track still fAlive) just add the post flag
+   to the flagmask, so hit selection and history flags still work
+3. final step (fStopAndKill or FastSim fSuspend) updates the current
+   photon from the post point with the same EPH flag change and
+   iindex as the full recording and saves the point
+
+So the seq/record/rec arrays of each photon hold two points, generation
+and final, eg "TO SD" : the intermediate flags are only in the flagmask.
+There is no aux, fake classification or PIDX dumping in this tier, so
+compare seq histories with the Full tier or with GPU running only
+when reduced to first and last flags.
+
+**/
+
+template <typename T>
+void U4Recorder::UserSteppingAction_Optical_Hit(const G4Step* step)
+{
+    const G4Track* track = step->GetTrack();
+
+    spho ulabel = {} ;
+    GetLabel( ulabel, track );
+    if(!Enabled(ulabel)) return ;   // EIDX, GIDX skipping
+
+    SEvt* sev = SEvt::Get_ECPU();
+    sphoton& current_photon = sev->current_ctx.p ;
+
+    if( current_photon.flagmask_count() == 1 )  // first step, only the genflag is set by beginPhoton
+    {
+        U4StepPoint::Update(current_photon, step->GetPreStepPoint());
+        sev->pointPhoton(ulabel);
+    }
+
+    const G4StepPoint* post = step->GetPostStepPoint() ;
+    bool warn = false ;
+    bool is_tir = false ;
+    unsigned flag = U4StepPoint::Flag<T>(post, warn, is_tir ) ;
+    if( flag == DEFER_FSTRACKINFO ) flag = FSTrackInfoFlag(ulabel.uc4.w) ;
+    if( flag == 0 || flag == NAN_ABORT ) return ;
+
+    G4TrackStatus tstat = track->GetTrackStatus();
+    if( tstat == fAlive )
+    {
+        current_photon.addto_flagmask(flag) ;
+        return ;
+    }
+
+    U4StepPoint::Update(current_photon, post);
+
+    const G4VTouchable* touch = track->GetTouchable();
+    unsigned iindex = OpticksPhoton::IsDetectFlag(flag) ?
+              U4Touchable::ImmediateReplicaNumber(touch)
+              :
+              U4Touchable::AncestorReplicaNumber(touch)
+              ;
+    current_photon.set_iindex__( iindex );
+
+    unsigned eph = ulabel.eph();  // SProcessHits_EPH.h
+    if( flag == SURFACE_DETECT || flag == SURFACE_ABSORB || flag == BULK_ABSORB ) EPH_FlagCheck(flag,eph);
+    if( flag == SURFACE_DETECT ) flag = EPH_EFFICIENCY_COLLECT_OR_CULL( eph );
+
+    current_photon.set_flag( flag );
+    sev->pointPhoton(ulabel);
+}
+
+/**
+U4Recorder::FSTrackInfoFlag
+-----------------------------
+
+FastSim status char "?DART" set at the tail of junoPMTOpticalModel::DoIt
+and communicated via the trackinfo label, 0 when not set.
+
+**/
+
+unsigned U4Recorder::FSTrackInfoFlag(char fstrackinfo_stat) // static
+{
+    unsigned flag = 0 ;
+    switch(fstrackinfo_stat)
+    {
+       case 'T': flag = BOUNDARY_TRANSMIT ; break ;
+       case 'R': flag = BOUNDARY_REFLECT  ; break ;
+       case 'A': flag = SURFACE_ABSORB    ; break ;
+       case 'D': flag = SURFACE_DETECT    ; break ;
+       case '_': flag = 0                 ; break ;
+       default:  flag = 0                 ; break ;
+    }
+    return flag ;
+}
+
+
 /**
 U4Recorder::EFFICIENCY_COLLECT_OR_CULL
 ---------------------------------------
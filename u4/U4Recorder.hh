@@ -32,6 +32,36 @@ that access to the label can to be done in the detector
 framework. This avoids conflicts over the use of the track
 info by enabling it to be shared.
 
+
+Recording tiers
+----------------
+
+The recording tier, which determines how much of each optical track
+and step is recorded, is chosen with envvar U4Recorder__MODE:
+
++-----------+----------------------------------------------------------------+
+| Full      | default, every photon and step point with aux and fake checks  |
++-----------+----------------------------------------------------------------+
+| Sample    | full recording of every U4Recorder__SAMPLE th photon (100)     |
+|           | and of photon ids within U4Recorder__SAMPLE_RANGE "i0,i1"      |
+|           | others return immediately after the label lookup               |
++-----------+----------------------------------------------------------------+
+| Hit       | every photon, but per step only the flag is accumulated into   |
+|           | the flagmask, only the generation and final points are         |
+|           | recorded : seq is eg "TO SD", no aux, fakes or PIDX dumping    |
++-----------+----------------------------------------------------------------+
+| Disabled  | tracking and stepping actions return immediately               |
++-----------+----------------------------------------------------------------+
+
+Building with U4RECORDER_DISABLE (cmake -DU4RECORDER_DISABLE=ON) makes MODE
+a compile time constant MODE_DISABLED, so the optimizer removes the
+recording from the tracking and stepping actions entirely while the run
+and event lifecycle still operates the SEvt.
+
+The time taken with each tier has not yet been measured, it can be with::
+
+    ~/o/u4/tests/U4RecorderModeBench.sh
+
 **/
 
 #include <vector>
@@ -71,6 +101,22 @@ struct U4_API U4Recorder
     static const int  UseGivenVelocity_KLUDGE ;
     static constexpr const char* _UseGivenVelocity_KLUDGE = "U4Recorder__PreUserTrackingAction_Optical_UseGivenVelocity_KLUDGE" ;
 
+    enum { MODE_DISABLED, MODE_HIT, MODE_SAMPLE, MODE_FULL } ;
+    static constexpr const char* _MODE = "U4Recorder__MODE" ;
+    static constexpr const char* _SAMPLE = "U4Recorder__SAMPLE" ;
+    static constexpr const char* _SAMPLE_RANGE = "U4Recorder__SAMPLE_RANGE" ;
+#ifdef U4RECORDER_DISABLE
+    static constexpr int MODE = MODE_DISABLED ;
+#else
+    static const int MODE ;
+#endif
+    static const int SAMPLE ;
+    static const int SAMPLE_ID0 ;
+    static const int SAMPLE_ID1 ;
+    static const char* ModeName(int mode);
+    static int SampleRange(int i);
+    static bool Sampled(int id);
+
     static const char* REPLICA_NAME_SELECT ;
     static const int PIDX ;   // used to control debug printout for idx
     static const int EIDX ;   // used to enable U4Recorder for an idx, skipping all others
@@ -143,6 +189,10 @@ public:
     template<typename T>
     void UserSteppingAction_Optical(const G4Step*);
 
+    template<typename T>
+    void UserSteppingAction_Optical_Hit(const G4Step*);
+
+    static unsigned FSTrackInfoFlag(char fstrackinfo_stat);
     static unsigned EPH_EFFICIENCY_COLLECT_OR_CULL(unsigned eph);
     static void     EPH_FlagCheck(unsigned original_flag, unsigned eph);
 
@@ -0,0 +1,179 @@
+#pragma once
+/**
+U4StepLimit.h : truncation of Geant4 optical photon tracks matching the GPU propagate loop
+==========================================================================================
+
+The GPU simulation of each photon ends when the bounce loop reaches
+SEventConfig::MaxBounce or the photon time reaches SEventConfig::MaxTime,
+see CSGOptiX7.cu::simulate::
+
+    while( bounce < evt->max_bounce && ctx.p.time < params.max_time ) { ... ; bounce++ ; }
+
+Geant4 has no such limits : photons trapped between reflective surfaces
+bounce until a step count check in the application kills them, so
+CPU validation runs spend most of their time on photons that the
+GPU truncated long before. U4StepLimit applies the same criteria
+to optical photon tracks, with each Geant4 step counting as one bounce,
+so the CPU and GPU photons end in the same state, with the last
+(live) flag of the truncated photon.
+
+Call after any step recording, as the recording must see the step
+while the track is still alive, just as the GPU records the last point
+before leaving the loop::
+
+    void SteppingAction::UserSteppingAction(const G4Step* step)
+    {
+        U4Recorder::Get()->UserSteppingAction(step) ;
+        U4StepLimit::Get()->UserSteppingAction(step) ;
+    }
+
+Non-optical tracks and tracks already ended by physics return after
+a pointer and a status comparison, without further lookups.
+
+The truncations are counted by reason for both criteria, see desc.
+Applications print desc per event only with U4StepLimit__level > 0.
+The limits can be set from the ctor for tests. A max_bounce of zero
+or less disables the bounce limit.
+
+**/
+
+#include <atomic>
+#include <string>
+#include <sstream>
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4StepPoint.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "ssys.h"
+#include "SEventConfig.hh"
+
+struct U4StepLimit
+{
+    static constexpr const char* _level = "U4StepLimit__level" ;
+    enum { NONE, BOUNCE, TIME } ;
+    static const char* ReasonName(int reason);
+
+    static U4StepLimit* Get();
+
+    const G4ParticleDefinition* optical ;
+    const int64_t max_bounce ;
+    const double  max_time ;     // ns, Geant4 time units
+    const int     level ;
+
+    std::atomic<int64_t> num_bounce ;
+    std::atomic<int64_t> num_time ;
+
+    U4StepLimit( int64_t max_bounce, double max_time );
+
+    int  check( const G4Track* track, const G4StepPoint* post ) const ;
+    int  UserSteppingAction( const G4Step* step );
+    int64_t num_truncated() const ;
+    void clear();
+
+    std::string desc() const ;
+};
+
+inline const char* U4StepLimit::ReasonName(int reason) // static
+{
+    const char* s = nullptr ;
+    switch(reason)
+    {
+        case NONE:   s = "NONE"   ; break ;
+        case BOUNCE: s = "BOUNCE" ; break ;
+        case TIME:   s = "TIME"   ; break ;
+    }
+    return s ;
+}
+
+/**
+U4StepLimit::Get
+------------------
+
+Shared by all worker threads, configured from SEventConfig on first use.
+
+**/
+
+inline U4StepLimit* U4StepLimit::Get() // static
+{
+    static U4StepLimit limit( SEventConfig::MaxBounce(), double(SEventConfig::MaxTime())*CLHEP::ns ) ;
+    return &limit ;
+}
+
+inline U4StepLimit::U4StepLimit( int64_t max_bounce_, double max_time_ )
+    :
+    optical(G4OpticalPhoton::Definition()),
+    max_bounce(max_bounce_),
+    max_time(max_time_),
+    level(ssys::getenvint(_level,0)),
+    num_bounce(0),
+    num_time(0)
+{
+}
+
+/**
+U4StepLimit::check
+--------------------
+
+Returns the reason for truncating the alive track after its current step.
+Bounce is checked first, as in the GPU loop condition.
+
+**/
+
+inline int U4StepLimit::check( const G4Track* track, const G4StepPoint* post ) const
+{
+    if( max_bounce > 0 && track->GetCurrentStepNumber() >= max_bounce ) return BOUNCE ;
+    if( post->GetGlobalTime() >= max_time ) return TIME ;
+    return NONE ;
+}
+
+/**
+U4StepLimit::UserSteppingAction
+---------------------------------
+
+Kills alive optical tracks reaching a limit, returning the reason.
+
+**/
+
+inline int U4StepLimit::UserSteppingAction( const G4Step* step )
+{
+    G4Track* track = step->GetTrack() ;
+    if( track->GetDefinition() != optical ) return NONE ;
+    if( track->GetTrackStatus() != fAlive ) return NONE ;
+
+    int reason = check( track, step->GetPostStepPoint() ) ;
+    if( reason == NONE ) return NONE ;
+
+    track->SetTrackStatus(fStopAndKill) ;
+    if( reason == BOUNCE ) num_bounce += 1 ;
+    if( reason == TIME )   num_time += 1 ;
+    return reason ;
+}
+
+inline int64_t U4StepLimit::num_truncated() const
+{
+    return num_bounce + num_time ;
+}
+
+inline void U4StepLimit::clear()
+{
+    num_bounce = 0 ;
+    num_time = 0 ;
+}
+
+inline std::string U4StepLimit::desc() const
+{
+    std::stringstream ss ;
+    ss << "U4StepLimit::desc"
+       << " max_bounce " << max_bounce
+       << " max_time " << max_time/CLHEP::ns << " ns"
+       << " num_truncated " << num_truncated()
+       << " " << ReasonName(BOUNCE) << " " << num_bounce
+       << " " << ReasonName(TIME) << " " << num_time
+       ;
+    std::string str = ss.str();
+    return str ;
+}
+
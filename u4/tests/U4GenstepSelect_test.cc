@@ -0,0 +1,189 @@
+/**
+U4GenstepSelect_test.cc
+=========================
+
+::
+
+    ~/opticks/u4/tests/U4GenstepSelect_test.sh
+
+    NUM_THREAD=16 NUM_REPEAT=100000 ~/opticks/u4/tests/U4GenstepSelect_test.sh
+
+Steps within three materials and volumes are classified with the
+genstep_only selection of Local_G4Cerenkov_modified and Local_DsG4Scintillation:
+
+1. material list, volume list (prefix match), both and neither
+2. the caches are filled once per material and logical volume
+3. concurrent selection with one U4GenstepSelect per thread, as with
+   the per-worker processes, over the same steps without any lock
+   matches the serial result
+
+**/
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <iostream>
+
+#include "ssys.h"
+
+#include "G4Material.hh"
+#include "G4Box.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PVPlacement.hh"
+#include "G4NavigationHistory.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Step.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "U4GenstepSelect.h"
+
+struct U4GenstepSelect_test
+{
+    int num_thread ;
+    int num_repeat ;
+
+    std::vector<G4Material*> mats ;
+    std::vector<G4LogicalVolume*> lvs ;
+    std::vector<G4Step*> steps ;
+
+    U4GenstepSelect_test();
+
+    void add( const char* mat, const char* lv, const char* pv );
+    int  count( U4GenstepSelect& sel, int repeat ) const ;
+
+    int check( const char* materials, const char* volumes, int expect );
+    int check_threads();
+    int main();
+};
+
+U4GenstepSelect_test::U4GenstepSelect_test()
+    :
+    num_thread(ssys::getenvint("NUM_THREAD", 8)),
+    num_repeat(ssys::getenvint("NUM_REPEAT", 10000))
+{
+    add( "LS",    "lTarget", "pTarget" );
+    add( "Water", "lBuffer", "pBuffer" );
+    add( "Air",   "lWorld",  "pWorld" );
+}
+
+/**
+U4GenstepSelect_test::add
+---------------------------
+
+One step with pre-step point in a new material and placed volume.
+
+**/
+
+void U4GenstepSelect_test::add( const char* mat, const char* lv, const char* pv )
+{
+    G4Material* mt = new G4Material(mat, 1., 1.01*g/mole, 1.*g/cm3 ) ;
+    G4LogicalVolume* l = new G4LogicalVolume( new G4Box(lv, 1*m, 1*m, 1*m), mt, lv ) ;
+    G4VPhysicalVolume* p = new G4PVPlacement( nullptr, G4ThreeVector(), l, pv, nullptr, false, 0 ) ;
+
+    G4NavigationHistory hist ;
+    hist.SetFirstEntry(p) ;
+    G4TouchableHistory* th = new G4TouchableHistory ;
+    th->UpdateYourself(p, &hist) ;
+
+    G4Step* st = new G4Step ;
+    st->GetPreStepPoint()->SetMaterial(mt) ;
+    st->GetPreStepPoint()->SetTouchableHandle( G4TouchableHandle(th) ) ;
+
+    mats.push_back(mt) ;
+    lvs.push_back(l) ;
+    steps.push_back(st) ;
+}
+
+int U4GenstepSelect_test::count( U4GenstepSelect& sel, int repeat ) const
+{
+    int n = 0 ;
+    for(int r=0 ; r < repeat ; r++) for(const G4Step* st : steps) if(sel.select(*st)) n += 1 ;
+    return n ;
+}
+
+int U4GenstepSelect_test::check( const char* materials, const char* volumes, int expect )
+{
+    U4GenstepSelect sel(materials, volumes) ;
+    int n0 = count(sel, 1) ;
+    int n1 = count(sel, 1) ;   // from the caches
+
+    size_t expect_mat = materials ? mats.size() : 0 ;
+    size_t expect_vol = materials == nullptr && volumes ? lvs.size() : sel.volume_cache.size() ;   // volumes only looked up for unselected materials
+    bool ok = n0 == expect && n1 == expect
+           && sel.material_cache.size() == expect_mat
+           && sel.volume_cache.size() == expect_vol
+           && sel.checked == false ;
+
+    std::cout
+        << "U4GenstepSelect_test::check"
+        << " n0 " << n0
+        << " n1 " << n1
+        << " expect " << expect
+        << " " << sel.desc()
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+/**
+U4GenstepSelect_test::check_threads
+-------------------------------------
+
+Each thread constructs its own U4GenstepSelect, as U4OpticalGenstepPhysics::ConstructProcess
+does for each worker, and classifies the shared steps concurrently.
+
+**/
+
+int U4GenstepSelect_test::check_threads()
+{
+    U4GenstepSelect ref("LS", "lBuf") ;
+    int expect = count(ref, num_repeat) ;
+
+    std::vector<int> nn(num_thread, 0) ;
+    std::vector<std::thread> tt ;
+    for(int t=0 ; t < num_thread ; t++)
+    {
+        tt.emplace_back( [this, &nn, t]()
+        {
+            U4GenstepSelect sel("LS", "lBuf") ;
+            nn[t] = count(sel, num_repeat) ;
+        });
+    }
+    for(auto& t : tt) t.join() ;
+
+    int num_bad = 0 ;
+    for(int t=0 ; t < num_thread ; t++) if( nn[t] != expect ) num_bad += 1 ;
+
+    std::cout
+        << "U4GenstepSelect_test::check_threads"
+        << " num_thread " << num_thread
+        << " num_repeat " << num_repeat
+        << " expect " << expect
+        << " num_bad " << num_bad
+        << " " << ( num_bad == 0 ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return num_bad == 0 ? 0 : 1 ;
+}
+
+int U4GenstepSelect_test::main()
+{
+    int rc = 0 ;
+    rc += check( "LS",    nullptr,  1 );
+    rc += check( "LS,Wa", nullptr,  2 );
+    rc += check( nullptr, "lBuf",   1 );
+    rc += check( "LS",    "lBuf",   2 );
+    rc += check( "LS",    "lTarg",  1 );
+    rc += check( nullptr, nullptr,  3 );
+    rc += check( "Oil",   "lPMT",   0 );
+    rc += check_threads();
+    std::cout << "U4GenstepSelect_test::main rc " << rc << std::endl ;
+    return rc ;
+}
+
+int main()
+{
+    U4GenstepSelect_test t ;
+    return t.main() ;
+}
@@ -0,0 +1,67 @@
+#!/bin/bash
+usage(){ cat << EOU
+U4GenstepSelect_test.sh
+========================
+
+Checks the U4GenstepSelect genstep_only step selection, including
+concurrent unlocked selection with one instance per thread::
+
+    ~/opticks/u4/tests/U4GenstepSelect_test.sh
+
+    NUM_THREAD=16 NUM_REPEAT=100000 ~/opticks/u4/tests/U4GenstepSelect_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+name=U4GenstepSelect_test
+BASE=/tmp/$name
+bin=$BASE/$name
+mkdir -p $BASE
+
+opticks-
+clhep-
+g4-
+
+vars="BASH_SOURCE name BASE bin"
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/info}" != "$arg" ]; then
+   for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done
+fi
+
+if (( $(g4-major-version-number) < 11 )); then
+	cc_std="c++11"
+else
+	cc_std="c++17"
+fi
+if [ "${arg/build}" != "$arg" ]; then
+    gcc \
+         $name.cc \
+         -I.. \
+         -O2 -std=$cc_std -lstdc++ -pthread \
+         -I$HOME/opticks/sysrap \
+         -I$(clhep-prefix)/include \
+         -I$(g4-prefix)/include/Geant4  \
+         -L$(g4-prefix)/lib \
+         -L$(g4-prefix)/lib64 \
+         -L$(clhep-prefix)/lib \
+         -lG4global \
+         -lG4materials \
+         -lG4geometry \
+         -lG4graphics_reps \
+         -lG4particles \
+         -lG4track \
+         -lCLHEP \
+         -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
@@ -0,0 +1,243 @@
+/**
+U4HitPool_test.cc
+===================
+
+::
+
+    ~/opticks/u4/tests/U4HitPool_test.sh
+
+    NUM_THREAD=8 NUM_EVT=200 ~/opticks/u4/tests/U4HitPool_test.sh
+
+Worker threads process events taken from a shared counter, publishing
+the gensteps of each event as an sevtshard (as SEvt::PublishWorker) and
+then blocking in U4HitPool::sync_inject. The mock launch on the pool
+thread merges the published shards (as SEvt::MergeWorkers), makes one
+hit for every third photon of each genstep, with the eventID in the hit
+time, and partitions them with seventsplit::Create (as SEvt::makeHitSplit).
+
+1. batch mode with sphoton hits : every event gets exactly its own hits,
+   converted on its own worker, with launches covering several events
+2. per_event mode with sphotonlite hits
+3. workers finishing at different times (worker_end) do not hold back
+   the remaining workers
+
+**/
+
+#include <set>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <iostream>
+
+#include "ssys.h"
+#include "sevtmerge.h"
+#include "U4HitPool.h"
+
+struct U4HitPool_test
+{
+    static constexpr const int HIT_EVERY = 3 ;
+
+    int num_thread ;
+    int num_evt ;
+    int num_gs ;
+
+    sevtmerge merge ;
+    std::atomic<int64_t> num_launch_event ;
+
+    U4HitPool_test();
+
+    static int64_t Photons( int evt, int g );
+    static int64_t ExpectedHits( int evt, int num_gs );
+
+    sevtshard* collect( int evt, int tid ) const ;
+    seventsplit* launch( int eventID, bool lite );
+    int run( bool lite, bool per_event );
+    int main();
+};
+
+U4HitPool_test::U4HitPool_test()
+    :
+    num_thread(ssys::getenvint("NUM_THREAD", 4)),
+    num_evt(ssys::getenvint("NUM_EVT", 50)),
+    num_gs(ssys::getenvint("NUM_GS", 10)),
+    num_launch_event(0)
+{
+}
+
+int64_t U4HitPool_test::Photons( int evt, int g ) // static
+{
+    return ( evt*31 + g*7 ) % 50 ;
+}
+
+int64_t U4HitPool_test::ExpectedHits( int evt, int num_gs ) // static
+{
+    int64_t n = 0 ;
+    for(int g=0 ; g < num_gs ; g++) n += ( Photons(evt, g) + HIT_EVERY - 1 )/HIT_EVERY ;
+    return n ;
+}
+
+/**
+U4HitPool_test::collect
+-------------------------
+
+Gensteps of one event with sgsid provenance, as collected by a worker SEvt.
+
+**/
+
+sevtshard* U4HitPool_test::collect( int evt, int tid ) const
+{
+    sevtshard* s = new sevtshard(evt, tid) ;
+    for(int g=0 ; g < num_gs ; g++)
+    {
+        sgs gs = {} ;
+        gs.index = g ;
+        gs.photons = Photons(evt, g) ;
+        gs.offset = s->num_photon() ;
+        s->gs.push_back(gs) ;
+        s->gsid.push_back( sgsid::Make(evt, tid, g+1) ) ;
+        s->genstep.push_back( quad6{} ) ;
+    }
+    return s ;
+}
+
+/**
+U4HitPool_test::launch
+------------------------
+
+Runs on the pool thread : merge, "simulate" and split.
+
+**/
+
+seventsplit* U4HitPool_test::launch( int eventID, bool lite )
+{
+    std::vector<sevtshard*> ss = merge.take(eventID) ;
+    sevtshard acc ;
+    for(sevtshard* s : ss)
+    {
+        sevtmerge::Append( acc, *s );
+        delete s ;
+    }
+
+    int ng = int(acc.gs.size()) ;
+    std::vector<int64_t> gs_offset(ng+1) ;
+    std::vector<int> gs_eventID(ng) ;
+    std::vector<int> gs_threadID(ng) ;
+    for(int g=0 ; g < ng ; g++)
+    {
+        gs_offset[g] = acc.gs[g].offset ;
+        gs_eventID[g] = acc.gsid[g].eventID ;
+        gs_threadID[g] = acc.gsid[g].threadID ;
+    }
+    gs_offset[ng] = acc.num_photon() ;
+
+    std::vector<sphoton> hh ;
+    std::vector<sphotonlite> ll ;
+    for(int g=0 ; g < ng ; g++)
+    for(int64_t j=0 ; j < acc.gs[g].photons ; j += HIT_EVERY)
+    {
+        sphoton p = {} ;
+        p.set_index( acc.gs[g].offset + j ) ;
+        p.time = float(gs_eventID[g]) ;
+        p.flagmask = SURFACE_DETECT ;
+        hh.push_back(p) ;
+
+        sphotonlite l = {} ;
+        l.init( 1u, p.time, p.flagmask ) ;
+        ll.push_back(l) ;
+    }
+
+    NP* hit = lite ? NP::Make<uint32_t>( ll.size(), 4 ) : NP::Make<float>( hh.size(), 4, 4 ) ;
+    if( lite && ll.size() > 0 ) hit->read2<uint32_t>( (uint32_t*)ll.data() );
+    if( !lite && hh.size() > 0 ) hit->read2<float>( (float*)hh.data() );
+
+    std::set<int> evts( gs_eventID.begin(), gs_eventID.end() ) ;
+    num_launch_event += evts.size() ;
+
+    seventsplit* split = seventsplit::Create( hit, gs_offset.data(), gs_eventID.data(), ng, gs_threadID.data() ) ;
+    delete hit ;
+    return split ;
+}
+
+int U4HitPool_test::run( bool lite, bool per_event )
+{
+    U4HitPool* pool = U4HitPool::Get() ;
+    num_launch_event = 0 ;
+    pool->num_launch = 0 ;
+    pool->num_injected = 0 ;
+    pool->start( [this, lite](int eventID){ return launch(eventID, lite) ; }, per_event );
+
+    std::atomic<int> next(0) ;
+    std::atomic<int> num_bad(0) ;
+    std::atomic<int64_t> num_hit(0) ;
+    std::vector<std::thread> tt ;
+    for(int t=0 ; t < num_thread ; t++)
+    {
+        tt.emplace_back( [&, t]()
+        {
+            G4Threading::G4SetThreadId(t) ;
+            pool->worker_begin() ;
+            std::mt19937 jitter(t) ;
+            int evt ;
+            while( (evt = next++) < num_evt )
+            {
+                if( jitter() % 3 == 0 ) std::this_thread::sleep_for(std::chrono::microseconds(jitter() % 200)) ;
+                merge.push( collect(evt, t) ) ;
+
+                U4OpticksHitsCollection* hc = new U4OpticksHitsCollection("det", "col") ;
+                size_t n = pool->sync_inject( hc, evt ) ;
+
+                bool ok = int64_t(n) == ExpectedHits(evt, num_gs) && hc->entries() == n ;
+                for(size_t i=0 ; ok && i < n ; i++)
+                {
+                    const U4OpticksHit* h = (*hc)[i] ;
+                    ok = h->eventID == evt && h->time == float(evt) && h->flagmask == SURFACE_DETECT ;
+                }
+                if(!ok) num_bad += 1 ;
+                num_hit += n ;
+                delete hc ;   // back to the allocator of this thread
+            }
+            pool->worker_end() ;
+        });
+    }
+    for(auto& t : tt) t.join() ;
+    pool->stop();
+
+    int64_t expect = 0 ;
+    for(int evt=0 ; evt < num_evt ; evt++) expect += ExpectedHits(evt, num_gs) ;
+
+    bool batched = per_event ? pool->num_launch == num_evt : pool->num_launch <= num_evt ;
+    bool ok = num_bad == 0 && num_hit == expect && num_launch_event == num_evt && batched ;
+
+    std::cout
+        << "U4HitPool_test::run"
+        << " lite " << lite
+        << " per_event " << per_event
+        << " num_thread " << num_thread
+        << " num_evt " << num_evt
+        << " num_hit " << num_hit
+        << " expect " << expect
+        << " num_bad " << num_bad
+        << " num_launch_event " << num_launch_event
+        << " " << pool->desc()
+        << " " << ( ok ? "PASS" : "FAIL" )
+        << std::endl
+        ;
+    return ok ? 0 : 1 ;
+}
+
+int U4HitPool_test::main()
+{
+    int rc = 0 ;
+    rc += run( false, false );
+    rc += run( true,  true );
+    rc += run( false, true );
+    std::cout << "U4HitPool_test::main rc " << rc << std::endl ;
+    return rc ;
+}
+
+int main()
+{
+    U4HitPool_test t ;
+    return t.main() ;
+}
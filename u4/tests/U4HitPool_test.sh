@@ -0,0 +1,67 @@
+#!/bin/bash
+usage(){ cat << EOU
+U4HitPool_test.sh
+==================
+
+Checks the U4HitPool end of batch synchronization with a mock launch,
+in batch mode with sphoton hits and per event mode with sphotonlite hits::
+
+    ~/opticks/u4/tests/U4HitPool_test.sh
+
+    NUM_THREAD=8 NUM_EVT=200 ~/opticks/u4/tests/U4HitPool_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+name=U4HitPool_test
+BASE=/tmp/$name
+bin=$BASE/$name
+mkdir -p $BASE
+
+opticks-
+clhep-
+g4-
+
+cuda_prefix=/usr/local/cuda
+CUDA_PREFIX=${CUDA_PREFIX:-$cuda_prefix}
+
+vars="BASH_SOURCE name BASE bin CUDA_PREFIX"
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/info}" != "$arg" ]; then
+   for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done
+fi
+
+if (( $(g4-major-version-number) < 11 )); then
+	cc_std="c++11"
+else
+	cc_std="c++17"
+fi
+if [ "${arg/build}" != "$arg" ]; then
+    gcc \
+         $name.cc \
+         -I.. \
+         -O2 -std=$cc_std -lstdc++ -pthread \
+         -I$HOME/opticks/sysrap \
+         -I$CUDA_PREFIX/include \
+         -I$(clhep-prefix)/include \
+         -I$(g4-prefix)/include/Geant4  \
+         -L$(g4-prefix)/lib \
+         -L$(g4-prefix)/lib64 \
+         -L$(clhep-prefix)/lib \
+         -lG4global \
+         -lG4digits_hits \
+         -lCLHEP \
+         -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
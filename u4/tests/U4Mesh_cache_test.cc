@@ -0,0 +1,101 @@
+/**
+U4Mesh_cache_test.cc
+=====================
+
+::
+
+    ~/opticks/u4/tests/U4Mesh_cache_test.sh
+
+1. differently named solids with identical parameters share a digest
+2. first U4Mesh::MakeFold polygonizes only the unique solids (concurrently)
+3. second U4Mesh::MakeFold with the same cache directory has no misses
+4. arrays from cache match those from U4Mesh::Serialize
+5. saving an entry that already exists, as when another process won
+   the race, leaves the entry and no temporary directory
+
+**/
+
+#include <iostream>
+#include <dirent.h>
+#include "G4Torus.hh"
+#include "G4Box.hh"
+#include "G4Polycone.hh"
+#include "G4UnionSolid.hh"
+#include "G4SystemOfUnits.hh"
+#include "U4Mesh.h"
+
+int main()
+{
+    std::vector<const G4VSolid*> solids ;
+    std::vector<std::string> keys ;
+
+    solids.push_back( new G4Torus("torusA", 0., 10*mm, 100*mm, 0., CLHEP::twopi) ) ;
+    solids.push_back( new G4Torus("torusB", 0., 10*mm, 100*mm, 0., CLHEP::twopi) ) ;
+    solids.push_back( new G4Torus("torusC", 0., 11*mm, 100*mm, 0., CLHEP::twopi) ) ;
+    solids.push_back( new G4Box("boxA", 50*mm, 50*mm, 50*mm) ) ;
+
+    double z[3] = { -100*mm, 0., 100*mm } ;
+    double rmin[3] = { 0., 0., 0. } ;
+    double rmax[3] = { 50*mm, 80*mm, 50*mm } ;
+    solids.push_back( new G4Polycone("pconA", 0., CLHEP::twopi, 3, z, rmin, rmax) ) ;
+    solids.push_back( new G4UnionSolid("unionA", const_cast<G4VSolid*>(solids[3]), const_cast<G4VSolid*>(solids[4]) ) ) ;
+    solids.push_back( new G4UnionSolid("unionB", const_cast<G4VSolid*>(solids[3]), const_cast<G4VSolid*>(solids[4]) ) ) ;
+
+    for(const G4VSolid* so : solids) keys.push_back( so->GetName() ) ;
+
+    int rc = 0 ;
+    if( U4Mesh::Digest(solids[0], 0) != U4Mesh::Digest(solids[1], 0) ) rc += 1 ;
+    if( U4Mesh::Digest(solids[0], 0) == U4Mesh::Digest(solids[2], 0) ) rc += 1 ;
+    if( U4Mesh::Digest(solids[0], 0) == U4Mesh::Digest(solids[0], 48) ) rc += 1 ;
+    if( U4Mesh::Digest(solids[5], 0) != U4Mesh::Digest(solids[6], 0) ) rc += 1 ;
+
+    NPFold* a = U4Mesh::MakeFold(solids, keys) ;
+    NPFold* b = U4Mesh::MakeFold(solids, keys) ;
+
+    int num_uniq = a->get_meta<int>("num_uniq", -1) ;
+    int a_miss = a->get_meta<int>("num_miss", -1) ;
+    int b_miss = b->get_meta<int>("num_miss", -1) ;
+    if( num_uniq != 5 ) rc += 1 ;
+    if( b_miss != 0 ) rc += 1 ;
+
+    for(size_t i=0 ; i < solids.size() ; i++)
+    {
+        NPFold* ref = U4Mesh::Serialize(solids[i]) ;
+        const NPFold* sub = b->get_subfold(keys[i].c_str()) ;
+        for(const char* k : { "vtx", "fpd", "tri" })
+        {
+            const NP* x = ref->get(k) ;
+            const NP* y = sub ? sub->get(k) : nullptr ;
+            bool same = x && y && x->arr_bytes() == y->arr_bytes() && memcmp(x->bytes(), y->bytes(), x->arr_bytes()) == 0 ;
+            if(!same) rc += 1 ;
+        }
+        if( sub == nullptr || sub->get_meta_string("solidName") != keys[i] ) rc += 1 ;
+        delete ref ;
+    }
+
+    const char* cache = U4Mesh::CacheDir() ;
+    std::string d0 = b->get_subfold(keys[0].c_str())->get_meta_string("digest") ;
+    NPFold* again = U4Mesh::Serialize(solids[0]) ;
+    U4Mesh::CacheSave( again, cache, d0.c_str() );
+    if( NPFold::LoadIfExists( spath::Resolve(cache, d0.c_str()) ) == nullptr ) rc += 1 ;
+
+    int num_tmp = 0 ;
+    DIR* d = opendir(cache) ;
+    struct dirent* e ;
+    while( d && (e = readdir(d)) != nullptr ) if( strstr(e->d_name, ".tmp") ) num_tmp += 1 ;
+    if(d) closedir(d);
+    if( num_tmp != 0 ) rc += 1 ;
+
+    std::cout
+        << "U4Mesh_cache_test"
+        << " cache " << ( U4Mesh::CacheDir() ? U4Mesh::CacheDir() : "-" )
+        << " num_solid " << solids.size()
+        << " num_uniq " << num_uniq
+        << " a_miss " << a_miss
+        << " b_miss " << b_miss
+        << " num_tmp " << num_tmp
+        << " rc " << rc
+        << "\n"
+        ;
+    return rc == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,65 @@
+#!/bin/bash
+usage(){ cat << EOU
+U4Mesh_cache_test.sh
+=====================
+
+Checks the U4Mesh::MakeFold content addressed mesh cache::
+
+    ~/opticks/u4/tests/U4Mesh_cache_test.sh
+
+EOU
+}
+
+cd $(dirname $(realpath $BASH_SOURCE))
+name=U4Mesh_cache_test
+BASE=/tmp/$name
+bin=$BASE/$name
+mkdir -p $BASE
+
+export U4Mesh__CACHE=$BASE/cache
+rm -rf $U4Mesh__CACHE
+
+opticks-
+clhep-
+g4-
+
+vars="BASH_SOURCE name BASE bin U4Mesh__CACHE"
+
+defarg="info_build_run"
+arg=${1:-$defarg}
+
+if [ "${arg/info}" != "$arg" ]; then
+   for var in $vars ; do printf "%20s : %s \n" "$var" "${!var}" ; done
+fi
+
+if (( $(g4-major-version-number) < 11 )); then
+	cc_std="c++11"
+else
+	cc_std="c++17"
+fi
+if [ "${arg/build}" != "$arg" ]; then
+    gcc \
+         $name.cc \
+         -I.. \
+         -O2 -std=$cc_std -lstdc++ -pthread \
+         -I$HOME/opticks/sysrap \
+         -I$(clhep-prefix)/include \
+         -I$(g4-prefix)/include/Geant4  \
+         -L$(g4-prefix)/lib \
+         -L$(g4-prefix)/lib64 \
+         -L$(clhep-prefix)/lib \
+         -lG4global \
+         -lG4geometry \
+         -lG4graphics_reps \
+         -lCLHEP \
+         -lssl -lcrypto \
+         -o $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE build error && exit 1
+fi
+
+if [ "${arg/run}" != "$arg" ]; then
+    $bin
+    [ $? -ne 0 ] && echo $BASH_SOURCE run error && exit 2
+fi
+
+exit 0
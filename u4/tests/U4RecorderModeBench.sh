@@ -0,0 +1,51 @@
+#!/bin/bash -l
+usage(){ cat << EOU
+U4RecorderModeBench.sh : overhead of each U4Recorder__MODE recording tier
+===========================================================================
+
+Runs the standard U4App geometry and photon source of U4SimulateTest.sh
+once for each tier and tabulates the wall time and the overhead
+relative to the Disabled tier::
+
+    ~/o/u4/tests/U4RecorderModeBench.sh
+    NUM_PHOTONS=100000 ~/o/u4/tests/U4RecorderModeBench.sh
+    MODES="Full Hit" ~/o/u4/tests/U4RecorderModeBench.sh
+
+Sample tier records every U4Recorder__SAMPLE th photon, default here 100.
+For the compile time disabled build configure with -DU4RECORDER_DISABLE=ON,
+in which case all tiers should match Disabled.
+
+EOU
+}
+
+DIR=$(cd $(dirname $BASH_SOURCE) && pwd)
+
+modes=${MODES:-Disabled Hit Sample Full}
+export U4Recorder__SAMPLE=${U4Recorder__SAMPLE:-100}
+export NUM_PHOTONS=${NUM_PHOTONS:-10000}
+
+log=/tmp/$USER/opticks/U4RecorderModeBench
+mkdir -p $log
+
+declare -A dt
+for mode in $modes ; do
+    t0=$(date +%s.%N)
+    U4Recorder__MODE=$mode $DIR/U4SimulateTest.sh run > $log/$mode.log 2>&1
+    rc=$?
+    t1=$(date +%s.%N)
+    [ $rc -ne 0 ] && echo $BASH_SOURCE mode $mode error, see $log/$mode.log && exit 1
+    dt[$mode]=$(echo "$t1 - $t0" | bc -l)
+done
+
+ref=${dt[Disabled]}
+printf "%10s %12s %12s   NUM_PHOTONS %s\n" mode seconds overhead $NUM_PHOTONS
+for mode in $modes ; do
+    if [ -n "$ref" ]; then
+        ovh=$(echo "${dt[$mode]} - $ref" | bc -l)
+    else
+        ovh="-"
+    fi
+    printf "%10s %12.3f %12s\n" $mode ${dt[$mode]} $ovh
+done
+
+exit 0